@@ -0,0 +1,63 @@
+// Shared helpers for the host-side benchmarks.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <chrono>
+
+namespace bench
+{
+  static inline uint64_t micros(void)
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  struct xorshift32_t
+  {
+    uint32_t state;
+    xorshift32_t(uint32_t seed = 2463534242u) : state(seed ? seed : 1) {}
+    uint32_t next(void)
+    {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+  };
+
+  static inline void fill_random(void* dst, size_t length, uint32_t seed = 1)
+  {
+    xorshift32_t rng(seed);
+    auto d = static_cast<uint8_t*>(dst);
+    for (size_t i = 0; i < length; ++i) { d[i] = rng.next() >> 24; }
+  }
+
+  /// Call `func` repeatedly until at least `min_us` have elapsed and return the average microseconds per call.
+  template <typename TFunc>
+  static double measure(TFunc&& func, uint32_t min_us = 30000)
+  {
+    func(); // warm up caches and branch predictors.
+    uint32_t loops = 0;
+    uint64_t start = micros();
+    uint64_t elapsed;
+    do
+    {
+      func();
+      ++loops;
+    } while ((elapsed = micros() - start) < min_us);
+    return (double)elapsed / loops;
+  }
+
+  /// Throughput in Mpixel/s (pixels per microsecond) for `pixels` processed in `us`.
+  static inline double mpix(size_t pixels, double us)
+  {
+    return us > 0 ? pixels / us : 0.0;
+  }
+
+  /// Throughput in MByte/s for `bytes` processed in `us`.
+  static inline double mbyte(size_t bytes, double us)
+  {
+    return us > 0 ? bytes / us : 0.0;
+  }
+}
@@ -0,0 +1,605 @@
+// Host benchmark of the bus traffic generated by the panel drivers.
+//
+// Each driver is connected to a Bus_Record ( lgfx/v1/misc/Bus_Record.hpp )
+// instead of a real SPI / I2C / parallel bus. For every scene the bytes sent
+// as commands and as data, the number of transactions, the transfer time
+// modeled for the bus clock, and the host CPU time of the driver are
+// reported. Where a controller model exists the controller memory is kept
+// up to date and compared with the same scene drawn into a sprite ( or, for
+// the 1bpp OLED which dithers, with the frame buffer of the driver ), on the
+// bits per channel the panel shows; a mismatch makes the exit code 1.
+// Pass a directory as the first argument to also write the memory out as
+// PNG images ( <dir>/<driver>_<scene>.png ).
+// For the M5HDMI ( AtomDisplay / ModuleDisplay ) driver the FPGA model also
+// lists the commands of every frame by opcode, with the pixels sent raw and
+// RLE compressed ( Panel_M5HDMI::setRLE ).
+
+#include <lgfx/v1/misc/Bus_Record.hpp>
+#include <lgfx/v1/misc/BusController.hpp>
+#include <lgfx/v1/panel/Panel_ST7789.hpp>
+#include <lgfx/v1/panel/Panel_ILI9342.hpp>
+#include <lgfx/v1/panel/Panel_SSD1306.hpp>
+#include <lgfx/v1/panel/Panel_M5UnitLCD.hpp>
+#include <lgfx/v1/panel/Panel_M5HDMI.hpp>
+#include <lgfx/v1/panel/Panel_IT8951.hpp>
+#include <lgfx/v1/LGFXBase.hpp>
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include "../bench_common.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  /// Answers the identification and buffer queries of the UnitLCD firmware, so that its driver runs.
+  /// The pixels are not decoded.
+  struct UnitLCD_stub_t : public IBusController
+  {
+    uint8_t last_cmd = 0;
+    void write(const uint8_t* data, uint32_t, bool) override { last_cmd = data[0]; }
+    void read(uint8_t* dst, uint32_t length) override
+    {
+      static constexpr uint8_t id[4] = { 0x77, 0x89, 0x00, 0x00 };
+      for (uint32_t i = 0; i < length; ++i)
+      {
+        dst[i] = (last_cmd == 0x04) ? id[i & 3] : 0xFF;  // CMD_READ_ID, or free space of the command buffer
+      }
+    }
+  };
+
+  struct scene_t
+  {
+    const char* name;
+    void (*draw)(LovyanGFX& gfx);
+  };
+
+  static int error_count = 0;
+  static std::vector<uint16_t> image;
+  static LGFX_Sprite canvas;
+
+  static void draw_ui(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    gfx.fillScreen(TFT_BLACK);
+    gfx.fillRect(0, 0, w, h / 8, TFT_DARKGREY);
+    gfx.setTextColor(TFT_WHITE, TFT_DARKGREY);
+    gfx.drawString("Settings", 4, 2);
+    gfx.setTextColor(TFT_WHITE, TFT_BLACK);
+    for (int32_t i = 0; i < 4; ++i)
+    {
+      int32_t y = h / 8 + 4 + i * (h / 5);
+      gfx.fillRoundRect(4, y, w - 8, h / 6, 6, i & 1 ? TFT_BLUE : TFT_DARKGREEN);
+      gfx.drawString("item", 10, y + 4);
+    }
+  }
+
+  static const scene_t scenes[] =
+  {
+    { "fill", [](LovyanGFX& gfx)
+      {
+        gfx.fillScreen(TFT_NAVY);
+      }
+    },
+    { "ui", [](LovyanGFX& gfx)
+      {
+        draw_ui(gfx);
+      }
+    },
+    { "sprite", [](LovyanGFX& gfx)
+      { // the same screen drawn off-screen and pushed as one image.
+        if (canvas.width() != gfx.width() || canvas.height() != gfx.height())
+        {
+          canvas.setColorDepth(16);
+          canvas.createSprite(gfx.width(), gfx.height());
+        }
+        draw_ui(canvas);
+        canvas.pushSprite(&gfx, 0, 0);
+      }
+    },
+    { "image", [](LovyanGFX& gfx)
+      {
+        int32_t w = gfx.width();
+        int32_t h = gfx.height();
+        gfx.pushImage(0, 0, w, h, image.data());
+      }
+    },
+  };
+
+  struct result_t
+  {
+    Bus_Record::stats_t stats;
+    double modeled_us;
+    double host_us;
+  };
+
+  static void print_commands(const BusController_M5HDMI::stats_t& s)
+  {
+    for (int i = 0; i < 256; ++i)
+    {
+      if (s.count[i] == 0) { continue; }
+      printf("    %-16s %8u cmds %10llu B\n", BusController_M5HDMI::getCommandName(i), s.count[i], (unsigned long long)s.bytes[i]);
+    }
+  }
+
+  /// Compares the controller memory with the scene drawn into a sprite of the same color depth,
+  /// or with the frame buffer of the driver when from_panel is set, on the top `bits` of each channel.
+  static bool check(LGFX_Device& gfx, const BusController_RAM& ctrl, const scene_t& scene, uint_fast8_t bits, bool from_panel)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    if (w > ctrl.width() || h > ctrl.height()) { return false; }
+
+    static LGFX_Sprite ref;
+    LovyanGFX* src = &gfx;
+    if (!from_panel)
+    {
+      ref.setColorDepth(gfx.getColorDepth());
+      if (!ref.createSprite(w, h)) { return false; }
+      scene.draw(ref);
+      src = &ref;
+    }
+
+    uint8_t mask = 0xFF << (8 - bits);
+    std::vector<uint8_t> expect(w * 3);
+    std::vector<uint8_t> actual(ctrl.width() * 3);
+    for (int32_t y = 0; y < h; ++y)
+    {
+      src->readRectRGB(0, y, w, 1, expect.data());
+      ctrl.readRow(y, actual.data());
+      for (int32_t i = 0; i < w * 3; ++i)
+      {
+        if ((expect[i] ^ actual[i]) & mask) { return false; }
+      }
+    }
+    return true;
+  }
+
+  /// bits : bits per channel shown by the panel, compared with the reference.
+  /// from_panel : the reference is read from the frame buffer of the driver.
+  static void run(const char* name, LGFX_Device& gfx, Bus_Record& bus, const BusController_RAM* ctrl, uint_fast8_t bits, bool from_panel, const char* png_dir, BusController_M5HDMI* hdmi = nullptr)
+  {
+    if (!gfx.init())
+    {
+      printf("%-24s init failed\n", name);
+      ++error_count;
+      return;
+    }
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    image.resize(w * h);
+    for (int32_t y = 0; y < h; ++y)
+    {
+      for (int32_t x = 0; x < w; ++x)
+      {
+        image[x + y * w] = lgfx::color565(x * 255 / w, y * 255 / h, (x ^ y) & 0xFF);
+      }
+    }
+
+    for (auto& scene : scenes)
+    {
+      bus.resetStats();
+      bus.clearTrace();
+      if (hdmi) { hdmi->endFrame(); }
+      uint64_t start = bench::micros();
+      gfx.startWrite();
+      scene.draw(gfx);
+      gfx.endWrite();
+      gfx.display();
+      double host_us = bench::micros() - start;
+
+      auto& s = bus.getStats();
+      const char* result = "-";
+      if (ctrl)
+      {
+        bool ok = check(gfx, *ctrl, scene, bits, from_panel);
+        if (!ok) { ++error_count; }
+        result = ok ? "ok" : "MISMATCH";
+      }
+      printf("%-24s %-6s %8u %10u %6u %10.2f %9.0f  %s\n"
+            , name, scene.name
+            , (uint32_t)s.command_bytes, (uint32_t)s.data_bytes, s.transactions
+            , bus.getModeledMicros() / 1000.0, host_us, result);
+      if (hdmi)
+      {
+        hdmi->endFrame();
+        print_commands(hdmi->getFrameStats());
+      }
+
+      if (ctrl && png_dir)
+      {
+        size_t len;
+        void* png = ctrl->createPng(&len);
+        std::string path = std::string(png_dir) + "/" + name + "_" + scene.name + ".png";
+        FILE* fp = fopen(path.c_str(), "wb");
+        if (fp) { fwrite(png, 1, len, fp); fclose(fp); }
+        free(png);
+      }
+    }
+  }
+
+  /// Panel_IT8951 with its CS line forwarded to the controller model, which needs it to find the frames.
+  struct Panel_IT8951_model_t : public Panel_IT8951
+  {
+    BusController_IT8951* ctrl = nullptr;
+
+  protected:
+    void cs_control(bool level) override
+    {
+      Panel_IT8951::cs_control(level);
+      if (ctrl) { ctrl->setCS(level); }
+    }
+  };
+
+  struct epd_scene_t
+  {
+    const char* name;
+    void (*draw)(LGFX_Device& gfx);
+    bool fastest;  // draws with epd_fastest, which loads over running refreshes without waiting
+  };
+
+  static void draw_button(LGFX_Device& gfx, int32_t i, bool pressed)
+  {
+    int32_t x = 20 + (i % 4) * 130;
+    int32_t y = 40 + (i / 4) * 90;
+    gfx.fillRoundRect(x, y, 120, 80, 8, pressed ? TFT_BLACK : TFT_WHITE);
+    gfx.drawRoundRect(x, y, 120, 80, 8, TFT_BLACK);
+    gfx.setTextColor(pressed ? TFT_WHITE : TFT_BLACK);
+    gfx.drawNumber(i, x + 10, y + 10);
+    gfx.display(x, y, 120, 80);
+  }
+
+  static const epd_scene_t epd_scenes[] =
+  {
+    { "widgets", [](LGFX_Device& gfx)
+      { // buttons pressed and released, each shown at once, as a touch UI does.
+        gfx.setEpdMode(epd_mode_t::epd_fast);
+        for (int32_t i = 0; i < 12; ++i)
+        {
+          draw_button(gfx, i, true);
+          draw_button(gfx, i, false);
+        }
+      }, false
+    },
+    { "photo", [](LGFX_Device& gfx)
+      { // a photo, then a caption over it while the photo is still refreshing.
+        int32_t w = gfx.width();
+        int32_t h = gfx.height();
+        gfx.setEpdMode(epd_mode_t::epd_quality);
+        gfx.pushImage(0, 0, w, h, image.data());
+        gfx.display();
+        gfx.setEpdMode(epd_mode_t::epd_text);
+        gfx.fillRect(0, h - 40, w, 40, TFT_WHITE);
+        gfx.setTextColor(TFT_BLACK);
+        gfx.drawString("caption", 8, h - 32);
+        gfx.display();
+      }, false
+    },
+    { "random", [](LGFX_Device& gfx)
+      { // rectangles anywhere in any mode, each shown at once.
+        static constexpr epd_mode_t modes[] = { epd_mode_t::epd_quality, epd_mode_t::epd_text, epd_mode_t::epd_fast };
+        srand(1);
+        for (int32_t i = 0; i < 200; ++i)
+        {
+          int32_t w = 8 + rand() % 200;
+          int32_t h = 8 + rand() % 200;
+          int32_t x = rand() % (gfx.width()  - w);
+          int32_t y = rand() % (gfx.height() - h);
+          gfx.setEpdMode(modes[rand() % 3]);
+          gfx.fillRect(x, y, w, h, rand() & 1 ? TFT_BLACK : TFT_LIGHTGREY);
+          gfx.display();
+        }
+      }, false
+    },
+    { "fastest", [](LGFX_Device& gfx)
+      { // a pointer trail drawn with epd_fastest.
+        gfx.setEpdMode(epd_mode_t::epd_fastest);
+        for (int32_t i = 0; i < 100; ++i)
+        {
+          gfx.fillCircle(40 + i * 4, 100 + (i & 15) * 8, 6, TFT_BLACK);
+          gfx.display();
+        }
+      }, true
+    },
+  };
+
+  /// Every write path of Panel_IT8951: fills, pixels, images with and without transparency, writePixels and text.
+  static void draw_epd_pixels(LovyanGFX& gfx)
+  {
+    static std::vector<uint16_t> transp_image;
+    static constexpr uint16_t transp = 0x1234;
+    if (transp_image.empty())
+    {
+      transp_image.resize(97 * 61);
+      for (size_t i = 0; i < transp_image.size(); ++i)
+      {
+        transp_image[i] = (i / 7) % 3 ? image[i] : transp;
+      }
+    }
+    gfx.fillScreen(TFT_WHITE);
+    gfx.pushImage(13, 7, 301, 203, image.data());  // starts and ends in the middle of a group of 4 pixels
+    gfx.pushImage(330, 21, 97, 61, transp_image.data(), transp);
+    for (int32_t i = 0; i < 16; ++i)
+    {
+      gfx.fillRect(5 + i * 33, 230, 31, 45, lgfx::color888(i * 17, i * 17, i * 17));
+    }
+    for (int32_t i = 0; i < 64; ++i)
+    {
+      gfx.drawPixel(400 + (i & 7) * 3, 300 + (i >> 3) * 3, image[i * 97]);
+    }
+    gfx.setAddrWindow(441, 311, 37, 29);
+    gfx.writePixels(image.data(), 37 * 29);
+    gfx.setTextColor(TFT_BLACK, TFT_LIGHTGREY);
+    gfx.setTextSize(3);
+    gfx.drawString("IT8951", 21, 300);
+    gfx.setTextSize(1);
+  }
+
+  /// Compares what the IT8951 model shows, and what the driver reads back, with the scene drawn into a sprite
+  /// and dithered to 4bpp the way the driver does ( Bayer 4x4, binary in epd_fast / epd_fastest ).
+  /// The dither pattern runs in load coordinates, which are the rotated coordinates flipped vertically
+  /// for rotations 4 to 7; the IT8951 itself turns the loads in steps of 90 degrees into its memory.
+  static bool check_epd_pixels(LGFX_Device& gfx, const BusController_IT8951& ctrl, uint_fast8_t offset_rotation)
+  {
+    static constexpr int8_t bayer[16] = { -30, 2, -22, 10, 18, -14, 26, -6, -18, 14, -26, 6, 30, -2, 22, -10 };
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    uint_fast8_t r = gfx.getRotation();
+    // the same as Panel_IT8951::setRotation.
+    uint_fast8_t internal = ((r + offset_rotation) & 3) | ((r & 4) ^ (offset_rotation & 4));
+    uint_fast8_t rotation = ((-internal) & 3) | (internal & 4);
+    bool binary = gfx.getEpdMode() == epd_mode_t::epd_fast || gfx.getEpdMode() == epd_mode_t::epd_fastest;
+    int32_t pw = ctrl.width();
+    int32_t ph = ctrl.height();
+
+    static LGFX_Sprite ref;
+    ref.setColorDepth(24);
+    if (!ref.createSprite(w, h)) { return false; }
+    draw_epd_pixels(ref);
+
+    std::vector<uint8_t> expect(w * 3);
+    std::vector<uint8_t> readback(w * 3);
+    std::vector<uint8_t> shown(pw * ph * 3);
+    for (int32_t y = 0; y < ph; ++y) { ctrl.readRow(y, &shown[y * pw * 3]); }
+
+    for (int32_t y = 0; y < h; ++y)
+    {
+      ref.readRectRGB(0, y, w, 1, expect.data());
+      gfx.readRectRGB(0, y, w, 1, readback.data());
+      int32_t ly = (rotation & 4) ? h - 1 - y : y;
+      for (int32_t x = 0; x < w; ++x)
+      {
+        int32_t sum = expect[x * 3] + (expect[x * 3 + 1] << 1) + expect[x * 3 + 2];
+        int32_t t = bayer[((ly & 3) << 2) | (x & 3)];
+        int32_t v = binary ? (sum + t * 16 < 512 ? 0 : 15)
+                           : std::min<int32_t>(15, std::max<int32_t>(0, sum + t) >> 6);
+        int32_t mx, my;
+        switch (rotation & 3)
+        {
+        default: mx = x;          my = ly;          break;
+        case 1:  mx = ly;         my = ph - 1 - x;  break;
+        case 2:  mx = pw - 1 - x; my = ph - 1 - ly; break;
+        case 3:  mx = pw - 1 - ly; my = x;          break;
+        }
+        if (shown[(mx + my * pw) * 3] >> 4 != v) { return false; }
+        if (readback[x * 3] >> 4 != v) { return false; }
+      }
+    }
+    return true;
+  }
+
+  /// Runs the scenes on the IT8951 model and checks the scheduling of the refreshes:
+  /// no refresh started over one still running, no load over a running refresh ( except with epd_fastest ),
+  /// everything drawn shown after waitDisplay and after setSleep / setPowerSave, and no protocol errors.
+  static void run_it8951(const char* name, LGFX_Device& gfx, Bus_Record& bus, BusController_IT8951& ctrl, uint_fast8_t offset_rotation)
+  {
+    if (!gfx.init())
+    {
+      printf("%-16s init failed\n", name);
+      ++error_count;
+      return;
+    }
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    image.resize(w * h);
+    for (int32_t y = 0; y < h; ++y)
+    {
+      for (int32_t x = 0; x < w; ++x)
+      {
+        image[x + y * w] = lgfx::color565(x * 255 / w, y * 255 / h, (x ^ y) & 0xFF);
+      }
+    }
+
+    printf("%-16s %-8s %5s %5s %5s %5s %5s %9s %6s %6s %7s %7s %6s  %s\n"
+          , "driver", "scene", "loads", "DU", "GC16", "GL16", "DU4", "refr Mpx", "polls", "overl", "ld.conf", "undisp", "bus ms", "result");
+    for (auto& scene : epd_scenes)
+    {
+      gfx.waitDisplay();
+      bus.resetStats();
+      ctrl.resetStats();
+      gfx.startWrite();
+      scene.draw(gfx);
+      gfx.endWrite();
+      // the last display() may still be queued; waitDisplay sends it.
+      gfx.waitDisplay();
+
+      auto& s = ctrl.getStats();
+      uint32_t undisplayed = ctrl.getUndisplayedPixels();
+      bool ok = s.errors == 0 && s.overlaps == 0 && undisplayed == 0
+             && (scene.fastest || s.load_conflicts == 0);
+      if (!ok) { ++error_count; }
+      printf("%-16s %-8s %5u %5u %5u %5u %5u %9.2f %6u %6u %7u %7u %6.0f  %s\n"
+            , name, scene.name, s.loads
+            , s.mode_refreshes[1], s.mode_refreshes[2], s.mode_refreshes[3], s.mode_refreshes[6]
+            , s.refresh_pixels / 1000000.0, s.lutafsr_reads, s.overlaps, s.load_conflicts, undisplayed
+            , bus.getModeledMicros() / 1000.0, ok ? "ok" : "FAIL");
+    }
+
+    // the pixels of every write path, in every rotation and EPD mode.
+    static constexpr epd_mode_t modes[] = { epd_mode_t::epd_quality, epd_mode_t::epd_text, epd_mode_t::epd_fast, epd_mode_t::epd_fastest };
+    printf("%-16s %-8s %-8s %-8s %-8s %-8s\n", "", "rotation", "quality", "text", "fast", "fastest");
+    for (uint_fast8_t r = 0; r < 8; ++r)
+    {
+      gfx.setRotation(r);
+      printf("%-16s %-8u", name, r);
+      for (auto mode : modes)
+      {
+        gfx.setEpdMode(mode);
+        gfx.startWrite();
+        draw_epd_pixels(gfx);
+        gfx.endWrite();
+        gfx.waitDisplay();
+        bool ok = check_epd_pixels(gfx, ctrl, offset_rotation) && ctrl.getStats().errors == 0;
+        if (!ok) { ++error_count; }
+        printf(" %-8s", ok ? "ok" : "MISMATCH");
+      }
+      printf("\n");
+    }
+    gfx.setRotation(0);
+
+    // sleep and power save must not cut a refresh short, nor leave the last display() unsent.
+    for (int i = 0; i < 2; ++i)
+    {
+      ctrl.resetStats();
+      gfx.setEpdMode(epd_mode_t::epd_quality);
+      gfx.fillRect(100, 100, 200, 200, i ? TFT_DARKGREY : TFT_BLACK);
+      gfx.display();
+      gfx.fillRect(200, 200, 200, 200, TFT_WHITE);
+      gfx.display();
+      if (i) { gfx.powerSave(true); }
+      else   { gfx.sleep(); }
+      uint32_t undisplayed = ctrl.getUndisplayedPixels();
+      bool ok = ctrl.getStats().errors == 0 && undisplayed == 0 && ctrl.isSleeping();
+      if (!ok) { ++error_count; }
+      printf("%-16s %-8s %56s %7u %6s  %s\n", name, i ? "pwrsave" : "sleep", "", undisplayed, "", ok ? "ok" : "FAIL");
+      if (i) { gfx.powerSave(false); }
+      else   { gfx.wakeup(); }
+    }
+  }
+
+  static void set_bus(Bus_Record& bus, bus_type_t type, uint32_t freq, uint8_t prefix_len = 1)
+  {
+    auto cfg = bus.config();
+    cfg.bus_type = type;
+    cfg.freq_write = freq;
+    cfg.prefix_len = prefix_len;
+    cfg.trace_limit = 0;
+    bus.config(cfg);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  const char* png_dir = argc > 1 ? argv[1] : nullptr;
+
+  printf("%-24s %-6s %8s %10s %6s %10s %9s  %s\n", "driver", "scene", "cmd B", "data B", "trans", "bus ms", "host us", "memory");
+
+  for (int depth : { 16, 24 })
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_spi, 40000000);
+    BusController_MIPI ctrl;
+    auto ccfg = ctrl.config();
+    ccfg.invert = true;
+    ctrl.config(ccfg);
+    bus.setController(&ctrl);
+
+    Panel_ST7789 panel;
+    auto pcfg = panel.config();
+    pcfg.invert = true;
+    panel.config(pcfg);
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    gfx.setColorDepth(depth);
+    // 24bit is sent as RGB666.
+    run(depth == 16 ? "ST7789_SPI40M_16bit" : "ST7789_SPI40M_24bit", gfx, bus, &ctrl, depth == 16 ? 5 : 6, false, png_dir);
+  }
+
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_parallel8, 20000000);
+    BusController_MIPI ctrl;
+    auto ccfg = ctrl.config();
+    ccfg.memory_width  = 320;
+    ccfg.memory_height = 240;
+    ctrl.config(ccfg);
+    bus.setController(&ctrl);
+
+    Panel_ILI9342 panel;
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    run("ILI9342_P8_20M", gfx, bus, &ctrl, 5, false, png_dir);
+  }
+
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_spi, 80000000);
+    BusController_M5HDMI ctrl;
+    bus.setController(&ctrl);
+
+    Panel_M5HDMI panel;
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    run("M5HDMI_SPI80M_1280x720", gfx, bus, &ctrl, 5, false, png_dir, &ctrl);
+    panel.setRLE(true);
+    run("M5HDMI_SPI80M_RLE", gfx, bus, &ctrl, 5, false, png_dir, &ctrl);
+  }
+
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_i2c, 400000);
+    BusController_SSD1306 ctrl(128, 64);
+    bus.setController(&ctrl);
+
+    Panel_SSD1306 panel;
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    run("SSD1306_I2C400k", gfx, bus, &ctrl, 1, true, png_dir);
+  }
+
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_i2c, 400000, 0);
+    UnitLCD_stub_t stub;
+    bus.setController(&stub);
+
+    Panel_M5UnitLCD panel;
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    run("UnitLCD_I2C400k", gfx, bus, nullptr, 0, false, png_dir);
+  }
+
+  {
+    Bus_Record bus;
+    set_bus(bus, bus_type_t::bus_spi, 40000000);
+    BusController_IT8951 ctrl;
+    bus.setController(&ctrl);
+
+    // M5Paper, with the busy line unconnected: the model answers at once.
+    Panel_IT8951_model_t panel;
+    panel.ctrl = &ctrl;
+    auto pcfg = panel.config();
+    pcfg.panel_width  = 960;
+    pcfg.panel_height = 540;
+    pcfg.offset_rotation = 3;
+    pcfg.pin_busy = -1;
+    panel.config(pcfg);
+    panel.setBus(&bus);
+    LGFX_Device gfx;
+    gfx.setPanel(&panel);
+    printf("\n");
+    run_it8951("IT8951_SPI40M", gfx, bus, ctrl, pcfg.offset_rotation);
+  }
+
+  return error_count ? 1 : 0;
+}
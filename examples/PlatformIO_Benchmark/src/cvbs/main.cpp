@@ -0,0 +1,293 @@
+// Host benchmark of the composite video encoder of Panel_CVBS ( lgfx/v1/misc/CVBS_Encoder.hpp ).
+//
+// On the ESP32 the I2S interrupt has to write the next scanline while the DMA
+// sends the other line buffer, so each call of CVBS_Encoder::writeScanline
+// must finish within one line period or the picture tears. For every signal
+// type, color depth and one resolution per blit kernel ( x1.0 .. x6.0 ), a
+// test picture is encoded for a number of frames and the time spent on the
+// active lines is reported against the line period. The numbers are for the
+// C++ kernels on this machine; the ESP32 build uses the Xtensa versions, so
+// compare the ratios between the rows rather than the absolute headroom.
+//
+// Each frame is also checked: every scanline has to start with a sync pulse,
+// and the black and white halves of a grayscale picture have to come out at
+// the black and white levels.
+//
+// Pass a file name to write the encoded signal instead, as 8 bit unsigned
+// mono WAV at 4x the color subcarrier ( *.wav ) or as raw DAC samples:
+//   program out.wav [ntsc|ntsc_j|pal|pal_m|pal_n] [frames]
+
+#include <lgfx/v1/misc/CVBS_Encoder.hpp>
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include "../bench_common.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  struct signal_t
+  {
+    const char* name;
+    CVBS_Encoder::signal_type_t type;
+  };
+
+  static constexpr signal_t signals[] =
+  { { "ntsc"  , CVBS_Encoder::NTSC   }
+  , { "ntsc_j", CVBS_Encoder::NTSC_J }
+  , { "pal"   , CVBS_Encoder::PAL    }
+  , { "pal_m" , CVBS_Encoder::PAL_M  }
+  , { "pal_n" , CVBS_Encoder::PAL_N  }
+  };
+
+  struct depth_t
+  {
+    const char* name;
+    color_depth_t depth;
+  };
+
+  static constexpr depth_t depths[] =
+  { { "rgb332", rgb332_1Byte   }
+  , { "rgb565", rgb565_2Byte   }
+  , { "gray8" , grayscale_8bit }
+  };
+
+  // output width = display width / scale ; one per blit kernel.
+  static constexpr float scales[] = { 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 5.0f };
+
+  static int error_count = 0;
+
+  static void draw_picture(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    static constexpr uint32_t bars[] = { 0xFFFFFFu, 0xFFFF00u, 0x00FFFFu, 0x00FF00u, 0xFF00FFu, 0xFF0000u, 0x0000FFu, 0x000000u };
+    for (int32_t i = 0; i < 8; ++i)
+    {
+      gfx.fillRect(i * w / 8, 0, (i + 1) * w / 8 - i * w / 8, h * 2 / 3, bars[i]);
+    }
+    for (int32_t x = 0; x < w; ++x)
+    {
+      uint8_t v = x * 255 / (w - 1);
+      gfx.drawFastVLine(x, h * 2 / 3, h - h * 2 / 3, gfx.color888(v, v, v));
+    }
+    gfx.setTextColor(TFT_BLACK);
+    gfx.drawCenterString("M5GFX CVBS", w >> 1, h >> 2);
+  }
+
+  struct frame_t
+  {
+    LGFX_Sprite sprite;
+    std::vector<const uint8_t*> lines;
+
+    bool create(int32_t w, int32_t h, color_depth_t depth)
+    {
+      sprite.setColorDepth(depth);
+      if (!sprite.createSprite(w, h)) { return false; }
+      lines.resize(h);
+      size_t stride = w * ((depth & color_depth_t::bit_mask) >> 3);
+      for (int32_t y = 0; y < h; ++y)
+      {
+        lines[y] = (const uint8_t*)sprite.getBuffer() + y * stride;
+      }
+      return true;
+    }
+  };
+
+  static bool init_encoder(CVBS_Encoder& encoder, CVBS_Encoder::signal_type_t type, color_depth_t depth, int32_t w, int32_t h)
+  {
+    CVBS_Encoder::config_t cfg;
+    cfg.signal_type = type;
+    cfg.color_depth = depth;
+    cfg.memory_width  = cfg.panel_width  = w;
+    cfg.memory_height = cfg.panel_height = h;
+    return encoder.init(cfg);
+  }
+
+  /// Every scanline of the frame has to start with a sync pulse of at least the equalizing pulse width.
+  static bool check_sync(const uint8_t* frame, const CVBS_Encoder::signal_spec_t& spec)
+  {
+    for (size_t y = 0; y < spec.total_scanlines; ++y)
+    {
+      auto line = &frame[y * spec.scanline_width];
+      for (size_t x = 0; x < spec.hsync_equalizing; ++x)
+      {
+        if (line[x] != 0) { return false; }
+      }
+    }
+    return true;
+  }
+
+  /// With a black left half and a white right half in the frame buffer, every
+  /// displayed scanline has to be dark at 1/4 and bright at 3/4 of the picture.
+  static bool check_levels(const uint8_t* frame, const CVBS_Encoder::signal_spec_t& spec)
+  {
+    uint32_t picture_lines = 0;
+    size_t active_w = spec.display_width;  // 1 sample per pixel at the full width.
+    size_t left  = spec.active_start + active_w / 4;
+    size_t right = spec.active_start + active_w * 3 / 4;
+    for (size_t y = 0; y < spec.total_scanlines; ++y)
+    {
+      auto line = &frame[y * spec.scanline_width];
+      if (line[right] > line[left] + 48) { ++picture_lines; }
+    }
+    return picture_lines + 2 >= spec.display_height && picture_lines <= spec.display_height;
+  }
+
+  static void run_bench(const signal_t& sig, const depth_t& dep, float scale)
+  {
+    const auto& spec = CVBS_Encoder::getSignalSpec(sig.type);
+    int32_t w = ((int32_t)(spec.display_width / scale)) & ~3;
+    int32_t h = (int32_t)(spec.display_height / scale);
+
+    frame_t fb;
+    CVBS_Encoder encoder;
+    if (!fb.create(w, h, dep.depth) || !init_encoder(encoder, sig.type, dep.depth, w, h))
+    {
+      printf("init %d x %d failed\n", w, h);
+      ++error_count;
+      return;
+    }
+    encoder.setLines(fb.lines.data());
+
+    std::vector<uint8_t> frame(spec.total_scanlines * spec.scanline_width);
+    fb.sprite.fillScreen(TFT_BLACK);
+    fb.sprite.fillRect(w >> 1, 0, w >> 1, h, TFT_WHITE);
+    encoder.renderFrame(frame.data());
+    bool ok = check_sync(frame.data(), spec) && check_levels(frame.data(), spec);
+
+    // time each scanline the way the I2S interrupt calls it, and keep the
+    // fastest of all frames per scanline so that preemption of this process
+    // does not show up as the worst case.
+    draw_picture(fb.sprite);
+    static constexpr int frames = 16;
+    std::vector<uint16_t> bufs(spec.scanline_width * CVBS_Encoder::line_buffers);
+    std::vector<double> best(spec.total_scanlines, 1e9);
+    std::vector<bool> active(spec.total_scanlines);
+    for (int f = 0; f < frames; ++f)
+    {
+      for (size_t y = 0; y < spec.total_scanlines; ++y)
+      {
+        auto buf = &bufs[(y % CVBS_Encoder::line_buffers) * spec.scanline_width];
+        auto t0 = std::chrono::steady_clock::now();
+        encoder.writeScanline(buf);
+        auto t1 = std::chrono::steady_clock::now();
+        best[y] = std::min(best[y], std::chrono::duration<double, std::micro>(t1 - t0).count());
+        int32_t line = encoder.getFieldLine();
+        active[y] = line >= 0 && (uint32_t)encoder.scanlineToY(line, encoder.isOddField()) < (uint32_t)h;
+      }
+    }
+    double active_sum = 0, active_max = 0, other_sum = 0;
+    uint32_t active_count = 0;
+    for (size_t y = 0; y < spec.total_scanlines; ++y)
+    {
+      if (active[y])
+      {
+        active_sum += best[y];
+        active_max = std::max(active_max, best[y]);
+        ++active_count;
+      }
+      else
+      {
+        other_sum += best[y];
+      }
+    }
+    uint32_t other_count = spec.total_scanlines - active_count;
+    double period = spec.scanline_width * 1000000.0 / encoder.getSampleRate();
+    double active_avg = active_count ? active_sum / active_count : 0;
+    double other_avg = other_count ? other_sum / other_count : 0;
+    printf("%-6s %-6s %4d x %-4d x%3.1f  %7.3f %7.3f %7.3f  %6.2f  %5.1f%%  %6.1f%%  %s\n"
+          , sig.name, dep.name, w, h, spec.display_width / (float)w
+          , active_avg, active_max, other_avg, period
+          , active_avg * 100.0 / period, (period - active_max) * 100.0 / period
+          , ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+
+  static void put_le(FILE* fp, uint32_t value, int bytes)
+  {
+    for (int i = 0; i < bytes; ++i) { fputc((value >> (i * 8)) & 0xFF, fp); }
+  }
+
+  static int write_signal(const char* path, const signal_t& sig, int frames)
+  {
+    const auto& spec = CVBS_Encoder::getSignalSpec(sig.type);
+    int32_t w = spec.display_width >> 1;
+    int32_t h = spec.display_height >> 1;
+    frame_t fb;
+    CVBS_Encoder encoder;
+    if (!fb.create(w, h, rgb565_2Byte) || !init_encoder(encoder, sig.type, rgb565_2Byte, w, h)) { return 1; }
+    draw_picture(fb.sprite);
+    encoder.setLines(fb.lines.data());
+
+    FILE* fp = fopen(path, "wb");
+    if (fp == nullptr) { printf("can not write %s\n", path); return 1; }
+
+    size_t frame_len = spec.total_scanlines * spec.scanline_width;
+    uint32_t data_len = frame_len * frames;
+    std::string name = path;
+    bool wav = name.size() > 4 && name.compare(name.size() - 4, 4, ".wav") == 0;
+    if (wav)
+    {
+      uint32_t rate = encoder.getSampleRate();
+      fwrite("RIFF", 1, 4, fp); put_le(fp, 36 + data_len, 4);
+      fwrite("WAVE", 1, 4, fp);
+      fwrite("fmt ", 1, 4, fp); put_le(fp, 16, 4);
+      put_le(fp, 1, 2);     // PCM
+      put_le(fp, 1, 2);     // mono
+      put_le(fp, rate, 4);
+      put_le(fp, rate, 4);  // bytes per second
+      put_le(fp, 1, 2);     // block align
+      put_le(fp, 8, 2);     // bits per sample ( unsigned )
+      fwrite("data", 1, 4, fp); put_le(fp, data_len, 4);
+    }
+
+    std::vector<uint8_t> frame(frame_len);
+    for (int f = 0; f < frames; ++f)
+    {
+      encoder.renderFrame(frame.data());
+      fwrite(frame.data(), 1, frame_len, fp);
+    }
+    fclose(fp);
+    printf("%s: %s %d x %d, %d frames of %u x %u samples at %u Hz\n", path, sig.name, w, h, frames, spec.total_scanlines, spec.scanline_width, encoder.getSampleRate());
+    return 0;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1)
+  {
+    const signal_t* sig = &signals[0];
+    if (argc > 2)
+    {
+      sig = nullptr;
+      for (auto& s : signals) { if (strcmp(argv[2], s.name) == 0) { sig = &s; } }
+      if (sig == nullptr) { printf("unknown signal type %s\n", argv[2]); return 1; }
+    }
+    int frames = argc > 3 ? atoi(argv[3]) : 30;
+    return write_signal(argv[1], *sig, frames < 1 ? 1 : frames);
+  }
+
+  printf("active = time per displayed scanline, blank = other scanlines, period = line period,\n"
+         "load = active / period, headroom = ( period - worst active ) / period  [us]\n\n");
+  printf("signal depth  size          scale  active   worst   blank  period    load  headroom\n");
+  for (auto& sig : signals)
+  {
+    if (sig.type == CVBS_Encoder::NTSC_J) { continue; } // same timing as NTSC
+    for (auto& dep : depths)
+    {
+      for (auto scale : scales)
+      {
+        run_bench(sig, dep, scale);
+      }
+    }
+  }
+  return error_count ? 1 : 0;
+}
@@ -0,0 +1,236 @@
+// Host benchmark of drawPngFile / drawQoiFile / drawBmpFile and VLW glyphs read through a BufferedDataWrapper.
+//
+// The files are read through a wrapper that counts the calls which reach the file
+// and the preRead / postRead pairs, which on a panel sharing its bus with the SD card
+// each end and begin a transaction. Unbuffered, every small read of a decoder is a
+// file call and a bus handoff; buffered, only every block is.
+// Every picture is compared with the one drawn without a buffer.
+
+#include "../bench_common.hpp"
+
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  static int error_count = 0;
+
+  static constexpr int32_t screen_w = 320;
+  static constexpr int32_t screen_h = 240;
+
+  static uint32_t handoffs = 0;
+  static void count_handoff(LGFXBase*) { ++handoffs; }
+
+  /// file wrapper that counts the calls reaching the file.
+  struct CountingFile : public DataWrapperT<FILE>
+  {
+    CountingFile(void)
+    { // what prepareTmpTransaction sets on a panel that shares its bus.
+      fp_pre_read = count_handoff;
+    }
+    int read(uint8_t* buf, uint32_t len) override { ++calls; return DataWrapperT<FILE>::read(buf, len); }
+    bool seek(uint32_t offset) override { ++calls; return DataWrapperT<FILE>::seek(offset); }
+    void skip(int32_t offset) override { ++calls; DataWrapperT<FILE>::seek(offset, SEEK_CUR); }
+    uint32_t calls = 0;
+  };
+
+  /// photo like picture: gradients and noise, so that the files are not tiny.
+  static void draw_picture(LovyanGFX& gfx)
+  {
+    bench::xorshift32_t rng;
+    for (int32_t y = 0; y < gfx.height(); ++y)
+    {
+      for (int32_t x = 0; x < gfx.width(); ++x)
+      {
+        uint32_t n = rng.next() >> 28;
+        gfx.writePixel(x, y, gfx.color888(x * 255 / gfx.width() + n, y * 255 / gfx.height() + n, 128 + 100 * sinf(x * 0.05f) + n));
+      }
+    }
+    gfx.fillRoundRect(40, 40, 120, 80, 12, TFT_WHITE);
+    gfx.drawString("BufferedDataWrapper", 50, 70);
+  }
+
+  struct file_t
+  {
+    const char* ext;
+    std::string path;
+  };
+
+  static bool make_files(std::vector<file_t>& files)
+  {
+    LGFX_Sprite sprite;
+    sprite.setColorDepth(24);
+    sprite.createSprite(screen_w, screen_h);
+    draw_picture(sprite);
+    for (auto& f : files)
+    {
+      f.path = std::string("filebuffer.") + f.ext;
+      auto fp = fopen(f.path.c_str(), "wb");
+      if (fp == nullptr) { return false; }
+      DataWrapperT<FILE> file(fp);
+      size_t len = (f.ext[0] == 'q') ? sprite.writeQoi(&file)
+                 : (f.ext[0] == 'b') ? sprite.writeBmp(&file)
+                 :                     sprite.writePng(&file);
+      file.close();
+      if (len == 0) { return false; }
+    }
+    return true;
+  }
+
+  static bool draw(LovyanGFX& gfx, const file_t& f, DataWrapper* data)
+  {
+    switch (f.ext[0])
+    {
+    case 'q': return gfx.drawQoiFile(data, f.path.c_str());
+    case 'b': return gfx.drawBmpFile(data, f.path.c_str());
+    default:  return gfx.drawPngFile(data, f.path.c_str());
+    }
+  }
+
+  struct config_t
+  {
+    uint32_t block_size;   // 0 : unbuffered
+    bool prefetch;
+  };
+
+  static const config_t configs[] =
+  { { 0, false }, { 512, false }, { 512, true }, { 4096, false }, { 4096, true }, { 16384, false } };
+
+  static void print_row(const char* name, const config_t& c, double us, uint32_t calls, uint32_t handoff, bool ok)
+  {
+    char block[16] = "-";
+    if (c.block_size) { snprintf(block, sizeof(block), "%u%s", c.block_size, c.prefetch ? "+pf" : ""); }
+    printf("%-5s %-9s %10.1f %8u %8u   %s\n", name, block, us, calls, handoff, ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+
+  static void bench_file(const file_t& f)
+  {
+    LGFX_Sprite ref;
+    LGFX_Sprite screen;
+    for (auto s : { &ref, &screen })
+    {
+      s->setColorDepth(16);
+      s->createSprite(screen_w, screen_h);
+      s->fillScreen(TFT_BLACK);
+    }
+    {
+      CountingFile file;
+      draw(ref, f, &file);
+    }
+
+    for (auto& c : configs)
+    {
+      CountingFile file;
+      BufferedDataWrapper buffered(&file, c.block_size, c.prefetch);
+      DataWrapper* data = c.block_size ? (DataWrapper*)&buffered : &file;
+
+      screen.fillScreen(TFT_BLACK);
+      handoffs = 0;
+      file.calls = 0;
+      bool ok = draw(screen, f, data)
+             && 0 == memcmp(screen.getBuffer(), ref.getBuffer(), screen.bufferLength());
+      uint32_t calls = file.calls;
+      uint32_t handoff = handoffs;
+      double us = bench::measure([&]()
+      {
+        draw(screen, f, data);
+      }, 200000);
+      print_row(f.ext, c, us, calls, handoff, ok);
+    }
+  }
+
+  /// text drawn with a VLW font loaded from a file, without a glyph cache, so that every glyph is read from the file.
+  static void bench_font(const char* path)
+  {
+    static constexpr const char* text = "The quick brown fox jumps over the lazy dog 0123456789";
+    // the files outlive the sprites, which close the font file they hold when destroyed.
+    CountingFile ref_file;
+    CountingFile file;
+    LGFX_Sprite ref;
+    LGFX_Sprite screen;
+    for (auto s : { &ref, &screen })
+    {
+      s->setColorDepth(16);
+      s->createSprite(screen_w, screen_h);
+      s->setFontCacheSize(0);
+      s->fillScreen(TFT_BLACK);
+    }
+    if (!ref_file.open(path) || !ref.loadFont(&ref_file))
+    {
+      printf("vlw   cannot load %s\n", path);
+      ref.unloadFont();
+      ++error_count;
+      return;
+    }
+    ref.drawString(text, 0, 0);
+    auto ref_buf = (const uint8_t*)ref.getBuffer();
+    if (std::all_of(ref_buf, ref_buf + ref.bufferLength(), [](uint8_t v) { return v == 0; }))
+    { // a file which is not a VLW font may load, but draws no glyphs to compare.
+      printf("vlw   no glyphs drawn from %s\n", path);
+      ref.unloadFont();
+      ++error_count;
+      return;
+    }
+
+    for (auto& c : configs)
+    {
+      file.open(path);
+      BufferedDataWrapper buffered(&file, c.block_size, c.prefetch);
+      DataWrapper* data = c.block_size ? (DataWrapper*)&buffered : &file;
+      if (!screen.loadFont(data))
+      {
+        printf("vlw   cannot load %s\n", path);
+        screen.unloadFont();
+        file.close();
+        ++error_count;
+        continue;
+      }
+
+      screen.fillScreen(TFT_BLACK);
+      handoffs = 0;
+      file.calls = 0;
+      screen.drawString(text, 0, 0);
+      bool ok = 0 == memcmp(screen.getBuffer(), ref.getBuffer(), screen.bufferLength());
+      uint32_t calls = file.calls;
+      uint32_t handoff = handoffs;
+      double us = bench::measure([&]()
+      {
+        screen.drawString(text, 0, 0);
+      }, 200000);
+      print_row("vlw", c, us, calls, handoff, ok);
+      screen.unloadFont();
+      file.close();
+    }
+    ref.unloadFont();
+    ref_file.close();
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<file_t> files = { { "png", {} }, { "qoi", {} }, { "bmp", {} } };
+
+  printf("%d x %d pictures from files into a 16 bit sprite; calls = read / seek / skip reaching the file, handoffs = preRead / postRead pairs\n\n", screen_w, screen_h);
+  printf("file  block         us/draw    calls handoffs\n");
+  if (make_files(files))
+  {
+    for (auto& f : files) { bench_file(f); }
+  }
+  else
+  {
+    printf("cannot write the picture files\n");
+    ++error_count;
+  }
+  for (auto& f : files) { remove(f.path.c_str()); }
+
+  bench_font(argc > 1 ? argv[1] : "../Basic/VlwFont/data/font.vlw");
+  return error_count ? 1 : 0;
+}
@@ -0,0 +1,276 @@
+// Host benchmark of drawPng / drawQoi on small icons, with and without a decoder object ( lgfx/v1/misc/ImageDecoder.hpp ).
+//
+// A launcher style screen draws a grid of icons, each one decoded from its file
+// every time. Without a decoder, drawPng keeps one shared inflate state that
+// releasePngMemory frees ( "release" rows free it after every icon, as apps that
+// give the memory back between screens do ), and drawQoi allocates its state and
+// line buffer on every call. PngDecoder / QoiDecoder keep all of that in their
+// own work area. The last table draws with one decoder and one sprite per thread.
+// Every picture is compared with the one drawn without a decoder.
+
+#include <lgfx/v1/LGFX_Sprite.hpp>
+#include <lgfx/utility/lgfx_miniz.h>
+
+#include "../bench_common.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  typedef std::vector<uint8_t> file_t;
+
+  static int error_count = 0;
+
+  static constexpr int32_t screen_w = 320;
+  static constexpr int32_t screen_h = 240;
+  static constexpr int icon_count = 12;
+
+  /// RGBA8888 PNG, for the icons with a transparent background.
+  static file_t make_png_rgba(const uint8_t* rgba, int32_t w, int32_t h)
+  {
+    size_t len = 0;
+    auto png = (uint8_t*)tdefl_write_image_to_png_file_in_memory(rgba, w, h, 4, &len);
+    file_t f(png, png + len);
+    free(png);
+    return f;
+  }
+
+  /// round icon with an antialiased edge on a transparent background.
+  static void draw_icon_rgba(uint8_t* rgba, int32_t size, int index)
+  {
+    float r = size * 0.5f - 1.0f;
+    float c = size * 0.5f - 0.5f;
+    for (int32_t y = 0; y < size; ++y)
+    {
+      for (int32_t x = 0; x < size; ++x)
+      {
+        float d = sqrtf((x - c) * (x - c) + (y - c) * (y - c));
+        float a = std::min(1.0f, std::max(0.0f, r - d));
+        auto p = &rgba[(y * size + x) * 4];
+        p[0] = (index * 40 + x * 255 / size) & 0xFF;
+        p[1] = (index * 90 + y * 255 / size) & 0xFF;
+        p[2] = ((x ^ y) & 8) ? 255 : 96;
+        p[3] = a * 255;
+      }
+    }
+  }
+
+  /// opaque icon drawn with the library, for createPng / writeQoi.
+  static void draw_icon(LovyanGFX& gfx, int index)
+  {
+    int32_t s = gfx.width();
+    gfx.fillScreen(gfx.color888(index * 20, 40, 80));
+    gfx.fillRoundRect(2, 2, s - 4, s - 4, s / 6, gfx.color888(255 - index * 16, index * 16, 160));
+    gfx.fillCircle(s / 2, s * 2 / 5, s / 5, TFT_WHITE);
+    gfx.fillRect(s / 4, s * 2 / 3, s / 2, s / 8, TFT_BLACK);
+  }
+
+  static bool qoi_writer(void* user, const uint8_t* data, uint32_t len)
+  {
+    auto f = (file_t*)user;
+    f->insert(f->end(), data, data + len);
+    return true;
+  }
+
+  struct icon_set_t
+  {
+    const char* name;
+    int32_t size;
+    bool qoi;
+    std::vector<file_t> files;
+  };
+
+  static void make_icons(icon_set_t& set, bool alpha)
+  {
+    int32_t s = set.size;
+    LGFX_Sprite sprite;
+    sprite.setColorDepth(24);
+    sprite.createSprite(s, s);
+    std::vector<uint8_t> rgba(s * s * 4);
+    for (int i = 0; i < icon_count; ++i)
+    {
+      if (alpha)
+      {
+        draw_icon_rgba(rgba.data(), s, i);
+        set.files.push_back(make_png_rgba(rgba.data(), s, s));
+        continue;
+      }
+      draw_icon(sprite, i);
+      if (set.qoi)
+      {
+        file_t f;
+        ImageEncoder::config_t cfg;
+        cfg.format = ImageEncoder::qoi;
+        sprite.writeImage(qoi_writer, &f, cfg);
+        set.files.push_back(f);
+      }
+      else
+      {
+        size_t len = 0;
+        auto png = (uint8_t*)sprite.createPng(&len);
+        set.files.push_back(file_t(png, png + len));
+        free(png);
+      }
+    }
+  }
+
+  enum mode_t { mode_shared, mode_release, mode_decoder };
+  static constexpr const char* mode_names[] = { "shared", "release", "decoder" };
+
+  struct decoders_t
+  {
+    PngDecoder png;
+    QoiDecoder qoi;
+  };
+
+  /// draws every icon of the set in a grid; the large ones overlap, so that all of them are decoded.
+  static bool draw_screen(LovyanGFX& gfx, const icon_set_t& set, mode_t mode, decoders_t* dec)
+  {
+    bool ok = true;
+    int32_t step = set.size + 4;
+    int32_t cols = screen_w / step;
+    int32_t rows = std::max<int32_t>(1, screen_h / step);
+    for (int i = 0; i < icon_count; ++i)
+    {
+      int32_t cell = i % (cols * rows);
+      int32_t x = (cell % cols) * step + (i / (cols * rows)) * 8;
+      int32_t y = (cell / cols) * step + (i / (cols * rows)) * 8;
+      auto& f = set.files[i];
+      if (mode == mode_release) { gfx.releasePngMemory(); }
+      if (set.qoi)
+      {
+        ok &= (mode == mode_decoder)
+            ? gfx.drawQoi(&dec->qoi, f.data(), f.size(), x, y)
+            : gfx.drawQoi(f.data(), f.size(), x, y);
+      }
+      else
+      {
+        ok &= (mode == mode_decoder)
+            ? gfx.drawPng(&dec->png, f.data(), f.size(), x, y)
+            : gfx.drawPng(f.data(), f.size(), x, y);
+      }
+    }
+    return ok;
+  }
+
+  static void create_screen(LGFX_Sprite& sprite)
+  {
+    sprite.setColorDepth(16);
+    sprite.createSprite(screen_w, screen_h);
+  }
+
+  static void bench_set(const icon_set_t& set)
+  {
+    LGFX_Sprite ref;
+    LGFX_Sprite screen;
+    create_screen(ref);
+    create_screen(screen);
+    ref.fillScreen(TFT_DARKGREY);
+    draw_screen(ref, set, mode_shared, nullptr);
+
+    for (auto mode : { mode_shared, mode_release, mode_decoder })
+    {
+      if (set.qoi && mode == mode_release) { continue; }
+      decoders_t dec;
+      screen.fillScreen(TFT_DARKGREY);
+      bool ok = draw_screen(screen, set, mode, &dec)
+             && 0 == memcmp(screen.getBuffer(), ref.getBuffer(), screen.bufferLength());
+      double us = bench::measure([&]()
+      {
+        draw_screen(screen, set, mode, &dec);
+      }, 200000);
+      char alloc[24] = "-";
+      char work[24] = "-";
+      if (mode == mode_decoder)
+      {
+        auto& d = set.qoi ? (ImageDecoder&)dec.qoi : (ImageDecoder&)dec.png;
+        snprintf(alloc, sizeof(alloc), "%u", d.getAllocCount());
+        snprintf(work, sizeof(work), "%u", (uint32_t)d.getWorkLength());
+      }
+      printf("%-10s %4d  %-5s %-8s %9.2f %8.1f   %5s  %8s  %s\n"
+            , set.name, set.size, set.qoi ? "qoi" : "png", mode_names[mode]
+            , us / icon_count, bench::mpix(set.size * set.size * icon_count, us)
+            , alloc, work
+            , ok ? "ok" : "MISMATCH");
+      if (!ok) { ++error_count; }
+    }
+    if (!set.qoi) { ref.releasePngMemory(); }
+  }
+
+  static void bench_threads(const icon_set_t& set, int threads)
+  {
+    LGFX_Sprite ref;
+    create_screen(ref);
+    ref.fillScreen(TFT_DARKGREY);
+    draw_screen(ref, set, mode_shared, nullptr);
+
+    static constexpr int screens = 200;
+    std::vector<int> bad(threads, 0);
+    std::vector<std::thread> pool;
+    uint64_t t0 = bench::micros();
+    for (int t = 0; t < threads; ++t)
+    {
+      pool.emplace_back([&, t]()
+      {
+        decoders_t dec;
+        LGFX_Sprite screen;
+        create_screen(screen);
+        for (int i = 0; i < screens; ++i)
+        {
+          screen.fillScreen(TFT_DARKGREY);
+          if (!draw_screen(screen, set, mode_decoder, &dec)
+           || memcmp(screen.getBuffer(), ref.getBuffer(), screen.bufferLength())) { ++bad[t]; }
+        }
+      });
+    }
+    for (auto& th : pool) { th.join(); }
+    double us = bench::micros() - t0;
+    bool ok = true;
+    for (auto b : bad) { ok &= (b == 0); }
+    uint32_t icons = screens * icon_count * threads;
+    printf("%-10s %4d  %-5s %7d  %10.0f  %s\n"
+          , set.name, set.size, set.qoi ? "qoi" : "png", threads
+          , icons * 1000000.0 / us
+          , ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+}
+
+int main(int, char**)
+{
+  std::vector<icon_set_t> sets =
+  { { "opaque",  32, false, {} }
+  , { "opaque",  64, false, {} }
+  , { "opaque", 128, false, {} }
+  , { "alpha" ,  32, false, {} }
+  , { "alpha" ,  64, false, {} }
+  , { "opaque",  32, true , {} }
+  , { "opaque",  64, true , {} }
+  , { "opaque", 128, true , {} }
+  };
+  for (auto& set : sets) { make_icons(set, set.name[0] == 'a'); }
+
+  printf("%d icons per screen into a 16 bit sprite; alloc / work = allocations and bytes of the decoder work area\n\n", icon_count);
+  printf("icons      size  fmt   mode        us/icon  Mpix/s   alloc      work\n");
+  for (auto& set : sets) { bench_set(set); }
+
+  unsigned cores = std::thread::hardware_concurrency();
+  printf("\none PngDecoder / QoiDecoder and one sprite per thread\n\n");
+  printf("icons      size  fmt   threads     icons/s\n");
+  for (auto& set : sets)
+  {
+    if (set.size != 64) { continue; }
+    for (unsigned threads = 1; threads <= std::max(4u, cores); threads <<= 1)
+    {
+      bench_threads(set, threads);
+    }
+  }
+  return error_count ? 1 : 0;
+}
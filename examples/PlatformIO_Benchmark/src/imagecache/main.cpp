@@ -0,0 +1,220 @@
+// Host benchmark of drawPngFile / drawQoiFile / drawBmpFile with and without an LGFX_ImageCache.
+//
+// A launcher style screen draws the same icons from their files every frame.
+// Without a cache every icon is opened, parsed and decoded again; with one, only
+// the first frame reads the files and the next ones push the decoded sprites.
+// "small" rows give the cache room for about half of the icons, so that the least
+// recently drawn ones are evicted and decoded again every frame.
+// Every frame is compared with the one drawn without a cache.
+
+#include "../bench_common.hpp"
+
+#include <lgfx/v1/LGFX_ImageCache.hpp>
+#include <lgfx/utility/lgfx_miniz.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  static int error_count = 0;
+
+  static constexpr int32_t screen_w = 320;
+  static constexpr int32_t screen_h = 240;
+  static constexpr int icon_count = 12;
+
+  struct icon_set_t
+  {
+    const char* name;
+    const char* ext;
+    int32_t size;
+    float scale;
+    std::vector<std::string> paths;
+  };
+
+  static bool write_file(const std::string& path, const void* data, size_t len)
+  {
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) { return false; }
+    bool res = fwrite(data, 1, len, fp) == len;
+    fclose(fp);
+    return res;
+  }
+
+  /// opaque icon drawn with the library.
+  static void draw_icon(LovyanGFX& gfx, int index)
+  {
+    int32_t s = gfx.width();
+    gfx.fillScreen(gfx.color888(index * 20, 40, 80));
+    gfx.fillRoundRect(2, 2, s - 4, s - 4, s / 6, gfx.color888(255 - index * 16, index * 16, 160));
+    gfx.fillCircle(s / 2, s * 2 / 5, s / 5, TFT_WHITE);
+    gfx.fillRect(s / 4, s * 2 / 3, s / 2, s / 8, TFT_BLACK);
+  }
+
+  /// round icon with an antialiased edge on a transparent background, as RGBA8888 PNG.
+  static bool write_alpha_png(const std::string& path, int32_t size, int index)
+  {
+    std::vector<uint8_t> rgba(size * size * 4);
+    float r = size * 0.5f - 1.0f;
+    float c = size * 0.5f - 0.5f;
+    for (int32_t y = 0; y < size; ++y)
+    {
+      for (int32_t x = 0; x < size; ++x)
+      {
+        float d = sqrtf((x - c) * (x - c) + (y - c) * (y - c));
+        auto p = &rgba[(y * size + x) * 4];
+        p[0] = (index * 40 + x * 255 / size) & 0xFF;
+        p[1] = (index * 90 + y * 255 / size) & 0xFF;
+        p[2] = ((x ^ y) & 8) ? 255 : 96;
+        p[3] = std::min(1.0f, std::max(0.0f, r - d)) * 255;
+      }
+    }
+    size_t len = 0;
+    auto png = tdefl_write_image_to_png_file_in_memory(rgba.data(), size, size, 4, &len);
+    bool res = png && write_file(path, png, len);
+    free(png);
+    return res;
+  }
+
+  static bool make_icons(icon_set_t& set)
+  {
+    LGFX_Sprite sprite;
+    sprite.setColorDepth(24);
+    sprite.createSprite(set.size, set.size);
+    for (int i = 0; i < icon_count; ++i)
+    {
+      char path[64];
+      snprintf(path, sizeof(path), "imagecache_%s%d_%d.%s", set.name, set.size, i, set.ext);
+      set.paths.push_back(path);
+      if (set.name[0] == 'a')
+      {
+        if (!write_alpha_png(path, set.size, i)) { return false; }
+        continue;
+      }
+      draw_icon(sprite, i);
+      auto fp = fopen(path, "wb");
+      if (fp == nullptr) { return false; }
+      DataWrapperT<FILE> file(fp);
+      size_t len = (set.ext[0] == 'q') ? sprite.writeQoi(&file)
+                 : (set.ext[0] == 'b') ? sprite.writeBmp(&file)
+                 :                       sprite.writePng(&file);
+      file.close();
+      if (len == 0) { return false; }
+    }
+    return true;
+  }
+
+  static void remove_icons(const icon_set_t& set)
+  {
+    for (auto& path : set.paths) { remove(path.c_str()); }
+  }
+
+  static bool draw_screen(LovyanGFX& gfx, const icon_set_t& set)
+  {
+    bool ok = true;
+    int32_t step = ceilf(set.size * set.scale) + 4;
+    int32_t cols = screen_w / step;
+    DataWrapperT<FILE> file;
+    for (int i = 0; i < icon_count; ++i)
+    {
+      int32_t x = (i % cols) * step;
+      int32_t y = (i / cols) * step;
+      auto path = set.paths[i].c_str();
+      switch (set.ext[0])
+      {
+      case 'q': ok &= gfx.drawQoiFile(&file, path, x, y, 0, 0, 0, 0, set.scale); break;
+      case 'b': ok &= gfx.drawBmpFile(&file, path, x, y, 0, 0, 0, 0, set.scale); break;
+      default:  ok &= gfx.drawPngFile(&file, path, x, y, 0, 0, 0, 0, set.scale); break;
+      }
+    }
+    return ok;
+  }
+
+  enum mode_t { mode_file, mode_cache, mode_small };
+  static constexpr const char* mode_names[] = { "file", "cache", "small" };
+
+  static void bench_set(const icon_set_t& set)
+  {
+    LGFX_Sprite ref;
+    LGFX_Sprite screen;
+    for (auto s : { &ref, &screen })
+    {
+      s->setColorDepth(16);
+      s->createSprite(screen_w, screen_h);
+      s->fillScreen(TFT_DARKGREY);
+    }
+    draw_screen(ref, set);
+
+    for (auto mode : { mode_file, mode_cache, mode_small })
+    {
+      LGFX_ImageCache cache(1 << 20);
+      screen.setImageCache(mode == mode_file ? nullptr : &cache);
+      if (mode == mode_small)
+      { // measure one frame, then leave room for half of it.
+        screen.fillScreen(TFT_DARKGREY);
+        draw_screen(screen, set);
+        cache.setBudget(cache.getUsedBytes() / 2);
+        cache.clear();
+      }
+      bool ok = true;
+      // first frame ( decodes into the cache ) and a second one ( hits )
+      for (int frame = 0; frame < 2; ++frame)
+      {
+        screen.fillScreen(TFT_DARKGREY);
+        ok &= draw_screen(screen, set)
+           && 0 == memcmp(screen.getBuffer(), ref.getBuffer(), screen.bufferLength());
+      }
+      cache.resetStats();
+      double us = bench::measure([&]()
+      {
+        draw_screen(screen, set);
+      }, 200000);
+      uint32_t draws = cache.getHitCount() + cache.getMissCount();
+      char hit_rate[16] = "-";
+      if (draws) { snprintf(hit_rate, sizeof(hit_rate), "%.0f%%", cache.getHitCount() * 100.0 / draws); }
+      printf("%-7s %4d  %4.1f  %-4s %-6s %9.2f %8.1f   %5s %9u %9u  %s\n"
+            , set.name, set.size, set.scale, set.ext, mode_names[mode]
+            , us / icon_count, bench::mpix(ceilf(set.size * set.scale) * ceilf(set.size * set.scale) * icon_count, us)
+            , hit_rate, (uint32_t)cache.getUsedBytes(), cache.getEvictionCount()
+            , ok ? "ok" : "MISMATCH");
+      if (!ok) { ++error_count; }
+      screen.setImageCache(nullptr);
+    }
+  }
+}
+
+int main(int, char**)
+{
+  std::vector<icon_set_t> sets =
+  { { "opaque", "png", 32, 1.0f, {} }
+  , { "opaque", "png", 64, 1.0f, {} }
+  , { "opaque", "png", 32, 1.5f, {} }
+  , { "alpha" , "png", 32, 1.0f, {} }
+  , { "alpha" , "png", 64, 1.0f, {} }
+  , { "opaque", "qoi", 64, 1.0f, {} }
+  , { "opaque", "bmp", 64, 1.0f, {} }
+  };
+
+  printf("%d icons per screen from files into a 16 bit sprite; bytes = memory of the cache, evict = evictions while measured\n\n", icon_count);
+  printf("icons   size  scale fmt  mode     us/icon  Mpix/s    hits     bytes     evict\n");
+  for (auto& set : sets)
+  {
+    if (make_icons(set))
+    {
+      bench_set(set);
+    }
+    else
+    {
+      printf("%-7s %4d  cannot write the icon files\n", set.name, set.size);
+      ++error_count;
+    }
+    remove_icons(set);
+  }
+  return error_count ? 1 : 0;
+}
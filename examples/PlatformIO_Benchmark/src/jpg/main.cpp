@@ -0,0 +1,127 @@
+// Host benchmark for the multithreaded drawJpg path.
+//
+// The JPEG is decoded into a 24 bit sprite (a memory backed panel, like the
+// Linux framebuffer) once on a single thread and then with several thread
+// counts ( setJpgDecodeThreads ). Every result is compared with the single
+// threaded output and the time per frame is reported for each scale.
+// Pass the path of a JPEG file as the first argument to use your own image,
+// and a thread count as the second argument to test only that count.
+// The default image is the photo of the AtomDisplay_Factory demo.
+
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include "../bench_common.hpp"
+#include "../../../Demo/AtomDisplay_Factory/jpg_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  static constexpr float scales[] = { 1.0f, 0.5f, 0.25f, 1.5f };
+
+  static int error_count = 0;
+
+  static bool load_file(const char* path, std::vector<uint8_t>& data)
+  {
+    FILE* fp = fopen(path, "rb");
+    if (fp == nullptr) { return false; }
+    uint8_t buf[4096];
+    size_t len;
+    while (0 < (len = fread(buf, 1, sizeof(buf), fp)))
+    {
+      data.insert(data.end(), buf, buf + len);
+    }
+    fclose(fp);
+    return true;
+  }
+
+  /// Image size from the SOF0 segment.
+  static bool jpg_size(const uint8_t* jpg, size_t len, int32_t& width, int32_t& height)
+  {
+    size_t i = 2;
+    while (i + 9 < len && jpg[i] == 0xFF)
+    {
+      uint_fast8_t marker = jpg[i + 1];
+      if (marker == 0xC0)
+      {
+        height = jpg[i + 5] << 8 | jpg[i + 6];
+        width  = jpg[i + 7] << 8 | jpg[i + 8];
+        return true;
+      }
+      i += 2 + (jpg[i + 2] << 8 | jpg[i + 3]);
+    }
+    return false;
+  }
+
+  static void bench_scale(const uint8_t* jpg, size_t len, int32_t width, int32_t height, float scale, const std::vector<uint32_t>& threads)
+  {
+    int32_t w = width * scale;
+    int32_t h = height * scale;
+    LGFX_Sprite ref;
+    ref.setColorDepth(24);
+    if (!ref.createSprite(w, h)) { printf("createSprite %d x %d failed\n", w, h); ++error_count; return; }
+
+    LGFX_Sprite canvas;
+    canvas.setColorDepth(24);
+    canvas.createSprite(w, h);
+
+    double base_us = 0;
+    for (auto n : threads)
+    {
+      auto& dst = (n == 1) ? ref : canvas;
+      dst.setJpgDecodeThreads(n);
+      dst.fillScreen(0);
+      bool ok = dst.drawJpg(jpg, len, 0, 0, 0, 0, 0, 0, scale);
+      double us = bench::measure([&](){ dst.drawJpg(jpg, len, 0, 0, 0, 0, 0, 0, scale); }, 200000);
+      if (n == 1) { base_us = us; }
+      else { ok = ok && 0 == memcmp(ref.getBuffer(), canvas.getBuffer(), ref.bufferLength()); }
+
+      printf("scale %-5.3g  threads %2u  %9.2f ms/frame  %8.2f Mpix/s  x%5.2f  %s\n"
+            , scale, n, us / 1000.0
+            , bench::mpix((size_t)width * height, us)
+            , base_us / us
+            , ok ? "ok" : "MISMATCH");
+      if (!ok) { ++error_count; }
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<uint8_t> file;
+  const uint8_t* jpg = jpg_image;
+  size_t len = sizeof(jpg_image);
+  if (argc > 1)
+  {
+    if (!load_file(argv[1], file)) { printf("can not open %s\n", argv[1]); return 1; }
+    jpg = file.data();
+    len = file.size();
+  }
+
+  int32_t width, height;
+  if (!jpg_size(jpg, len, width, height)) { printf("not a baseline JPEG\n"); return 1; }
+
+  uint32_t cores = std::thread::hardware_concurrency();
+  std::vector<uint32_t> threads = { 1 };
+  if (argc > 2)
+  {
+    threads.push_back(atoi(argv[2]));
+  }
+  else
+  {
+    for (uint32_t n = 2; n < cores; n <<= 1) { threads.push_back(n); }
+    threads.push_back(cores > 2 ? cores : 2);
+  }
+
+  printf("%d x %d, %u bytes, %u hardware threads\n", width, height, (uint32_t)len, cores);
+  for (auto scale : scales)
+  {
+    bench_scale(jpg, len, width, height, scale, threads);
+  }
+  return error_count ? 1 : 0;
+}
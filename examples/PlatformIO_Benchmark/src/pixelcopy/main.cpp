@@ -0,0 +1,398 @@
+// Host benchmark for the pixelcopy_t conversion kernels.
+//
+// Every kernel is run over a frame of `width` x LINES pixels for a set of
+// realistic line widths, its output is compared against an independent
+// reference (the affine kernel with an identity transform, or a plain
+// per-pixel formula), and the throughput is reported in Mpixel/s.
+// Pass a SIMD level name (none, SSE2, SSSE3, AVX2, NEON) as the second
+// argument to compare the vectorized host kernels with the scalar ones.
+
+#include <lgfx/v1/misc/pixelcopy.hpp>
+
+#include "../bench_common.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  static constexpr uint32_t LINES = 64;
+  static constexpr uint32_t widths[] = { 128, 317, 320, 800, 1280 };
+
+  static int error_count = 0;
+
+  template <typename T> struct type_name { static constexpr const char* value = "?"; };
+  template <> struct type_name<rgb332_t   > { static constexpr const char* value = "rgb332"; };
+  template <> struct type_name<rgb565_t   > { static constexpr const char* value = "rgb565"; };
+  template <> struct type_name<swap565_t  > { static constexpr const char* value = "swap565"; };
+  template <> struct type_name<rgb888_t   > { static constexpr const char* value = "rgb888"; };
+  template <> struct type_name<bgr888_t   > { static constexpr const char* value = "bgr888"; };
+  template <> struct type_name<bgr666_t   > { static constexpr const char* value = "bgr666"; };
+  template <> struct type_name<argb8888_t > { static constexpr const char* value = "argb8888"; };
+  template <> struct type_name<grayscale_t> { static constexpr const char* value = "gray8"; };
+
+  static void report(const char* kernel, const char* dst, const char* src, uint32_t width, double us, bool ok)
+  {
+    printf("%-24s %-9s <- %-9s %5u  %9.2f Mpix/s  %s\n"
+          , kernel, dst, src, width
+          , bench::mpix(width * LINES, us)
+          , ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+
+  /// Fill `buf` with random pixels, avoiding values that alias the NON_TRANSP sentinel.
+  template <typename T>
+  static void fill_pixels(std::vector<T>& buf, uint32_t seed)
+  {
+    bench::fill_random(buf.data(), buf.size() * sizeof(T), seed);
+    for (auto& c : buf)
+    {
+      if (c.get() == pixelcopy_t::NON_TRANSP) { c.set(0); }
+    }
+  }
+
+  template <typename TDst, typename TSrc>
+  static void bench_copy_rgb_fast(uint32_t width)
+  {
+    std::vector<TSrc> src(width * LINES);
+    std::vector<TDst> dst(width * LINES);
+    std::vector<TDst> ref(width * LINES);
+    fill_pixels(src, width);
+
+    pixelcopy_t pc(src.data(), TDst::depth, TSrc::depth);
+    pc.src_bitwidth = width;
+    for (uint32_t y = 0; y < LINES; ++y)
+    {
+      pc.src_x32 = 0;
+      pc.src_y32 = y << pixelcopy_t::FP_SCALE;
+      pixelcopy_t::copy_rgb_affine<TDst, TSrc>(&ref[y * width], 0, width, &pc);
+    }
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), TDst::depth, TSrc::depth);
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        p.fp_copy = pixelcopy_t::copy_rgb_fast<TDst, TSrc>;
+        p.fp_copy(&dst[y * width], 0, width, &p);
+      }
+    });
+    report("copy_rgb_fast", type_name<TDst>::value, type_name<TSrc>::value, width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(TDst)));
+  }
+
+  template <typename TDst, typename TSrc>
+  static void bench_copy_rgb_affine(uint32_t width)
+  {
+    std::vector<TSrc> src(width * LINES);
+    std::vector<TDst> dst(width * LINES);
+    std::vector<TDst> ref(width * LINES);
+    fill_pixels(src, width);
+
+    for (uint32_t i = 0; i < width * LINES; ++i)
+    {
+      ref[i].set(color_convert<TDst, TSrc>(src[i].get()));
+    }
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), TDst::depth, TSrc::depth);
+      p.src_bitwidth = width;
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        p.src_x32 = 0;
+        p.src_y32 = y << pixelcopy_t::FP_SCALE;
+        pixelcopy_t::copy_rgb_affine<TDst, TSrc>(&dst[y * width], 0, width, &p);
+      }
+    });
+    report("copy_rgb_affine", type_name<TDst>::value, type_name<TSrc>::value, width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(TDst)));
+  }
+
+  template <typename TDst, typename TPalette>
+  static void bench_copy_palette_fast(uint32_t width, color_depth_t src_depth)
+  {
+    uint32_t bits = src_depth & color_depth_t::bit_mask;
+    std::vector<uint8_t> src((width * LINES * bits + 7) >> 3);
+    std::vector<TPalette> palette(256);
+    std::vector<TDst> dst(width * LINES);
+    std::vector<TDst> ref(width * LINES);
+    bench::fill_random(src.data(), src.size(), width + bits);
+    bench::fill_random(palette.data(), palette.size() * sizeof(TPalette), 77);
+
+    pixelcopy_t pc(src.data(), TDst::depth, src_depth, false, palette.data());
+    pc.src_bitwidth = width;
+    for (uint32_t y = 0; y < LINES; ++y)
+    {
+      pc.src_x32 = 0;
+      pc.src_y32 = y << pixelcopy_t::FP_SCALE;
+      pixelcopy_t::copy_palette_affine<TDst, TPalette>(&ref[y * width], 0, width, &pc);
+    }
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), TDst::depth, src_depth, false, palette.data());
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        pixelcopy_t::copy_palette_fast<TDst, TPalette>(&dst[y * width], 0, width, &p);
+      }
+    });
+    char name[32];
+    snprintf(name, sizeof(name), "copy_palette_fast/%ubit", bits);
+    report(name, type_name<TDst>::value, type_name<TPalette>::value, width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(TDst)));
+  }
+
+  static void bench_copy_bit_fast(uint32_t width, color_depth_t depth)
+  {
+    uint32_t bits = depth & color_depth_t::bit_mask;
+    size_t len = (width * LINES * bits + 7) >> 3;
+    std::vector<uint8_t> src(len);
+    std::vector<uint8_t> dst(len);
+    std::vector<uint8_t> ref(len);
+    bench::fill_random(src.data(), len, width + bits);
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), depth, depth, true);
+      p.fp_copy = pixelcopy_t::copy_bit_fast;
+      p.fp_copy(dst.data(), 0, width * LINES, &p);
+    });
+    char name[32];
+    snprintf(name, sizeof(name), "copy_bit_fast/%ubit", bits);
+    report(name, "palette", "palette", width, us, 0 == memcmp(dst.data(), src.data(), len));
+  }
+
+  template <typename TDst>
+  static void bench_blend_rgb_fast(uint32_t width)
+  {
+    std::vector<argb8888_t> src(width * LINES);
+    std::vector<TDst> base(width * LINES);
+    std::vector<TDst> dst(width * LINES);
+    std::vector<TDst> ref(width * LINES);
+    fill_pixels(src, width);
+    fill_pixels(base, width + 1);
+    // Make a quarter of the pixels fully transparent and a quarter opaque, as in typical UI overlays.
+    for (uint32_t i = 0; i < src.size(); ++i)
+    {
+      switch (i & 3)
+      {
+      case 0: src[i].a = 0; break;
+      case 1: src[i].a = 255; break;
+      default: break;
+      }
+    }
+
+    for (uint32_t i = 0; i < src.size(); ++i)
+    {
+      ref[i] = base[i];
+      uint_fast16_t a = src[i].a;
+      if (a == 0) continue;
+      if (a == 255) { ref[i].set(src[i].r, src[i].g, src[i].b); continue; }
+      uint_fast16_t inv = 256 - a;
+      ++a;
+      ref[i].set( (ref[i].R8() * inv + src[i].R8() * a) >> 8
+                , (ref[i].G8() * inv + src[i].G8() * a) >> 8
+                , (ref[i].B8() * inv + src[i].B8() * a) >> 8
+                );
+    }
+
+    double us = bench::measure([&]()
+    {
+      memcpy(dst.data(), base.data(), dst.size() * sizeof(TDst));
+      pixelcopy_t p(src.data(), TDst::depth, argb8888_t::depth);
+      p.src_bitwidth = width;
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        p.src_x32 = 0;
+        p.src_y32 = y << pixelcopy_t::FP_SCALE;
+        pixelcopy_t::blend_rgb_fast<TDst>(&dst[y * width], 0, width, &p);
+      }
+    });
+    report("blend_rgb_fast", type_name<TDst>::value, "argb8888", width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(TDst)));
+  }
+
+  /// Set up a 2:1 downscale, so each destination pixel averages a 2x2 source block.
+  static void setup_antialias_half(pixelcopy_t* p, uint32_t width, uint32_t y)
+  {
+    p->src_width    = width * 2;
+    p->src_height   = LINES * 2;
+    p->src_bitwidth = width * 2;
+    p->src_x32_add  = 2 << pixelcopy_t::FP_SCALE;
+    p->src_y32_add  = 0;
+    p->src_x32  = 0;
+    p->src_xe32 = (2 << pixelcopy_t::FP_SCALE) - 1;
+    p->src_y32  = (y * 2) << pixelcopy_t::FP_SCALE;
+    p->src_ye32 = p->src_y32 + (2 << pixelcopy_t::FP_SCALE) - 1;
+  }
+
+  /// Box average of a 2x2 block, accumulated in 32-bit with the same 256x256 coverage weights as the kernels.
+  template <typename TColor>
+  static argb8888_t average_2x2(const TColor* c[4])
+  {
+    static constexpr uint32_t rate = 256 * 256;
+    uint32_t a = 0, r = 0, g = 0, b = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      uint32_t w = std::is_same<TColor, argb8888_t>::value ? rate * c[i]->A8() : rate;
+      a += w;
+      r += c[i]->R8() * w;
+      g += c[i]->G8() * w;
+      b += c[i]->B8() * w;
+    }
+    if (!a) { return argb8888_t(0u); }
+    return argb8888_t( (std::is_same<TColor, argb8888_t>::value ? a : a * 255) / (rate * 4)
+                     , r / a, g / a, b / a);
+  }
+
+  template <typename TSrc>
+  static void bench_copy_rgb_antialias(uint32_t width)
+  {
+    uint32_t sw = width * 2;
+    std::vector<TSrc> src(sw * LINES * 2);
+    std::vector<argb8888_t> dst(width * LINES);
+    std::vector<argb8888_t> ref(width * LINES);
+    fill_pixels(src, width);
+
+    for (uint32_t y = 0; y < LINES; ++y)
+    {
+      for (uint32_t x = 0; x < width; ++x)
+      {
+        auto s = &src[y * 2 * sw + x * 2];
+        const TSrc* c[4] = { &s[0], &s[1], &s[sw], &s[sw + 1] };
+        ref[y * width + x] = average_2x2(c);
+      }
+    }
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), argb8888_t::depth, TSrc::depth);
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        setup_antialias_half(&p, width, y);
+        pixelcopy_t::copy_rgb_antialias<TSrc>(&dst[y * width], 0, width, &p);
+      }
+    });
+    report("copy_rgb_antialias", "argb8888", type_name<TSrc>::value, width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(argb8888_t)));
+  }
+
+  template <typename TPalette>
+  static void bench_copy_palette_antialias(uint32_t width)
+  {
+    static constexpr uint32_t bits = 4;
+    uint32_t sw = width * 2;
+    std::vector<uint8_t> src((sw * LINES * 2 * bits + 7) >> 3);
+    std::vector<TPalette> palette(16);
+    std::vector<argb8888_t> dst(width * LINES);
+    std::vector<argb8888_t> ref(width * LINES);
+    bench::fill_random(src.data(), src.size(), width);
+    bench::fill_random(palette.data(), palette.size() * sizeof(TPalette), 99);
+
+    auto index_at = [&](uint32_t i) -> uint32_t { return (src[i >> 1] >> ((i & 1) ? 0 : 4)) & 0x0F; };
+    for (uint32_t y = 0; y < LINES; ++y)
+    {
+      for (uint32_t x = 0; x < width; ++x)
+      {
+        uint32_t i = y * 2 * sw + x * 2;
+        const TPalette* c[4] = { &palette[index_at(i)], &palette[index_at(i + 1)], &palette[index_at(i + sw)], &palette[index_at(i + sw + 1)] };
+        ref[y * width + x] = average_2x2(c);
+      }
+    }
+
+    double us = bench::measure([&]()
+    {
+      pixelcopy_t p(src.data(), argb8888_t::depth, palette_4bit, false, palette.data());
+      for (uint32_t y = 0; y < LINES; ++y)
+      {
+        setup_antialias_half(&p, width, y);
+        pixelcopy_t::copy_palette_antialias<TPalette>(&dst[y * width], 0, width, &p);
+      }
+    });
+    report("copy_palette_antialias", "argb8888", type_name<TPalette>::value, width, us
+          , 0 == memcmp(dst.data(), ref.data(), dst.size() * sizeof(argb8888_t)));
+  }
+
+  template <typename TDst, typename TSrc>
+  static void bench_rgb_pair(uint32_t width)
+  {
+    bench_copy_rgb_fast<TDst, TSrc>(width);
+    bench_copy_rgb_affine<TDst, TSrc>(width);
+  }
+
+  /// Every destination format that LGFXBase::create_pc_fast can select.
+  template <typename TSrc>
+  static void bench_rgb_src(uint32_t width)
+  {
+    bench_rgb_pair<swap565_t  , TSrc>(width);
+    bench_rgb_pair<rgb332_t   , TSrc>(width);
+    bench_rgb_pair<bgr888_t   , TSrc>(width);
+    bench_rgb_pair<bgr666_t   , TSrc>(width);
+    bench_rgb_pair<argb8888_t , TSrc>(width);
+    bench_rgb_pair<grayscale_t, TSrc>(width);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  // Optional arguments: a single line width to run (0 = all), and the SIMD level to cap the kernels at.
+  uint32_t only_width = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 0;
+  if (argc > 2)
+  {
+    for (int l = simd::level_none; l <= simd::level_neon; ++l)
+    {
+      if (0 == strcmp(argv[2], simd::get_level_name((simd::simd_level_t)l)))
+      {
+        simd::set_level((simd::simd_level_t)l);
+      }
+    }
+  }
+  printf("SIMD level: %s\n", simd::get_level_name(simd::get_level()));
+
+  printf("%-24s %-9s    %-9s %5s  %16s\n", "kernel", "dst", "src", "width", "throughput");
+  for (auto width : widths)
+  {
+    if (only_width && only_width != width) { continue; }
+
+    bench_rgb_src<rgb332_t   >(width);
+    bench_rgb_src<swap565_t  >(width);
+    bench_rgb_src<rgb565_t   >(width);
+    bench_rgb_src<bgr888_t   >(width);
+    bench_rgb_src<rgb888_t   >(width);
+    bench_rgb_src<bgr666_t   >(width);
+    bench_rgb_src<argb8888_t >(width);
+    bench_rgb_src<grayscale_t>(width);
+
+    for (auto depth : { palette_1bit, palette_2bit, palette_4bit, palette_8bit })
+    {
+      bench_copy_palette_fast<swap565_t  , bgr888_t>(width, depth);
+      bench_copy_palette_fast<rgb332_t   , bgr888_t>(width, depth);
+      bench_copy_palette_fast<bgr888_t   , bgr888_t>(width, depth);
+      bench_copy_palette_fast<argb8888_t , bgr888_t>(width, depth);
+      bench_copy_bit_fast(width, depth);
+    }
+
+    bench_blend_rgb_fast<swap565_t>(width);
+    bench_blend_rgb_fast<rgb332_t >(width);
+    bench_blend_rgb_fast<bgr888_t >(width);
+    bench_blend_rgb_fast<bgr666_t >(width);
+
+    bench_copy_rgb_antialias<swap565_t >(width);
+    bench_copy_rgb_antialias<rgb332_t  >(width);
+    bench_copy_rgb_antialias<bgr888_t  >(width);
+    bench_copy_rgb_antialias<argb8888_t>(width);
+    bench_copy_palette_antialias<bgr888_t  >(width);
+    bench_copy_palette_antialias<argb8888_t>(width);
+  }
+
+  if (error_count)
+  {
+    printf("\n%d kernel(s) produced output that differs from the reference.\n", error_count);
+    return 1;
+  }
+  return 0;
+}
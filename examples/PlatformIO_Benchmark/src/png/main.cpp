@@ -0,0 +1,218 @@
+// Host benchmark of the PNG encoder of createPng / writeImage ( lgfx/v1/misc/ImageEncoder.hpp ).
+//
+// UI screens are drawn with the library into 16 bit sprites of 320 x 240 and
+// 1280 x 720, plus the photo of the AtomDisplay_Factory demo as a worst case.
+// Each screen is captured with createPng for every encoder preset and row
+// filter, and the encode time per frame is reported against the file size.
+// The deflate state is kept between the captures; the "realloc" rows free it
+// before every capture, as the former createPng did, to show what that costs.
+// Every file is drawn back into a sprite and compared with the screen.
+
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include "../bench_common.hpp"
+#include "../../../Demo/AtomDisplay_Factory/jpg_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  struct screen_t
+  {
+    const char* name;
+    int32_t width;
+    int32_t height;
+    void (*draw)(LovyanGFX& gfx);
+  };
+
+  struct preset_t
+  {
+    const char* name;
+    ImageEncoder::png_preset_t preset;
+  };
+
+  static constexpr preset_t presets[] =
+  { { "store"   , ImageEncoder::png_store    }
+  , { "fast"    , ImageEncoder::png_fast     }
+  , { "balanced", ImageEncoder::png_balanced }
+  , { "max"     , ImageEncoder::png_max      }
+  };
+
+  struct filter_t
+  {
+    const char* name;
+    ImageEncoder::png_filter_t filter;
+  };
+
+  static constexpr filter_t filters[] =
+  { { "none"    , ImageEncoder::png_filter_none     }
+  , { "sub"     , ImageEncoder::png_filter_sub      }
+  , { "up"      , ImageEncoder::png_filter_up       }
+  , { "adaptive", ImageEncoder::png_filter_adaptive }
+  };
+
+  static int error_count = 0;
+
+  static void draw_settings(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    gfx.fillScreen(TFT_BLACK);
+    gfx.fillRect(0, 0, w, h / 8, TFT_DARKGREY);
+    gfx.setFont(&lgfx::fonts::Font2);
+    gfx.setTextColor(TFT_WHITE, TFT_DARKGREY);
+    gfx.drawString("Settings", 4, 2);
+    static constexpr const char* items[] = { "Wi-Fi", "Bluetooth", "Display", "Sound", "Battery", "About" };
+    int32_t ih = (h - h / 8) / 6;
+    for (int32_t i = 0; i < 6; ++i)
+    {
+      int32_t y = h / 8 + i * ih;
+      gfx.fillRoundRect(4, y + 2, w - 8, ih - 4, 6, i == 2 ? TFT_BLUE : 0x2104u);
+      gfx.setTextColor(TFT_WHITE);
+      gfx.drawString(items[i], 12, y + (ih - gfx.fontHeight()) / 2);
+      gfx.fillCircle(w - 20, y + ih / 2, 5, (i & 1) ? TFT_GREEN : TFT_DARKGREY);
+    }
+    gfx.setFont(&lgfx::fonts::Font0);
+  }
+
+  static void draw_terminal(LovyanGFX& gfx)
+  {
+    gfx.fillScreen(TFT_BLACK);
+    gfx.setFont(&lgfx::fonts::Font0);
+    gfx.setTextColor(TFT_GREEN, TFT_BLACK);
+    gfx.setTextWrap(true, true);
+    gfx.setCursor(0, 0);
+    bench::xorshift32_t rng(7);
+    while (gfx.getCursorY() < gfx.height() - 8)
+    {
+      gfx.printf("[%6u.%03u] ", rng.next() % 100000, rng.next() % 1000);
+      uint32_t words = 2 + rng.next() % 8;
+      for (uint32_t i = 0; i < words; ++i)
+      {
+        static constexpr const char* dict[] = { "wifi:", "connected", "ip", "192.168.0.12", "heap", "free", "task", "ok", "lcd", "init" };
+        gfx.print(dict[rng.next() % 10]);
+        gfx.print(' ');
+      }
+      gfx.println();
+    }
+  }
+
+  static void draw_dashboard(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    for (int32_t y = 0; y < h; ++y)
+    { // vertical gradient background
+      gfx.drawFastHLine(0, y, w, gfx.color888(0, y * 64 / h, 32 + y * 96 / h));
+    }
+    int32_t r = std::min(w / 4, h / 3) - 4;
+    for (int32_t i = 0; i < 2; ++i)
+    {
+      int32_t cx = w / 4 + i * w / 2;
+      int32_t cy = h / 3 + 4;
+      gfx.fillArc(cx, cy, r, r - r / 5, 135, 405, TFT_DARKGREY);
+      gfx.fillArc(cx, cy, r, r - r / 5, 135, 135 + 120 + i * 90, i ? TFT_ORANGE : TFT_CYAN);
+      gfx.setTextDatum(textdatum_t::middle_center);
+      gfx.setFont(&lgfx::fonts::FreeSansBold12pt7b);
+      gfx.setTextColor(TFT_WHITE);
+      gfx.drawString(i ? "72%" : "21.5", cx, cy);
+    }
+    gfx.setTextDatum(textdatum_t::top_left);
+    gfx.setFont(&lgfx::fonts::Font0);
+    int32_t gy = h * 2 / 3;
+    int32_t gh = h - gy - 4;
+    gfx.fillRect(4, gy, w - 8, gh, TFT_BLACK);
+    gfx.drawRect(4, gy, w - 8, gh, TFT_LIGHTGREY);
+    bench::xorshift32_t rng(3);
+    int32_t prev = gh / 2;
+    for (int32_t x = 5; x < w - 5; x += 2)
+    {
+      int32_t v = prev + (int32_t)(rng.next() % 7) - 3;
+      v = std::max<int32_t>(2, std::min<int32_t>(gh - 3, v));
+      gfx.drawLine(x - 2, gy + prev, x, gy + v, TFT_YELLOW);
+      prev = v;
+    }
+  }
+
+  static void draw_photo(LovyanGFX& gfx)
+  {
+    gfx.fillScreen(TFT_BLACK);
+    gfx.drawJpg(jpg_image, sizeof(jpg_image));
+  }
+
+  /// Encodes the screen once to check it, then times the captures.
+  static void bench_png(LGFX_Sprite& screen, LGFX_Sprite& check, const char* name, const preset_t& preset, const filter_t& filter, bool realloc_state)
+  {
+    int32_t w = screen.width();
+    int32_t h = screen.height();
+    size_t raw = w * h * 3;
+
+    size_t len = 0;
+    void* png = screen.createPng(&len, 0, 0, w, h, preset.preset, filter.filter);
+    bool ok = png != nullptr;
+    if (ok)
+    {
+      check.fillScreen(TFT_MAGENTA);
+      ok = check.drawPng((const uint8_t*)png, len)
+        && 0 == memcmp(check.getBuffer(), screen.getBuffer(), w * h * 2);
+      free(png);
+    }
+
+    double us = bench::measure([&]()
+    {
+      if (realloc_state) { screen.releasePngMemory(); }
+      size_t l;
+      free(screen.createPng(&l, 0, 0, w, h, preset.preset, filter.filter));
+    }, 100000);
+
+    printf("%-10s %4d x %-4d %-8s %-8s %-7s %9u %6.1f%%  %8.2f %7.1f  %s\n"
+          , name, w, h, preset.name, filter.name, realloc_state ? "realloc" : "keep"
+          , (uint32_t)len, len * 100.0 / raw
+          , us / 1000.0, bench::mbyte(raw, us)
+          , ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+}
+
+int main(int, char**)
+{
+  static constexpr screen_t screens[] =
+  { { "settings" ,  320, 240, draw_settings  }
+  , { "terminal" ,  320, 240, draw_terminal  }
+  , { "dashboard",  320, 240, draw_dashboard }
+  , { "settings" , 1280, 720, draw_settings  }
+  , { "terminal" , 1280, 720, draw_terminal  }
+  , { "dashboard", 1280, 720, draw_dashboard }
+  , { "photo"    ,  320, 240, draw_photo     }
+  };
+
+  printf("ratio = file size / RGB888 size, MB/s of RGB888 pixels\n\n");
+  printf("screen     size        preset   filter   state    size [B]  ratio  ms/frame    MB/s\n");
+  for (auto& s : screens)
+  {
+    LGFX_Sprite screen;
+    LGFX_Sprite check;
+    screen.setColorDepth(16);
+    check.setColorDepth(16);
+    if (!screen.createSprite(s.width, s.height) || !check.createSprite(s.width, s.height))
+    {
+      printf("createSprite %d x %d failed\n", s.width, s.height);
+      return 1;
+    }
+    s.draw(screen);
+    for (auto& preset : presets)
+    {
+      for (auto& filter : filters)
+      {
+        bench_png(screen, check, s.name, preset, filter, false);
+      }
+    }
+    // the former createPng: level 6, no filter, a new deflate state per capture.
+    bench_png(screen, check, s.name, presets[2], filters[0], true);
+  }
+  return error_count ? 1 : 0;
+}
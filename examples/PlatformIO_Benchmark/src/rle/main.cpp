@@ -0,0 +1,385 @@
+// Host benchmark of the RLE codec used for CMD_WRITE_RLE_* ( lgfx/v1/misc/rle.hpp ).
+//
+// UI screens are drawn with the library into sprites of 8, 16, 24 and 32 bit
+// depth, in the sizes of the UnitLCD ( 135 x 240 ), a 320 x 240 LCD and the
+// AtomDisplay ( 1280 x 720 ). Each screen is encoded line by line, the way
+// the panel drivers send it, and the encoded size and the encode / decode
+// throughput in MByte/s of raw pixel data are reported. Every line is decoded
+// again and compared with the screen, and the byte at a time encoder that
+// Panel_M5UnitLCD used before is run on the same lines for comparison.
+// Pass the paths of PNG / JPEG / BMP screenshots to use them instead of the
+// built-in screens.
+
+#include <lgfx/v1/misc/rle.hpp>
+#include <lgfx/v1/LGFX_Sprite.hpp>
+
+#include "../bench_common.hpp"
+#include "../../../Demo/AtomDisplay_Factory/jpg_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace lgfx;
+
+namespace
+{
+  struct screen_t
+  {
+    std::string name;
+    int32_t width;
+    int32_t height;
+    std::vector<uint8_t> file;  // PNG / JPEG / BMP; empty for the built-in screens.
+    void (*draw)(LovyanGFX& gfx);
+  };
+
+  static constexpr uint8_t depths[] = { 8, 16, 24, 32 };
+
+  static int error_count = 0;
+
+  static void draw_settings(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    gfx.fillScreen(TFT_BLACK);
+    gfx.fillRect(0, 0, w, h / 8, TFT_DARKGREY);
+    gfx.setFont(&lgfx::fonts::Font2);
+    gfx.setTextColor(TFT_WHITE, TFT_DARKGREY);
+    gfx.drawString("Settings", 4, 2);
+    static constexpr const char* items[] = { "Wi-Fi", "Bluetooth", "Display", "Sound", "Battery", "About" };
+    int32_t ih = (h - h / 8) / 6;
+    for (int32_t i = 0; i < 6; ++i)
+    {
+      int32_t y = h / 8 + i * ih;
+      gfx.fillRoundRect(4, y + 2, w - 8, ih - 4, 6, i == 2 ? TFT_BLUE : 0x2104u);
+      gfx.setTextColor(TFT_WHITE);
+      gfx.drawString(items[i], 12, y + (ih - gfx.fontHeight()) / 2);
+      gfx.fillCircle(w - 20, y + ih / 2, 5, (i & 1) ? TFT_GREEN : TFT_DARKGREY);
+    }
+    gfx.setFont(&lgfx::fonts::Font0);
+  }
+
+  static void draw_terminal(LovyanGFX& gfx)
+  {
+    gfx.fillScreen(TFT_BLACK);
+    gfx.setFont(&lgfx::fonts::Font0);
+    gfx.setTextColor(TFT_GREEN, TFT_BLACK);
+    gfx.setTextWrap(true, true);
+    gfx.setCursor(0, 0);
+    bench::xorshift32_t rng(7);
+    while (gfx.getCursorY() < gfx.height() - 8)
+    {
+      gfx.printf("[%6u.%03u] ", rng.next() % 100000, rng.next() % 1000);
+      uint32_t words = 2 + rng.next() % 8;
+      for (uint32_t i = 0; i < words; ++i)
+      {
+        static constexpr const char* dict[] = { "wifi:", "connected", "ip", "192.168.0.12", "heap", "free", "task", "ok", "lcd", "init" };
+        gfx.print(dict[rng.next() % 10]);
+        gfx.print(' ');
+      }
+      gfx.println();
+    }
+  }
+
+  static void draw_dashboard(LovyanGFX& gfx)
+  {
+    int32_t w = gfx.width();
+    int32_t h = gfx.height();
+    for (int32_t y = 0; y < h; ++y)
+    { // vertical gradient background
+      gfx.drawFastHLine(0, y, w, gfx.color888(0, y * 64 / h, 32 + y * 96 / h));
+    }
+    int32_t r = std::min(w / 4, h / 3) - 4;
+    for (int32_t i = 0; i < 2; ++i)
+    {
+      int32_t cx = w / 4 + i * w / 2;
+      int32_t cy = h / 3 + 4;
+      gfx.fillArc(cx, cy, r, r - r / 5, 135, 405, TFT_DARKGREY);
+      gfx.fillArc(cx, cy, r, r - r / 5, 135, 135 + 120 + i * 90, i ? TFT_ORANGE : TFT_CYAN);
+      gfx.setTextDatum(textdatum_t::middle_center);
+      gfx.setFont(&lgfx::fonts::FreeSansBold12pt7b);
+      gfx.setTextColor(TFT_WHITE);
+      gfx.drawString(i ? "72%" : "21.5", cx, cy);
+    }
+    gfx.setTextDatum(textdatum_t::top_left);
+    gfx.setFont(&lgfx::fonts::Font0);
+    int32_t gy = h * 2 / 3;
+    int32_t gh = h - gy - 4;
+    gfx.fillRect(4, gy, w - 8, gh, TFT_BLACK);
+    gfx.drawRect(4, gy, w - 8, gh, TFT_LIGHTGREY);
+    bench::xorshift32_t rng(3);
+    int32_t prev = gh / 2;
+    for (int32_t x = 5; x < w - 5; x += 2)
+    {
+      int32_t v = prev + (int32_t)(rng.next() % 7) - 3;
+      v = std::max<int32_t>(2, std::min<int32_t>(gh - 3, v));
+      gfx.drawLine(x - 2, gy + prev, x, gy + v, TFT_YELLOW);
+      prev = v;
+    }
+  }
+
+  /// Image size from the PNG IHDR, the BMP header or the JPEG SOF0 segment.
+  static bool image_size(const std::vector<uint8_t>& d, int32_t& width, int32_t& height)
+  {
+    size_t len = d.size();
+    if (len > 24 && d[0] == 0x89 && d[1] == 'P' && d[2] == 'N' && d[3] == 'G')
+    {
+      width  = d[16] << 24 | d[17] << 16 | d[18] << 8 | d[19];
+      height = d[20] << 24 | d[21] << 16 | d[22] << 8 | d[23];
+      return true;
+    }
+    if (len > 26 && d[0] == 'B' && d[1] == 'M')
+    {
+      width  = d[18] | d[19] << 8 | d[20] << 16 | d[21] << 24;
+      height = d[22] | d[23] << 8 | d[24] << 16 | d[25] << 24;
+      if (height < 0) { height = -height; }
+      return true;
+    }
+    size_t i = 2;
+    while (i + 9 < len && d[i] == 0xFF)
+    {
+      uint_fast8_t marker = d[i + 1];
+      if (marker == 0xC0 || marker == 0xC2)
+      {
+        height = d[i + 5] << 8 | d[i + 6];
+        width  = d[i + 7] << 8 | d[i + 8];
+        return true;
+      }
+      i += 2 + (d[i + 2] << 8 | d[i + 3]);
+    }
+    return false;
+  }
+
+  static bool load_file(const char* path, std::vector<uint8_t>& data)
+  {
+    FILE* fp = fopen(path, "rb");
+    if (fp == nullptr) { return false; }
+    uint8_t buf[4096];
+    size_t len;
+    while (0 < (len = fread(buf, 1, sizeof(buf), fp)))
+    {
+      data.insert(data.end(), buf, buf + len);
+    }
+    fclose(fp);
+    return true;
+  }
+
+  static void draw_file(LovyanGFX& gfx, const std::vector<uint8_t>& d)
+  {
+    gfx.fillScreen(TFT_BLACK);
+    if (d[0] == 0x89)     { gfx.drawPng(d.data(), d.size()); }
+    else if (d[0] == 'B') { gfx.drawBmp(d.data(), d.size()); }
+    else                  { gfx.drawJpg(d.data(), d.size()); }
+  }
+
+//----------------------------------------------------------------------------
+
+  /// The byte at a time encoder of Panel_M5UnitLCD before rle::encode, as the baseline.
+  static uint8_t* ref_store_encoded(uint8_t* dst, const uint8_t* src, size_t data_num, size_t bytes)
+  {
+    *dst++ = data_num;
+    memmove(dst, src, bytes);
+    return dst + bytes;
+  }
+
+  static uint8_t* ref_store_absolute(uint8_t* dst, const uint8_t* src, size_t src_size, size_t bytes)
+  {
+    if (src_size >= 3)
+    {
+      *dst++ = 0x00;
+      *dst++ = src_size;
+      memmove(dst, src, src_size * bytes);
+      return dst + src_size * bytes;
+    }
+    for (size_t i = 0; i < src_size; i++)
+    {
+      dst = ref_store_encoded(dst, src + i * bytes, 1, bytes);
+    }
+    return dst;
+  }
+
+  static size_t ref_encode(uint8_t* dest, const uint8_t* src, size_t bytelen, size_t bytes)
+  {
+    static constexpr size_t maxbyte = 255;
+    uint8_t* pdest = dest;
+    const uint8_t* pabs = src;
+    const uint8_t* prev = src;
+    int_fast16_t cont = 1;
+    int_fast16_t abso = 0;
+    for (size_t i = bytes; i < bytelen; i += bytes)
+    {
+      size_t byteidx = 0;
+      while (src[i + byteidx] == src[i + byteidx - bytes] && ++byteidx != bytes);
+      if (byteidx == bytes)
+      {
+        cont++;
+        if (abso >= 1)
+        {
+          pdest = ref_store_absolute(pdest, pabs, abso, bytes);
+        }
+        else if (cont == maxbyte)
+        {
+          pdest = ref_store_encoded(pdest, prev, maxbyte, bytes);
+          cont = 1;
+          prev = src + i;
+        }
+        abso = -1;
+      }
+      else
+      {
+        abso++;
+        if (cont >= 2)
+        {
+          pdest = ref_store_encoded(pdest, prev, cont, bytes);
+        }
+        else if (abso == maxbyte)
+        {
+          pdest = ref_store_absolute(pdest, pabs, maxbyte, bytes);
+          abso = 0;
+        }
+        cont = 1;
+        if (abso == 0) { pabs = src + i; }
+        prev = src + i;
+      }
+    }
+    if (abso >= 0)
+    {
+      pdest = ref_store_absolute(pdest, pabs, abso + 1, bytes);
+    }
+    else if (cont >= 2)
+    {
+      pdest = ref_store_encoded(pdest, prev, cont, bytes);
+    }
+    return pdest - dest;
+  }
+
+//----------------------------------------------------------------------------
+
+  static void bench_screen(const screen_t& screen, LGFX_Sprite& sprite, uint8_t depth)
+  {
+    int32_t w = screen.width;
+    int32_t h = screen.height;
+    sprite.setColorDepth(depth);
+    if (!sprite.createSprite(w, h)) { printf("createSprite %d x %d failed\n", w, h); ++error_count; return; }
+    if (screen.file.empty()) { screen.draw(sprite); }
+    else if (depth != 32) { draw_file(sprite, screen.file); }
+    else
+    { // images can not be drawn to a 32 bit sprite, so the 24 bit result is expanded.
+      LGFX_Sprite rgb;
+      rgb.setColorDepth(24);
+      rgb.createSprite(w, h);
+      draw_file(rgb, screen.file);
+      auto src = static_cast<const bgr888_t*>(rgb.getBuffer());
+      auto dst = static_cast<argb8888_t*>(sprite.getBuffer());
+      for (int32_t i = 0; i < w * h; ++i)
+      {
+        dst[i] = argb8888_t(255, src[i].r, src[i].g, src[i].b);
+      }
+    }
+
+    uint_fast8_t bytes = depth >> 3;
+    size_t line_bytes = w * bytes;
+    size_t raw = line_bytes * h;
+    auto pixels = static_cast<const uint8_t*>(sprite.getBuffer());
+    size_t stride = rle::encode_bound(w, bytes);
+    std::vector<uint8_t> enc(stride * h);
+    std::vector<size_t> enc_len(h);
+    std::vector<uint8_t> dec(raw);
+
+    size_t total = 0;
+    bool ok = true;
+    for (int32_t y = 0; y < h; ++y)
+    {
+      enc_len[y] = rle::encode(&enc[y * stride], &pixels[y * line_bytes], w, bytes);
+      total += enc_len[y];
+      size_t used;
+      ok = ok && w == (int32_t)rle::decode(&dec[y * line_bytes], w, &enc[y * stride], enc_len[y], bytes, &used) && used == enc_len[y];
+      std::vector<uint8_t> ref(stride);
+      size_t ref_len = ref_encode(ref.data(), &pixels[y * line_bytes], line_bytes, bytes);
+      ok = ok && ref_len >= enc_len[y];  // the new encoder never does worse on a line.
+    }
+    ok = ok && 0 == memcmp(dec.data(), pixels, raw);
+
+    double enc_us = bench::measure([&]()
+    {
+      for (int32_t y = 0; y < h; ++y)
+      {
+        rle::encode(&enc[y * stride], &pixels[y * line_bytes], w, bytes);
+      }
+    });
+    double ref_us = bench::measure([&]()
+    {
+      for (int32_t y = 0; y < h; ++y)
+      {
+        ref_encode(&enc[y * stride], &pixels[y * line_bytes], line_bytes, bytes);
+      }
+    });
+    for (int32_t y = 0; y < h; ++y)
+    { // ref_encode overwrote the buffer.
+      rle::encode(&enc[y * stride], &pixels[y * line_bytes], w, bytes);
+    }
+    double dec_us = bench::measure([&]()
+    {
+      for (int32_t y = 0; y < h; ++y)
+      {
+        rle::decode(&dec[y * line_bytes], w, &enc[y * stride], enc_len[y], bytes);
+      }
+    });
+
+    printf("%-10s %4d x %-4d %2u bit %9u %9u %6.1f%%  %8.1f %8.1f  x%5.2f %8.1f  %s\n"
+          , screen.name.c_str(), w, h, depth
+          , (uint32_t)raw, (uint32_t)total, total * 100.0 / raw
+          , bench::mbyte(raw, enc_us), bench::mbyte(raw, ref_us), ref_us / enc_us
+          , bench::mbyte(raw, dec_us)
+          , ok ? "ok" : "MISMATCH");
+    if (!ok) { ++error_count; }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  std::vector<screen_t> screens;
+  if (argc > 1)
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      screen_t s;
+      s.name = argv[i];
+      auto slash = s.name.find_last_of('/');
+      if (slash != std::string::npos) { s.name = s.name.substr(slash + 1); }
+      if (!load_file(argv[i], s.file) || !image_size(s.file, s.width, s.height))
+      {
+        printf("can not read %s\n", argv[i]);
+        return 1;
+      }
+      screens.push_back(s);
+    }
+  }
+  else
+  {
+    static constexpr int32_t sizes[][2] = { { 135, 240 }, { 320, 240 }, { 1280, 720 } };
+    for (auto& size : sizes)
+    {
+      screens.push_back({ "settings" , size[0], size[1], {}, draw_settings  });
+      screens.push_back({ "terminal" , size[0], size[1], {}, draw_terminal  });
+      screens.push_back({ "dashboard", size[0], size[1], {}, draw_dashboard });
+    }
+    screen_t photo;
+    photo.name = "photo";
+    photo.file.assign(jpg_image, jpg_image + sizeof(jpg_image));
+    image_size(photo.file, photo.width, photo.height);
+    screens.push_back(photo);
+  }
+
+  printf("screen     size        depth   raw [B]   enc [B]  ratio  enc MB/s ref MB/s  speedup dec MB/s\n");
+  LGFX_Sprite sprite;
+  for (auto& screen : screens)
+  {
+    for (auto depth : depths)
+    {
+      bench_screen(screen, sprite, depth);
+    }
+  }
+  return error_count ? 1 : 0;
+}
@@ -22,6 +22,8 @@
 #include "lgfx/v1/LGFXBase.hpp"
 #include "lgfx/v1/LGFX_Sprite.hpp"
 #include "lgfx/v1/LGFX_Button.hpp"
+#include "lgfx/v1/LGFX_TextLabel.hpp"
+#include "lgfx/v1/LGFX_ImageCache.hpp"
 
 #include <vector>
 #include <memory>
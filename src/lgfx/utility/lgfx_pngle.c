@@ -78,6 +78,10 @@ struct _pngle_t {
   uint8_t *scanline_buf;
   uint8_t *palette;
 
+  // work area given to lgfx_pngle_new_static (NULL = malloc)
+  uint8_t *pool;
+  size_t pool_len;
+
   size_t n_palettes;
   uint32_t trans_color;
 
@@ -138,13 +142,43 @@ pngle_t *lgfx_pngle_new()
   {
     res->palette       = NULL;
     res->scanline_buf  = NULL;
+    res->pool          = NULL;
+    res->pool_len      = 0;
   }
   return res;
 }
 
+// the palette (256 x 4 bytes) is placed at the top of the pool, the scanline after it.
+#define LGFX_PNGLE_POOL_PALETTE_LEN 1024
+
+static size_t pngle_scanline_len(uint32_t width, uint_fast8_t channels, uint_fast8_t depth)
+{
+  uint_fast8_t bytes_per_pixel = (channels * depth + 7) >> 3;
+  return ((width * channels * depth + 7) >> 3) + (2 * bytes_per_pixel);
+}
+
+size_t lgfx_pngle_work_size(uint32_t max_width)
+{
+  return sizeof(pngle_t) + 8 + LGFX_PNGLE_POOL_PALETTE_LEN + pngle_scanline_len(max_width, 4, 16);
+}
+
+pngle_t *lgfx_pngle_new_static(void *work, size_t work_len)
+{
+  uintptr_t top = ((uintptr_t)work + 7) & ~(uintptr_t)7;
+  size_t pad = top - (uintptr_t)work;
+  if (work == NULL || work_len < pad + sizeof(pngle_t) + LGFX_PNGLE_POOL_PALETTE_LEN) { return NULL; }
+
+  pngle_t* res = (pngle_t *)top;
+  res->palette       = NULL;
+  res->scanline_buf  = NULL;
+  res->pool          = (uint8_t*)top + sizeof(pngle_t);
+  res->pool_len      = work_len - pad - sizeof(pngle_t);
+  return res;
+}
+
 void lgfx_pngle_destroy(pngle_t *pngle)
 {
-  if (pngle) {
+  if (pngle && pngle->pool == NULL) {
     if (pngle->scanline_buf ) { free(pngle->scanline_buf ); }
     if (pngle->palette      ) { free(pngle->palette      ); }
     free(pngle);
@@ -395,8 +429,16 @@ static int pngle_on_data(pngle_t *pngle, uint8_t *lzbuf, size_t len, size_t outb
 int lgfx_pngle_prepare(pngle_t *pngle, lgfx_pngle_read_callback_t read_cb, void* user_data)
 {
   if (pngle == NULL || read_cb == NULL) { return PNGLE_STATE_ERROR; }
-  if (pngle->palette      ) { free(pngle->palette      ); pngle->palette      = NULL; }
-  if (pngle->scanline_buf ) { free(pngle->scanline_buf ); pngle->scanline_buf = NULL; }
+  if (pngle->pool)
+  {
+    pngle->palette      = NULL;
+    pngle->scanline_buf = NULL;
+  }
+  else
+  {
+    if (pngle->palette      ) { free(pngle->palette      ); pngle->palette      = NULL; }
+    if (pngle->scanline_buf ) { free(pngle->scanline_buf ); pngle->scanline_buf = NULL; }
+  }
 
   pngle->read_callback = read_cb;
   pngle->user_data = user_data;
@@ -470,9 +512,16 @@ int lgfx_pngle_prepare(pngle_t *pngle, lgfx_pngle_read_callback_t read_cb, void*
                                   : 0x01
                    );
 
-    uint_fast8_t bytes_per_pixel = (pngle->channels * pngle->hdr.depth + 7) >> 3;
-    size_t memlen = ((pngle->hdr.width * pngle->channels * pngle->hdr.depth + 7) >> 3) + (2 * bytes_per_pixel);
-    if ((pngle->scanline_buf = (uint8_t*)PNGLE_MALLOC(memlen, 1, "scanline flipbuf")) == NULL) return PNGLE_ERROR("Insufficient memory");
+    size_t memlen = pngle_scanline_len(pngle->hdr.width, pngle->channels, pngle->hdr.depth);
+    if (pngle->pool)
+    {
+      if (memlen > pngle->pool_len - LGFX_PNGLE_POOL_PALETTE_LEN) return PNGLE_ERROR("Image too wide for the work area");
+      pngle->scanline_buf = pngle->pool + LGFX_PNGLE_POOL_PALETTE_LEN;
+    }
+    else
+    {
+      if ((pngle->scanline_buf = (uint8_t*)PNGLE_MALLOC(memlen, 1, "scanline flipbuf")) == NULL) return PNGLE_ERROR("Insufficient memory");
+    }
     memset(pngle->scanline_buf, 0, memlen);
   }
   // interlace
@@ -564,7 +613,7 @@ int lgfx_pngle_decomp(pngle_t *pngle, lgfx_pngle_draw_callback_t draw_cb)
       if (chunk_remain_3 > MIN(256, (1UL << pngle->hdr.depth))) return PNGLE_ERROR("Too many palettes in PLTE");
       if (chunk_remain_3 <= 0 || chunk_remain != chunk_remain_3 * 3) return PNGLE_ERROR("Invalid PLTE chunk size");
       if (pngle->palette) return PNGLE_ERROR("Too many PLTE chunk");
-      uint8_t* plt = (uint8_t*)PNGLE_MALLOC(chunk_remain_3, 4, "palette");
+      uint8_t* plt = pngle->pool ? pngle->pool : (uint8_t*)PNGLE_MALLOC(chunk_remain_3, 4, "palette");
       if (plt == NULL) return PNGLE_ERROR("Insufficient memory");
       pngle->palette = plt;
       pngle->n_palettes = chunk_remain_3;
@@ -33,6 +33,7 @@
 #define __LGFX_PNGLE_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,12 @@ typedef void (*lgfx_pngle_draw_callback_t)(void *user_data, uint32_t x, uint32_t
 // ----------------
 pngle_t *lgfx_pngle_new();
 
+// Places the pngle object, the palette and the scanline buffer in work instead of malloc.
+// Images up to max_width pixels wide fit in lgfx_pngle_work_size(max_width) bytes;
+// lgfx_pngle_prepare fails on wider ones. lgfx_pngle_destroy does not free work.
+pngle_t *lgfx_pngle_new_static(void *work, size_t work_len);
+size_t lgfx_pngle_work_size(uint32_t max_width);
+
 int lgfx_pngle_prepare(pngle_t *pngle, lgfx_pngle_read_callback_t read_cb, void* user_data);
 int lgfx_pngle_decomp(pngle_t *pngle, lgfx_pngle_draw_callback_t draw_cb);
 
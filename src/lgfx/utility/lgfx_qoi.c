@@ -58,6 +58,10 @@ struct _qoi_t
   qoi_rgba_t* pixelBuffer;
   qoi_rgba_t px;
 
+  // work area given to lgfx_qoi_new_static (NULL = malloc)
+  uint8_t* pool;
+  size_t pool_len;
+
   void *user_data;
   lgfx_qoi_read_callback_t read_cb;
 
@@ -114,14 +118,28 @@ int lgfx_qoi_prepare(qoi_t *qoi, lgfx_qoi_read_callback_t read_cb, void* user_da
   qoi->desc.height      = read_uint32(buf +  8);
   qoi->desc.channels    = read_uint8(buf + 12);
   qoi->desc.colorspace  = read_uint8(buf + 13);
+
+  // clear the state left by the previous image (lgfx_qoi_prepare may be called again on the same object)
+  qoi->px.v = 0;
   qoi->px.rgba.a = 255;
+  qoi->repeat = 0;
+  memset(qoi->index, 0, sizeof(qoi->index));
 
   if( qoi->desc.width == 0 || qoi->desc.height == 0 || qoi->desc.colorspace > 1 ) return QOI_ERROR("Incorrect QOI signature");
   if (qoi->desc.channels != 0 && qoi->desc.channels != 3 && qoi->desc.channels != 4) return QOI_ERROR("Bad channels count");
   // if( qoi->desc.height >= QOI_PIXELS_MAX / qoi->desc.width ) return QOI_ERROR("Image too big");
 
-  qoi->pixelBuffer = (qoi_rgba_t*)malloc(qoi->desc.width * sizeof(qoi_rgba_t));
-  if (qoi->pixelBuffer == NULL) { return QOI_ERROR("Insufficient memory"); }
+  if (qoi->pool)
+  {
+    if (qoi->desc.width > qoi->pool_len / sizeof(qoi_rgba_t)) { return QOI_ERROR("Image too wide for the work area"); }
+    qoi->pixelBuffer = (qoi_rgba_t*)qoi->pool;
+  }
+  else
+  {
+    lgfx_qoi_reset(qoi);
+    qoi->pixelBuffer = (qoi_rgba_t*)malloc(qoi->desc.width * sizeof(qoi_rgba_t));
+    if (qoi->pixelBuffer == NULL) { return QOI_ERROR("Insufficient memory"); }
+  }
 
   return 0;
 }
@@ -218,7 +236,7 @@ int lgfx_qoi_decomp(qoi_t *qoi, lgfx_qoi_draw_callback_t draw_cb)
 
 void lgfx_qoi_reset(qoi_t *qoi)
 {
-  if (!qoi) return;
+  if (!qoi || qoi->pool) return;
   if (qoi->pixelBuffer != NULL) { free(qoi->pixelBuffer);  qoi->pixelBuffer = NULL; }
 }
 
@@ -231,9 +249,29 @@ qoi_t *lgfx_qoi_new()
 }
 
 
+size_t lgfx_qoi_work_size(uint32_t max_width)
+{
+  return sizeof(qoi_t) + 8 + max_width * sizeof(qoi_rgba_t);
+}
+
+
+qoi_t *lgfx_qoi_new_static(void *work, size_t work_len)
+{
+  uintptr_t top = ((uintptr_t)work + 7) & ~(uintptr_t)7;
+  size_t pad = top - (uintptr_t)work;
+  if (work == NULL || work_len < pad + sizeof(qoi_t)) { return NULL; }
+
+  qoi_t *qoi = (qoi_t *)top;
+  memset(qoi, 0, sizeof(qoi_t));
+  qoi->pool = (uint8_t*)top + sizeof(qoi_t);
+  qoi->pool_len = work_len - pad - sizeof(qoi_t);
+  return qoi;
+}
+
+
 void lgfx_qoi_destroy(qoi_t *qoi)
 {
-  if (qoi) {
+  if (qoi && qoi->pool == NULL) {
     lgfx_qoi_reset(qoi);
     free(qoi);
   }
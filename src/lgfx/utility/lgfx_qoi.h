@@ -2,6 +2,7 @@
 #define __LGFX_QOI_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,12 @@ typedef int (*lfgx_qoi_writer_func)(uint8_t* buf, size_t buf_len);
 // ---------------------
 qoi_t *lgfx_qoi_new();
 
+// Places the qoi object and the pixel row in work instead of malloc.
+// Images up to max_width pixels wide fit in lgfx_qoi_work_size(max_width) bytes;
+// lgfx_qoi_prepare fails on wider ones. lgfx_qoi_destroy does not free work.
+qoi_t *lgfx_qoi_new_static(void *work, size_t work_len);
+size_t lgfx_qoi_work_size(uint32_t max_width);
+
 int lgfx_qoi_prepare(qoi_t *qoi, lgfx_qoi_read_callback_t read_cb, void* user_data);
 int lgfx_qoi_decomp(qoi_t *qoi, lgfx_qoi_draw_callback_t draw_cb);
 
@@ -468,7 +468,8 @@ static void block_idct (
 /*-----------------------------------------------------------------------*/
 
 static JRESULT mcu_load (
-	lgfxJdec* jd		/* Pointer to the decompressor object */
+	lgfxJdec* jd,		/* Pointer to the decompressor object */
+	uint_fast8_t skip	/* 1: only advance the bit stream (no de-quantize and IDCT) */
 )
 {
 	int32_t *tmp = (int32_t*)jd->workbuf;	/* Block working buffer for de-quantize and IDCT */
@@ -503,10 +504,12 @@ static JRESULT mcu_load (
 			jd->dcv[cmp] = d;					/* Save current DC value for next block */
 		}
 		const int32_t *dqf = jd->qttbl[jd->qtid[cmp]];			/* De-quantizer table ID for this component */
-		tmp[0] = d * dqf[0] >> 8;				/* De-quantize, apply scale factor of Arai algorithm and descale 8 bits */
+		if (!skip) {
+			tmp[0] = d * dqf[0] >> 8;				/* De-quantize, apply scale factor of Arai algorithm and descale 8 bits */
 
-		/* Extract following 63 AC elements from input stream */
-		memset(&tmp[1], 0, 63*sizeof(int32_t));	/* Clear rest of elements */
+			/* Extract following 63 AC elements from input stream */
+			memset(&tmp[1], 0, 63*sizeof(int32_t));	/* Clear rest of elements */
+		}
 		hb = jd->huffbits[id][1];				/* Huffman table for the AC elements */
 		hc = jd->huffcode[id][1];
 		hd = jd->huffdata[id][1];
@@ -526,7 +529,9 @@ static JRESULT mcu_load (
 			}
 		} while (++i < 64);		/* Next AC element */
 
-		if (i == 1 || (JD_USE_SCALE && jd->scale == 3)) {
+		if (skip) {
+			/* The block is not output */
+		} else if (i == 1 || (JD_USE_SCALE && jd->scale == 3)) {
 			d = (int16_t)((*tmp >> 8) + 128);	/* If scale ratio is 1/8, IDCT can be ommited and only DC element is used */
 			for (i = 0; i < 64; bp[i++] = d) ;
 		} else {
@@ -951,8 +956,32 @@ JRESULT lgfx_jd_decomp (
 	uint_fast8_t scale							/* Output de-scaling factor (0 to 3) */
 )
 {
-	uint32_t x, y, mx, my;
-	uint32_t nrst, rst, rsc;
+	uint32_t mx = jd->msx << 3, my = jd->msy << 3;	/* Size of the MCU (pixel) */
+
+	jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;	/* Initialize DC values */
+	jd->rst = jd->rsc = 0;
+
+	return lgfx_jd_decomp_range(jd, outfunc, scale, 0, ((jd->width + mx - 1) / mx) * ((jd->height + my - 1) / my));
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Decompress a range of MCUs (in raster order)                          */
+/*-----------------------------------------------------------------------*/
+/* The bit stream, DC values and restart counters of jd must be at the   */
+/* state of mcu_start. With outfunc == 0 the MCUs are only skipped over. */
+
+JRESULT lgfx_jd_decomp_range (
+	lgfxJdec* jd,								/* Initialized decompression object */
+	uint32_t (*outfunc)(void*, void*, JRECT*),	/* RGB output function (0:skip) */
+	uint_fast8_t scale,							/* Output de-scaling factor (0 to 3) */
+	uint32_t mcu_start,							/* Index of the first MCU */
+	uint32_t mcu_end							/* Index of the MCU following the last one */
+)
+{
+	uint32_t mx, my, mcu_w, nrst, i;
 	JRESULT rc;
 
 
@@ -961,29 +990,23 @@ JRESULT lgfx_jd_decomp (
 
 	nrst = jd->nrst;
 	mx = jd->msx << 3; my = jd->msy << 3;			/* Size of the MCU (pixel) */
-
-	jd->dcv[2] = jd->dcv[1] = jd->dcv[0] = 0;	/* Initialize DC values */
-	rst = rsc = 0;
+	mcu_w = (jd->width + mx - 1) / mx;				/* Number of MCUs in a row */
 
 	rc = JDR_OK;
 
-	for (y = 0; y < jd->height; y += my) {		/* Vertical loop of MCUs */
-		x = 0;
-		do {	/* Horizontal loop of MCUs */
-			if (nrst && rst++ == nrst) {	/* Process restart interval if enabled */
-				rc = restart(jd, rsc++);
-				if (rc != JDR_OK) return rc;
-				rst = 1;
-			}
-			rc = mcu_load(jd);					/* Load an MCU (decompress huffman coded stream and apply IDCT) */
+	for (i = mcu_start; i < mcu_end; ++i) {
+		if (nrst && jd->rst++ == nrst) {	/* Process restart interval if enabled */
+			rc = restart(jd, jd->rsc++);
 			if (rc != JDR_OK) return rc;
-			rc = mcu_output(jd, outfunc, x, y);	/* Output the MCU (color space conversion, scaling and output) */
+			jd->rst = 1;
+		}
+		rc = mcu_load(jd, !outfunc);			/* Load an MCU (decompress huffman coded stream and apply IDCT) */
+		if (rc != JDR_OK) return rc;
+		if (outfunc) {
+			rc = mcu_output(jd, outfunc, (i % mcu_w) * mx, (i / mcu_w) * my);	/* Output the MCU (color space conversion, scaling and output) */
 			if (rc != JDR_OK) return rc;
-		} while ( (x += mx) < jd->width);
+		}
 	}
 
 	return rc;
 }
-
-
-
@@ -69,6 +69,7 @@ struct lgfxJdec {
 	uint8_t qtid[3];		/* Quantization table ID of each component */
 	int32_t dcv[3];				/* Previous DC element of each component */
 	uint16_t nrst;				/* Restart inverval */
+	uint16_t rst, rsc;			/* MCUs since the last restart, next restart marker number */
 	uint16_t width, height;/* Size of the input image (pixel) */
 	uint8_t* huffbits[2][2];	/* Huffman bit distribution tables [id][dcac] */
 	uint16_t* huffcode[2][2];	/* Huffman code word tables [id][dcac] */
@@ -88,6 +89,7 @@ struct lgfxJdec {
 /* TJpgDec API functions */
 JRESULT lgfx_jd_prepare (lgfxJdec*, uint32_t(*)(void*,uint8_t*,uint32_t), void*, uint_fast16_t, void*);
 JRESULT lgfx_jd_decomp (lgfxJdec*, uint32_t(*)(void*,void*,JRECT*), uint_fast8_t);
+JRESULT lgfx_jd_decomp_range (lgfxJdec*, uint32_t(*)(void*,void*,JRECT*), uint_fast8_t, uint32_t, uint32_t);
 
 
 #ifdef __cplusplus
@@ -17,9 +17,9 @@ Contributors:
 /----------------------------------------------------------------------------*/
 
 #include "LGFXBase.hpp"
+#include "LGFX_ImageCache.hpp"
 
 #include "../internal/limits.h"
-#include "../utility/lgfx_miniz.h"
 #include "../utility/lgfx_pngle.h"
 #include "../utility/lgfx_qrcode.h"
 #include "../utility/lgfx_tjpgd.h"
@@ -31,7 +31,15 @@ Contributors:
 #include <stdarg.h>
 #include <stdint.h>
 #include <math.h>
-#include <list>
+#include <new>
+#include <vector>
+
+#if !defined (ESP_PLATFORM) && !defined (ARDUINO) && defined (__has_include)
+ #if __has_include(<thread>)
+  #include <thread>
+  #define LGFX_JPG_PARALLEL
+ #endif
+#endif
 
 #ifdef min
 #undef min
@@ -1825,7 +1833,7 @@ namespace lgfx
 
   struct paint_point_t { int32_t lx,rx,y,oy; };
 
-  static void paint_add_points(std::list<paint_point_t>& points, int32_t lx, int32_t rx, int32_t y, int32_t oy, uint8_t* linebuf)
+  static void paint_add_points(std::vector<paint_point_t>& points, int32_t lx, int32_t rx, int32_t y, int32_t oy, uint8_t* linebuf)
   {
     paint_point_t pt { 0, 0, y, oy };
     do
@@ -1839,6 +1847,60 @@ namespace lgfx
     } while (lx <= rx);
   }
 
+  /// Scanline flood fill on a mask of the whole clip area, for panels whose readRect is a memory access.
+  /// mask holds 1 for pixels that match the target color; filled pixels are cleared, so each pixel is visited once.
+  /// Rows are read into the mask the first time a span reaches them, so small fills stay cheap.
+  void LGFXBase::flood_fill_masked(int32_t x, int32_t y, uint8_t* mask, pixelcopy_t* param)
+  {
+    struct span_t { int32_t lx, rx, y, dy; };  // scan row y within [lx, rx]. row (y - dy) is the parent.
+
+    const int32_t cl = _clip_l;
+    const int32_t cr = _clip_r;
+    const int32_t ct = _clip_t;
+    const int32_t cb = _clip_b;
+    const int32_t w = cr - cl + 1;
+
+    std::vector<bool> loaded(cb - ct + 1, false);
+    std::vector<span_t> spans;
+    spans.reserve(64);
+    spans.push_back({ x, x, y, 1 });
+    spans.push_back({ x, x, y - 1, -1 });
+
+    startWrite();
+    while (!spans.empty())
+    {
+      span_t sp = spans.back();
+      spans.pop_back();
+      if (sp.y < ct || sp.y > cb) continue;
+
+      auto line = &mask[(sp.y - ct) * w];
+      if (!loaded[sp.y - ct])
+      {
+        loaded[sp.y - ct] = true;
+        _panel->readRect(cl, sp.y, w, 1, line, param);
+      }
+      line -= cl;
+      int32_t lx = sp.lx;
+      while (lx <= sp.rx)
+      {
+        if (!line[lx]) { ++lx; continue; }
+        int32_t l = lx;
+        int32_t r = lx;
+        while (l > cl && line[l - 1]) --l;
+        while (r < cr && line[r + 1]) ++r;
+        memset(&line[l], 0, r - l + 1);
+        writeFillRectPreclipped(l, sp.y, r - l + 1, 1);
+
+        spans.push_back({ l, r, sp.y + sp.dy, sp.dy });
+        // The run leaks past the parent span; those parts of the parent row have not been scanned yet.
+        if (l < sp.lx) { spans.push_back({ l, sp.lx - 1, sp.y - sp.dy, -sp.dy }); }
+        if (r > sp.rx) { spans.push_back({ sp.rx + 1, r, sp.y - sp.dy, -sp.dy }); }
+        lx = r + 2;
+      }
+    }
+    endWrite();
+  }
+
   void LGFXBase::floodFill(int32_t x, int32_t y)
   {
     if (x < _clip_l || x > _clip_r || y < _clip_t || y > _clip_b) return;
@@ -1863,11 +1925,26 @@ namespace lgfx
 
     const int32_t cl = _clip_l;
     const int32_t w = _clip_r - cl + 1;
+
+    if (_panel->isMemoryBacked())
+    {
+      const int32_t h = _clip_b - _clip_t + 1;
+      auto mask = (uint8_t*)heap_alloc_psram(w * h);
+      if (!mask) { mask = (uint8_t*)heap_alloc(w * h); }
+      if (mask)
+      {
+        flood_fill_masked(x, y, mask, &p);
+        heap_free(mask);
+        return;
+      }
+    }
+
     size_t bufIdx = 0;
     uint8_t* linebufs[3] = { new uint8_t[w], new uint8_t[w], new uint8_t[w] };
     int32_t bufY[3] = {y, -2, -2};  // 3 line buffer (default: out of range.)
     _panel->readRect(cl, y, w, 1, linebufs[0], &p);
-    std::list<paint_point_t> points;
+    std::vector<paint_point_t> points;
+    points.reserve(64);
     points.push_back({x, x, y, y});
 
     startWrite();
@@ -1910,7 +1987,9 @@ namespace lgfx
       int32_t rx = it->rx;
       int32_t ly = it->y;
       int32_t oy = it->oy;
-      points.erase(it);
+      // the order of pending points does not matter, so remove by moving the last one into place.
+      *it = points.back();
+      points.pop_back();
       if (!linebuf[lx]) continue;
 
       int32_t lxsav = lx - 1;
@@ -2485,6 +2564,9 @@ namespace lgfx
 
     if (this->_runtime_font->loadFont(data)) {
       result = true;
+      if (this->_runtime_font->getType() == IFont::font_type_t::ft_vlw) {
+        static_cast<VLWfont*>(this->_runtime_font.get())->setGlyphCacheSize(this->_font_cache_size);
+      }
       this->_font = this->_runtime_font.get();
       this->_font->getDefaultMetric(&this->_font_metrics);
     } else {
@@ -2498,6 +2580,15 @@ namespace lgfx
     if (_runtime_font.get() != nullptr) { setFont(&fonts::Font0); }
   }
 
+  void LGFXBase::setFontCacheSize(size_t bytes)
+  {
+    _font_cache_size = bytes;
+    if (_runtime_font.get() != nullptr && _runtime_font->getType() == IFont::font_type_t::ft_vlw)
+    {
+      static_cast<VLWfont*>(_runtime_font.get())->setGlyphCacheSize(bytes);
+    }
+  }
+
   void LGFXBase::showFont(uint32_t td)
   {
     int_fast16_t x = 0;
@@ -2598,6 +2689,25 @@ namespace lgfx
 
 //----------------------------------------------------------------------------
 
+  /// zoom <= -1 : stretch to fit_width / fit_height , -1 < zoom <= 0 : same as the other axis ( both : fit keeping the aspect ratio )
+  static void fit_zoom(float fit_width, float fit_height, int32_t w, int32_t h, float& zoom_x, float& zoom_y)
+  {
+    if (zoom_x <= -1.0f) { zoom_x = fit_width  / w; }
+    if (zoom_y <= -1.0f) { zoom_y = fit_height / h; }
+    if (zoom_x <= 0.0f)
+    {
+      if (zoom_y <= 0.0f)
+      {
+        zoom_y = std::min<float>(fit_width / w, fit_height / h);
+      }
+      zoom_x = zoom_y;
+    }
+    if (zoom_y <= 0.0f)
+    {
+      zoom_y = zoom_x;
+    }
+  }
+
   struct image_info_t
   {
     LGFXBase* gfx;
@@ -2640,22 +2750,9 @@ namespace lgfx
 
       if (zoom_y_ <= 0.0f || zoom_x_ <= 0.0f)
       {
-        float fit_width  = (maxWidth_  > 0) ? maxWidth_  : gfx_->width();
-        float fit_height = (maxHeight_ > 0) ? maxHeight_ : gfx_->height();
-        if (zoom_x_ <= -1.0f) { zoom_x_ = fit_width  / w_; }
-        if (zoom_y_ <= -1.0f) { zoom_y_ = fit_height / h_; }
-        if (zoom_x_ <= 0.0f)
-        {
-          if (zoom_y_ <= 0.0f)
-          {
-            zoom_y_ = std::min<float>(fit_width / w_, fit_height / h_);
-          }
-          zoom_x_ = zoom_y_;
-        }
-        if (zoom_y_ <= 0.0f)
-        {
-          zoom_y_ = zoom_x_;
-        }
+        fit_zoom( (maxWidth_  > 0) ? maxWidth_  : gfx_->width()
+                , (maxHeight_ > 0) ? maxHeight_ : gfx_->height()
+                , w_, h_, zoom_x_, zoom_y_);
       }
 
       if (datum_)
@@ -2850,6 +2947,23 @@ namespace lgfx
   struct draw_jpg_info_t : public image_decoder_t
   {
     pixelcopy_t *pc;
+#if defined (LGFX_JPG_PARALLEL)
+    std::vector<uint8_t>* record = nullptr;  // every byte read from data, for the parallel decoder
+
+    static uint32_t record_data(void* self, uint8_t* buf, uint32_t len)
+    {
+      auto info = (draw_jpg_info_t*)self;
+      auto record = info->record;
+      size_t pos = record->size();
+      record->resize(pos + len);
+      info->data->preRead();
+      int res = info->data->read(&(*record)[pos], len, len);
+      if (res < 0) res = 0;
+      record->resize(pos + res);
+      if (buf) memcpy(buf, &(*record)[pos], res);
+      return res;
+    }
+#endif
   };
 
   static uint32_t jpg_push_image(void *device, void *bitmap, JRECT *rect)
@@ -2892,7 +3006,270 @@ namespace lgfx
     return 1;
   }
 
+#if defined (LGFX_JPG_PARALLEL)
+
+  /// One stripe of MCU rows, decoded by its own thread from the recorded stream.
+  struct jpg_stripe_t
+  {
+    const uint8_t* data;  // whole JPEG stream
+    uint32_t length;
+    uint32_t pos;         // read position of this decoder
+    bgr888_t* buf;        // output, width * rows
+    int32_t width;
+    int32_t top;          // first output row of the stripe
+    int32_t rows;
+    uint32_t mcu_start;
+    uint32_t mcu_end;
+
+    struct state_t  // bit stream state at mcu_start
+    {
+      uint32_t offset;    // stream position of the current byte
+      int32_t dcv[3];
+      uint16_t rst;
+      uint16_t rsc;
+      uint8_t byte;
+      uint8_t dbit;
+    } state;
+
+    JRESULT res = JDR_INP;
+    std::thread thread;
+
+    static uint32_t read(void* self, uint8_t* buf, uint32_t len)
+    {
+      auto s = (jpg_stripe_t*)self;
+      uint32_t remain = s->length - s->pos;
+      if (len > remain) len = remain;
+      if (buf) memcpy(buf, &s->data[s->pos], len);
+      s->pos += len;
+      return len;
+    }
+
+    static uint32_t write(void* self, void* bitmap, JRECT* rect)
+    {
+      auto s = (jpg_stripe_t*)self;
+      auto src = (const bgr888_t*)bitmap;
+      int32_t w = rect->right - rect->left + 1;
+      auto dst = &s->buf[(rect->top - s->top) * s->width + rect->left];
+      for (uint32_t y = rect->top; y <= rect->bottom; ++y)
+      {
+        memcpy(dst, src, w * sizeof(bgr888_t));
+        dst += s->width;
+        src += w;
+      }
+      return 1;
+    }
+
+    void save(const lgfxJdec* jd, state_t* st) const
+    {
+      st->offset = pos - (jd->dpend - jd->dptr);
+      st->byte = *jd->dptr;
+      st->dbit = jd->dbit;
+      st->rst = jd->rst;
+      st->rsc = jd->rsc;
+      memcpy(st->dcv, jd->dcv, sizeof(st->dcv));
+    }
+
+    void restore(lgfxJdec* jd)
+    {
+      jd->inbuf[0] = state.byte;
+      jd->dptr = jd->inbuf;
+      jd->dpend = jd->inbuf + 1;
+      jd->dbit = state.dbit;
+      jd->rst = state.rst;
+      jd->rsc = state.rsc;
+      memcpy(jd->dcv, state.dcv, sizeof(state.dcv));
+      pos = state.offset + 1;
+    }
+  };
+
+  static constexpr uint16_t jpg_sz_pool = 3900;
+
+  static void jpg_decode_stripe(jpg_stripe_t* s, uint_fast8_t scale)
+  {
+    lgfxJdec jd;
+    auto pool = (uint8_t*)heap_alloc(jpg_sz_pool);
+    if (!pool) { s->res = JDR_MEM1; return; }
+    s->pos = 0;
+    s->res = lgfx_jd_prepare(&jd, jpg_stripe_t::read, pool, jpg_sz_pool, s);
+    if (s->res == JDR_OK)
+    {
+      s->restore(&jd);
+      s->res = lgfx_jd_decomp_range(&jd, jpg_stripe_t::write, scale, s->mcu_start, s->mcu_end);
+    }
+    heap_free(pool);
+  }
+
+  static uint32_t jpg_gcd(uint32_t a, uint32_t b)
+  {
+    while (b) { uint32_t t = a % b; a = b; b = t; }
+    return a;
+  }
+
+  /// Decodes the frame prepared by jd in stripes, on up to `threads` threads.
+  /// The stripes start at restart markers when the interval lines up with MCU rows,
+  /// otherwise the calling thread walks the Huffman stream to find the stripe boundaries.
+  static JRESULT jpg_decomp_parallel(lgfxJdec* jd, draw_jpg_info_t* info, uint_fast8_t scale, uint32_t threads)
+  {
+    auto& stream = *info->record;
+    auto data = info->data;
+
+    // Fetch the rest of the entropy coded segment, up to its terminating marker.
+    uint32_t entropy = stream.size() - (jd->dpend - jd->dptr) + 1;
+    std::vector<uint32_t> markers;  // positions of the RSTn markers
+    size_t i = entropy;
+    for (;;)
+    {
+      if (i + 1 >= stream.size())
+      {
+        size_t len = stream.size();
+        stream.resize(len + JD_SZBUF);
+        data->preRead();
+        int res = data->read(&stream[len], JD_SZBUF);
+        stream.resize(len + (res > 0 ? res : 0));
+        if (res <= 0) break;
+        continue;
+      }
+      if (stream[i] != 0xFF) { ++i; continue; }
+      uint_fast8_t m = stream[i + 1];
+      if (m == 0xFF) { ++i; continue; }
+      if (m != 0 && (m & 0xF8) != 0xD0) break;
+      if (m) markers.push_back(i);
+      i += 2;
+    }
+    data->postRead();
+
+    uint32_t mx = jd->msx << 3;
+    uint32_t my = jd->msy << 3;
+    uint32_t mcu_w = (jd->width + mx - 1) / mx;
+    uint32_t mcu_h = (jd->height + my - 1) / my;
+    uint32_t count = std::min(threads, mcu_h);
+
+    // Stripe boundaries in MCU rows; move them onto restart markers when possible.
+    std::vector<uint32_t> rows;
+    rows.push_back(0);
+    uint32_t step = jd->nrst ? jd->nrst / jpg_gcd(jd->nrst, mcu_w) : 0;
+    bool use_markers = step && step < mcu_h && count > 1;
+    for (uint32_t k = 1; k < count; ++k)
+    {
+      uint32_t r = k * mcu_h / count;
+      if (use_markers)
+      {
+        r = (r + (step >> 1)) / step * step;
+        if (r == 0 || r >= mcu_h || r == rows.back()) continue;
+        uint32_t idx = r * mcu_w / jd->nrst;  // restart interval the row starts
+        if (idx > markers.size()) { use_markers = false; r = k * mcu_h / count; }
+      }
+      if (r > rows.back()) rows.push_back(r);
+    }
+    if (use_markers && rows.size() * 2 < count) { use_markers = false; }  // interval too coarse
+    if (!use_markers)
+    { // split evenly and locate the boundaries by walking the stream.
+      rows.resize(1);
+      for (uint32_t k = 1; k < count; ++k) { rows.push_back(k * mcu_h / count); }
+    }
+    rows.push_back(mcu_h);
+    count = rows.size() - 1;
+
+    int32_t width = jd->width >> scale;
+    std::vector<jpg_stripe_t> stripes(count);
+    for (uint32_t k = 0; k < count; ++k)
+    {
+      auto& s = stripes[k];
+      s.data = stream.data();
+      s.length = stream.size();
+      s.width = width;
+      s.top = (rows[k] * my) >> scale;
+      s.rows = (std::min(rows[k + 1] * my, (uint32_t)jd->height) >> scale) - s.top;
+      s.mcu_start = rows[k] * mcu_w;
+      s.mcu_end = rows[k + 1] * mcu_w;
+      s.buf = (s.rows > 0) ? (bgr888_t*)heap_alloc_psram(width * s.rows * sizeof(bgr888_t)) : nullptr;
+      if (s.buf == nullptr && s.rows > 0) { s.buf = (bgr888_t*)heap_alloc(width * s.rows * sizeof(bgr888_t)); }
+    }
+
+    // The first stripe starts where lgfx_jd_prepare left the bit stream.
+    lgfxJdec scan;
+    jpg_stripe_t reader;
+    reader.data = stream.data();
+    reader.length = stream.size();
+    reader.pos = 0;
+    uint8_t* pool = nullptr;
+    JRESULT res = JDR_OK;
+    if (!use_markers && count > 1)
+    {
+      pool = (uint8_t*)heap_alloc(jpg_sz_pool);
+      res = pool ? lgfx_jd_prepare(&scan, jpg_stripe_t::read, pool, jpg_sz_pool, &reader) : JDR_MEM1;
+    }
+    scan.rst = scan.rsc = 0;
+    scan.dcv[0] = scan.dcv[1] = scan.dcv[2] = 0;
+    memset(&stripes[0].state, 0, sizeof(jpg_stripe_t::state_t));
+    stripes[0].state.offset = entropy - 1;
+
+    uint32_t launched = 0;
+    for (uint32_t k = 0; k < count && res == JDR_OK; ++k)
+    {
+      auto& s = stripes[k];
+      if (k)
+      {
+        if (use_markers)
+        { // RSTn of the interval starting this stripe is read by the restart process of the decoder.
+          uint32_t idx = s.mcu_start / jd->nrst;
+          memset(&s.state, 0, sizeof(jpg_stripe_t::state_t));
+          s.state.offset = markers[idx - 1] - 1;
+          s.state.rst = jd->nrst;
+          s.state.rsc = idx - 1;
+        }
+        else
+        {
+          res = lgfx_jd_decomp_range(&scan, nullptr, scale, stripes[k - 1].mcu_start, s.mcu_start);
+          if (res != JDR_OK) break;
+          reader.save(&scan, &s.state);
+        }
+      }
+      if (s.rows > 0 && s.buf == nullptr) { res = JDR_MEM1; break; }
+      s.thread = std::thread(jpg_decode_stripe, &s, scale);
+      ++launched;
+    }
+    if (pool) { heap_free(pool); }
+
+    // Draw the stripes in order while the later ones are still decoding.
+    auto gfx = info->gfx;
+    for (uint32_t k = 0; k < launched; ++k)
+    {
+      auto& s = stripes[k];
+      s.thread.join();
+      if (res == JDR_OK) { res = s.res; }
+      if (res != JDR_OK || s.rows <= 0) continue;
+      if (info->zoom_x == 1.0f && info->zoom_y == 1.0f)
+      {
+        info->pc->src_data = s.buf;
+        info->pc->src_x32_add = 1 << FP_SCALE;
+        info->pc->src_y32_add = 0;
+        gfx->pushImage(info->x, info->y + s.top, s.width, s.rows, info->pc, false);
+      }
+      else
+      {
+        float affine[6] =
+        { info->zoom_x, 0.0f , (float)info->x
+        , 0.0f , info->zoom_y, s.top * info->zoom_y + info->y
+        };
+        gfx->pushImageAffine(affine, s.width, s.rows, s.buf);
+      }
+    }
+    for (auto& s : stripes)
+    {
+      if (s.buf) { heap_free(s.buf); }
+    }
+    return res;
+  }
+
+#endif
+
   bool LGFXBase::draw_jpg(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum)
+  {
+    return draw_jpg(data, x, y, maxWidth, maxHeight, offX, offY, zoom_x, zoom_y, datum, nullptr);
+  }
+
+  bool LGFXBase::draw_jpg(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum, JpegDecoder* decoder)
   {
     prepareTmpTransaction(data);
     draw_jpg_info_t drawinfo;
@@ -2901,22 +3278,51 @@ namespace lgfx
     drawinfo.data = data;
 
     //TJpgD jpegdec;
-    lgfxJdec jpegdec;
-
-    static constexpr uint16_t sz_pool = 3900;
-    uint8_t *pool = (uint8_t*)heap_alloc_dma(sz_pool);
-    if (!pool)
+    lgfxJdec local_jdec;
+    lgfxJdec* jdec = &local_jdec;
+    uint8_t *pool = nullptr;
+
+    auto infunc = drawinfo.read_data;
+#if defined (LGFX_JPG_PARALLEL)
+    uint32_t threads = _jpg_threads ? _jpg_threads : std::thread::hardware_concurrency();
+    std::vector<uint8_t> record;
+    if (threads > 1)
     {
-      // ESP_LOGW("LGFX", "jpeg memory alloc fail");
-      return false;
+      drawinfo.record = &record;
+      infunc = drawinfo.record_data;
     }
+#endif
 
-    auto jres = lgfx_jd_prepare(&jpegdec, drawinfo.read_data, pool, sz_pool, &drawinfo);
+    JRESULT jres;
+    if (decoder)
+    {
+      jdec = &decoder->_jdec;
+      jres = decoder->read_header(data);
+#if defined (LGFX_JPG_PARALLEL)
+      // the header is not read through infunc ; the stripe decoders need it at the top of the record.
+      if (drawinfo.record) { record.assign(decoder->_header.begin(), decoder->_header.end()); }
+#endif
+      if (jres == JDR_OK)
+      {
+        jres = decoder->prepare(infunc, &drawinfo);
+      }
+    }
+    else
+    {
+      static constexpr uint16_t sz_pool = 3900;
+      pool = (uint8_t*)heap_alloc_dma(sz_pool);
+      if (!pool)
+      {
+        // ESP_LOGW("LGFX", "jpeg memory alloc fail");
+        return false;
+      }
+      jres = lgfx_jd_prepare(jdec, infunc, pool, sz_pool, &drawinfo);
+    }
 
     if (jres != JDR_OK)
     {
       // ESP_LOGW("LGFX", "jpeg prepare error:%x", jres);
-      heap_free(pool);
+      if (pool) { heap_free(pool); }
       return false;
     }
 
@@ -2930,9 +3336,9 @@ namespace lgfx
                        , zoom_x
                        , zoom_y
                        , datum
-                       , jpegdec.width, jpegdec.height))
+                       , jdec->width, jdec->height))
     {
-      heap_free(pool);
+      if (pool) { heap_free(pool); }
       return false;
     }
 
@@ -2953,13 +3359,20 @@ namespace lgfx
 
     this->startWrite(!data->hasParent());
 
-    jres = lgfx_jd_decomp(&jpegdec, drawinfo.zoom_x == 1.0f && drawinfo.zoom_y == 1.0f ? jpg_push_image : jpg_push_image_affine, div);
+#if defined (LGFX_JPG_PARALLEL)
+    if (drawinfo.record)
+    {
+      jres = jpg_decomp_parallel(jdec, &drawinfo, div, threads);
+    }
+    else
+#endif
+    jres = lgfx_jd_decomp(jdec, drawinfo.zoom_x == 1.0f && drawinfo.zoom_y == 1.0f ? jpg_push_image : jpg_push_image_affine, div);
 
     drawinfo.end();
     this->endWrite();
     drawinfo.data->preRead();
 
-    heap_free(pool);
+    if (pool) { heap_free(pool); }
 
     if (jres != JDR_OK) {
       // ESP_LOGW("LGFX", "jpeg decomp error:%x", jres);
@@ -2972,6 +3385,24 @@ namespace lgfx
   {
     bgra8888_t* lineBuffer;
     pixelcopy_t *pc;
+    const uint8_t* header = nullptr;  // bytes already read by PngDecoder / QoiDecoder, returned first
+    uint32_t header_len = 0;
+
+    static uint32_t read_header_data(void *self, uint8_t *buf, uint32_t len)
+    {
+      auto p = (png_file_decoder_t*)self;
+      uint32_t res = 0;
+      if (p->header_len)
+      {
+        res = std::min(len, p->header_len);
+        if (buf) { memcpy(buf, p->header, res); buf += res; }
+        p->header += res;
+        p->header_len -= res;
+        len -= res;
+        if (len == 0) { return res; }
+      }
+      return res + read_data(self, buf, len);
+    }
   };
 
 //-----
@@ -3265,30 +3696,54 @@ namespace lgfx
 
 
   static pngle_t* pngle = nullptr;
+  static ImageEncoder* image_encoder = nullptr;
   void LGFXBase::releasePngMemory(void)
   {
     if (pngle) {
       lgfx_pngle_destroy(pngle);
       pngle = nullptr;
     }
+    if (image_encoder) {
+      delete image_encoder;
+      image_encoder = nullptr;
+    }
   }
 
   bool LGFXBase::draw_png(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum)
   {
-    /// PNG描画を繰り返し使用した場合、pngleのメモリ確保に失敗するケースがある。
-    /// そのため、pngle使用後に解放せず、再利用できる構成に変更した。
-    /// メモリを明示的に解放したい場合は releasePngMemory を使用する。
-    if (pngle == nullptr) {
-      pngle = lgfx_pngle_new();
-    }
-    if (pngle == nullptr) { return false; }
+    return draw_png(data, x, y, maxWidth, maxHeight, offX, offY, zoom_x, zoom_y, datum, nullptr);
+  }
 
+  bool LGFXBase::draw_png(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum, PngDecoder* decoder)
+  {
     prepareTmpTransaction(data);
     png_file_decoder_t png;
     png.lineBuffer = nullptr;
     png.data = data;
 
-    if (lgfx_pngle_prepare(pngle, image_decoder_t::read_data, &png) < 0)
+    pngle_t* ctx;
+    auto infunc = image_decoder_t::read_data;
+    if (decoder)
+    {
+      if (!decoder->read_header(data)) { return false; }
+      ctx = decoder->_pngle;
+      png.header = decoder->_header;
+      png.header_len = decoder->_header_len;
+      infunc = png_file_decoder_t::read_header_data;
+    }
+    else
+    {
+      /// PNG描画を繰り返し使用した場合、pngleのメモリ確保に失敗するケースがある。
+      /// そのため、pngle使用後に解放せず、再利用できる構成に変更した。
+      /// メモリを明示的に解放したい場合は releasePngMemory を使用する。
+      if (pngle == nullptr) {
+        pngle = lgfx_pngle_new();
+      }
+      if (pngle == nullptr) { return false; }
+      ctx = pngle;
+    }
+
+    if (lgfx_pngle_prepare(ctx, infunc, &png) < 0)
     {
       return false;
     }
@@ -3303,7 +3758,7 @@ namespace lgfx
                   , zoom_x
                   , zoom_y
                   , datum
-                  , lgfx_pngle_get_width(pngle), lgfx_pngle_get_height(pngle)))
+                  , lgfx_pngle_get_width(ctx), lgfx_pngle_get_height(ctx)))
     {
       return true;
     }
@@ -3318,19 +3773,21 @@ namespace lgfx
       pc.fp_skip = pixelcopy_t::skip_rgb_affine<bgra8888_t>;
       pc.fp_copy = pixelcopy_t::get_fp_copy_rgb_affine<bgra8888_t>(pc.dst_depth);
     }
-    // png.lineBuffer = (bgra8888_t*)heap_alloc_dma(sizeof(bgra8888_t) * png.maxWidth);
-    // pc.src_data = png.lineBuffer;
+    // without a decoder, the line buffer is allocated by the draw callbacks when it is needed.
+    bgra8888_t* own_line = decoder ? (bgra8888_t*)decoder->get_line_buffer(png.maxWidth) : nullptr;
+    png.lineBuffer = own_line;
+    pc.src_data = own_line;
 
     png.pc = &pc;
 
     this->startWrite(!data->hasParent());
 
-    auto res = lgfx_pngle_decomp(pngle, png.zoom_x == 1.0f && png.zoom_y == 1.0f ? png_draw_alpha_callback : png_draw_alpha_scale_callback);
+    auto res = lgfx_pngle_decomp(ctx, png.zoom_x == 1.0f && png.zoom_y == 1.0f ? png_draw_alpha_callback : png_draw_alpha_scale_callback);
 
     this->endWrite();
     if (png.lineBuffer) {
       this->waitDMA();
-      heap_free(png.lineBuffer);
+      if (png.lineBuffer != own_line) { heap_free(png.lineBuffer); }
     }
     png.end();
 
@@ -3340,15 +3797,34 @@ namespace lgfx
 
   bool LGFXBase::draw_qoi(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum)
   {
-    qoi_t *qoi = lgfx_qoi_new();
-    if (qoi == nullptr) { return false; }
+    return draw_qoi(data, x, y, maxWidth, maxHeight, offX, offY, zoom_x, zoom_y, datum, nullptr);
+  }
 
+  bool LGFXBase::draw_qoi(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum, QoiDecoder* decoder)
+  {
     prepareTmpTransaction(data);
     png_file_decoder_t png;
     png.lineBuffer = nullptr;
     png.data = data;
 
-    if (lgfx_qoi_prepare(qoi, image_decoder_t::read_data, &png) < 0)
+    qoi_t *qoi;
+    auto infunc = image_decoder_t::read_data;
+    if (decoder)
+    {
+      if (!decoder->read_header(data)) { return false; }
+      qoi = decoder->_qoi;
+      png.header = decoder->_header;
+      png.header_len = decoder->_header_len;
+      infunc = png_file_decoder_t::read_header_data;
+    }
+    else
+    {
+      qoi = lgfx_qoi_new();
+      if (qoi == nullptr) { return false; }
+    }
+
+    // lgfx_qoi_destroy does not free the work area of a decoder.
+    if (lgfx_qoi_prepare(qoi, infunc, &png) < 0)
     {
       lgfx_qoi_destroy(qoi);
       return false;
@@ -3380,7 +3856,8 @@ namespace lgfx
       pc.fp_skip = pixelcopy_t::skip_rgb_affine<bgra8888_t>;
       pc.fp_copy = pixelcopy_t::get_fp_copy_rgb_affine<bgra8888_t>(pc.dst_depth);
     }
-    png.lineBuffer = (bgra8888_t*)heap_alloc_dma(sizeof(bgra8888_t) * png.maxWidth);
+    bgra8888_t* own_line = decoder ? (bgra8888_t*)decoder->get_line_buffer(png.maxWidth) : nullptr;
+    png.lineBuffer = own_line ? own_line : (bgra8888_t*)heap_alloc_dma(sizeof(bgra8888_t) * png.maxWidth);
     pc.src_data = png.lineBuffer;
 
     png.pc = &pc;
@@ -3392,7 +3869,7 @@ namespace lgfx
     this->endWrite();
     if (png.lineBuffer) {
       this->waitDMA();
-      heap_free(png.lineBuffer);
+      if (png.lineBuffer != own_line) { heap_free(png.lineBuffer); }
     }
     png.end();
     lgfx_qoi_destroy(qoi);
@@ -3400,47 +3877,311 @@ namespace lgfx
     return res < 0 ? false : true;
   }
 
+//----------------------------------------------------------------------------
 
-  struct png_encoder_t
+  /// PNG / QOI pixels stored with their alpha into an LGFX_ImageCache entry, at its zoom.
+  /// Pixels map to the same area as in png_draw_alpha_scale_callback.
+  struct image_capture_t : public image_decoder_t
   {
-    LGFXBase* gfx;
-    int32_t x;
-    int32_t y;
+    bgra8888_t* image;
+    int32_t width;
+    int32_t height;
+  };
+
+  static void image_capture_callback(void *user_data, uint32_t x, uint32_t y, uint_fast8_t div_x, size_t len, const uint8_t* argb)
+  {
+    auto p = (image_capture_t*)user_data;
+
+    int32_t y0 = ceilf( y      * p->zoom_y);
+    int32_t y1 = ceilf((y + 1) * p->zoom_y);
+    if (y1 > p->height) y1 = p->height;
+    if (y0 >= y1) return;
+
+    auto row = &p->image[y0 * p->width];
+    do
+    {
+      int32_t l = ceilf( x      * p->zoom_x);
+      int32_t r = ceilf((x + 1) * p->zoom_x);
+      if (r > p->width) r = p->width;
+      for (; l < r; ++l) { row[l].set(*(uint32_t*)argb); }
+      argb += 4;
+      x += div_x;
+    } while (--len);
+
+    while (++y0 < y1)
+    {
+      memcpy(&row[p->width], row, p->width * sizeof(bgra8888_t));
+      row += p->width;
+    }
+  }
+
+  static bool capture_image(image_capture_t* cap, bool qoi)
+  {
+    if (qoi)
+    {
+      auto ctx = lgfx_qoi_new();
+      if (ctx == nullptr) { return false; }
+      bool res = lgfx_qoi_prepare(ctx, image_decoder_t::read_data, cap) >= 0
+              && lgfx_qoi_decomp(ctx, image_capture_callback) >= 0;
+      lgfx_qoi_destroy(ctx);
+      return res;
+    }
+    if (pngle == nullptr) {
+      pngle = lgfx_pngle_new();
+    }
+    if (pngle == nullptr) { return false; }
+    return lgfx_pngle_prepare(pngle, image_decoder_t::read_data, cap) >= 0
+        && lgfx_pngle_decomp(pngle, image_capture_callback) >= 0;
+  }
+
+  bool LGFXBase::draw_cached_file(DataWrapper* file, const char* path, draw_image_t draw_image, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float zoom_x, float zoom_y, datum_t datum)
+  {
+    auto cache = _image_cache;
+    LGFX_ImageCache::entry_t* entry = nullptr;
+    auto depth = getColorDepth();
+    bool cacheable = !hasPalette() && _write_conv.bits >= 8;
+
+    // a zoom <= 0 fits the image in maxWidth x maxHeight, or in the whole target.
+    int32_t fit_width = 0;
+    int32_t fit_height = 0;
+    if (zoom_x <= 0.0f || zoom_y <= 0.0f)
+    {
+      fit_width  = (maxWidth  > 0) ? maxWidth  : width();
+      fit_height = (maxHeight > 0) ? maxHeight : height();
+    }
+
+    if (cacheable)
+    {
+      entry = cache->find(file->getFileSystem(), path, depth, zoom_x, zoom_y, fit_width, fit_height);
+    }
+
+    if (entry == nullptr)
+    {
+      bool res = false;
+      prepareTmpTransaction(file);
+      file->preRead();
+      if (file->open(path))
+      {
+        int32_t w, h;
+        bool alpha;
+        if (cacheable && LGFX_ImageCache::read_info(file, &w, &h, &alpha))
+        {
+          float zx = zoom_x;
+          float zy = zoom_y;
+          if (fit_width) { fit_zoom(fit_width, fit_height, w, h, zx, zy); }
+          entry = cache->create(file->getFileSystem(), path, alpha ? argb8888_4Byte : depth, ceilf(w * zx), ceilf(h * zy));
+          if (entry)
+          {
+            entry->key_zoom_x = zoom_x;
+            entry->key_zoom_y = zoom_y;
+            entry->fit_width  = fit_width;
+            entry->fit_height = fit_height;
+            entry->depth  = depth;
+            entry->width  = w;
+            entry->height = h;
+            entry->zoom_x = zx;
+            entry->zoom_y = zy;
+            entry->alpha  = alpha;
+
+            file->seek(0);
+            bool decoded;
+            if (alpha)
+            { // PNG / QOI with transparent pixels are kept with their alpha, to be blended when drawn.
+              image_capture_t cap;
+              cap.data   = file;
+              cap.image  = (bgra8888_t*)entry->sprite.getBuffer();
+              cap.width  = entry->sprite.width();
+              cap.height = entry->sprite.height();
+              cap.zoom_x = zx;
+              cap.zoom_y = zy;
+              decoded = capture_image(&cap, draw_image == static_cast<draw_image_t>(&LGFXBase::draw_qoi));
+            }
+            else
+            {
+              decoded = (entry->sprite.*draw_image)(file, 0, 0, 0, 0, 0, 0, zx, zy, datum_t::top_left);
+            }
+            if (!decoded)
+            {
+              cache->remove(entry);
+              entry = nullptr;
+            }
+          }
+        }
+        if (entry == nullptr)
+        { // not cacheable : draw from the file.
+          file->seek(0);
+          res = (this->*draw_image)(file, x, y, maxWidth, maxHeight, offX, offY, zoom_x, zoom_y, datum);
+        }
+        file->close();
+      }
+      file->postRead();
+      if (entry == nullptr) { return res; }
+    }
+
+    // same position and clipping as the draw from the file, at the zoom the image was decoded at.
+    png_file_decoder_t png;
+    PointerWrapper none;
+    png.data = &none;
+    png.lineBuffer = nullptr;
+    if (!png.begin( this
+                  , x
+                  , y
+                  , maxWidth
+                  , maxHeight
+                  , offX
+                  , offY
+                  , entry->zoom_x
+                  , entry->zoom_y
+                  , datum
+                  , entry->width, entry->height))
+    {
+      return true;
+    }
+
+    auto& sprite = entry->sprite;
+    if (!entry->alpha)
+    { // same as pushSprite; without DMA, as the sprite may be evicted by the next draw.
+      pixelcopy_t pc(sprite.getBuffer(), depth, sprite.getColorDepth(), false);
+      pushImage(png.x - png.offX, png.y - png.offY, sprite.width(), sprite.height(), &pc, false);
+    }
+    else
+    {
+      pixelcopy_t pc(nullptr, depth, bgra8888_t::depth, _palette_count);
+      pc.fp_skip = pixelcopy_t::skip_rgb_affine<bgra8888_t>;
+      pc.fp_copy = pixelcopy_t::get_fp_copy_rgb_affine<bgra8888_t>(pc.dst_depth);
+      png.pc = &pc;
+
+      auto image = (const bgra8888_t*)sprite.getBuffer();
+      int32_t w = sprite.width();
+      int32_t bottom = png.offY + png.maxHeight;
+      this->startWrite();
+      for (int32_t iy = png.offY; iy < bottom; ++iy)
+      {
+        png_draw_alpha_callback(&png, 0, iy, 1, w, (const uint8_t*)&image[iy * w]);
+      }
+      this->endWrite();
+      if (png.lineBuffer) {
+        this->waitDMA();
+        heap_free(png.lineBuffer);
+      }
+    }
+    png.end();
+    return true;
+  }
+
+
+  struct png_memory_writer_t
+  {
+    uint8_t* buf;
+    size_t len;
+    size_t capacity;
   };
 
-  static uint8_t *png_encoder_get_row( uint8_t *pImage, int flip, int w, int h, int y, int, void *target )
+  static bool png_memory_writer(void* user, const uint8_t* data, uint32_t len)
   {
-    auto enc = static_cast<png_encoder_t*>(target);
-    uint32_t ypos = (flip ? (h - 1 - y) : y);
-    enc->gfx->readRectRGB( enc->x, enc->y + ypos, w, 1, pImage );
-    return pImage;
+    auto mem = static_cast<png_memory_writer_t*>(user);
+    if (mem->len + len > mem->capacity)
+    {
+      size_t capacity = mem->capacity + (mem->capacity >> 1);
+      if (capacity < mem->len + len) { capacity = mem->len + len; }
+      auto buf = (uint8_t*)realloc(mem->buf, capacity);
+      if (buf == nullptr) { return false; }
+      mem->buf = buf;
+      mem->capacity = capacity;
+    }
+    memcpy(&mem->buf[mem->len], data, len);
+    mem->len += len;
+    return true;
   }
 
-  void* LGFXBase::createPng(size_t* datalen, int32_t x, int32_t y, int32_t w, int32_t h)
+  void* LGFXBase::createPng(size_t* datalen, int32_t x, int32_t y, int32_t w, int32_t h, ImageEncoder::png_preset_t preset, ImageEncoder::png_filter_t filter)
   {
-    if (_adjust_abs(x, w)||_adjust_abs(y, h)) return nullptr;
+    *datalen = 0;
+    ImageEncoder::config_t config;
+    config.format = ImageEncoder::png;
+    config.chunk_size = 4096;
+    config.png_preset = preset;
+    config.png_filter = filter;
+
+    png_memory_writer_t mem = { nullptr, 0, 0 };
+    if (0 == writeImage(png_memory_writer, &mem, config, x, y, w, h))
+    {
+      if (mem.buf) { free(mem.buf); }
+      return nullptr;
+    }
+    *datalen = mem.len;
+    return mem.buf;
+  }
+
+  size_t LGFXBase::writeImage(ImageEncoder::writer_t writer, void* user, const ImageEncoder::config_t& config, int32_t x, int32_t y, int32_t w, int32_t h)
+  {
+    if (w == 0) { w = width()  - x; }
+    if (h == 0) { h = height() - y; }
+    if (_adjust_abs(x, w)||_adjust_abs(y, h)) return 0;
     if (x < 0) { w += x; x = 0; }
     if (w > width() - x)  w = width()  - x;
-    if (w < 1) return nullptr;
+    if (w < 1) return 0;
     if (y < 0) { h += y; y = 0; }
     if (h > height() - y) h = height() - y;
-    if (h < 1) return nullptr;
+    if (h < 1) return 0;
 
-    void* rgbBuffer = heap_alloc_dma(w * 3);
+    /// 圧縮状態 (tdefl) やチャンクバッファは次回の撮影で再利用する。
+    /// メモリを明示的に解放したい場合は releasePngMemory を使用する。
+    if (image_encoder == nullptr) {
+      image_encoder = new (std::nothrow) ImageEncoder();
+    }
+    if (image_encoder == nullptr) { return 0; }
 
-    png_encoder_t enc = { this, x, y };
+    uint32_t row_bytes = w * 3;
+    int32_t rows = config.readback_size / row_bytes;
+    if (rows > h) { rows = h; }
+    if (rows < 1) { rows = 1; }
+    auto buf = (uint8_t*)heap_alloc_dma(row_bytes * rows);
+    if (buf == nullptr && rows > 1)
+    {
+      rows = 1;
+      buf = (uint8_t*)heap_alloc_dma(row_bytes);
+    }
+    if (buf == nullptr) return 0;
 
-    auto res = tdefl_write_image_to_png_file_in_memory_ex_with_cb(rgbBuffer, w, h, 3, datalen, 6, 0, (tdefl_get_png_row_func)png_encoder_get_row, &enc);
+    auto& encoder = *image_encoder;
+    bool res = encoder.begin(config, w, h, writer, user);
+    bool bottom_up = encoder.isBottomUp();
+    for (int32_t i = 0; res && i < h; i += rows)
+    {
+      int32_t n = (rows < h - i) ? rows : (h - i);
+      readRectRGB(x, bottom_up ? (y + h - i - n) : (y + i), w, n, buf);
+      for (int32_t j = 0; res && j < n; ++j)
+      {
+        res = encoder.writeRow(&buf[(bottom_up ? (n - 1 - j) : j) * row_bytes]);
+      }
+    }
+    heap_free(buf);
 
-    heap_free(rgbBuffer);
+    return res ? encoder.end() : 0;
+  }
 
+  static bool image_writer_data_wrapper(void* user, const uint8_t* data, uint32_t len)
+  {
+    auto sink = static_cast<DataWrapper*>(user);
+    sink->preRead();
+    bool res = (uint32_t)sink->write(data, len) == len;
+    sink->postRead();
     return res;
   }
 
+  size_t LGFXBase::writeImage(DataWrapper* sink, const ImageEncoder::config_t& config, int32_t x, int32_t y, int32_t w, int32_t h)
+  {
+    this->prepareTmpTransaction(sink);
+    return writeImage(image_writer_data_wrapper, sink, config, x, y, w, h);
+  }
+
 //----------------------------------------------------------------------------
 
   void LGFXBase::prepareTmpTransaction(DataWrapper* data)
   {
+    // a buffering wrapper hands the bus over itself, once per block it reads from its source.
+    while (auto source = data->getSource()) { data = source; }
     if (data->need_transaction && isBusShared())
     {
       data->parent = this;
@@ -29,6 +29,10 @@ Contributors:
 #include "misc/colortype.hpp"
 #include "misc/pixelcopy.hpp"
 #include "misc/DataWrapper.hpp"
+#include "misc/BufferedDataWrapper.hpp"
+#include "misc/JpegDecoder.hpp"
+#include "misc/ImageDecoder.hpp"
+#include "misc/ImageEncoder.hpp"
 #include "lgfx_fonts.hpp"
 #include "Touch.hpp"
 #include "panel/Panel_Device.hpp"
@@ -52,6 +56,7 @@ namespace lgfx
 #define LGFX_PRINTF_ENABLED
 #endif
 
+  class LGFX_ImageCache;
 
   class LGFXBase
 #if defined (ARDUINO)
@@ -315,6 +320,7 @@ namespace lgfx
     LGFX_INLINE   RGBColor*     getPalette(void) const { return getPalette_impl(); }
     LGFX_INLINE   bool isReadable(void) const { return _panel->isReadable(); }
     LGFX_INLINE   bool isEPD(void) const { return _panel->isEpd(); }
+    LGFX_INLINE   bool isMemoryBacked(void) const { return _panel->isMemoryBacked(); }
     LGFX_INLINE   bool getSwapBytes(void) const { return _swapBytes; }
     LGFX_INLINE   void setSwapBytes(bool swap) { _swapBytes = swap; }
     LGFX_INLINE   bool isBusShared(void) const { return _panel->isBusShared(); }
@@ -794,6 +800,10 @@ namespace lgfx
     /// unload VLW font
     void unloadFont(void);
 
+    /// Sets the byte budget of the glyph cache for VLW fonts loaded at run time. ( 0 = disabled )
+    /// Also applies to fonts loaded later. Statistics are available from the VLWfont returned by getFont().
+    void setFontCacheSize(size_t bytes);
+
     /// show VLW font
     void showFont(uint32_t td = 2000);
 
@@ -896,6 +906,7 @@ namespace lgfx
     } \
     bool drawImg##File(DataWrapper* file, const char *path, int32_t x = 0, int32_t y = 0, int32_t maxWidth = 0, int32_t maxHeight = 0, int32_t offX = 0, int32_t offY = 0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left) \
     { \
+      if (_image_cache) { return this->draw_cached_file(file, path, &LGFXBase::draw_img, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum); } \
       bool res = false; \
       this->prepareTmpTransaction(file); \
       file->preRead(); \
@@ -930,6 +941,52 @@ namespace lgfx
 
   #undef LGFX_FUNCTION_GENERATOR
 
+    /// Number of threads drawJpg decodes with on hosts that have std::thread. ( 1 = single thread (default), 0 = one per CPU core )
+    /// The image is split into stripes of MCU rows, at restart markers when the interval allows it.
+    /// Each stripe is buffered as RGB888 and drawn in order as soon as it is done. Ignored on embedded targets.
+    void setJpgDecodeThreads(uint8_t threads) { _jpg_threads = threads; }
+    uint8_t getJpgDecodeThreads(void) const { return _jpg_threads; }
+
+    /// Keeps the images drawn by drawBmpFile / drawJpgFile / drawPngFile / drawQoiFile decoded in cache,
+    /// so that drawing the same path and scale again does not read the file. ( nullptr = off (default) )
+    /// The cache may be shared by several targets. see LGFX_ImageCache
+    void setImageCache(LGFX_ImageCache* cache) { _image_cache = cache; }
+    LGFX_ImageCache* getImageCache(void) const { return _image_cache; }
+
+    /// drawJpg with a decoder context that is kept between calls ( see JpegDecoder ).
+    bool drawJpg(JpegDecoder* decoder, const uint8_t *jpg_data, uint32_t jpg_len, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      PointerWrapper data_wrapper;
+      data_wrapper.set(jpg_data, jpg_len);
+      return this->draw_jpg(&data_wrapper, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+    inline bool drawJpg(JpegDecoder* decoder, DataWrapper *data, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      return this->draw_jpg(data, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+
+    /// drawPng / drawQoi with a decoder that keeps its work area between calls ( see PngDecoder / QoiDecoder ).
+    bool drawPng(PngDecoder* decoder, const uint8_t *png_data, uint32_t png_len, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      PointerWrapper data_wrapper;
+      data_wrapper.set(png_data, png_len);
+      return this->draw_png(&data_wrapper, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+    inline bool drawPng(PngDecoder* decoder, DataWrapper *data, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      return this->draw_png(data, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+    bool drawQoi(QoiDecoder* decoder, const uint8_t *qoi_data, uint32_t qoi_len, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      PointerWrapper data_wrapper;
+      data_wrapper.set(qoi_data, qoi_len);
+      return this->draw_qoi(&data_wrapper, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+    inline bool drawQoi(QoiDecoder* decoder, DataWrapper *data, int32_t x=0, int32_t y=0, int32_t maxWidth=0, int32_t maxHeight=0, int32_t offX=0, int32_t offY=0, float scale_x = 1.0f, float scale_y = 0.0f, datum_t datum = datum_t::top_left)
+    {
+      return this->draw_qoi(data, x, y, maxWidth, maxHeight, offX, offY, scale_x, scale_y, datum, decoder);
+    }
+
     [[deprecated("use float scale")]] bool drawJpg(const uint8_t *jpg_data, uint32_t jpg_len, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, jpeg_div::jpeg_div_t scale)
     {
       return drawJpg(jpg_data, jpg_len, x, y, maxWidth, maxHeight, offX, offY, 1.0f / (1 << scale));
@@ -944,7 +1001,22 @@ namespace lgfx
       return drawJpgFile(path, x, y, maxWidth, maxHeight, offX, offY, 1.0f / (1 << scale));
     }
 
-    void* createPng( size_t* datalen, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0);
+    /// Returns the PNG file in memory allocated with malloc. width / height 0 = up to the right / bottom edge.
+    /// The deflate state is kept for the next call until releasePngMemory.
+    void* createPng( size_t* datalen, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0
+                   , ImageEncoder::png_preset_t preset = ImageEncoder::png_balanced, ImageEncoder::png_filter_t filter = ImageEncoder::png_filter_none);
+
+    /// Encodes the area as PNG, QOI or BMP and passes the file to writer in chunks of config.chunk_size bytes.
+    /// The pixels are read back config.readback_size bytes of rows at a time, so neither the image nor the file has to fit in memory.
+    /// width / height 0 = up to the right / bottom edge. Returns the file size, or 0 on error.
+    size_t writeImage(ImageEncoder::writer_t writer, void* user, const ImageEncoder::config_t& config, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0);
+
+    /// writeImage to a file or stream opened for writing. ( e.g. DataWrapperT<FILE> , DataWrapperT<fs::File> )
+    size_t writeImage(DataWrapper* sink, const ImageEncoder::config_t& config, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0);
+
+    size_t writePng(DataWrapper* sink, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0) { return write_image(sink, ImageEncoder::png, x, y, width, height); }
+    size_t writeQoi(DataWrapper* sink, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0) { return write_image(sink, ImageEncoder::qoi, x, y, width, height); }
+    size_t writeBmp(DataWrapper* sink, int32_t x = 0, int32_t y = 0, int32_t width = 0, int32_t height = 0) { return write_image(sink, ImageEncoder::bmp, x, y, width, height); }
 
     void releasePngMemory(void);
 
@@ -971,6 +1043,22 @@ namespace lgfx
 
     virtual RGBColor* getPalette_impl(void) const { return nullptr; }
 
+    bool draw_jpg(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float scale_x, float scale_y, datum_t datum, JpegDecoder* decoder);
+    bool draw_png(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float scale_x, float scale_y, datum_t datum, PngDecoder* decoder);
+    bool draw_qoi(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float scale_x, float scale_y, datum_t datum, QoiDecoder* decoder);
+
+    typedef bool (LGFXBase::*draw_image_t)(DataWrapper* data, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float scale_x, float scale_y, datum_t datum);
+
+    /// drawXxxFile through _image_cache. draw_image decodes the file on a miss.
+    bool draw_cached_file(DataWrapper* file, const char* path, draw_image_t draw_image, int32_t x, int32_t y, int32_t maxWidth, int32_t maxHeight, int32_t offX, int32_t offY, float scale_x, float scale_y, datum_t datum);
+
+    size_t write_image(DataWrapper* sink, ImageEncoder::format_t format, int32_t x, int32_t y, int32_t w, int32_t h)
+    {
+      ImageEncoder::config_t config;
+      config.format = format;
+      return writeImage(sink, config, x, y, w, h);
+    }
+
     IPanel* _panel = nullptr;
 
     int32_t _sx = 0, _sy = 0, _sw = 0, _sh = 0; // for scroll zone
@@ -1007,6 +1095,9 @@ namespace lgfx
 
     std::shared_ptr<RunTimeFont> _runtime_font;  // run-time generated font
     std::shared_ptr<DataWrapper> _font_file;  // run-time font file
+    size_t _font_cache_size = 0;  // glyph cache budget for run-time VLW fonts
+    uint8_t _jpg_threads = 1;  // drawJpg decode threads (host only)
+    LGFX_ImageCache* _image_cache = nullptr;  // decoded images of drawXxxFile
     PointerWrapper _font_data;
 
     std::shared_ptr<DataWrapperFactory> _data_wrapper_factory;
@@ -1294,6 +1385,8 @@ namespace lgfx
 
     void read_rect(int32_t x, int32_t y, int32_t w, int32_t h, void* dst, pixelcopy_t* param);
 
+    void flood_fill_masked(int32_t x, int32_t y, uint8_t* mask, pixelcopy_t* param);
+
 //----------------------------------------------------------------------------
 
     bool clampArea(int32_t *xlo, int32_t *ylo, int32_t *xhi, int32_t *yhi);
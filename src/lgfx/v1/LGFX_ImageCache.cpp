@@ -0,0 +1,224 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "LGFX_ImageCache.hpp"
+
+#include "misc/bitmap.hpp"
+#include "platforms/common.hpp"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static uint32_t hash_path(const char* path)
+  { // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*path) { hash = (hash ^ (uint8_t)*path++) * 16777619u; }
+    return hash;
+  }
+
+  static inline uint32_t get_be32(const uint8_t* p)
+  {
+    return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+  }
+
+  bool LGFX_ImageCache::read_info(DataWrapper* data, int32_t* width, int32_t* height, bool* alpha)
+  {
+    uint8_t buf[32];
+    *alpha = false;
+    if (data->read(buf, 4, 4) != 4) return false;
+
+    if (!memcmp(buf, "\x89PNG", 4))
+    {
+      // signature (8) + IHDR length, type (8) + width, height, bit depth, color type
+      if (data->read(&buf[4], 22, 22) != 22) return false;
+      *width  = get_be32(&buf[16]);
+      *height = get_be32(&buf[20]);
+      if (buf[25] & 4)
+      { // gray + alpha, rgba
+        *alpha = true;
+      }
+      else
+      { // gray, rgb and palette images are transparent with a tRNS chunk, which comes before the image data.
+        data->skip(7);  // rest of IHDR + crc
+        for (;;)
+        {
+          if (data->read(buf, 8, 8) != 8) return false;
+          if (!memcmp(&buf[4], "tRNS", 4)) { *alpha = true; break; }
+          if (!memcmp(&buf[4], "IDAT", 4)) { break; }
+          data->skip(get_be32(buf) + 4);
+        }
+      }
+    }
+    else if (!memcmp(buf, "qoif", 4))
+    {
+      if (data->read(&buf[4], 10, 10) != 10) return false;
+      *width  = get_be32(&buf[4]);
+      *height = get_be32(&buf[8]);
+      *alpha = (buf[12] == 4);
+    }
+    else if (buf[0] == 'B' && buf[1] == 'M')
+    {
+      bitmap_header_t bmp;
+      data->seek(0);
+      if (!bmp.load_bmp_header(data)) return false;
+      *width  = bmp.biWidth;
+      *height = abs(bmp.biHeight);
+    }
+    else if (buf[0] == 0xFF && buf[1] == 0xD8)
+    { // JPEG : size from the first SOFn segment.
+      for (;;)
+      {
+        uint_fast8_t marker = buf[3];
+        if (buf[2] != 0xFF) return false;
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+        {
+          if (data->read(buf, 7, 7) != 7) return false;
+          *height = buf[3] << 8 | buf[4];
+          *width  = buf[5] << 8 | buf[6];
+          break;
+        }
+        if (data->read(buf, 2, 2) != 2) return false;
+        uint32_t len = buf[0] << 8 | buf[1];
+        if (len < 2) return false;
+        data->skip(len - 2);
+        if (data->read(&buf[2], 2, 2) != 2) return false;
+      }
+    }
+    else
+    {
+      return false;
+    }
+    return *width > 0 && *height > 0 && *width < INT16_MAX && *height < INT16_MAX;
+  }
+
+  LGFX_ImageCache::entry_t* LGFX_ImageCache::find(const void* file_system, const char* path, color_depth_t depth, float zoom_x, float zoom_y, int32_t fit_width, int32_t fit_height)
+  {
+    uint32_t hash = hash_path(path);
+    for (auto entry = _head; entry; entry = entry->next)
+    {
+      if (entry->hash != hash
+       || entry->file_system != file_system
+       || entry->depth != depth
+       || entry->key_zoom_x != zoom_x
+       || entry->key_zoom_y != zoom_y
+       || entry->fit_width  != fit_width
+       || entry->fit_height != fit_height
+       || strcmp(entry->path, path)) continue;
+      ++_hits;
+      if (entry != _head)
+      { // move to the front of the LRU list.
+        unlink(entry);
+        entry->prev = nullptr;
+        entry->next = _head;
+        _head->prev = entry;
+        _head = entry;
+      }
+      return entry;
+    }
+    ++_misses;
+    return nullptr;
+  }
+
+  LGFX_ImageCache::entry_t* LGFX_ImageCache::create(const void* file_system, const char* path, color_depth_t sprite_depth, int32_t width, int32_t height)
+  {
+    size_t path_len = strlen(path) + 1;
+    size_t size = sizeof(entry_t) + path_len + ((size_t)width * height * (sprite_depth & color_depth_t::bit_mask) >> 3);
+    if (size > _budget) return nullptr;
+    evict(_budget - size);
+
+    auto entry = new (std::nothrow) entry_t;
+    if (entry == nullptr) return nullptr;
+    entry->path = (char*)heap_alloc(path_len);
+    entry->sprite.setPsram(_psram);
+    entry->sprite.setColorDepth(sprite_depth);
+    if (entry->path == nullptr || !entry->sprite.createSprite(width, height))
+    {
+      if (entry->path) { heap_free(entry->path); }
+      delete entry;
+      return nullptr;
+    }
+    memcpy(entry->path, path, path_len);
+    entry->hash = hash_path(path);
+    entry->file_system = file_system;
+    entry->size = sizeof(entry_t) + path_len + entry->sprite.bufferLength();
+
+    entry->next = _head;
+    if (_head) { _head->prev = entry; } else { _tail = entry; }
+    _head = entry;
+    _used += entry->size;
+    ++_count;
+    return entry;
+  }
+
+  void LGFX_ImageCache::unlink(entry_t* entry)
+  {
+    if (entry->prev) { entry->prev->next = entry->next; } else { _head = entry->next; }
+    if (entry->next) { entry->next->prev = entry->prev; } else { _tail = entry->prev; }
+  }
+
+  void LGFX_ImageCache::remove(entry_t* entry)
+  {
+    unlink(entry);
+    _used -= entry->size;
+    --_count;
+    heap_free(entry->path);
+    delete entry;
+  }
+
+  void LGFX_ImageCache::evict(size_t budget)
+  {
+    while (_used > budget && _tail)
+    {
+      remove(_tail);
+      ++_evictions;
+    }
+  }
+
+  void LGFX_ImageCache::clear(void)
+  {
+    while (_tail) { remove(_tail); }
+  }
+
+  uint32_t LGFX_ImageCache::erase_entries(const char* path, bool any_file_system, const void* file_system)
+  {
+    uint32_t hash = hash_path(path);
+    uint32_t count = 0;
+    for (auto entry = _head; entry; )
+    {
+      auto next = entry->next;
+      if (entry->hash == hash
+       && (any_file_system || entry->file_system == file_system)
+       && !strcmp(entry->path, path))
+      {
+        remove(entry);
+        ++count;
+      }
+      entry = next;
+    }
+    return count;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
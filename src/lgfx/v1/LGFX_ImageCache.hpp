@@ -0,0 +1,130 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "LGFX_Sprite.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Decoded images of drawBmpFile / drawJpgFile / drawPngFile / drawQoiFile, kept in sprites.
+  /// Set with LGFXBase::setImageCache, the first draw of a file decodes the whole image at its scale
+  /// into a sprite of the color depth of the target; the next draws of the same path and scale
+  /// on the same file system ( DataWrapper::getFileSystem ) only push that sprite, without opening the file.
+  /// Images with transparent pixels are kept as argb8888 and blended like drawPng does.
+  /// Scaled BMP / JPEG images are resampled as if drawn at 0,0, so a sample edge may be one pixel off the draw from the file.
+  /// The least recently drawn images are freed to stay within the budget.
+  /// The cache does not notice when a file changes; call erase or clear after writing it.
+  class LGFX_ImageCache
+  {
+    friend class LGFXBase;
+  public:
+    LGFX_ImageCache(size_t budget = 32768) : _budget { budget } {}
+    LGFX_ImageCache(const LGFX_ImageCache&) = delete;
+    LGFX_ImageCache& operator=(const LGFX_ImageCache&) = delete;
+    ~LGFX_ImageCache(void) { clear(); }
+
+    /// Bytes the cached images may use, sprites and entries together. Images larger than this are drawn without caching.
+    void setBudget(size_t bytes) { _budget = bytes; evict(bytes); }
+    size_t getBudget(void) const { return _budget; }
+    size_t getUsedBytes(void) const { return _used; }
+    uint32_t getEntryCount(void) const { return _count; }
+
+    /// Allocates the sprites of new entries in PSRAM.
+    void setPsram(bool enabled) { _psram = enabled; }
+
+    /// Frees every image.
+    void clear(void);
+
+    /// Frees the images of path at every scale, from every file system. Returns the number of images freed.
+    uint32_t erase(const char* path) { return erase_entries(path, true, nullptr); }
+
+    /// Frees the images of path on the file system fs ( e.g. SD or LittleFS ) only.
+    template <typename T>
+    uint32_t erase(T &fs, const char* path)
+    {
+      DataWrapperT<T> file ( &fs );
+      return erase_entries(path, false, file.getFileSystem());
+    }
+
+    /// Draws that pushed a cached image / that read the file / images freed to stay within the budget.
+    uint32_t getHitCount(void) const { return _hits; }
+    uint32_t getMissCount(void) const { return _misses; }
+    uint32_t getEvictionCount(void) const { return _evictions; }
+    void resetStats(void) { _hits = _misses = _evictions = 0; }
+
+  protected:
+    struct entry_t
+    {
+      entry_t* prev = nullptr;   // LRU list, toward the most recently used
+      entry_t* next = nullptr;   // LRU list, toward the least recently used
+      LGFX_Sprite sprite;        // image at the zoom it is drawn with ( ceil(width * zoom_x) x ceil(height * zoom_y) )
+      char* path = nullptr;
+      const void* file_system;   // DataWrapper::getFileSystem of the file; the same path on another one is another image
+      uint32_t hash = 0;
+      uint32_t size = 0;         // bytes of this entry, including the sprite
+      float key_zoom_x;          // scale as passed to drawXxxFile
+      float key_zoom_y;
+      int32_t fit_width;         // area a zoom <= 0 fits the image in, 0 otherwise
+      int32_t fit_height;
+      color_depth_t depth;       // color depth of the target
+      int32_t width;             // size of the file
+      int32_t height;
+      float zoom_x;              // zoom the image was decoded at
+      float zoom_y;
+      bool alpha;                // sprite is argb8888 and blended when drawn
+    };
+
+    /// Size of the image from its header, and whether it may have transparent pixels.
+    /// The data is left at an arbitrary position.
+    static bool read_info(DataWrapper* data, int32_t* width, int32_t* height, bool* alpha);
+
+    /// Cached image, moved to the front of the LRU list. Counts a hit or a miss.
+    entry_t* find(const void* file_system, const char* path, color_depth_t depth, float zoom_x, float zoom_y, int32_t fit_width, int32_t fit_height);
+
+    /// New entry with a sprite of width x height pixels, freeing older images to make room for it.
+    /// nullptr if it does not fit in the budget or in memory.
+    entry_t* create(const void* file_system, const char* path, color_depth_t sprite_depth, int32_t width, int32_t height);
+
+    /// Frees the images of path, on file_system or on any file system.
+    uint32_t erase_entries(const char* path, bool any_file_system, const void* file_system);
+
+    /// Unlinks and frees an entry. ( evicted, erased or not decodable )
+    void remove(entry_t* entry);
+    void unlink(entry_t* entry);
+
+    /// Frees the least recently drawn images until at most budget bytes are used.
+    void evict(size_t budget);
+
+    entry_t* _head = nullptr;
+    entry_t* _tail = nullptr;
+    size_t _budget;
+    size_t _used = 0;
+    uint32_t _count = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    uint32_t _evictions = 0;
+    bool _psram = false;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,234 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+
+#include "LGFX_TextLabel.hpp"
+
+#include "../internal/algorithm.h"
+
+#ifdef min
+#undef min
+#endif
+#ifdef max
+#undef max
+#endif
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static inline uint32_t atlas_stride(int32_t w, uint_fast8_t bits)
+  {
+    uint32_t x_mask = 7 >> (bits >> 1);
+    return ((w + x_mask) & ~x_mask) * bits >> 3;
+  }
+
+  bool LGFX_TextLabel::create(LovyanGFX* gfx, const char* string, color_depth_t depth)
+  {
+    release();
+    if (gfx == nullptr || string == nullptr) return false;
+    uint_fast8_t bits = depth & color_depth_t::bit_mask;
+    if (bits != 1 && bits != 2 && bits != 4) return false;
+
+    auto style = gfx->getTextStyle();
+    if (!gfx->hasPalette())
+    {
+      _fore_rgb888 = style.fore_rgb888;
+      _back_rgb888 = style.back_rgb888;
+    }
+    _datum = style.datum;
+
+    auto font = gfx->getFont();
+    FontMetrics metrics;
+    font->getDefaultMetric(&metrics);
+    int32_t sy = 65536 * style.size_y;
+    _text_w = gfx->textWidth(string);
+    _text_h = (metrics.height * sy) >> 16;
+    _baseline = (metrics.baseline * sy) >> 16;
+
+    // Render white on black into an 8 bit canvas with room for glyphs overhanging the text box.
+    int32_t margin = (_text_h >> 1) + 1;
+    int32_t cw = _text_w + margin * 2;
+    int32_t ch = _text_h + margin * 2;
+    LGFX_Sprite canvas;
+    canvas.setColorDepth(grayscale_8bit);
+    if (!canvas.createSprite(cw, ch))
+    {
+      canvas.setPsram(true);
+      if (!canvas.createSprite(cw, ch)) return false;
+    }
+    canvas.fillScreen(0);
+    canvas.setFont(font);
+    style.fore_rgb888 = style.back_rgb888 = 0xFFFFFFu;
+    style.datum = textdatum_t::top_left;
+    style.padding_x = 0;
+    canvas.setTextStyle(style);
+    canvas.drawString(string, margin, margin);
+
+    // Bounding box of the rendered pixels, including the text box itself.
+    auto src = (const uint8_t*)canvas.getBuffer();
+    int32_t l = margin, r = margin + _text_w - 1;
+    int32_t t = margin, b = margin + _text_h - 1;
+    for (int32_t y = 0; y < ch; ++y)
+    {
+      auto line = &src[y * cw];
+      int32_t x0 = 0;
+      while (x0 < cw && !line[x0]) { ++x0; }
+      if (x0 == cw) continue;
+      int32_t x1 = cw - 1;
+      while (!line[x1]) { --x1; }
+      if (l > x0) l = x0;
+      if (r < x1) r = x1;
+      if (t > y) t = y;
+      if (b < y) b = y;
+    }
+    _origin_x = margin - l;
+    _origin_y = margin - t;
+
+    int32_t aw = r - l + 1;
+    int32_t ah = b - t + 1;
+    _atlas.setColorDepth(depth);
+    if (!_atlas.createSprite(aw, ah))
+    {
+      _atlas.setPsram(true);
+      if (!_atlas.createSprite(aw, ah)) { release(); return false; }
+    }
+
+    // Quantize the coverage into the packed atlas, most significant bits first.
+    uint32_t max_level = (1 << bits) - 1;
+    uint32_t stride = atlas_stride(aw, bits);
+    auto dst = (uint8_t*)_atlas.getBuffer();
+    memset(dst, 0, stride * ah);
+    for (int32_t y = 0; y < ah; ++y)
+    {
+      auto line = &src[(t + y) * cw + l];
+      auto d = &dst[y * stride];
+      for (int32_t x = 0; x < aw; ++x)
+      {
+        uint32_t level = (line[x] * max_level + 127) / 255;
+        if (level)
+        {
+          uint32_t i = x * bits;
+          d[i >> 3] |= level << (-(int32_t)(i + bits) & 7);
+        }
+      }
+    }
+    return true;
+  }
+
+  void LGFX_TextLabel::draw_label(LovyanGFX* dst, int32_t x, int32_t y, uint32_t fore_rgb888, uint32_t back_rgb888, bool transparent)
+  {
+    auto img = (const uint8_t*)_atlas.getBuffer();
+    if (dst == nullptr || img == nullptr) return;
+
+    if (_datum & middle_left) {          // vertical: middle
+      y -= _text_h >> 1;
+    } else if (_datum & bottom_left) {   // vertical: bottom
+      y -= _text_h;
+    } else if (_datum & baseline_left) { // vertical: baseline
+      y -= _baseline;
+    }
+    if (_datum & top_center) {           // Horizontal: middle
+      x -= _text_w >> 1;
+    } else if (_datum & top_right) {     // Horizontal: right
+      x -= _text_w;
+    }
+    x -= _origin_x;
+    y -= _origin_y;
+
+    int32_t w = _atlas.width();
+    int32_t h = _atlas.height();
+    uint_fast8_t bits = _atlas.getColorDepth() & color_depth_t::bit_mask;
+    uint32_t max_level = (1 << bits) - 1;
+
+    int32_t fore_r = (fore_rgb888 >> 16) & 0xFF;
+    int32_t fore_g = (fore_rgb888 >>  8) & 0xFF;
+    int32_t fore_b =  fore_rgb888        & 0xFF;
+
+    if (transparent && dst->isReadable() && !dst->hasPalette())
+    { // blend with the pixels read back from dst, a few rows at a time.
+      int32_t cl, ct, cw, ch;
+      dst->getClipRect(&cl, &ct, &cw, &ch);
+      int32_t sx = std::max(0, cl - x);
+      int32_t sy = std::max(0, ct - y);
+      int32_t ex = std::min(w, cl + cw - x);
+      int32_t ey = std::min(h, ct + ch - y);
+      int32_t bw = ex - sx;
+      if (bw <= 0 || sy >= ey) return;
+
+      int32_t rows = std::max<int32_t>(1, 2048 / (bw * (int32_t)sizeof(bgr888_t)));
+      auto buf = (bgr888_t*)alloca(rows * bw * sizeof(bgr888_t));
+      uint32_t stride = atlas_stride(w, bits);
+      dst->startWrite();
+      for (int32_t row = sy; row < ey; row += rows)
+      {
+        int32_t bh = std::min(rows, ey - row);
+        dst->readRectRGB(x + sx, y + row, bw, bh, buf);
+        for (int32_t yy = 0; yy < bh; ++yy)
+        {
+          auto line = &img[(row + yy) * stride];
+          auto bgr = &buf[yy * bw];
+          for (int32_t xx = 0; xx < bw; ++xx, ++bgr)
+          {
+            uint32_t i = (sx + xx) * bits;
+            uint32_t level = (line[i >> 3] >> (-(int32_t)(i + bits) & 7)) & max_level;
+            if (level == 0) continue;
+            int32_t p = 1 + level * 255 / max_level;
+            bgr->r = (fore_r * p + bgr->r * (257 - p)) >> 8;
+            bgr->g = (fore_g * p + bgr->g * (257 - p)) >> 8;
+            bgr->b = (fore_b * p + bgr->b * (257 - p)) >> 8;
+          }
+        }
+        dst->pushImage(x + sx, y + row, bw, bh, buf);
+      }
+      dst->endWrite();
+      return;
+    }
+
+    if (transparent)
+    {
+      back_rgb888 = dst->getBaseColor();
+    }
+    int32_t back_r = (back_rgb888 >> 16) & 0xFF;
+    int32_t back_g = (back_rgb888 >>  8) & 0xFF;
+    int32_t back_b =  back_rgb888        & 0xFF;
+
+    // Tint by building the palette for this draw; every coverage level maps to one blended color.
+    bgr888_t palette[16];
+    for (uint32_t i = 0; i <= max_level; ++i)
+    {
+      int32_t p = 1 + i * 255 / max_level;
+      palette[i].set( (fore_r * p + back_r * (257 - p)) >> 8
+                    , (fore_g * p + back_g * (257 - p)) >> 8
+                    , (fore_b * p + back_b * (257 - p)) >> 8 );
+    }
+    auto depth = (color_depth_t)(bits | color_depth_t::has_palette);
+    if (transparent)
+    {
+      dst->pushImage(x, y, w, h, img, 0u, depth, palette);
+    }
+    else
+    {
+      dst->pushImage(x, y, w, h, img, depth, palette);
+    }
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
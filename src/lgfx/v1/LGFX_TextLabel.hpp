@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "LGFX_Sprite.hpp"
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// A string rasterized once into a 1/2/4 bit alpha atlas, for labels that are redrawn often.
+  /// Drawing it again is a single image push, tinted with any fore / back color.
+  class LGFX_TextLabel
+  {
+  public:
+    /// Renders string with the current font, text size, datum and utf8 / cp437 settings of gfx.
+    /// depth : grayscale_1bit, grayscale_2bit or grayscale_4bit (number of antialiasing levels kept)
+    bool create(LovyanGFX* gfx, const char* string, color_depth_t depth = grayscale_4bit);
+    void release(void) { _atlas.deleteSprite(); _text_w = _text_h = 0; }
+
+    bool isCreated(void) const { return _atlas.getBuffer() != nullptr; }
+
+    /// Size of the text box used for datum alignment (same as textWidth / fontHeight).
+    int32_t width(void) const { return _text_w; }
+    int32_t height(void) const { return _text_h; }
+
+    /// Bytes held by the atlas.
+    uint32_t bufferLength(void) const { return _atlas.bufferLength(); }
+
+    void setDatum(textdatum_t datum) { _datum = datum; }
+    textdatum_t getDatum(void) const { return _datum; }
+
+    /// Draws with the text colors gfx had when the label was created.
+    void draw(LovyanGFX* dst, int32_t x, int32_t y) { draw_label(dst, x, y, _fore_rgb888, _back_rgb888, _fore_rgb888 == _back_rgb888); }
+
+    /// Draws with a filled background.
+    template <typename T>
+    void draw(LovyanGFX* dst, int32_t x, int32_t y, const T& fore, const T& back) { draw_label(dst, x, y, convert_to_rgb888(fore), convert_to_rgb888(back), false); }
+
+    /// Draws with a transparent background. Edges are blended with the pixels read back from dst,
+    /// or with its base color when dst is not readable.
+    template <typename T>
+    void drawTransparent(LovyanGFX* dst, int32_t x, int32_t y, const T& fore) { uint32_t c = convert_to_rgb888(fore); draw_label(dst, x, y, c, c, true); }
+
+  private:
+    void draw_label(LovyanGFX* dst, int32_t x, int32_t y, uint32_t fore_rgb888, uint32_t back_rgb888, bool transparent);
+
+    LGFX_Sprite _atlas;
+    int32_t _text_w = 0;
+    int32_t _text_h = 0;
+    int32_t _baseline = 0;
+    int32_t _origin_x = 0;  // position of the text box in the atlas (glyphs may overhang it)
+    int32_t _origin_y = 0;
+    uint32_t _fore_rgb888 = 0xFFFFFFu;
+    uint32_t _back_rgb888 = 0;
+    textdatum_t _datum = textdatum_t::top_left;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -141,6 +141,9 @@ namespace lgfx
     /// @return -1=unsupported. / 0~height= current scanline position.
     virtual int32_t getScanLine(void) { return -1; }
 
+    /// Whether readRect is served from a frame buffer in local memory, so reading large areas is cheap.
+    virtual bool isMemoryBacked(void) const { return false; }
+
     virtual void writeFillRectAlphaPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t argb8888)
     {
       effect(x, y, w, h, effect_fill_alpha ( argb8888_t { argb8888 } ) );
@@ -737,6 +737,7 @@ label_nextbyte: /// 次のデータを取得する;
   bool VLWfont::unloadFont(void)
   {
     _fontLoaded = false;
+    clearGlyphCache();
     if (gUnicode)  { heap_free(gUnicode);  gUnicode  = nullptr; }
     if (gWidth)    { heap_free(gWidth);    gWidth    = nullptr; }
     if (gxAdvance) { heap_free(gxAdvance); gxAdvance = nullptr; }
@@ -759,6 +760,118 @@ label_nextbyte: /// 次のデータを取得する;
     return (*poi == unicode);
   }
 
+  struct VLWfont::glyph_cache_t
+  {
+    glyph_cache_t* prev;   // LRU list, toward the most recently used
+    glyph_cache_t* next;   // LRU list, toward the least recently used
+    glyph_cache_t* chain;  // next entry in the same bucket
+    uint32_t size;         // bytes of this entry, including the bitmap
+    uint16_t gNum;
+    uint32_t header[6];    // glyph header as stored in the file (big endian)
+    // followed by the alpha bitmap (width * height bytes)
+
+    uint8_t* bitmap(void) const { return (uint8_t*)&this[1]; }
+  };
+
+  void VLWfont::setGlyphCacheSize(size_t bytes)
+  {
+    _cache_budget = bytes;
+    if (bytes == 0)
+    {
+      clearGlyphCache();
+    }
+    else
+    {
+      cache_evict(bytes);
+    }
+  }
+
+  void VLWfont::clearGlyphCache(void)
+  {
+    cache_evict(0);
+    if (_cache_bucket) { heap_free(_cache_bucket); _cache_bucket = nullptr; }
+  }
+
+  void VLWfont::cache_unlink(glyph_cache_t* entry) const
+  {
+    if (entry->prev) { entry->prev->next = entry->next; } else { _cache_head = entry->next; }
+    if (entry->next) { entry->next->prev = entry->prev; } else { _cache_tail = entry->prev; }
+  }
+
+  void VLWfont::cache_evict(size_t budget) const
+  {
+    while (_cache_used > budget && _cache_tail)
+    {
+      auto entry = _cache_tail;
+      cache_unlink(entry);
+      auto link = &_cache_bucket[entry->gNum % cache_bucket_count];
+      while (*link != entry) { link = &(*link)->chain; }
+      *link = entry->chain;
+      _cache_used -= entry->size;
+      heap_free(entry);
+    }
+  }
+
+  const VLWfont::glyph_cache_t* VLWfont::get_cached_glyph(uint16_t gNum) const
+  {
+    if (_cache_budget == 0) return nullptr;
+
+    auto entry = _cache_bucket ? _cache_bucket[gNum % cache_bucket_count] : nullptr;
+    for (; entry; entry = entry->chain)
+    {
+      if (entry->gNum != gNum) continue;
+      ++_cache_hits;
+      if (entry != _cache_head)
+      { // move to the front of the LRU list.
+        cache_unlink(entry);
+        entry->prev = nullptr;
+        entry->next = _cache_head;
+        _cache_head->prev = entry;
+        _cache_head = entry;
+      }
+      return entry;
+    }
+    ++_cache_misses;
+    return nullptr;
+  }
+
+  const VLWfont::glyph_cache_t* VLWfont::cache_glyph(uint16_t gNum, const uint32_t* header) const
+  {
+    uint32_t len = getSwap32(header[0]) * getSwap32(header[1]);
+    uint32_t size = sizeof(glyph_cache_t) + len;
+    if (size > _cache_budget) return nullptr;
+
+    if (_cache_bucket == nullptr)
+    {
+      size_t bucket_len = cache_bucket_count * sizeof(glyph_cache_t*);
+      _cache_bucket = (glyph_cache_t**)heap_alloc_psram(bucket_len);
+      if (nullptr == _cache_bucket) _cache_bucket = (glyph_cache_t**)heap_alloc(bucket_len);
+      if (nullptr == _cache_bucket) return nullptr;
+      memset(_cache_bucket, 0, bucket_len);
+    }
+
+    cache_evict(_cache_budget - size);
+    auto entry = (glyph_cache_t*)heap_alloc_psram(size);
+    if (nullptr == entry) entry = (glyph_cache_t*)heap_alloc(size);
+    if (nullptr == entry) return nullptr;
+
+    auto file = _fontData;
+    file->seek(this->gBitmap[gNum]);
+    file->read(entry->bitmap(), len);
+    memcpy(entry->header, header, sizeof(entry->header));
+    auto bucket = &_cache_bucket[gNum % cache_bucket_count];
+    entry->gNum = gNum;
+    entry->size = size;
+    entry->chain = *bucket;
+    *bucket = entry;
+    entry->prev = nullptr;
+    entry->next = _cache_head;
+    if (_cache_head) { _cache_head->prev = entry; } else { _cache_tail = entry; }
+    _cache_head = entry;
+    _cache_used += size;
+    return entry;
+  }
+
   bool VLWfont::updateFontMetric(FontMetrics *metrics, uint16_t uniCode) const {
     uint16_t gNum = 0;
     if (getUnicodeIndex(uniCode, &gNum)) {
@@ -766,6 +879,10 @@ label_nextbyte: /// 次のデータを取得する;
         metrics->width     = gWidth[gNum];
         metrics->x_advance = gxAdvance[gNum];
         metrics->x_offset  = gdX[gNum];
+      } else if (auto glyph = get_cached_glyph(gNum)) {
+        metrics->width     = getSwap32(glyph->header[1]);
+        metrics->x_advance = getSwap32(glyph->header[2]);
+        metrics->x_offset  = (int32_t)((int8_t)getSwap32(glyph->header[4]));
       } else {
         auto file = _fontData;
 
@@ -777,6 +894,7 @@ label_nextbyte: /// 次のデータを取得する;
         metrics->width     = getSwap32(buffer[1]); // Width of glyph
         metrics->x_advance = getSwap32(buffer[2]); // xAdvance - to move x cursor
         metrics->x_offset  = (int32_t)((int8_t)getSwap32(buffer[4])); // x delta from cursor
+        cache_glyph(gNum, buffer);
 
         file->postRead();
       }
@@ -882,6 +1000,7 @@ label_nextbyte: /// 次のデータを取得する;
 
     uint32_t buffer[6] = {0};
     uint16_t gNum = 0;
+    uint8_t* pixel = nullptr;
 
     int32_t sy = 65536 * style->size_y;
     y += (metrics->y_offset * sy) >> 16;
@@ -891,11 +1010,19 @@ label_nextbyte: /// 次のデータを取得する;
       buffer[2] = getSwap32(this->spaceWidth);
     } else if (!this->getUnicodeIndex(code, &gNum)) {
       return drawCharDummy(gfx, x, y, this->spaceWidth, metrics->height, style, filled_x);
+    } else if (auto glyph = get_cached_glyph(gNum)) {
+      memcpy(buffer, glyph->header, sizeof(glyph->header));
+      pixel = glyph->bitmap();
     } else {
       file->preRead();
       file->seek(28 + gNum * 28);
       file->read((uint8_t*)buffer, 24);
-      file->seek(this->gBitmap[gNum]);
+      if (auto glyph = cache_glyph(gNum, buffer)) {
+        file->postRead();
+        pixel = glyph->bitmap();
+      } else {
+        file->seek(this->gBitmap[gNum]);
+      }
     }
 
 
@@ -908,10 +1035,12 @@ label_nextbyte: /// 次のデータを取得する;
     int32_t yoffset  = (this->maxAscent - dY);
 //      int32_t yoffset = (gfx->_font_metrics.y_offset) - dY;
 
-    auto pixel = (uint8_t*)alloca(w * h);
-    if (gNum != 0xFFFF) {
-      file->read(pixel, w * h);
-      file->postRead();
+    if (pixel == nullptr) {
+      pixel = (uint8_t*)alloca(w * h);
+      if (gNum != 0xFFFF) {
+        file->read(pixel, w * h);
+        file->postRead();
+      }
     }
 
     gfx->startWrite();
@@ -948,6 +1077,66 @@ label_nextbyte: /// 次のデータを取得する;
       int32_t fore_g = ((style->fore_rgb888>> 8)&0xFF);
       int32_t fore_b = ((style->fore_rgb888)    &0xFF);
 
+      if (fillbg && left <= x && x < right && !gfx->hasPalette() && !gfx->isMemoryBacked())
+      { // fill background mode on a bus panel : blend each row into a line buffer and push it with one transfer.
+        gfx->setRawColor(colortbl[0]);
+        if (yoffset > 0) {
+          gfx->writeFillRect(left, y, right - left, (yoffset * sy) >> 16);
+        }
+        int32_t y0 = ((yoffset + h)   * sy) >> 16;
+        int32_t y1 = (metrics->height * sy) >> 16;
+        if (y0 < y1) {
+          gfx->writeFillRect(left, y + y0, right - left, y1 - y0);
+        }
+
+        int32_t bl = std::max(left, clip_left);
+        int32_t br = std::min(right, clip_right + 1);
+        if (0 < w && bl < br) {
+          int32_t lw = br - bl;
+          auto buf = (bgr888_t*)alloca((lw * ((sy + 65535) >> 16)) * sizeof(bgr888_t));
+          pixelcopy_t p_(buf, gfx->getColorConverter()->depth, rgb888_3Byte, false);
+
+          bgr888_t fore(fore_r, fore_g, fore_b);
+          int32_t back_r = ((style->back_rgb888>>16)&0xFF);
+          int32_t back_g = ((style->back_rgb888>> 8)&0xFF);
+          int32_t back_b = ( style->back_rgb888     &0xFF);
+          bgr888_t back(back_r, back_g, back_b);
+
+          int32_t i = 0;
+          y1 = (yoffset * sy) >> 16;
+          do {
+            y0 = y1;
+            if (y0 > (clip_bottom - y)) break;
+            y1 = ((yoffset + i + 1) * sy) >> 16;
+            int32_t by = y + y0;
+            int32_t bh = y1 - y0;
+            if (by < clip_top) { bh += by - clip_top; by = clip_top; }
+            if (bh > 0) {
+              for (int32_t k = 0; k < lw; ++k) { buf[k] = back; }
+              int32_t x1 = x - bl;
+              for (int32_t j = 0; j < w; ++j) {
+                int32_t x0 = x1;
+                x1 = x - bl + (((j + 1) * sx) >> 16);
+                if (x0 >= lw) break;
+                if (pixel[j] == 0 || x1 <= 0) continue;
+                bgr888_t color = fore;
+                if (pixel[j] != 0xFF) {
+                  int32_t p = 1 + (uint32_t)pixel[j];
+                  color.r = ( fore_r * p + back_r * (257 - p)) >> 8;
+                  color.g = ( fore_g * p + back_g * (257 - p)) >> 8;
+                  color.b = ( fore_b * p + back_b * (257 - p)) >> 8;
+                }
+                int32_t xe = std::min(x1, lw);
+                for (int32_t k = std::max(x0, 0); k < xe; ++k) { buf[k] = color; }
+              }
+              for (int32_t k = 1; k < bh; ++k) { memcpy(&buf[k * lw], buf, lw * sizeof(bgr888_t)); }
+              gfx->pushImage(bl, by, lw, bh, &p_);
+            }
+            pixel += w;
+          } while (++i < h);
+        }
+      }
+      else
       if (fillbg || !gfx->isReadable() || gfx->hasPalette())
       { // fill background mode  or unreadable panel  or palette sprite mode
         if (left < right && fillbg) {
@@ -256,6 +256,35 @@ namespace lgfx
     bool updateFontMetric(FontMetrics *metrics, uint16_t uniCode) const override;
 
     bool getUnicodeIndex(uint16_t unicode, uint16_t *index) const;
+
+    /// Sets the byte budget of the glyph cache. ( 0 = disabled (default) )
+    /// Decoded glyph headers and alpha bitmaps are kept in PSRAM when available, least recently used first out.
+    void setGlyphCacheSize(size_t bytes);
+    size_t getGlyphCacheSize(void) const { return _cache_budget; }
+    size_t getGlyphCacheUsed(void) const { return _cache_used; }
+    uint32_t getGlyphCacheHits(void) const { return _cache_hits; }
+    uint32_t getGlyphCacheMisses(void) const { return _cache_misses; }
+    void resetGlyphCacheStats(void) { _cache_hits = 0; _cache_misses = 0; }
+    void clearGlyphCache(void);
+
+  private:
+    struct glyph_cache_t;
+    static constexpr size_t cache_bucket_count = 64;
+
+    const glyph_cache_t* get_cached_glyph(uint16_t gNum) const;
+    /// Stores the glyph whose header was just read from the file, with its bitmap read from the file.
+    /// nullptr when the cache cannot hold it; the caller then reads the bitmap itself.
+    const glyph_cache_t* cache_glyph(uint16_t gNum, const uint32_t* header) const;
+    void cache_unlink(glyph_cache_t* entry) const;
+    void cache_evict(size_t budget) const;
+
+    mutable glyph_cache_t** _cache_bucket = nullptr;
+    mutable glyph_cache_t* _cache_head = nullptr;  // most recently used
+    mutable glyph_cache_t* _cache_tail = nullptr;  // least recently used
+    mutable size_t _cache_used = 0;
+    mutable uint32_t _cache_hits = 0;
+    mutable uint32_t _cache_misses = 0;
+    size_t _cache_budget = 0;
   };
 
 //----------------------------------------------------------------------------
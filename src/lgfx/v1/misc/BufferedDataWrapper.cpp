@@ -0,0 +1,215 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "BufferedDataWrapper.hpp"
+
+#include "../platforms/common.hpp"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  void BufferedDataWrapper::setBlockSize(uint32_t block_size, bool prefetch)
+  {
+    release();
+    _block_size = block_size ? block_size : 1;
+    _prefetch = prefetch;
+  }
+
+  void BufferedDataWrapper::release(void)
+  {
+    if (_buffer) { heap_free(_buffer); }
+    _buffer = nullptr;
+    _block[0] = block_t();
+    _block[1] = block_t();
+  }
+
+  void BufferedDataWrapper::invalidate(void)
+  {
+    _block[0].len = 0;
+    _block[1].len = 0;
+    _end = UINT32_MAX;
+    _pos_valid = false;
+    _source_pos_valid = false;
+  }
+
+  bool BufferedDataWrapper::allocate(void)
+  {
+    if (_buffer) { return true; }
+    size_t len = (size_t)_block_size << (_prefetch ? 1 : 0);
+    _buffer = (uint8_t*)(_psram ? heap_alloc_psram(len) : nullptr);
+    if (_buffer == nullptr) { _buffer = (uint8_t*)heap_alloc(len); }
+    if (_buffer == nullptr) { return false; }
+    _block[0].data = _buffer;
+    _block[1].data = _prefetch ? &_buffer[_block_size] : nullptr;
+    return true;
+  }
+
+  bool BufferedDataWrapper::sync(void)
+  {
+    if (_pos_valid) { return true; }
+    if (_source == nullptr) { return false; }
+    _source->preRead();
+    int32_t pos = _source->tell();
+    _source->postRead();
+    _pos = _source_pos = pos < 0 ? 0 : pos;
+    _pos_valid = _source_pos_valid = true;
+    return true;
+  }
+
+  uint32_t BufferedDataWrapper::copy(uint8_t* buf, uint32_t len)
+  {
+    for (int i = 0; i < 2; ++i)
+    {
+      auto& b = _block[_newest ^ i];
+      uint32_t offset = _pos - b.pos;
+      if (_pos < b.pos || offset >= b.len) { continue; }
+      if (len > b.len - offset) { len = b.len - offset; }
+      memcpy(buf, &b.data[offset], len);
+      _pos += len;
+      _newest ^= i;
+      return len;
+    }
+    return 0;
+  }
+
+  uint32_t BufferedDataWrapper::read_source(uint32_t pos, uint8_t* buf, uint32_t len)
+  {
+    _source->preRead();
+    if (!_source_pos_valid || _source_pos != pos) { _source->seek(pos); }
+    int res = _source->read(buf, len);
+    _source->postRead();
+    ++_fetch_count;
+
+    uint32_t n = res < 0 ? 0 : res;
+    _source_pos = pos + n;
+    _source_pos_valid = true;
+    if (n < len) { _end = pos + n; }
+    return n;
+  }
+
+  bool BufferedDataWrapper::sequential(void) const
+  {
+    // _pos is in the block that follows what was read last; continuing from where the source is
+    // also lets sources which cannot seek back ( streams ) be read straight through.
+    return _source_pos_valid && _source_pos <= _pos && _pos - _source_pos < _block_size;
+  }
+
+  bool BufferedDataWrapper::fetch(uint32_t len)
+  {
+    if (_prefetch && sequential())
+    { // read this block and the next one in the same handoff.
+      uint32_t pos = _source_pos;
+      uint32_t n = read_source(pos, _buffer, _block_size << 1);
+      _block[0].pos = pos;
+      _block[0].len = n < _block_size ? n : _block_size;
+      _block[1].pos = pos + _block_size;
+      _block[1].len = n - _block[0].len;
+      _newest = 0;
+      return n;
+    }
+    uint32_t pos = _source_pos;
+    if (!sequential())
+    { // blocks at multiples of the block size, unless the read would cross the end of that block.
+      pos = _pos - (_pos % _block_size);
+      if (len > _block_size - (_pos - pos)) { pos = _pos; }
+    }
+    // replace the block used least recently; the other one stays for seeks back to it.
+    uint_fast8_t i = _prefetch ? (_newest ^ 1) : 0;
+    auto& b = _block[i];
+    b.len = read_source(pos, b.data, _block_size);
+    b.pos = pos;
+    _newest = i;
+    return b.len;
+  }
+
+  int BufferedDataWrapper::read(uint8_t *buf, uint32_t len)
+  {
+    if (!sync()) { return 0; }
+
+    uint32_t done = 0;
+    bool fetched = false;
+    while (done < len)
+    {
+      uint32_t n = copy(&buf[done], len - done);
+      if (n) { done += n; continue; }
+      if (_pos >= _end) { break; }
+
+      fetched = true;
+      uint32_t rest = len - done;
+      if (!allocate() || rest >= (_block_size << (_prefetch && sequential())))
+      { // no memory for the buffers, or more than they hold: straight from the source.
+        n = read_source(_pos, &buf[done], rest);
+        _pos += n;
+        done += n;
+        break;
+      }
+      if (!fetch(rest)) { break; }
+    }
+    if (!fetched) { ++_hit_count; }
+    return done;
+  }
+
+  bool BufferedDataWrapper::open(const char* path)
+  {
+    invalidate();
+    if (_source == nullptr) { return false; }
+    _source->preRead();
+    bool res = _source->open(path);
+    _source->postRead();
+    if (res)
+    {
+      _pos = _source_pos = 0;
+      _pos_valid = _source_pos_valid = true;
+    }
+    return res;
+  }
+
+  void BufferedDataWrapper::close(void)
+  {
+    if (_source)
+    {
+      _source->preRead();
+      _source->close();
+      _source->postRead();
+    }
+    invalidate();
+  }
+
+  int BufferedDataWrapper::write(const uint8_t *buf, uint32_t len)
+  {
+    if (!sync()) { return 0; }
+    uint32_t pos = _pos;
+    _source->preRead();
+    if (!_source_pos_valid || _source_pos != pos) { _source->seek(pos); }
+    int res = _source->write(buf, len);
+    _source->postRead();
+
+    // the written range may be buffered; the end of the data may have moved.
+    invalidate();
+    _pos = _source_pos = pos + (res < 0 ? 0 : res);
+    _pos_valid = _source_pos_valid = true;
+    return res;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,133 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "DataWrapper.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Reads another DataWrapper ( a file on SD / LittleFS ) in blocks, and serves the small
+  /// read / skip / seek calls of the image decoders and of VLW fonts from memory.
+  /// The source is read, and the bus handed over from the panel ( preRead / postRead ), once per block
+  /// instead of once per read; the preRead / postRead of the wrapper itself do nothing.
+  /// Reads return the whole length asked for, as a file does, unless the data ends.
+  /// Seeks within a buffered block do not touch the source.
+  /// With prefetch ( the default ), two blocks are kept: a sequential read fetches the next two blocks in one handoff,
+  /// a seek elsewhere replaces only the block used less recently, so that the other one
+  /// ( e.g. the glyph table of a VLW font ) is still there to seek back to.
+  /// Without prefetch, a single block is kept; that suits sequential image files, but a VLW font
+  /// then reads its glyph table and the bitmaps into the same block and hands the bus over more often than unbuffered.
+  /// The wrapper does not own the source. Use it in place of the source:
+  ///   DataWrapperT<fs::FS> file(&SD);
+  ///   BufferedDataWrapper buffered(&file, 4096);
+  ///   lcd.drawPngFile(&buffered, "/image.png");
+  ///   buffered.open("/font.vlw");
+  ///   lcd.loadFont(&buffered);   // both must outlive the font
+  struct BufferedDataWrapper : public DataWrapper
+  {
+    BufferedDataWrapper(DataWrapper* source = nullptr, uint32_t block_size = 4096, bool prefetch = true)
+    : DataWrapper{}, _source { source }, _block_size { block_size ? block_size : 1 }, _prefetch { prefetch } {}
+    BufferedDataWrapper(const BufferedDataWrapper&) = delete;
+    BufferedDataWrapper& operator=(const BufferedDataWrapper&) = delete;
+    ~BufferedDataWrapper(void) override { release(); }
+
+    /// Reads through source from its current position on. Buffered data is dropped.
+    void setSource(DataWrapper* source) { _source = source; invalidate(); }
+    DataWrapper* getSource(void) override { return _source; }
+    const void* getFileSystem(void) const override { return _source ? _source->getFileSystem() : nullptr; }
+
+    /// Bytes read from the source at a time, and whether a second block is kept and read ahead.
+    /// The buffers are freed, and allocated again by the next read.
+    void setBlockSize(uint32_t block_size, bool prefetch = true);
+    uint32_t getBlockSize(void) const { return _block_size; }
+    bool getPrefetch(void) const { return _prefetch; }
+
+    /// Allocates the buffers in PSRAM.
+    void setPsram(bool enabled) { _psram = enabled; }
+
+    /// Frees the buffers. Reads allocate them again.
+    void release(void);
+
+    /// Drops the buffered data, e.g. after the source was written or moved by another user.
+    void invalidate(void);
+
+    /// Reads of the source ( bus handoffs ) / read calls served from the buffers alone.
+    uint32_t getFetchCount(void) const { return _fetch_count; }
+    uint32_t getHitCount(void) const { return _hit_count; }
+    void resetStats(void) { _fetch_count = _hit_count = 0; }
+
+    bool open(const char* path) override;
+    using DataWrapper::read;
+    int read(uint8_t *buf, uint32_t len) override;
+    void skip(int32_t offset) override { if (sync()) { _pos += offset; } }
+    bool seek(uint32_t offset) override { _pos = offset; _pos_valid = true; return true; }
+    void close(void) override;
+    int32_t tell(void) override { return sync() ? _pos : 0; }
+    int write(const uint8_t *buf, uint32_t len) override;
+
+  protected:
+    struct block_t
+    {
+      uint8_t* data = nullptr;
+      uint32_t pos = 0;          // position in the source of data[0]
+      uint32_t len = 0;          // valid bytes, 0 when empty
+    };
+
+    /// Takes the position of the source when it is not known yet.
+    bool sync(void);
+
+    /// Copies from the block holding _pos, and advances _pos. Returns the bytes copied.
+    uint32_t copy(uint8_t* buf, uint32_t len);
+
+    /// _pos is at or just after the position of the source.
+    bool sequential(void) const;
+
+    /// Reads the block(s) holding _pos, for a read of len bytes, from the source. false at the end of the data.
+    bool fetch(uint32_t len);
+
+    /// Reads up to len bytes at pos from the source into buf, around a bus handoff.
+    uint32_t read_source(uint32_t pos, uint8_t* buf, uint32_t len);
+
+    bool allocate(void);
+
+    DataWrapper* _source;
+    uint8_t* _buffer = nullptr;
+    block_t _block[2];
+    uint32_t _block_size;
+    uint32_t _pos = 0;           // position of the next read
+    uint32_t _source_pos = 0;    // position the source is at
+    uint32_t _end = UINT32_MAX;  // size of the data, once a read came back short
+    uint32_t _fetch_count = 0;
+    uint32_t _hit_count = 0;
+    uint8_t _newest = 0;         // block used last
+    bool _pos_valid = false;     // _pos is known, else taken from the source by sync
+    bool _source_pos_valid = false;
+    bool _prefetch;
+    bool _psram = false;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
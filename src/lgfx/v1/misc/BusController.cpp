@@ -0,0 +1,1255 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "BusController.hpp"
+
+#include "colortype.hpp"
+#include "../panel/Panel_M5HDMI.hpp"
+#include "../../utility/lgfx_miniz.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static uint8_t* controller_png_get_row(uint8_t* buf, int flip, int, int h, int y, int, void* target)
+  {
+    auto ctrl = static_cast<const BusController_RAM*>(target);
+    ctrl->readRow(flip ? (h - 1 - y) : y, buf);
+    return buf;
+  }
+
+  void* BusController_RAM::createPng(size_t* datalen) const
+  {
+    if (_width == 0 || _height == 0) { return nullptr; }
+    std::vector<uint8_t> row(_width * 3);
+    return tdefl_write_image_to_png_file_in_memory_ex_with_cb(row.data(), _width, _height, 3, datalen, 6, 0, (tdefl_get_png_row_func)controller_png_get_row, const_cast<BusController_RAM*>(this));
+  }
+
+//----------------------------------------------------------------------------
+
+  static constexpr uint8_t MIPI_SWRESET = 0x01;
+  static constexpr uint8_t MIPI_INVOFF  = 0x20;
+  static constexpr uint8_t MIPI_INVON   = 0x21;
+  static constexpr uint8_t MIPI_DISPOFF = 0x28;
+  static constexpr uint8_t MIPI_DISPON  = 0x29;
+  static constexpr uint8_t MIPI_CASET   = 0x2A;
+  static constexpr uint8_t MIPI_RASET   = 0x2B;
+  static constexpr uint8_t MIPI_RAMWR   = 0x2C;
+  static constexpr uint8_t MIPI_MADCTL  = 0x36;
+  static constexpr uint8_t MIPI_COLMOD  = 0x3A;
+  static constexpr uint8_t MIPI_RAMWRC  = 0x3C;
+
+  static constexpr uint8_t MAD_MY = 0x80;
+  static constexpr uint8_t MAD_MX = 0x40;
+  static constexpr uint8_t MAD_MV = 0x20;
+
+  BusController_MIPI::BusController_MIPI(void)
+  {
+    config(_cfg);
+  }
+
+  void BusController_MIPI::config(const config_t& config)
+  {
+    _cfg = config;
+    _width  = config.memory_width;
+    _height = config.memory_height;
+    _ram.assign(_width * _height * 3, 0);
+    _xs = _ys = 0;
+    _xe = _width - 1;
+    _ye = _height - 1;
+  }
+
+  void BusController_MIPI::readRow(uint_fast16_t y, uint8_t* rgb) const
+  {
+    size_t len = _width * 3;
+    if (!_display_on)
+    {
+      memset(rgb, 0, len);
+      return;
+    }
+    memcpy(rgb, &_ram[y * len], len);
+    if (_inversion != _cfg.invert)
+    {
+      for (size_t i = 0; i < len; ++i) { rgb[i] = ~rgb[i]; }
+    }
+  }
+
+  void BusController_MIPI::command(uint8_t cmd)
+  {
+    _cmd = cmd;
+    _param_count = 0;
+    switch (cmd)
+    {
+    case MIPI_SWRESET:
+      _madctl = 0;
+      _inversion = false;
+      _display_on = false;
+      _pixel_bytes = 3;
+      _pixel_mask = 0xFC;
+      break;
+
+    case MIPI_INVOFF:  _inversion = false;  break;
+    case MIPI_INVON:   _inversion = true;   break;
+    case MIPI_DISPOFF: _display_on = false; break;
+    case MIPI_DISPON:  _display_on = true;  break;
+
+    case MIPI_RAMWR:
+      _x = _xs;
+      _y = _ys;
+      _pixel_count = 0;
+      break;
+
+    case MIPI_RAMWRC:
+      _pixel_count = 0;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void BusController_MIPI::parameter(uint8_t value)
+  {
+    if (_param_count < sizeof(_param)) { _param[_param_count] = value; }
+    ++_param_count;
+    switch (_cmd)
+    {
+    case MIPI_CASET:
+    case MIPI_RASET:
+      if (_param_count == 4)
+      {
+        uint16_t s = _param[0] << 8 | _param[1];
+        uint16_t e = _param[2] << 8 | _param[3];
+        if (_cmd == MIPI_CASET) { _xs = s; _xe = e; }
+        else                    { _ys = s; _ye = e; }
+      }
+      break;
+
+    case MIPI_MADCTL:
+      if (_param_count == 1) { _madctl = value; }
+      break;
+
+    case MIPI_COLMOD:
+      if (_param_count == 1)
+      {
+        switch (value & 7)
+        {
+        case 5:  _pixel_bytes = 2; _pixel_mask = 0xFF; break;
+        case 6:  _pixel_bytes = 3; _pixel_mask = 0xFC; break;
+        default: _pixel_bytes = 3; _pixel_mask = 0xFF; break;
+        }
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void BusController_MIPI::store_pixel(void)
+  {
+    uint_fast16_t x = _x;
+    uint_fast16_t y = _y;
+    if (++_x > _xe)
+    {
+      _x = _xs;
+      if (++_y > _ye) { _y = _ys; }
+    }
+    ++_write_count;
+
+    // MV exchanges the address counters, MX / MY then mirror them within the memory.
+    if (_madctl & MAD_MV) { std::swap(x, y); }
+    if (x >= _width || y >= _height) { return; }
+    if (_madctl & MAD_MX) { x = _width  - 1 - x; }
+    if (_madctl & MAD_MY) { y = _height - 1 - y; }
+
+    auto dst = &_ram[(x + y * _width) * 3];
+    if (_pixel_bytes == 2)
+    {
+      uint_fast16_t c = _pixel[0] << 8 | _pixel[1];
+      uint_fast8_t r = c >> 11;
+      uint_fast8_t g = (c >> 5) & 0x3F;
+      uint_fast8_t b = c & 0x1F;
+      dst[0] = (r << 3) | (r >> 2);
+      dst[1] = (g << 2) | (g >> 4);
+      dst[2] = (b << 3) | (b >> 2);
+    }
+    else
+    {
+      dst[0] = _pixel[0] & _pixel_mask;
+      dst[1] = _pixel[1] & _pixel_mask;
+      dst[2] = _pixel[2] & _pixel_mask;
+    }
+  }
+
+  void BusController_MIPI::write(const uint8_t* data, uint32_t length, bool dc)
+  {
+    if (!dc)
+    {
+      for (uint32_t i = 0; i < length; ++i) { command(data[i]); }
+      return;
+    }
+    if (_cmd != MIPI_RAMWR && _cmd != MIPI_RAMWRC)
+    {
+      for (uint32_t i = 0; i < length; ++i) { parameter(data[i]); }
+      return;
+    }
+    auto pixel_bytes = _pixel_bytes;
+    for (uint32_t i = 0; i < length; ++i)
+    {
+      _pixel[_pixel_count] = data[i];
+      if (++_pixel_count == pixel_bytes)
+      {
+        _pixel_count = 0;
+        store_pixel();
+      }
+    }
+  }
+
+//----------------------------------------------------------------------------
+
+  static constexpr uint8_t OLED_MEMORYMODE  = 0x20;
+  static constexpr uint8_t OLED_COLUMNADDR  = 0x21;
+  static constexpr uint8_t OLED_PAGEADDR    = 0x22;
+  static constexpr uint8_t OLED_SEGREMAP    = 0xA0;
+  static constexpr uint8_t OLED_NORMAL      = 0xA6;
+  static constexpr uint8_t OLED_INVERT      = 0xA7;
+  static constexpr uint8_t OLED_DISP_OFF    = 0xAE;
+  static constexpr uint8_t OLED_DISP_ON     = 0xAF;
+  static constexpr uint8_t OLED_COMSCANINC  = 0xC0;
+  static constexpr uint8_t OLED_COMSCANDEC  = 0xC8;
+
+  /// Number of parameter bytes that follow a command.
+  static uint_fast8_t oled_param_length(uint_fast8_t cmd)
+  {
+    switch (cmd)
+    {
+    case 0x26: case 0x27:               return 6;  // horizontal scroll
+    case 0x29: case 0x2A:               return 5;  // vertical and horizontal scroll
+    case OLED_COLUMNADDR: case OLED_PAGEADDR:
+    case 0xA3:                          return 2;  // vertical scroll area
+    case OLED_MEMORYMODE: case 0x81: case 0x8D: case 0xA8: case 0xAD:
+    case 0xD3: case 0xD5: case 0xD9: case 0xDA: case 0xDB: case 0xDC:
+                                        return 1;
+    default:                            return 0;
+    }
+  }
+
+  BusController_SSD1306::BusController_SSD1306(uint16_t width, uint16_t height)
+  {
+    _width = width;
+    _height = height;
+    _col_end = width - 1;
+    _page_end = pages() - 1;
+    _gddram.assign(width * pages(), 0);
+    _display_on = false;
+  }
+
+  void BusController_SSD1306::readRow(uint_fast16_t y, uint8_t* rgb) const
+  {
+    uint_fast16_t lines = pages() << 3;
+    uint_fast16_t row = _com_reverse ? (_height - 1 - y) : y;
+    row = (row + _start_line) % lines;
+    auto src = &_gddram[(row >> 3) * _width];
+    uint_fast8_t mask = 1 << (row & 7);
+    for (uint_fast16_t x = 0; x < _width; ++x)
+    {
+      uint_fast16_t col = _seg_remap ? (_width - 1 - x) : x;
+      bool on = _display_on && ((bool)(src[col] & mask) != _invert);
+      uint8_t v = on ? 0xFF : 0;
+      rgb[x * 3 + 0] = v;
+      rgb[x * 3 + 1] = v;
+      rgb[x * 3 + 2] = v;
+    }
+  }
+
+  void BusController_SSD1306::command(uint8_t cmd)
+  {
+    _cmd = cmd;
+    _param_count = 0;
+    _param_need = oled_param_length(cmd);
+    if (_param_need) { return; }
+
+    if      (cmd < 0x10) { _col = (_col & 0xF0) | cmd; }  // lower column start address (page mode)
+    else if (cmd < 0x20) { _col = (_col & 0x0F) | (cmd & 0x0F) << 4; }
+    else if ((cmd & 0xC0) == 0x40) { _start_line = cmd & 0x3F; }
+    else if ((cmd & 0xF0) == 0xB0) { _page = cmd & 0x0F; }
+    else
+    {
+      switch (cmd)
+      {
+      case OLED_SEGREMAP:     _seg_remap = false;   break;
+      case OLED_SEGREMAP | 1: _seg_remap = true;    break;
+      case OLED_NORMAL:       _invert = false;      break;
+      case OLED_INVERT:       _invert = true;       break;
+      case OLED_DISP_OFF:     _display_on = false;  break;
+      case OLED_DISP_ON:      _display_on = true;   break;
+      case OLED_COMSCANINC:   _com_reverse = false; break;
+      case OLED_COMSCANDEC:   _com_reverse = true;  break;
+      default: break;
+      }
+    }
+  }
+
+  void BusController_SSD1306::command_done(void)
+  {
+    switch (_cmd)
+    {
+    case OLED_MEMORYMODE:
+      _mode = _param[0] & 3;
+      break;
+
+    case OLED_COLUMNADDR:
+      _col = _col_start = _param[0];
+      _col_end = _param[1];
+      break;
+
+    case OLED_PAGEADDR:
+      _page = _page_start = _param[0];
+      _page_end = _param[1];
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void BusController_SSD1306::store(uint8_t value)
+  {
+    if (_col < _width && _page < pages())
+    {
+      _gddram[_col + _page * _width] = value;
+    }
+    ++_write_count;
+
+    switch (_mode)
+    {
+    case 0:  // horizontal
+      if (++_col > _col_end)
+      {
+        _col = _col_start;
+        if (++_page > _page_end) { _page = _page_start; }
+      }
+      break;
+
+    case 1:  // vertical
+      if (++_page > _page_end)
+      {
+        _page = _page_start;
+        if (++_col > _col_end) { _col = _col_start; }
+      }
+      break;
+
+    default: // page
+      if (++_col >= _width) { _col = 0; }
+      break;
+    }
+  }
+
+  void BusController_SSD1306::write(const uint8_t* data, uint32_t length, bool dc)
+  {
+    if (dc)
+    {
+      for (uint32_t i = 0; i < length; ++i) { store(data[i]); }
+      return;
+    }
+    for (uint32_t i = 0; i < length; ++i)
+    {
+      if (_param_count < _param_need)
+      {
+        _param[_param_count] = data[i];
+        if (++_param_count == _param_need) { command_done(); }
+      }
+      else
+      {
+        command(data[i]);
+      }
+    }
+  }
+
+//----------------------------------------------------------------------------
+
+  typedef Panel_M5HDMI HDMI;
+
+  /// Total length of a command, including the command byte. (pixel data of CMD_WRITE_RAW_* is not included)
+  static uint_fast8_t hdmi_command_length(uint_fast8_t cmd)
+  {
+    switch (cmd)
+    {
+    case HDMI::CMD_SCREEN_SCALING:  return 8;
+    case HDMI::CMD_SCREEN_ORIGIN:   return 6;
+    case HDMI::CMD_COPYRECT:        return 13;
+    case HDMI::CMD_CASET:
+    case HDMI::CMD_RASET:           return 5;
+    case HDMI::CMD_VIDEO_TIMING_V:
+    case HDMI::CMD_VIDEO_TIMING_H:  return 10;
+    case HDMI::CMD_VIDEO_CLOCK:     return 9;
+    default: break;
+    }
+    if ((cmd & 7) <= 4)
+    {
+      if ((cmd & ~7) == HDMI::CMD_DRAWPIXEL) { return 5 + (cmd & 7); }
+      if ((cmd & ~7) == HDMI::CMD_FILLRECT ) { return 9 + (cmd & 7); }
+    }
+    return 1;
+  }
+
+  /// Number of bytes of one pixel for the low 3 bits of CMD_WRITE_RAW_* / CMD_DRAWPIXEL_* / CMD_FILLRECT_*.
+  static uint_fast8_t hdmi_pixel_bytes(uint_fast8_t format)
+  {
+    static constexpr uint8_t tbl[8] = { 0, 1, 2, 3, 4, 1, 0, 0 };
+    return tbl[format & 7];
+  }
+
+  /// Converts the pixel data on the wire to A, R, G, B. The format 0 and the alpha only format take the color from last.
+  static void hdmi_decode(uint8_t* argb, const uint8_t* src, uint_fast8_t format, const uint8_t* last)
+  {
+    switch (format & 7)
+    {
+    case 1:
+      {
+        rgb332_t c(src[0]);
+        argb[0] = 0xFF;
+        argb[1] = c.R8();
+        argb[2] = c.G8();
+        argb[3] = c.B8();
+      }
+      break;
+
+    case 2:
+      {
+        uint_fast16_t c = src[0] << 8 | src[1];
+        uint_fast8_t r = c >> 11;
+        uint_fast8_t g = (c >> 5) & 0x3F;
+        uint_fast8_t b = c & 0x1F;
+        argb[0] = 0xFF;
+        argb[1] = (r << 3) | (r >> 2);
+        argb[2] = (g << 2) | (g >> 4);
+        argb[3] = (b << 3) | (b >> 2);
+      }
+      break;
+
+    case 3:
+      argb[0] = 0xFF;
+      memcpy(&argb[1], src, 3);
+      break;
+
+    case 4:
+      memcpy(argb, src, 4);
+      break;
+
+    case 5:
+      argb[0] = src[0];
+      memcpy(&argb[1], &last[1], 3);
+      break;
+
+    default:
+      memcpy(argb, last, 4);
+      break;
+    }
+  }
+
+  static inline uint_fast16_t hdmi_get16(const uint8_t* src)
+  {
+    return src[0] << 8 | src[1];
+  }
+
+  uint32_t BusController_M5HDMI::stats_t::commands(void) const
+  {
+    uint32_t res = 0;
+    for (auto c : count) { res += c; }
+    return res;
+  }
+
+  uint64_t BusController_M5HDMI::stats_t::total_bytes(void) const
+  {
+    uint64_t res = 0;
+    for (auto b : bytes) { res += b; }
+    return res;
+  }
+
+  const char* BusController_M5HDMI::getCommandName(uint8_t cmd)
+  {
+    switch (cmd)
+    {
+    case HDMI::CMD_NOP:             return "NOP";
+    case HDMI::CMD_READ_ID:         return "READ_ID";
+    case HDMI::CMD_SCREEN_SCALING:  return "SCREEN_SCALING";
+    case HDMI::CMD_SCREEN_ORIGIN:   return "SCREEN_ORIGIN";
+    case HDMI::CMD_COPYRECT:        return "COPYRECT";
+    case HDMI::CMD_CASET:           return "CASET";
+    case HDMI::CMD_RASET:           return "RASET";
+    case HDMI::CMD_WRITE_RAW_8:     return "WRITE_RAW_8";
+    case HDMI::CMD_WRITE_RAW_16:    return "WRITE_RAW_16";
+    case HDMI::CMD_WRITE_RAW_24:    return "WRITE_RAW_24";
+    case HDMI::CMD_WRITE_RAW_32:    return "WRITE_RAW_32";
+    case HDMI::CMD_WRITE_RAW_A:     return "WRITE_RAW_A";
+    case HDMI::CMD_WRITE_RLE_8:     return "WRITE_RLE_8";
+    case HDMI::CMD_WRITE_RLE_16:    return "WRITE_RLE_16";
+    case HDMI::CMD_WRITE_RLE_24:    return "WRITE_RLE_24";
+    case HDMI::CMD_WRITE_RLE_32:    return "WRITE_RLE_32";
+    case HDMI::CMD_WRITE_RLE_A:     return "WRITE_RLE_A";
+    case HDMI::CMD_DRAWPIXEL:       return "DRAWPIXEL";
+    case HDMI::CMD_DRAWPIXEL_8:     return "DRAWPIXEL_8";
+    case HDMI::CMD_DRAWPIXEL_16:    return "DRAWPIXEL_16";
+    case HDMI::CMD_DRAWPIXEL_24:    return "DRAWPIXEL_24";
+    case HDMI::CMD_DRAWPIXEL_32:    return "DRAWPIXEL_32";
+    case HDMI::CMD_FILLRECT:        return "FILLRECT";
+    case HDMI::CMD_FILLRECT_8:      return "FILLRECT_8";
+    case HDMI::CMD_FILLRECT_16:     return "FILLRECT_16";
+    case HDMI::CMD_FILLRECT_24:     return "FILLRECT_24";
+    case HDMI::CMD_FILLRECT_32:     return "FILLRECT_32";
+    case HDMI::CMD_READ_RAW_8:      return "READ_RAW_8";
+    case HDMI::CMD_READ_RAW_16:     return "READ_RAW_16";
+    case HDMI::CMD_READ_RAW_24:     return "READ_RAW_24";
+    case HDMI::CMD_VIDEO_TIMING_V:  return "VIDEO_TIMING_V";
+    case HDMI::CMD_VIDEO_TIMING_H:  return "VIDEO_TIMING_H";
+    case HDMI::CMD_VIDEO_CLOCK:     return "VIDEO_CLOCK";
+    default:                        return "?";
+    }
+  }
+
+  BusController_M5HDMI::BusController_M5HDMI(uint16_t width, uint16_t height)
+  {
+    resize(width, height);
+  }
+
+  void BusController_M5HDMI::resize(uint16_t width, uint16_t height)
+  {
+    _width = width;
+    _height = height;
+    _ram.assign(width * height * 3, 0);
+    _xs = _ys = 0;
+    _xe = width - 1;
+    _ye = height - 1;
+  }
+
+  void BusController_M5HDMI::readRow(uint_fast16_t y, uint8_t* rgb) const
+  {
+    size_t len = _width * 3;
+    y += _origin_y;
+    if (y >= _height)
+    {
+      memset(rgb, 0, len);
+      return;
+    }
+    size_t skip = std::min<size_t>(_origin_x, _width) * 3;
+    memcpy(rgb, &_ram[y * len + skip], len - skip);
+    memset(&rgb[len - skip], 0, skip);
+  }
+
+  void BusController_M5HDMI::endFrame(void)
+  {
+    _frame_stats = _stats;
+    _stats = stats_t();
+    ++_frame_count;
+  }
+
+  void BusController_M5HDMI::endTransaction(void)
+  {
+    // CS high ends the pixel data and drops an unfinished command.
+    _write_raw = false;
+    _read_raw = false;
+    _reply_len = 0;
+    _param_need = 0;
+    _param_count = 0;
+  }
+
+  void BusController_M5HDMI::next_pixel(void)
+  {
+    if (++_x > _xe)
+    {
+      _x = _xs;
+      if (++_y > _ye) { _y = _ys; }
+    }
+  }
+
+  void BusController_M5HDMI::store(uint_fast16_t x, uint_fast16_t y, const uint8_t* argb)
+  {
+    if (x >= _width || y >= _height) { return; }
+    ++_stats.pixels;
+    ++_write_count;
+    auto dst = &_ram[(x + y * _width) * 3];
+    uint_fast8_t a = argb[0];
+    if (a == 0xFF)
+    {
+      memcpy(dst, &argb[1], 3);
+    }
+    else if (a)
+    {
+      uint_fast8_t inv = 0xFF - a;
+      for (int i = 0; i < 3; ++i)
+      {
+        dst[i] = (argb[i + 1] * a + dst[i] * inv + 127) / 255;
+      }
+    }
+  }
+
+  void BusController_M5HDMI::fill(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye)
+  {
+    if (xs > xe) { std::swap(xs, xe); }
+    if (ys > ye) { std::swap(ys, ye); }
+    if (xe >= _width ) { xe = _width  - 1; }
+    if (ye >= _height) { ye = _height - 1; }
+    for (uint_fast16_t y = ys; y <= ye; ++y)
+    {
+      for (uint_fast16_t x = xs; x <= xe; ++x)
+      {
+        store(x, y, _color);
+      }
+    }
+  }
+
+  void BusController_M5HDMI::copy(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye, uint_fast16_t dst_x, uint_fast16_t dst_y)
+  {
+    // The rows are copied in the order given, ye < ys copies from the bottom row up. (used when the destination is below the source)
+    int_fast16_t ay = (ye < ys) ? -1 : 1;
+    uint_fast16_t h = ((ay < 0) ? (ys - ye) : (ye - ys)) + 1;
+    if (xs > xe) { std::swap(xs, xe); }
+    uint_fast16_t w = xe - xs + 1;
+    std::vector<uint8_t> line(w * 4);
+    for (uint_fast16_t i = 0; i < h; ++i)
+    {
+      uint_fast16_t sy = ys + i * ay;
+      uint_fast16_t dy = dst_y + i * ay;
+      for (uint_fast16_t j = 0; j < w; ++j)
+      {
+        auto argb = &line[j * 4];
+        uint_fast16_t sx = xs + j;
+        argb[0] = 0;
+        if (sx < _width && sy < _height)
+        {
+          argb[0] = 0xFF;
+          memcpy(&argb[1], &_ram[(sx + sy * _width) * 3], 3);
+        }
+      }
+      for (uint_fast16_t j = 0; j < w; ++j)
+      {
+        if (line[j * 4]) { store(dst_x + j, dy, &line[j * 4]); }
+      }
+    }
+  }
+
+  void BusController_M5HDMI::command(uint8_t cmd)
+  {
+    _cmd = cmd;
+    _param_count = 0;
+    _param_need = hdmi_command_length(cmd) - 1;
+    ++_stats.count[cmd];
+    ++_stats.bytes[cmd];
+
+    switch (cmd)
+    {
+    case HDMI::CMD_NOP:
+      break;
+
+    case HDMI::CMD_READ_ID:
+      { // the first byte ends the wait for the reply, the second one is skipped by the driver.
+        static constexpr uint8_t id[] = { 0x00, 0xFF, 'H', 'D', 0x01, 0x00 };
+        memcpy(_reply, id, sizeof(id));
+        _reply_len = sizeof(id);
+        _reply_pos = 0;
+      }
+      break;
+
+    case HDMI::CMD_WRITE_RAW_8:
+    case HDMI::CMD_WRITE_RAW_16:
+    case HDMI::CMD_WRITE_RAW_24:
+    case HDMI::CMD_WRITE_RAW_32:
+    case HDMI::CMD_WRITE_RAW_A:
+    case HDMI::CMD_WRITE_RLE_8:
+    case HDMI::CMD_WRITE_RLE_16:
+    case HDMI::CMD_WRITE_RLE_24:
+    case HDMI::CMD_WRITE_RLE_32:
+    case HDMI::CMD_WRITE_RLE_A:
+      _write_raw = true;
+      _pixel_bytes = hdmi_pixel_bytes(cmd);
+      _pixel_count = 0;
+      _rle_state = 0;
+      _x = _xs;
+      _y = _ys;
+      break;
+
+    case HDMI::CMD_READ_RAW_8:
+    case HDMI::CMD_READ_RAW_16:
+    case HDMI::CMD_READ_RAW_24:
+      _read_raw = true;
+      _pixel_bytes = hdmi_pixel_bytes(cmd);
+      _pixel_count = 0;
+      _x = _xs;
+      _y = _ys;
+      break;
+
+    default:
+      if (_param_need == 0) { ++_stats.errors; }
+      break;
+    }
+  }
+
+  void BusController_M5HDMI::command_done(void)
+  {
+    auto p = _param;
+    uint_fast8_t sum = _cmd;
+    for (uint_fast8_t i = 0; i < _param_need; ++i) { sum += p[i]; }
+
+    switch (_cmd)
+    {
+    case HDMI::CMD_CASET:
+      _xs = hdmi_get16(&p[0]);
+      _xe = hdmi_get16(&p[2]);
+      return;
+
+    case HDMI::CMD_RASET:
+      _ys = hdmi_get16(&p[0]);
+      _ye = hdmi_get16(&p[2]);
+      return;
+
+    case HDMI::CMD_COPYRECT:
+      copy(hdmi_get16(&p[0]), hdmi_get16(&p[2]), hdmi_get16(&p[4]), hdmi_get16(&p[6]), hdmi_get16(&p[8]), hdmi_get16(&p[10]));
+      return;
+
+    default:
+      break;
+    }
+
+    if ((_cmd & ~7) == HDMI::CMD_DRAWPIXEL || (_cmd & ~7) == HDMI::CMD_FILLRECT)
+    {
+      bool rect = (_cmd & ~7) == HDMI::CMD_FILLRECT;
+      uint_fast8_t format = _cmd & 7;
+      if (format) { hdmi_decode(_color, &p[rect ? 8 : 4], format, _color); }
+      uint_fast16_t x = hdmi_get16(&p[0]);
+      uint_fast16_t y = hdmi_get16(&p[2]);
+      if (rect) { fill(x, y, hdmi_get16(&p[4]), hdmi_get16(&p[6])); }
+      else      { store(x, y, _color); }
+      return;
+    }
+
+    // the remaining commands end with a checksum, all the bytes of the command add up to 0xFF.
+    if ((sum & 0xFF) != 0xFF)
+    {
+      ++_stats.errors;
+      return;
+    }
+    switch (_cmd)
+    {
+    case HDMI::CMD_SCREEN_SCALING:
+      {
+        uint_fast16_t w = hdmi_get16(&p[2]);
+        uint_fast16_t h = hdmi_get16(&p[4]);
+        _scale_x = p[0];
+        _scale_y = p[1];
+        if (w && h && (w != _width || h != _height)) { resize(w, h); }
+      }
+      break;
+
+    case HDMI::CMD_SCREEN_ORIGIN:
+      _origin_x = hdmi_get16(&p[0]);
+      _origin_y = hdmi_get16(&p[2]);
+      break;
+
+    default: // video timing and clock, nothing to emulate.
+      break;
+    }
+  }
+
+  uint32_t BusController_M5HDMI::write_raw(const uint8_t* data, uint32_t length)
+  {
+    uint_fast8_t bytes = _pixel_bytes;
+    uint_fast8_t format = _cmd & 7;
+    bool rle = (_cmd & ~7) == HDMI::CMD_WRITE_RLE;
+    uint8_t argb[4];
+    for (uint32_t i = 0; i < length; ++i)
+    {
+      uint8_t value = data[i];
+      if (rle && _rle_state < 2)
+      {
+        if (_rle_state == 0)
+        { // 1~255 : run length, 0 : absolute data follows.
+          _rle_len = value;
+          _rle_state = value ? 2 : 1;
+        }
+        else
+        {
+          if (value < 3) { ++_stats.errors; }  // 0~2 are not used by the encoders.
+          _rle_len = value;
+          _rle_state = value ? 3 : 0;
+        }
+        continue;
+      }
+      _pixel[_pixel_count] = value;
+      if (++_pixel_count == bytes)
+      {
+        _pixel_count = 0;
+        hdmi_decode(argb, _pixel, format, _color);
+        uint_fast8_t count = (rle && _rle_state == 2) ? _rle_len : 1;
+        do
+        {
+          store(_x, _y, argb);
+          next_pixel();
+        } while (--count);
+        if (rle && (_rle_state == 2 || --_rle_len == 0)) { _rle_state = 0; }
+      }
+    }
+    _stats.bytes[_cmd] += length;
+    return length;
+  }
+
+  void BusController_M5HDMI::write(const uint8_t* data, uint32_t length, bool dc)
+  {
+    // the FPGA has no D/C line, command and data bytes form one stream.
+    (void)dc;
+    _reply_len = 0;
+    _read_raw = false;
+
+    uint32_t i = 0;
+    while (i < length)
+    {
+      if (_write_raw)
+      {
+        i += write_raw(&data[i], length - i);
+      }
+      else if (_param_count < _param_need)
+      {
+        uint32_t len = std::min<uint32_t>(_param_need - _param_count, length - i);
+        memcpy(&_param[_param_count], &data[i], len);
+        _stats.bytes[_cmd] += len;
+        _param_count += len;
+        i += len;
+        if (_param_count == _param_need) { command_done(); }
+      }
+      else
+      {
+        command(data[i++]);
+      }
+    }
+  }
+
+  void BusController_M5HDMI::read(uint8_t* dst, uint32_t length)
+  {
+    // reading toggles CS, which ends the pixel data of CMD_WRITE_RAW_*.
+    _write_raw = false;
+
+    if (_reply_pos < _reply_len || _read_raw)
+    {
+      for (uint32_t i = 0; i < length; ++i)
+      {
+        if (_reply_pos < _reply_len)
+        {
+          dst[i] = _reply[_reply_pos++];
+        }
+        else if (_read_raw)
+        {
+          if (_pixel_count == 0)
+          {
+            uint8_t rgb[3] = { 0, 0, 0 };
+            if (_x < _width && _y < _height) { memcpy(rgb, &_ram[(_x + _y * _width) * 3], 3); }
+            next_pixel();
+            switch (_pixel_bytes)
+            {
+            case 1:
+              _pixel[0] = color332(rgb[0], rgb[1], rgb[2]);
+              break;
+            case 2:
+              {
+                uint_fast16_t c = color565(rgb[0], rgb[1], rgb[2]);
+                _pixel[0] = c >> 8;
+                _pixel[1] = c;
+              }
+              break;
+            default:
+              memcpy(_pixel, rgb, 3);
+              break;
+            }
+            _pixel_count = _pixel_bytes;
+          }
+          dst[i] = _pixel[_pixel_bytes - _pixel_count--];
+        }
+        else
+        {
+          dst[i] = 0xFF;
+        }
+      }
+      return;
+    }
+
+    // busy poll : anything other than 0x00 means the FPGA has processed the commands.
+    ++_stats.status_reads;
+    memset(dst, 0xFF, length);
+  }
+
+//----------------------------------------------------------------------------
+
+  static constexpr uint16_t IT8951_PREAMBLE_CMD   = 0x6000;
+  static constexpr uint16_t IT8951_PREAMBLE_WRITE = 0x0000;
+  static constexpr uint16_t IT8951_PREAMBLE_READ  = 0x1000;
+
+  static constexpr uint16_t IT8951_SYS_RUN        = 0x0001;
+  static constexpr uint16_t IT8951_STANDBY        = 0x0002;
+  static constexpr uint16_t IT8951_SLEEP          = 0x0003;
+  static constexpr uint16_t IT8951_REG_RD         = 0x0010;
+  static constexpr uint16_t IT8951_REG_WR         = 0x0011;
+  static constexpr uint16_t IT8951_MEM_BST_RD_T   = 0x0012;
+  static constexpr uint16_t IT8951_MEM_BST_RD_S   = 0x0013;
+  static constexpr uint16_t IT8951_MEM_BST_WR     = 0x0014;
+  static constexpr uint16_t IT8951_MEM_BST_END    = 0x0015;
+  static constexpr uint16_t IT8951_LD_IMG_AREA    = 0x0021;
+  static constexpr uint16_t IT8951_LD_IMG_END     = 0x0022;
+  static constexpr uint16_t IT8951_DPY_AREA       = 0x0034;
+  static constexpr uint16_t IT8951_DPY_BUF_AREA   = 0x0037;
+  static constexpr uint16_t IT8951_VCOM           = 0x0039;
+  static constexpr uint16_t IT8951_GET_DEV_INFO   = 0x0302;
+
+  static constexpr uint16_t IT8951_LISAR          = 0x0208;
+  static constexpr uint16_t IT8951_LUTAFSR        = 0x1224;
+
+  /// Number of data words that form the parameters of a command. ( the pixel data of LD_IMG_AREA follows them )
+  static uint_fast8_t it8951_param_length(uint_fast16_t cmd)
+  {
+    switch (cmd)
+    {
+    case IT8951_REG_RD:        return 1;
+    case IT8951_REG_WR:        return 2;
+    case IT8951_MEM_BST_RD_T:  return 4;
+    case IT8951_LD_IMG_AREA:   return 5;
+    case IT8951_DPY_AREA:      return 5;
+    case IT8951_DPY_BUF_AREA:  return 7;
+    case IT8951_VCOM:          return 2;  // 0 : read, 1 : followed by the value to write
+    default:                   return 0;
+    }
+  }
+
+  BusController_IT8951::BusController_IT8951(void)
+  {
+    config(_cfg);
+  }
+
+  void BusController_IT8951::config(const config_t& config)
+  {
+    _cfg = config;
+    _width  = config.panel_width;
+    _height = config.panel_height;
+    // start white, as the panel is after the INIT waveform.
+    _mem.assign(_width * _height, 0xF0);
+    _screen = _mem;
+    _refreshing.clear();
+    _lisar = config.image_buffer_addr;
+  }
+
+  void BusController_IT8951::readRow(uint_fast16_t y, uint8_t* rgb) const
+  {
+    auto src = &_screen[y * _width];
+    for (uint_fast16_t x = 0; x < _width; ++x)
+    {
+      uint8_t v = src[x] | src[x] >> 4;
+      rgb[x * 3 + 0] = v;
+      rgb[x * 3 + 1] = v;
+      rgb[x * 3 + 2] = v;
+    }
+  }
+
+  uint32_t BusController_IT8951::getUndisplayedPixels(void) const
+  {
+    uint32_t res = 0;
+    for (size_t i = 0; i < _mem.size(); ++i)
+    {
+      if (_mem[i] != _screen[i]) { ++res; }
+    }
+    return res;
+  }
+
+  void BusController_IT8951::setCS(bool level)
+  {
+    if (!level) { return; }
+    if (_has_byte) { ++_stats.errors; }  // a frame must hold whole words.
+    _has_byte = false;
+    _frame = 0;
+  }
+
+  void BusController_IT8951::write(const uint8_t* data, uint32_t length, bool)
+  {
+    for (uint32_t i = 0; i < length; ++i)
+    {
+      if (!_has_byte)
+      {
+        _byte = data[i];
+        _has_byte = true;
+        continue;
+      }
+      _has_byte = false;
+      word(_byte << 8 | data[i]);
+    }
+  }
+
+  void BusController_IT8951::read(uint8_t* dst, uint32_t length)
+  {
+    if (_frame != 3) { ++_stats.errors; }  // a read needs its own frame with the read preamble.
+    for (uint32_t i = 0; i < length; ++i, ++_reply_pos)
+    {
+      uint32_t idx = _reply_pos >> 1;
+      uint16_t w = idx < _reply.size() ? _reply[idx] : 0;
+      dst[i] = (_reply_pos & 1) ? w : w >> 8;
+    }
+  }
+
+  void BusController_IT8951::word(uint16_t value)
+  {
+    switch (_frame)
+    {
+    case 0:  // preamble
+      switch (value)
+      {
+      case IT8951_PREAMBLE_CMD:   _frame = 1; break;
+      case IT8951_PREAMBLE_WRITE: _frame = 2; break;
+      case IT8951_PREAMBLE_READ:  _frame = 3; break;
+      default: ++_stats.errors; _frame = 4; break;
+      }
+      break;
+
+    case 1:  // a command frame holds one command word.
+      command(value);
+      _frame = 4;
+      break;
+
+    case 2:
+      if (_param_count < it8951_param_length(_cmd)) { parameter(value); }
+      else if (_cmd == IT8951_LD_IMG_AREA)         { load_pixels(value); }
+      else                                          { ++_stats.errors; }
+      break;
+
+    default:  // words after the command, or written in a read frame.
+      ++_stats.errors;
+      break;
+    }
+  }
+
+  void BusController_IT8951::command(uint16_t cmd)
+  {
+    _cmd = cmd;
+    _param_count = 0;
+    switch (cmd)
+    {
+    case IT8951_SYS_RUN:
+      _sleep = false;
+      break;
+
+    case IT8951_STANDBY:
+    case IT8951_SLEEP:
+      // the waveforms stop with the clocks, leaving the refreshes unfinished.
+      if (!_refreshing.empty()) { ++_stats.errors; }
+      _sleep = true;
+      break;
+
+    case IT8951_MEM_BST_RD_S:
+      {
+        _reply.resize(_burst_len);
+        uint32_t addr = _burst_addr - _cfg.image_buffer_addr;
+        for (uint32_t i = 0; i < _burst_len; ++i, addr += 2)
+        { // the pixel at the lower address is the low byte of a word.
+          uint8_t lo = addr     < _mem.size() ? _mem[addr    ] : 0;
+          uint8_t hi = addr + 1 < _mem.size() ? _mem[addr + 1] : 0;
+          _reply[i] = hi << 8 | lo;
+        }
+        _reply_pos = 0;
+      }
+      break;
+
+    case IT8951_LD_IMG_END:
+      {
+        uint32_t x = _param[1];
+        uint32_t w = _param[3];
+        uint32_t words = (((x + w + 3) >> 2) - (x >> 2)) * _param[4];
+        if (_load_words != words) { ++_stats.errors; }
+        _load_words = 0;
+      }
+      break;
+
+    case IT8951_GET_DEV_INFO:
+      _reply.assign(20, 0);
+      _reply[0] = _cfg.panel_width;
+      _reply[1] = _cfg.panel_height;
+      _reply[2] = _cfg.image_buffer_addr;
+      _reply[3] = _cfg.image_buffer_addr >> 16;
+      _reply_pos = 0;
+      break;
+
+    case IT8951_MEM_BST_WR:
+    case IT8951_MEM_BST_END:
+      break;
+
+    default:
+      if (it8951_param_length(cmd) == 0) { ++_stats.errors; }
+      break;
+    }
+  }
+
+  void BusController_IT8951::parameter(uint16_t value)
+  {
+    _param[_param_count++] = value;
+    switch (_cmd)
+    {
+    case IT8951_REG_RD:
+      _reply.assign(1, 0);
+      _reply_pos = 0;
+      if (value == IT8951_LUTAFSR)
+      { // time passes with the polls : every running refresh gets closer to its end.
+        ++_stats.lutafsr_reads;
+        for (size_t i = 0; i < _refreshing.size(); )
+        {
+          if (--_refreshing[i].polls == 0) { _refreshing.erase(_refreshing.begin() + i); }
+          else { ++i; }
+        }
+        _reply[0] = _refreshing.empty() ? 0 : 1;
+      }
+      break;
+
+    case IT8951_REG_WR:
+      if (_param_count == 2)
+      {
+        if      (_param[0] == IT8951_LISAR + 2) { _lisar = (_lisar & 0xFFFF) | (uint32_t)value << 16; }
+        else if (_param[0] == IT8951_LISAR    ) { _lisar = (_lisar & ~0xFFFFu) | value; }
+      }
+      break;
+
+    case IT8951_MEM_BST_RD_T:
+      if (_param_count == 4)
+      {
+        _burst_addr = _param[0] | (uint32_t)_param[1] << 16;
+        _burst_len  = _param[2] | (uint32_t)_param[3] << 16;
+      }
+      break;
+
+    case IT8951_LD_IMG_AREA:
+      if (_param_count == 5)
+      {
+        ++_stats.loads;
+        _load_words = 0;
+        // 4bpp, big endian, and into the image buffer that DPY_BUF_AREA shows.
+        if ((_param[0] & 0x0F30) != 0x0120 || _lisar != _cfg.image_buffer_addr) { ++_stats.errors; }
+        uint_fast16_t l, t, r, b;
+        load_raw_range(l, t, r, b);
+        if (refreshing(l, t, r, b)) { ++_stats.load_conflicts; }
+      }
+      break;
+
+    case IT8951_DPY_AREA:
+      if (_param_count == 5) { refresh(_param[0], _param[1], _param[2], _param[3], _param[4]); }
+      break;
+
+    case IT8951_DPY_BUF_AREA:
+      if (_param_count == 7)
+      {
+        if ((_param[5] | (uint32_t)_param[6] << 16) != _cfg.image_buffer_addr) { ++_stats.errors; }
+        refresh(_param[0], _param[1], _param[2], _param[3], _param[4]);
+      }
+      break;
+
+    case IT8951_VCOM:
+      if (_param_count == 1 && value == 0)
+      { // read : no value follows.
+        _reply.assign(1, 0);
+        _reply_pos = 0;
+        _param_count = 2;
+      }
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  /// Area of the load in memory coordinates.
+  void BusController_IT8951::load_raw_range(uint_fast16_t& left, uint_fast16_t& top, uint_fast16_t& right, uint_fast16_t& bottom) const
+  {
+    uint_fast16_t x = _param[1], y = _param[2], w = _param[3], h = _param[4];
+    uint_fast16_t pw = _cfg.panel_width, ph = _cfg.panel_height;
+    switch (_param[0] & 3)
+    {
+    default: left = x;          top = y;          right = x + w - 1;  bottom = y + h - 1;  break;
+    case 1:  left = y;          top = ph - x - w; right = y + h - 1;  bottom = ph - x - 1; break;
+    case 2:  left = pw - x - w; top = ph - y - h; right = pw - x - 1; bottom = ph - y - 1; break;
+    case 3:  left = pw - y - h; top = x;          right = pw - y - 1; bottom = x + w - 1;  break;
+    }
+  }
+
+  void BusController_IT8951::load_pixels(uint16_t value)
+  {
+    uint_fast16_t x = _param[1];
+    uint_fast16_t w = _param[3];
+    uint32_t words = ((x + w + 3) >> 2) - (x >> 2);
+    uint32_t row = _load_words / words;
+    uint32_t px = (x & ~3) + ((_load_words % words) << 2);
+    if (row >= _param[4]) { ++_stats.errors; return; }
+    ++_load_words;
+    for (int_fast8_t shift = 12; shift >= 0; shift -= 4, ++px)
+    { // first pixel in the upper 4 bits, pixels outside the area are padding.
+      if (x <= px && px < x + w) { store(px, _param[2] + row, (value >> shift) & 15); }
+    }
+  }
+
+  void BusController_IT8951::store(uint_fast16_t x, uint_fast16_t y, uint_fast8_t value)
+  {
+    // the IT8951 rotates counterclockwise from the load coordinates to the memory.
+    uint_fast16_t pw = _cfg.panel_width, ph = _cfg.panel_height;
+    uint_fast16_t mx, my;
+    switch (_param[0] & 3)
+    {
+    default: mx = x;          my = y;          break;
+    case 1:  mx = y;          my = ph - 1 - x; break;
+    case 2:  mx = pw - 1 - x; my = ph - 1 - y; break;
+    case 3:  mx = pw - 1 - y; my = x;          break;
+    }
+    if (mx >= pw || my >= ph) { ++_stats.errors; return; }
+    _mem[mx + my * pw] = value << 4;
+  }
+
+  bool BusController_IT8951::refreshing(uint_fast16_t left, uint_fast16_t top, uint_fast16_t right, uint_fast16_t bottom) const
+  {
+    for (auto& r : _refreshing)
+    {
+      if (left <= r.right && r.left <= right && top <= r.bottom && r.top <= bottom) { return true; }
+    }
+    return false;
+  }
+
+  void BusController_IT8951::refresh(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint_fast8_t mode)
+  {
+    if (_sleep) { ++_stats.errors; }
+    uint_fast16_t r = std::min<uint_fast16_t>(x + w, _width ) - 1;
+    uint_fast16_t b = std::min<uint_fast16_t>(y + h, _height) - 1;
+    if (w == 0 || h == 0 || x > r || y > b) { ++_stats.errors; return; }
+
+    ++_stats.refreshes;
+    ++_stats.mode_refreshes[mode & 7];
+    _stats.refresh_pixels += (r - x + 1) * (b - y + 1);
+    if (refreshing(x, y, r, b)) { ++_stats.overlaps; }
+
+    for (uint_fast16_t j = y; j <= b; ++j)
+    {
+      memcpy(&_screen[x + j * _width], &_mem[x + j * _width], r - x + 1);
+    }
+    refresh_t ref = { (uint16_t)x, (uint16_t)y, (uint16_t)r, (uint16_t)b, std::max<uint32_t>(1, _cfg.refresh_polls) };
+    _refreshing.push_back(ref);
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,319 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "Bus_Record.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Controller model that keeps the memory of the display, so the result of a driver can be checked as an image.
+  class BusController_RAM : public IBusController
+  {
+  public:
+    uint16_t width(void) const { return _width; }
+    uint16_t height(void) const { return _height; }
+
+    /// Converts one row of the display, as it would be seen on the panel, to RGB888 (3 bytes per pixel, R first).
+    virtual void readRow(uint_fast16_t y, uint8_t* rgb) const = 0;
+
+    /// Encodes the display contents to a PNG image in memory. The caller must free() the result.
+    void* createPng(size_t* datalen) const;
+
+    /// Number of pixels (or bytes for 1bpp controllers) stored in the memory.
+    uint32_t getWriteCount(void) const { return _write_count; }
+    void resetWriteCount(void) { _write_count = 0; }
+
+  protected:
+    uint16_t _width = 0;
+    uint16_t _height = 0;
+    uint32_t _write_count = 0;
+    bool _invert = false;
+    bool _display_on = true;
+  };
+
+//----------------------------------------------------------------------------
+
+  /// MIPI DCS controller (ST7789, ILI9341, GC9A01 ...) driven by Panel_LCD.
+  /// Understands CASET / RASET / RAMWR / RAMWRC / MADCTL / COLMOD / INVON / INVOFF / DISPON / DISPOFF.
+  class BusController_MIPI : public BusController_RAM
+  {
+  public:
+    struct config_t
+    {
+      /// Size of the controller memory. (not the panel)
+      uint16_t memory_width  = 240;
+      uint16_t memory_height = 320;
+
+      /// true : the panel shows inverted colors, and needs INVON to display them normally. (IPS panels)
+      bool invert = false;
+    };
+
+    BusController_MIPI(void);
+
+    const config_t& config(void) const { return _cfg; }
+    void config(const config_t& config);
+
+    void readRow(uint_fast16_t y, uint8_t* rgb) const override;
+
+    void write(const uint8_t* data, uint32_t length, bool dc) override;
+
+  protected:
+    config_t _cfg;
+    std::vector<uint8_t> _ram;  // RGB888
+    uint16_t _xs = 0, _xe = 0, _ys = 0, _ye = 0;
+    uint16_t _x = 0, _y = 0;
+    uint8_t _cmd = 0;
+    uint8_t _param[4];
+    uint8_t _param_count = 0;
+    uint8_t _madctl = 0;
+    uint8_t _pixel_bytes = 2;
+    uint8_t _pixel_mask = 0xFF;
+    uint8_t _pixel[3];
+    uint8_t _pixel_count = 0;
+    bool _inversion = false;
+
+    void command(uint8_t cmd);
+    void parameter(uint8_t value);
+    void store_pixel(void);
+  };
+
+//----------------------------------------------------------------------------
+
+  /// SSD1306 style 1bpp OLED controller driven by Panel_SSD1306.
+  /// Understands the horizontal / vertical / page addressing modes, segment remap, COM scan direction,
+  /// display start line, invert and display on/off. Commands with parameters are skipped correctly.
+  class BusController_SSD1306 : public BusController_RAM
+  {
+  public:
+    BusController_SSD1306(uint16_t width = 128, uint16_t height = 64);
+
+    void readRow(uint_fast16_t y, uint8_t* rgb) const override;
+
+    void write(const uint8_t* data, uint32_t length, bool dc) override;
+
+  protected:
+    std::vector<uint8_t> _gddram;  // 8 vertical pixels per byte, one page after another.
+    uint8_t _cmd = 0;
+    uint8_t _param[6];
+    uint8_t _param_count = 0;
+    uint8_t _param_need = 0;
+    uint8_t _mode = 2;  // 0 : horizontal, 1 : vertical, 2 : page
+    uint8_t _col_start = 0, _col_end = 127;
+    uint8_t _page_start = 0, _page_end = 7;
+    uint8_t _col = 0, _page = 0;
+    uint8_t _start_line = 0;
+    bool _seg_remap = false;
+    bool _com_reverse = false;
+
+    uint8_t pages(void) const { return (_height + 7) >> 3; }
+    void command(uint8_t cmd);
+    void command_done(void);
+    void store(uint8_t value);
+  };
+
+//----------------------------------------------------------------------------
+
+  /// FPGA of M5AtomDisplay / M5ModuleDisplay driven by Panel_M5HDMI.
+  /// Keeps the frame memory in the logical resolution set by CMD_SCREEN_SCALING, answers CMD_READ_ID and the busy polls,
+  /// and counts the commands and bytes received for every opcode, per frame.
+  class BusController_M5HDMI : public BusController_RAM
+  {
+  public:
+    struct stats_t
+    {
+      uint32_t count[256] = {};   // commands received, per opcode
+      uint64_t bytes[256] = {};   // bytes received, per opcode (command byte, parameters and pixel data)
+      uint64_t pixels = 0;        // pixels stored to the memory
+      uint32_t status_reads = 0;  // busy polls answered
+      uint32_t errors = 0;        // checksum errors and unknown opcodes
+
+      uint32_t commands(void) const;
+      uint64_t total_bytes(void) const;
+    };
+
+    BusController_M5HDMI(uint16_t width = 1280, uint16_t height = 720);
+
+    void readRow(uint_fast16_t y, uint8_t* rgb) const override;
+
+    void endTransaction(void) override;
+    void write(const uint8_t* data, uint32_t length, bool dc) override;
+    void read(uint8_t* dst, uint32_t length) override;
+
+    const stats_t& getStats(void) const { return _stats; }
+    void resetStats(void) { _stats = stats_t(); }
+
+    /// Closes the current frame. The statistics counted since the previous call move to getFrameStats().
+    void endFrame(void);
+    const stats_t& getFrameStats(void) const { return _frame_stats; }
+    uint32_t getFrameCount(void) const { return _frame_count; }
+
+    uint8_t getScaleX(void) const { return _scale_x; }
+    uint8_t getScaleY(void) const { return _scale_y; }
+    uint16_t getViewPortX(void) const { return _origin_x; }
+    uint16_t getViewPortY(void) const { return _origin_y; }
+
+    /// Name of an opcode for reports. ( "?" for unknown opcodes )
+    static const char* getCommandName(uint8_t cmd);
+
+  protected:
+    std::vector<uint8_t> _ram;  // RGB888
+    stats_t _stats;
+    stats_t _frame_stats;
+    uint32_t _frame_count = 0;
+    uint16_t _xs = 0, _xe = 0, _ys = 0, _ye = 0;
+    uint16_t _x = 0, _y = 0;
+    uint16_t _origin_x = 0, _origin_y = 0;
+    uint8_t _scale_x = 1, _scale_y = 1;
+    uint8_t _cmd = 0;
+    uint8_t _param[16];
+    uint8_t _param_count = 0;
+    uint8_t _param_need = 0;
+    uint8_t _color[4] = { 0xFF, 0, 0, 0 };  // A, R, G, B of the last color received
+    uint8_t _pixel[4];
+    uint8_t _pixel_count = 0;
+    uint8_t _pixel_bytes = 0;
+    uint8_t _rle_state = 0;   // CMD_WRITE_RLE_* : 0 count, 1 length of absolute data, 2 pixel of a run, 3 absolute pixels
+    uint8_t _rle_len = 0;
+    uint8_t _reply[8];
+    uint8_t _reply_len = 0;
+    uint8_t _reply_pos = 0;
+    bool _write_raw = false;  // receiving the pixel data of CMD_WRITE_RAW_* / CMD_WRITE_RLE_*
+    bool _read_raw = false;   // sending the pixel data of CMD_READ_RAW_*
+
+    void resize(uint16_t width, uint16_t height);
+    void command(uint8_t cmd);
+    void command_done(void);
+    uint32_t write_raw(const uint8_t* data, uint32_t length);
+    void next_pixel(void);
+    void store(uint_fast16_t x, uint_fast16_t y, const uint8_t* argb);
+    void fill(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye);
+    void copy(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye, uint_fast16_t dst_x, uint_fast16_t dst_y);
+  };
+
+//----------------------------------------------------------------------------
+
+  /// IT8951 E-paper controller ( M5Paper ) driven by Panel_IT8951 over SPI.
+  /// Decodes the 16bit word stream ( preamble, then a command, data words or a read ), keeps the 8bpp image memory
+  /// loaded with LD_IMG_AREA in 4bpp, answers GET_DEV_INFO, VCOM, register and memory burst reads,
+  /// and models the refreshes started by DPY_BUF_AREA: each one copies its area of the memory to the screen
+  /// and keeps the LUT engine busy ( LUTAFSR != 0 ) for a number of LUTAFSR reads.
+  /// readRow returns the screen, i.e. what the panel shows, in the orientation of the memory.
+  /// Bus_Record does not see the CS line, which the driver toggles through Panel_Device::cs_control;
+  /// forward it with setCS from an override of cs_control so that the preamble of every frame is found.
+  class BusController_IT8951 : public BusController_RAM
+  {
+  public:
+    struct config_t
+    {
+      uint16_t panel_width  = 960;
+      uint16_t panel_height = 540;
+
+      /// Address of the image buffer reported by GET_DEV_INFO.
+      uint32_t image_buffer_addr = 0x001236E0;
+
+      /// Number of LUTAFSR reads a refresh stays busy for.
+      uint32_t refresh_polls = 4;
+    };
+
+    struct stats_t
+    {
+      uint32_t refreshes = 0;           // DPY_BUF_AREA / DPY_AREA received
+      uint32_t mode_refreshes[8] = {};  // refreshes per waveform ( INIT, DU, GC16, GL16, GLR16, GLD16, DU4, A2 )
+      uint64_t refresh_pixels = 0;      // area of all refreshes
+      uint32_t overlaps = 0;            // refreshes started over the area of a refresh still running
+      uint32_t load_conflicts = 0;      // LD_IMG_AREA over the area of a refresh still running
+      uint32_t loads = 0;               // LD_IMG_AREA received
+      uint32_t lutafsr_reads = 0;
+      uint32_t errors = 0;              // unknown commands, load data not matching the area, refresh while asleep
+    };
+
+    BusController_IT8951(void);
+
+    const config_t& config(void) const { return _cfg; }
+    void config(const config_t& config);
+
+    void readRow(uint_fast16_t y, uint8_t* rgb) const override;
+
+    void write(const uint8_t* data, uint32_t length, bool dc) override;
+    void read(uint8_t* dst, uint32_t length) override;
+
+    /// Level of the CS line. A frame ends when it goes high; the next one starts with a preamble word.
+    void setCS(bool level);
+
+    const stats_t& getStats(void) const { return _stats; }
+    void resetStats(void) { _stats = stats_t(); }
+
+    /// Refreshes still running.
+    uint32_t getRefreshingCount(void) const { return _refreshing.size(); }
+
+    /// Ends the running refreshes, as if the waveforms had run to the end.
+    void finishRefreshes(void) { _refreshing.clear(); }
+
+    /// Pixels whose value in the image memory is not shown on the screen, i.e. loaded but not refreshed yet.
+    uint32_t getUndisplayedPixels(void) const;
+
+    /// true after TCON_SLEEP / TCON_STANDBY, until TCON_SYS_RUN.
+    bool isSleeping(void) const { return _sleep; }
+
+  protected:
+    struct refresh_t
+    {
+      uint16_t left, top, right, bottom;  // in memory coordinates
+      uint32_t polls;                     // LUTAFSR reads left until it ends
+    };
+
+    config_t _cfg;
+    stats_t _stats;
+    std::vector<uint8_t> _mem;     // image memory, 8bpp ( 4bpp loads are stored in the upper 4 bits )
+    std::vector<uint8_t> _screen;  // what the panel shows
+    std::vector<refresh_t> _refreshing;
+    std::vector<uint16_t> _reply;
+    uint32_t _reply_pos = 0;
+    uint32_t _lisar = 0;           // image buffer address of the loads ( LISAR )
+    uint32_t _burst_addr = 0;
+    uint32_t _burst_len = 0;
+    uint32_t _load_words = 0;      // pixel words received for the current load
+    uint16_t _cmd = 0;
+    uint16_t _param[8] = {};
+    uint8_t _param_count = 0;
+    uint8_t _frame = 0;            // 0 : preamble expected, 1 : command word, 2 : data words, 3 : read, 4 : frame over
+    uint8_t _byte = 0;             // first byte of a word, while _has_byte
+    bool _has_byte = false;
+    bool _sleep = false;
+
+    void word(uint16_t value);
+    void command(uint16_t cmd);
+    void parameter(uint16_t value);
+    void load_pixels(uint16_t value);
+    void refresh(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint_fast8_t mode);
+    bool refreshing(uint_fast16_t left, uint_fast16_t top, uint_fast16_t right, uint_fast16_t bottom) const;
+    void load_raw_range(uint_fast16_t& left, uint_fast16_t& top, uint_fast16_t& right, uint_fast16_t& bottom) const;
+    void store(uint_fast16_t x, uint_fast16_t y, uint_fast8_t value);
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
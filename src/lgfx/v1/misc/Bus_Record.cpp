@@ -0,0 +1,448 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "Bus_Record.hpp"
+#include "pixelcopy.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  void IBusController::read(uint8_t* dst, uint32_t length)
+  {
+    memset(dst, 0, length);
+  }
+
+//----------------------------------------------------------------------------
+
+  static constexpr uint32_t i2c_start_clocks = 1;
+  static constexpr uint32_t i2c_stop_clocks = 1;
+  static constexpr uint32_t i2c_byte_clocks = 9;
+
+  double Bus_Record::getModeledMicros(void) const
+  {
+    double res = 0;
+    if (_cfg.freq_write) { res += (double)_stats.write_clocks * 1000000.0 / _cfg.freq_write; }
+    if (_cfg.freq_read ) { res += (double)_stats.read_clocks  * 1000000.0 / _cfg.freq_read; }
+    return res;
+  }
+
+  bool Bus_Record::init(void)
+  {
+    _in_transaction = false;
+    _in_read = false;
+    _dc = -1;
+    return true;
+  }
+
+  void Bus_Record::release(void)
+  {
+    _dma_buf[0].clear();
+    _dma_buf[0].shrink_to_fit();
+    _dma_buf[1].clear();
+    _dma_buf[1].shrink_to_fit();
+  }
+
+  uint8_t* Bus_Record::getDMABuffer(uint32_t length)
+  {
+    auto& buf = _dma_buf[_dma_index ^= 1];
+    if (buf.size() < length) { buf.resize(length); }
+    return buf.data();
+  }
+
+//----------------------------------------------------------------------------
+
+  bool Bus_Record::trace_reserve(size_t length)
+  {
+    if (_trace_overflow) { return false; }
+    if (_trace.size() + length > _cfg.trace_limit)
+    {
+      _trace_overflow = (_cfg.trace_limit != 0);
+      return false;
+    }
+    return true;
+  }
+
+  void Bus_Record::trace_push(uint8_t tag)
+  {
+    _trace.push_back(tag);
+  }
+
+  void Bus_Record::trace_varint(uint32_t value)
+  {
+    while (value >= 0x80)
+    {
+      _trace.push_back(value | 0x80);
+      value >>= 7;
+    }
+    _trace.push_back(value);
+  }
+
+  void Bus_Record::trace_value(uint32_t value, uint_fast8_t bytes)
+  {
+    auto p = (const uint8_t*)&value;
+    _trace.insert(_trace.end(), p, p + bytes);
+  }
+
+  void Bus_Record::count_write(uint32_t length, bool dc)
+  {
+    uint64_t clocks = 0;
+    switch (_cfg.bus_type)
+    {
+    case bus_type_t::bus_i2c:
+      if (!_in_transaction || _in_read)
+      { // a write outside beginTransaction is sent in its own transfer.
+        _in_read = false;
+        _dc = -1;
+      }
+      if (_dc < 0)
+      {
+        clocks += i2c_start_clocks + i2c_byte_clocks;
+        _dc = 2;
+      }
+      if (_cfg.prefix_len && _dc != (int8_t)dc)
+      {
+        if (_dc != 2)
+        { // the prefix can not be changed within a transfer ; restart it.
+          clocks += i2c_stop_clocks + i2c_start_clocks + i2c_byte_clocks;
+        }
+        clocks += i2c_byte_clocks * _cfg.prefix_len;
+        _dc = dc;
+      }
+      clocks += (uint64_t)i2c_byte_clocks * length;
+      if (!_in_transaction)
+      {
+        clocks += i2c_stop_clocks;
+        _dc = -1;
+      }
+      break;
+
+    case bus_type_t::bus_parallel8:
+      clocks = length;
+      break;
+
+    case bus_type_t::bus_parallel16:
+      clocks = (length + 1) >> 1;
+      break;
+
+    default:
+      clocks = (uint64_t)length << 3;
+      break;
+    }
+    _stats.write_clocks += clocks;
+  }
+
+  void Bus_Record::count_read(uint32_t bits)
+  {
+    switch (_cfg.bus_type)
+    {
+    case bus_type_t::bus_i2c:
+      _stats.read_clocks += (bits >> 3) * i2c_byte_clocks;
+      break;
+
+    case bus_type_t::bus_parallel8:
+      _stats.read_clocks += bits >> 3;
+      break;
+
+    case bus_type_t::bus_parallel16:
+      _stats.read_clocks += bits >> 4;
+      break;
+
+    default:
+      _stats.read_clocks += bits;
+      break;
+    }
+  }
+
+  void Bus_Record::send(const uint8_t* data, uint32_t length, bool dc)
+  {
+    count_write(length, dc);
+    if (dc) { _stats.data_bytes    += length; }
+    else    { _stats.command_bytes += length; }
+    if (_controller) { _controller->write(data, length, dc); }
+  }
+
+//----------------------------------------------------------------------------
+
+  void Bus_Record::beginTransaction(void)
+  {
+    if (trace_reserve(1)) { trace_push(tag_begin); }
+    ++_stats.transactions;
+    _in_transaction = true;
+    _dc = -1;
+    if (_controller) { _controller->beginTransaction(); }
+  }
+
+  void Bus_Record::endTransaction(void)
+  {
+    if (trace_reserve(1)) { trace_push(tag_end); }
+    if (_cfg.bus_type == bus_type_t::bus_i2c && _dc >= 0)
+    {
+      _stats.write_clocks += i2c_stop_clocks;
+    }
+    _in_transaction = false;
+    _in_read = false;
+    _dc = -1;
+    if (_controller) { _controller->endTransaction(); }
+  }
+
+  bool Bus_Record::writeCommand(uint32_t data, uint_fast8_t bit_length)
+  {
+    uint_fast8_t bytes = bit_length >> 3;
+    if (trace_reserve(2 + bytes))
+    {
+      trace_push(tag_command);
+      trace_push(bit_length);
+      trace_value(data, bytes);
+    }
+    ++_stats.commands;
+    send((const uint8_t*)&data, bytes, false);
+    return true;
+  }
+
+  void Bus_Record::writeData(uint32_t data, uint_fast8_t bit_length)
+  {
+    uint_fast8_t bytes = bit_length >> 3;
+    if (trace_reserve(2 + bytes))
+    {
+      trace_push(tag_data);
+      trace_push(bit_length);
+      trace_value(data, bytes);
+    }
+    ++_stats.writes;
+    send((const uint8_t*)&data, bytes, true);
+  }
+
+  void Bus_Record::writeDataRepeat(uint32_t data, uint_fast8_t bit_length, uint32_t count)
+  {
+    if (count == 0) { return; }
+    uint_fast8_t bytes = bit_length >> 3;
+    if (trace_reserve(2 + 5 + bytes))
+    {
+      trace_push(tag_repeat);
+      trace_push(bit_length);
+      trace_varint(count);
+      trace_value(data, bytes);
+    }
+    ++_stats.writes;
+
+    uint32_t total = count * bytes;
+    count_write(total, true);
+    _stats.data_bytes += total;
+    if (_controller == nullptr || bytes == 0) { return; }
+
+    // expand the value into a buffer of whole repetitions, and hand it over in pieces.
+    uint8_t buf[1536];
+    uint32_t limit = sizeof(buf) / bytes;
+    uint32_t len = std::min(count, limit);
+    for (uint32_t i = 0; i < len; ++i) { memcpy(&buf[i * bytes], &data, bytes); }
+    do
+    {
+      len = std::min(count, limit);
+      _controller->write(buf, len * bytes, true);
+    } while (count -= len);
+  }
+
+  void Bus_Record::writePixels(pixelcopy_t* param, uint32_t length)
+  {
+    const uint8_t bytes = param->dst_bits >> 3;
+    uint8_t buf[1536];
+    uint32_t limit = sizeof(buf) / bytes;
+    do
+    {
+      uint32_t len = std::min(length, limit);
+      param->fp_copy(buf, 0, len, param);
+      writeBytes(buf, len * bytes, true, false);
+      length -= len;
+    } while (length);
+  }
+
+  void Bus_Record::writeBytes(const uint8_t* data, uint32_t length, bool dc, bool)
+  {
+    if (length == 0) { return; }
+    if (trace_reserve(1 + 5 + length))
+    {
+      trace_push(dc ? tag_bytes_data : tag_bytes_cmd);
+      trace_varint(length);
+      _trace.insert(_trace.end(), data, data + length);
+    }
+    if (dc) { ++_stats.writes; }
+    else    { ++_stats.commands; }
+    send(data, length, dc);
+  }
+
+//----------------------------------------------------------------------------
+
+  void Bus_Record::beginRead(uint_fast8_t dummy_bits)
+  {
+    beginRead();
+    count_read(dummy_bits);
+  }
+
+  void Bus_Record::beginRead(void)
+  {
+    if (_in_read) { return; }
+    if (trace_reserve(1)) { trace_push(tag_begin_read); }
+    if (_cfg.bus_type == bus_type_t::bus_i2c)
+    { // repeated START with the read address.
+      _stats.read_clocks += i2c_start_clocks + i2c_byte_clocks;
+      _dc = -1;
+    }
+    _in_read = true;
+  }
+
+  void Bus_Record::endRead(void)
+  {
+    if (!_in_read) { return; }
+    if (trace_reserve(1)) { trace_push(tag_end_read); }
+    _in_read = false;
+  }
+
+  uint32_t Bus_Record::readData(uint_fast8_t bit_length)
+  {
+    uint32_t res = 0;
+    readBytes((uint8_t*)&res, bit_length >> 3, false);
+    return res;
+  }
+
+  bool Bus_Record::readBytes(uint8_t* dst, uint32_t length, bool)
+  {
+    if (trace_reserve(1 + 5))
+    {
+      trace_push(tag_read);
+      trace_varint(length);
+    }
+    count_read(length << 3);
+    _stats.read_bytes += length;
+    if (_controller) { _controller->read(dst, length); }
+    else             { memset(dst, 0, length); }
+    return true;
+  }
+
+  void Bus_Record::readPixels(void* dst, pixelcopy_t* param, uint32_t length)
+  {
+    const uint8_t bytes = param->src_bits >> 3;
+    uint8_t buf[1536];
+    uint32_t limit = sizeof(buf) / bytes;
+    int32_t dstindex = 0;
+    do
+    {
+      uint32_t len = std::min(length, limit);
+      readBytes(buf, len * bytes, false);
+      param->src_data = buf;
+      param->src_x = 0;
+      dstindex = param->fp_copy(dst, dstindex, dstindex + len, param);
+      length -= len;
+    } while (length);
+  }
+
+//----------------------------------------------------------------------------
+
+  static uint32_t read_varint(const uint8_t*& p, const uint8_t* end)
+  {
+    uint32_t res = 0;
+    uint_fast8_t shift = 0;
+    while (p < end)
+    {
+      uint8_t b = *p++;
+      res |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) { break; }
+      shift += 7;
+    }
+    return res;
+  }
+
+  static uint32_t read_value(const uint8_t*& p, uint_fast8_t bytes)
+  {
+    uint32_t res = 0;
+    memcpy(&res, p, bytes);
+    p += bytes;
+    return res;
+  }
+
+  void Bus_Record::replay(IBus* bus, const uint8_t* trace, size_t length)
+  {
+    auto p = trace;
+    auto end = trace + length;
+    uint8_t buf[256];
+    while (p < end)
+    {
+      switch (*p++)
+      {
+      case tag_begin:      bus->beginTransaction(); break;
+      case tag_end:        bus->endTransaction();   break;
+      case tag_begin_read: bus->beginRead();        break;
+      case tag_end_read:   bus->endRead();          break;
+
+      case tag_read:
+        {
+          uint32_t len = read_varint(p, end);
+          do
+          {
+            uint32_t l = std::min<uint32_t>(len, sizeof(buf));
+            bus->readBytes(buf, l);
+            len -= l;
+          } while (len);
+        }
+        break;
+
+      case tag_command:
+        {
+          uint_fast8_t bits = *p++;
+          bus->writeCommand(read_value(p, bits >> 3), bits);
+        }
+        break;
+
+      case tag_data:
+        {
+          uint_fast8_t bits = *p++;
+          bus->writeData(read_value(p, bits >> 3), bits);
+        }
+        break;
+
+      case tag_repeat:
+        {
+          uint_fast8_t bits = *p++;
+          uint32_t count = read_varint(p, end);
+          bus->writeDataRepeat(read_value(p, bits >> 3), bits, count);
+        }
+        break;
+
+      case tag_bytes_cmd:
+      case tag_bytes_data:
+        {
+          bool dc = (p[-1] == tag_bytes_data);
+          uint32_t len = read_varint(p, end);
+          bus->writeBytes(p, len, dc, false);
+          p += len;
+        }
+        break;
+
+      default:  // broken trace
+        return;
+      }
+    }
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,181 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "../Bus.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Model of the chip at the other end of a Bus_Record.
+  /// It receives the bytes as they would appear on the wire.
+  struct IBusController
+  {
+    virtual ~IBusController(void) = default;
+
+    virtual void beginTransaction(void) {}
+    virtual void endTransaction(void) {}
+
+    /// Bytes sent with the D/C line low (dc == false) or high (dc == true).
+    virtual void write(const uint8_t* data, uint32_t length, bool dc) = 0;
+
+    /// Bytes returned to a read from the host.
+    virtual void read(uint8_t* dst, uint32_t length);
+  };
+
+//----------------------------------------------------------------------------
+
+  /// Bus for host builds that records the traffic of a panel driver instead of sending it.
+  /// Every write is appended to a compact trace that can be replayed to another bus,
+  /// the bytes on the wire are counted and turned into a transfer time for the configured clock,
+  /// and the traffic is passed to an optional controller model ( see BusController.hpp ).
+  class Bus_Record : public IBus
+  {
+  public:
+    struct config_t
+    {
+      uint32_t freq_write = 40000000;
+      uint32_t freq_read  = 16000000;
+
+      /// Bus type reported to the panel, also selects how the clocks are counted.
+      /// bus_spi : 8 clocks per byte.
+      /// bus_i2c : 9 clocks per byte, plus START / address / STOP and the D/C prefix bytes.
+      /// bus_parallel8 : 1 clock per byte.  bus_parallel16 : 1 clock per 2 data bytes.
+      bus_type_t bus_type = bus_type_t::bus_spi;
+
+      /// I2C only : length of the control byte sent when the D/C state changes. (0 : none)
+      uint8_t prefix_len = 1;
+
+      /// Maximum size of the trace in bytes. Recording stops when it is full. (0 : no trace)
+      uint32_t trace_limit = 16 * 1024 * 1024;
+    };
+
+    struct stats_t
+    {
+      uint32_t transactions = 0;
+      uint32_t commands = 0;        // writeCommand calls and command writeBytes
+      uint32_t writes = 0;          // data write calls
+      uint64_t command_bytes = 0;
+      uint64_t data_bytes = 0;
+      uint64_t read_bytes = 0;
+      uint64_t write_clocks = 0;
+      uint64_t read_clocks = 0;
+    };
+
+    const config_t& config(void) const { return _cfg; }
+    void config(const config_t& config) { _cfg = config; }
+
+    /// Controller that receives the traffic. (nullptr : none, reads return 0)
+    void setController(IBusController* controller) { _controller = controller; }
+    IBusController* getController(void) const { return _controller; }
+
+    const stats_t& getStats(void) const { return _stats; }
+    void resetStats(void) { _stats = stats_t(); }
+
+    /// Modeled transfer time in microseconds of the traffic counted since resetStats.
+    double getModeledMicros(void) const;
+
+    const std::vector<uint8_t>& getTrace(void) const { return _trace; }
+    void clearTrace(void) { _trace.clear(); _trace_overflow = false; }
+    /// true when writes were dropped from the trace because trace_limit was reached.
+    bool isTraceOverflow(void) const { return _trace_overflow; }
+
+    /// Sends a recorded trace to another bus. Reads in the trace are performed and their result discarded.
+    static void replay(IBus* bus, const uint8_t* trace, size_t length);
+    void replay(IBus* bus) const { replay(bus, _trace.data(), _trace.size()); }
+
+    bus_type_t busType(void) const override { return _cfg.bus_type; }
+
+    bool init(void) override;
+    void release(void) override;
+
+    uint32_t getClock(void) const override { return _cfg.freq_write; }
+    void setClock(uint32_t freq) override { _cfg.freq_write = freq; }
+    uint32_t getReadClock(void) const override { return _cfg.freq_read; }
+    void setReadClock(uint32_t freq) override { _cfg.freq_read = freq; }
+
+    void beginTransaction(void) override;
+    void endTransaction(void) override;
+    void wait(void) override {}
+    bool busy(void) const override { return false; }
+
+    void initDMA(void) override {}
+    void addDMAQueue(const uint8_t* data, uint32_t length) override { writeBytes(data, length, true, true); }
+    void execDMAQueue(void) override {}
+    uint8_t* getDMABuffer(uint32_t length) override;
+
+    void flush(void) override {}
+    bool writeCommand(uint32_t data, uint_fast8_t bit_length) override;
+    void writeData(uint32_t data, uint_fast8_t bit_length) override;
+    void writeDataRepeat(uint32_t data, uint_fast8_t bit_length, uint32_t count) override;
+    void writePixels(pixelcopy_t* param, uint32_t length) override;
+    void writeBytes(const uint8_t* data, uint32_t length, bool dc, bool use_dma) override;
+
+    void beginRead(uint_fast8_t dummy_bits) override;
+    void beginRead(void) override;
+    void endRead(void) override;
+    uint32_t readData(uint_fast8_t bit_length) override;
+    bool readBytes(uint8_t* dst, uint32_t length, bool use_dma) override;
+    void readPixels(void* dst, pixelcopy_t* param, uint32_t length) override;
+
+  protected:
+    enum trace_tag_t : uint8_t
+    {
+      tag_begin = 1,
+      tag_end,
+      tag_begin_read,
+      tag_end_read,
+      tag_read,         // length
+      tag_command,      // bit_length, value
+      tag_data,         // bit_length, value
+      tag_repeat,       // bit_length, count, value
+      tag_bytes_cmd,    // length, bytes
+      tag_bytes_data,   // length, bytes
+    };
+
+    config_t _cfg;
+    stats_t _stats;
+    IBusController* _controller = nullptr;
+    std::vector<uint8_t> _trace;
+    std::vector<uint8_t> _dma_buf[2];
+    uint8_t _dma_index = 0;
+    int8_t _dc = -1;        // D/C state of the current I2C transfer (-1 : no prefix sent yet)
+    bool _in_transaction = false;
+    bool _in_read = false;
+    bool _trace_overflow = false;
+
+    bool trace_reserve(size_t length);
+    void trace_push(uint8_t tag);
+    void trace_varint(uint32_t value);
+    void trace_value(uint32_t value, uint_fast8_t bytes);
+
+    void count_write(uint32_t length, bool dc);
+    void count_read(uint32_t bits);
+    void send(const uint8_t* data, uint32_t length, bool dc);
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,1878 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+
+Inspiration Sources:
+ [Roger Cheng](https://github.com/Roger-random/ESP_8_BIT_composite)
+ [rossum](https://github.com/rossumur/esp_8_bit)
+/----------------------------------------------------------------------------*/
+#include "CVBS_Encoder.hpp"
+#include "../platforms/common.hpp"
+
+#if defined ( ESP_PLATFORM )
+ #include <sdkconfig.h>
+ #include <esp_attr.h>
+#endif
+
+#ifndef IRAM_ATTR
+ #define IRAM_ATTR
+#endif
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef M_PI
+ #define M_PI 3.14159265358979323846
+#endif
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static uint32_t setup_palette_ntsc_inner(uint32_t rgb, uint32_t diff_level, uint32_t base_level, float satuation_base, float chroma_scale)
+  {
+// NTSCの I・Q信号は基準位相から-147度ずれている。;
+// 加えて、このライブラリのburst_waveの位相基準は-45度となっている。;
+// この両者を合わせて 147+45=192 を引いた値が基準位相となる。;
+// つまり 360-192 = 168度を基準とする。;
+    static constexpr float BASE_RAD = (M_PI * 168) / 180; // 2.932153;
+
+    uint32_t r = rgb >> 16;
+    uint32_t g = (rgb >> 8) & 0xFF;
+    uint32_t b = rgb & 0xFF;
+
+    float y = r * 0.299f + g * 0.587f + b * 0.114f;
+    float i = (b - y) * -0.2680f + (r - y) * 0.7358f;
+    float q = (b - y) *  0.4127f + (r - y) * 0.4778f;
+    y = y * diff_level / 256 + base_level;
+
+    float phase_offset = atan2f(i, q) + BASE_RAD;
+    float saturation = sqrtf(i * i + q * q) * chroma_scale;
+    saturation = saturation * satuation_base;
+
+    uint8_t buf[4];
+    uint8_t frac[4];
+    int frac_total = 0;
+    for (int j = 0; j < 4; j++)
+    {
+      int tmp = ((int)(y + sinf(phase_offset + (float)M_PI / 2 * j) * saturation));
+      frac[j] = tmp & 0xFF;
+      frac_total += frac[j];
+      tmp >>= 8;
+      buf[j] = tmp < 0 ? 0 : tmp > 255 ? 255 : tmp;
+    }
+    // 切り捨てた端数分を補正する
+    while (frac_total > 128)
+    {
+      frac_total -= 256;
+      int target_idx = 0;
+      const uint8_t idxtbl[] = { 0, 2, 1, 3 };
+      for (int j = 1; j < 4; j++)
+      {
+        if (frac[idxtbl[j]] > frac[target_idx] || frac[target_idx] == 255) {
+          target_idx = idxtbl[j];
+        }
+      }
+      if (buf[target_idx] == 255) { break; }
+      buf[target_idx]++;
+      frac[target_idx] = 0;
+    }
+    // I2Sに渡す際に処理負荷を軽減できるよう、予めバイトスワップ等を行ったテーブルを作成しておく;
+    return buf[0] << 24
+          | buf[1] <<  8
+          | buf[2] << 16
+          | buf[3] <<  0
+          ;
+  }
+
+  static void setup_palette_ntsc_565(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    float chroma_scale = chroma_level / 7168.0f;
+    float satuation_base = black_level / 2;
+    uint32_t diff_level = white_level - black_level;
+
+    uint32_t base_level = black_level / 2;
+    for (int idx = 0; idx < 256; ++idx)
+    {
+      { // RGB565の上位1Byteに対するテーブル
+        int r = (idx >> 3);
+        int g = (idx & 7) << 3;
+        r = (r * 0x21) >> 2;
+        g = (g * 0x41) >> 4;
+        palette[idx << 1] = setup_palette_ntsc_inner(r<<16|g<<8, diff_level, base_level, satuation_base, chroma_scale);
+      }
+      { // RGB565の下位1Byteに対するテーブル
+        int g = idx >> 5;
+        int b = idx & 0x1F;
+        b = (b * 0x21) >> 2;
+        g = (g * 0x41) >> 4;
+        palette[(idx << 1) + 1] = setup_palette_ntsc_inner(g<<8|b, diff_level, base_level, satuation_base, chroma_scale);
+      }
+    }
+  }
+
+  static void setup_palette_ntsc_332(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    float chroma_scale = chroma_level / 7168.0f;
+    float satuation_base = black_level / 2;
+    uint32_t diff_level = white_level - black_level;
+
+    for (int rgb332 = 0; rgb332 < 256; ++rgb332)
+    {
+      int r = (( rgb332 >> 5)         * 0x49) >> 1;
+      int g = (((rgb332 >> 2) & 0x07) * 0x49) >> 1;
+      int b = (( rgb332       & 0x03) * 0x55);
+
+      palette[rgb332] = setup_palette_ntsc_inner(r<<16|g<<8|b, diff_level, black_level, satuation_base, chroma_scale);
+    }
+  }
+
+  static void setup_palette_ntsc_gray(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    float chroma_scale = chroma_level / 7168.0f;
+    float satuation_base = black_level / 2;
+    uint32_t diff_level = white_level - black_level;
+
+    for (int idx = 0; idx < 256; ++idx)
+    {
+      palette[idx] = setup_palette_ntsc_inner(idx<<16|idx<<8|idx, diff_level, black_level, satuation_base, chroma_scale);
+    }
+  }
+
+  static void setup_palette_pal_inner(uint8_t *result, uint32_t rgb, int diff_level, float base_level, float chroma_scale)
+  {
+    static constexpr const int8_t sin_tbl[5] = { 0, -1, 0, 1, 0 };
+
+    // I2Sに渡す際に処理負荷を軽減できるよう、予めバイトスワップされたテーブルを作成するため、インデクス順を入れ替える
+    static constexpr const int8_t idx_tbl[4] = { 3, 1, 2, 0 };
+    uint32_t r = rgb >> 16;
+    uint32_t g = (rgb >> 8) & 0xFF;
+    uint32_t b = rgb & 0xFF;
+
+    float y = r * 0.299f + g * 0.587f + b * 0.114f;
+    float u = -0.147407 * r - 0.289391 * g + 0.436798 * b;
+    float v =  0.614777 * r - 0.514799 * g - 0.099978 * b;
+    y = y * diff_level / 256 + base_level;
+    u *= chroma_scale;
+    v *= chroma_scale;
+
+    uint8_t frac[8];
+    int frac_total[2] = {0,0};
+
+    for (int j = 0; j < 4; j++)
+    {
+      float s = u * sin_tbl[j    ];
+      float c = v * sin_tbl[j + 1]; // cos
+      int i = idx_tbl[j];
+      int tmp = ((int)(y + s + c));
+      frac[i  ] = tmp & 0xFF;
+      frac_total[0] += frac[i  ];
+      tmp >>= 8;
+      result[i  ] = tmp < 0 ? 0 : tmp > 255 ? 255 : tmp;
+      tmp = ((int)(y + s - c));
+      i += 4;
+      frac[i] = tmp & 0xFF;
+      frac_total[1] += frac[i];
+      tmp >>= 8;
+      result[i] = tmp < 0 ? 0 : tmp > 255 ? 255 : tmp;
+    }
+
+    // 切り捨てた端数分を補正する
+    for (int i = 0; i < 2; ++i) {
+      while (frac_total[i] > 128)
+      {
+        frac_total[i] -= 256;
+        int target_idx = i*4;
+        for (int j = 1; j < 4; j++)
+        {
+          if (frac[j+i*4] > frac[target_idx] || frac[target_idx] == 255) {
+            target_idx = j+i*4;
+          }
+        }
+        if (result[target_idx] == 255) { break; }
+        result[target_idx]++;
+        frac[target_idx] = 0;
+      }
+    }
+  }
+
+  static void setup_palette_pal_565(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    auto e = palette;
+    auto o = &palette[512];
+
+    uint32_t result_buf[2];
+    float chroma_scale = black_level * chroma_level / 14336.0f;
+
+    int32_t diff_level = white_level - black_level;
+    float base_level = (float)black_level / 2;
+    for (int idx = 0; idx < 256; ++idx)
+    {
+      { // RGB565の上位1Byteに対するテーブル
+        int r = (idx >> 3);
+        int g = (idx & 7) << 3;
+        r = (r * 0x21) >> 2;
+        g = (g * 0x41) >> 4;
+
+        setup_palette_pal_inner((uint8_t*)result_buf, r<<16|g<<8, diff_level, base_level, chroma_scale);
+        e[idx << 1] = result_buf[0];
+        o[idx << 1] = result_buf[1];
+      }
+      { // RGB565の下位1Byteに対するテーブル
+        int g = idx >> 5;
+        int b = idx & 0x1F;
+        b = (b * 0x21) >> 2;
+        g = (g * 0x41) >> 4;
+
+        setup_palette_pal_inner((uint8_t*)result_buf, g<<8|b, diff_level, base_level, chroma_scale);
+        e[(idx << 1) + 1] = result_buf[0];
+        o[(idx << 1) + 1] = result_buf[1];
+      }
+    }
+  }
+
+  static void setup_palette_pal_332(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    auto e = palette;
+    auto o = &palette[256];
+
+    uint32_t result_buf[2];
+    float chroma_scale = black_level * chroma_level / 14336.0f;
+
+    int32_t diff_level = white_level - black_level;
+    float base_level = (float)black_level;
+
+    for (int rgb332 = 0; rgb332 < 256; ++rgb332)
+    {
+      int r = (( rgb332 >> 5)         * 0x49) >> 1;
+      int g = (((rgb332 >> 2) & 0x07) * 0x49) >> 1;
+      int b = (( rgb332       & 0x03) * 0x55);
+
+      setup_palette_pal_inner((uint8_t*)result_buf, r<<16|g<<8|b, diff_level, base_level, chroma_scale);
+
+      e[rgb332] = result_buf[0];
+      o[rgb332] = result_buf[1];
+    }
+  }
+
+  static void setup_palette_pal_gray(uint32_t* palette, uint_fast16_t white_level, uint_fast16_t black_level, uint_fast8_t chroma_level)
+  {
+    auto e = palette;
+    auto o = &palette[256];
+
+    uint32_t result_buf[2];
+    float chroma_scale = black_level * chroma_level / 14336.0f;
+
+    int32_t diff_level = white_level - black_level;
+    float base_level = (float)black_level;
+
+    for (int idx = 0; idx < 256; ++idx)
+    {
+      setup_palette_pal_inner((uint8_t*)result_buf, idx<<16|idx<<8|idx, diff_level, base_level, chroma_scale);
+
+      e[idx] = result_buf[0];
+      o[idx] = result_buf[1];
+    }
+  }
+
+  static constexpr const CVBS_Encoder::signal_spec_t signal_spec_info_list[]
+  { // NTSC
+    { 525         // 走査線525本;
+    , 910         // 1走査線あたり 227.5 x4 sample
+    , 32          // equalizing = 32 sample (2.3us)
+    , 66          // hsync_short = 66 sample (4.7us)
+    , 380         // hsync_long = 380 sample
+    , 76          // burst start = 76 sample
+    , 9           // burst cycle = 9 cycle
+    , 148         // active_start = 148 sample (10.8us)
+    , 2           // burst_shift_mask バースト信号反転動作;
+    , 720         // width max 720
+    , 480         // height max 480
+    , { { 0x55, 0x55, 0x00, 0x22, 0x22, 0x00, 0x55, 0x55, 0x00, 0xB0, 0xB0, 0x00 } // NTSC EVEN
+      , { 0x05, 0x55, 0x50, 0x02, 0x22, 0x20, 0x05, 0x55, 0x50, 0x04, 0xB0, 0xB0 } // NTSC ODD
+      }
+    , 22
+    }
+  , // NTSC_J
+    { 525         // 走査線525本;
+    , 910         // 1走査線あたり 227.5 x4 sample
+    , 32          // equalizing = 32 sample (2.3us)
+    , 66          // hsync_short = 66 sample (4.7us)
+    , 380         // hsync_long = 380 sample
+    , 76          // burst start = 76 sample
+    , 9           // burst cycle = 9 cycle
+    , 148         // active_start = 148 sample (10.8us)
+    , 2           // burst_shift_mask バースト信号反転動作;
+    , 720         // width max 720
+    , 480         // height max 480
+    , { { 0x55, 0x55, 0x00, 0x22, 0x22, 0x00, 0x55, 0x55, 0x00, 0xB0, 0xB0, 0x00 } // NTSC EVEN
+      , { 0x05, 0x55, 0x50, 0x02, 0x22, 0x20, 0x05, 0x55, 0x50, 0x04, 0xB0, 0xB0 } // NTSC ODD
+
+      }
+    , 22
+    }
+  , // PAL
+    { 625         // 走査線625本;
+    , 1136        // 1走査線あたり 284 x4 sample (正確には283.75x4 = 1135だが、2の倍数でないとI2S出力できないため1136とする)
+    , 40          // equalizing = 40 sample (2.3us)
+    , 84          // hsync_shor = 84 sample (4.7us)
+    , 484         // hsync_long 484 sample
+    , 98          // burst start = 98 sample (5.6us)
+    , 10          // burst cycle = 10 cycle
+    , 216         // active_start = 216 sample (12.0us)
+    , 1           // burst_shift_mask パレットインデクス変更動作;
+    , 864         // max width 864
+    , 576         // max height 576
+    , { { 0x05, 0x55, 0x50, 0x22, 0x22, 0x05, 0x55, 0x50, 0x34, 0xB0, 0xB0, 0x00 } // PAL EVEN
+      , { 0x00, 0x55, 0x55, 0x02, 0x22, 0x20, 0x55, 0x55, 0x04, 0xB0, 0xB0, 0x00 } // PAL ODD
+      }
+    , 25
+    }
+  , // PAL_M  (PAL_M方式は周波数等がNTSCと共通、カラー情報の仕様がPALと共通)
+    { 525         // 走査線525本;
+    , 908         // 1走査線あたり 227.5 x4 sample
+    , 32          // equalizing = 32 sample (2.3us)
+    , 66          // hsync_short = 66 sample (4.7us)
+    , 380         // hsync_long = 380 sample
+    , 80          // burst start = 84 sample
+    , 9           // burst cycle = 9 cycle
+    , 148         // active_start = 148 sample (10.8us)
+    , 1           // burst_shift_mask パレットインデクス変更動作;
+    , 720         // width max 720
+    , 480         // height max 480
+    , { { 0x55, 0x55, 0x00, 0x22, 0x22, 0x00, 0x55, 0x55, 0x00, 0xB0, 0xB0, 0x00 } // NTSC EVEN
+      , { 0x05, 0x55, 0x50, 0x02, 0x22, 0x20, 0x05, 0x55, 0x50, 0x04, 0xB0, 0xB0 } // NTSC ODD
+      }
+    , 22
+    }
+  , // PAL_N
+    { 625         // 走査線625本;
+    , 916
+    , 32
+    , 66
+    , 380
+    , 80
+    , 9           // burst cycle = 9 cycle
+    , 156
+    , 1           // burst_shift_mask パレットインデクス変更動作;
+    , 720         // max width 720
+    , 576         // max height 576
+    , { { 0x05, 0x55, 0x50, 0x22, 0x22, 0x05, 0x55, 0x50, 0x34, 0xB0, 0xB0, 0x00 } // PAL EVEN
+      , { 0x00, 0x55, 0x55, 0x02, 0x22, 0x20, 0x55, 0x55, 0x04, 0xB0, 0xB0, 0x00 } // PAL ODD
+      }
+    , 25
+    }
+  };
+
+  struct signal_setup_info_t
+  {
+    void (*setup_palette_332)(uint32_t*, uint_fast16_t, uint_fast16_t, uint_fast8_t); // RGB332用パレット生成関数のポインタ;
+    void (*setup_palette_565)(uint32_t*, uint_fast16_t, uint_fast16_t, uint_fast8_t); // RGB565用パレット生成関数のポインタ;
+    void (*setup_palette_gray)(uint32_t*, uint_fast16_t, uint_fast16_t, uint_fast8_t); // グレースケール用パレット生成関数のポインタ;
+    uint16_t blanking_mv;         // SYNCレベルとBLANKINGレベルの電圧差 mV
+    uint16_t black_mv;            // SYNCレベルと黒レベルの電圧差 mV
+    uint16_t white_mv;            // SYNCレベルと白レベルの電圧差 mV
+    uint8_t palette_num_256;      // パレット面数 (palはODD_EVENで2倍使用する);
+    uint8_t sdm0;
+    uint8_t sdm1;
+    uint8_t sdm2;
+    uint8_t div_n;
+    uint8_t div_b;
+    uint8_t div_a;
+  };
+
+/*
+  PAL   = 4.43361875
+  NTSC  = 3.579545
+  SECAM = 4.406250
+  PAL_M = 3.57561149
+  PAL_N = 3.58205625
+*/
+
+  static constexpr const signal_setup_info_t signal_setup_info_list[]
+  { // NTSC
+    { setup_palette_ntsc_332
+    , setup_palette_ntsc_565
+    , setup_palette_ntsc_gray
+    , 286         // 286mV = 0IRE
+    , 340         // 340mV = 7.5IRE  米国仕様では黒レベルは 7.5IRE
+    , 960         // 960mV  黄色の振幅の最大値が100IRE付近になるよう、白レベルは100IREよりも低く調整しておく;
+    , 1           // パレット数は256
+    // APLL設定 14.318237 映像に縞模様ノイズが出にくい;
+    //  意図的に要求仕様を外している。 ( 0x049746 = 14.318181 = 3.579545 x4 // 要求仕様に近い )
+    , 0x48, 0x97, 0x04
+    // CLKDIV設定 (ESP32 rev0用)
+    , 5, 10, 17
+    }
+  , // NTSC_J
+    { setup_palette_ntsc_332
+    , setup_palette_ntsc_565
+    , setup_palette_ntsc_gray
+    , 286         // 286mV = 0IRE
+    , 286         // 286mV = 0IRE  日本仕様では黒レベルは 0IRE
+    , 960
+    , 1           // パレット数は256
+    // APLL設定 14.318237 映像に縞模様ノイズが出にくい;
+    //  意図的に要求仕様を外している。 ( 0x049746 = 14.318181 = 3.579545 x4 // 要求仕様に近い )
+    , 0x48, 0x97, 0x04
+    // CLKDIV設定 (ESP32 rev0用)
+    , 5, 10, 17
+    }
+  , // PAL
+    { setup_palette_pal_332
+    , setup_palette_pal_565
+    , setup_palette_pal_gray
+    , 300
+    , 300
+    , 960
+    , 2           // パレット数は512
+    // APLL設定 17.734476mhz ~4x   4.43361875 x4
+    , 0x04, 0xA4, 0x06
+    // CLKDIV設定 (ESP32 rev0用)
+    , 4, 24, 47
+    }
+  , // PAL_M
+    { setup_palette_pal_332
+    , setup_palette_pal_565
+    , setup_palette_pal_gray
+    , 300
+    , 300
+    , 960
+    , 2           // パレット数は512
+    // APLL設定
+    , 0xDA, 0x94, 0x04
+    // CLKDIV設定 (ESP32 rev0用)
+    , 5, 19, 32
+    }
+  , // PAL_N
+    { setup_palette_pal_332
+    , setup_palette_pal_565
+    , setup_palette_pal_gray
+    , 300
+    , 300
+    , 960
+    , 2           // パレット数は512
+    // APLL設定 // 3.58205625 x4
+    , 0xD1, 0x98, 0x04
+    // CLKDIV設定 (ESP32 rev0用)
+    , 5, 7, 12
+    }
+  };
+
+// asm : ESP32 only ( the target Panel_CVBS is built for ) / cpp : other
+#if defined ( ESP_PLATFORM ) && defined ( __XTENSA__ ) && ( !defined ( CONFIG_IDF_TARGET ) || defined ( CONFIG_IDF_TARGET_ESP32 ) )
+
+// a6 = シフト量反転 SARレジスタと入替、シフト量を 8 or 0 で変化させる
+// a9 = ratio diff
+#define ASM_INIT_BLIT \
+    "ssl        a6                      \n" \
+    "addi       a6, a6, 24              \n" \
+    "srai       a9, a7, 1               \n" \
+    "addmi      a9, a9, -16384          \n"
+
+#define ASM_READ_RGB332_2PIXEL \
+    "l8ui       a10,a3, 0               \n" \
+    "l8ui       a11,a3, 1               \n" \
+    "addi       a3, a3, 2               \n" \
+    "addx4      a10,a10,a5              \n" \
+    "l32i       a10,a10,0               \n" \
+    "addx4      a11,a11,a5              \n" \
+    "l32i       a11,a11,0               \n"
+
+#define ASM_READ_RGB565_2PIXEL \
+    "l8ui       a10,a3, 0               \n" \
+    "l8ui       a12,a3, 1               \n" \
+    "l8ui       a11,a3, 2               \n" \
+    "l8ui       a13,a3, 3               \n" \
+    "addx8      a10,a10,a5              \n" \
+    "l32i       a10,a10,0               \n" \
+    "addx8      a12,a12,a5              \n" \
+    "l32i       a12,a12,4               \n" \
+    "addx8      a11,a11,a5              \n" \
+    "l32i       a11,a11,0               \n" \
+    "addx8      a13,a13,a5              \n" \
+    "l32i       a13,a13,4               \n" \
+    "addi       a3, a3, 4               \n" \
+    "add        a10,a10,a12             \n" \
+    "add        a11,a11,a13             \n"
+
+#define ASM_READ_RGB332_4PIXEL \
+    "l8ui       a10,a3, 0               \n" \
+    "l8ui       a11,a3, 1               \n" \
+    "l8ui       a12,a3, 2               \n" \
+    "l8ui       a13,a3, 3               \n" \
+    "addx4      a10,a10,a5              \n" \
+    "l32i       a10,a10,0               \n" \
+    "addx4      a11,a11,a5              \n" \
+    "l32i       a11,a11,0               \n" \
+    "addx4      a12,a12,a5              \n" \
+    "l32i       a12,a12,0               \n" \
+    "addx4      a13,a13,a5              \n" \
+    "l32i       a13,a13,0               \n" \
+    "addi       a3, a3, 4               \n"
+
+#define ASM_READ_RGB565_4PIXEL \
+    "l8ui       a12,a3, 1               \n" \
+    "l8ui       a10,a3, 0               \n" \
+    "l8ui       a13,a3, 3               \n" \
+    "l8ui       a11,a3, 2               \n" \
+    "addx8      a12,a12,a5              \n" \
+    "l32i       a12,a12,4               \n" \
+    "addx8      a10,a10,a5              \n" \
+    "l32i       a10,a10,0               \n" \
+    "addx8      a13,a13,a5              \n" \
+    "l32i       a13,a13,4               \n" \
+    "addx8      a11,a11,a5              \n" \
+    "l32i       a11,a11,0               \n" \
+    "l8ui       a14,a3, 5               \n" \
+    "add        a10,a10,a12             \n" \
+    "l8ui       a12,a3, 4               \n" \
+    "add        a11,a11,a13             \n" \
+    "l8ui       a15,a3, 7               \n" \
+    "l8ui       a13,a3, 6               \n" \
+    "addx8      a14,a14,a5              \n" \
+    "l32i       a14,a14,4               \n" \
+    "addx8      a12,a12,a5              \n" \
+    "l32i       a12,a12,0               \n" \
+    "addx8      a15,a15,a5              \n" \
+    "l32i       a15,a15,4               \n" \
+    "addx8      a13,a13,a5              \n" \
+    "l32i       a13,a13,0               \n" \
+    "addi       a3, a3, 8               \n" \
+    "add        a12,a12,a14             \n" \
+    "add        a13,a13,a15             \n"
+
+
+
+/* blit_関数が呼び出された直後のレジスタの値
+    a0 : リターンアドレス     (使用しない)
+    a1 : スタックポインタ     (変更不可)
+    a2 : uint32_t d           (ループ中で加算しながら利用する)
+    a3 : const uint8_t* s     (ループ中で加算しながら利用する)
+    a4 : size_t src_length    (ループ回数として設定後、別用途に利用)
+    a5 : const uint32_t* p    (変更せずそのまま利用する)
+    a6 : int32_t odd          (そのまま利用する)
+    a7 : int32_t ratio        (変更せずそのまま利用する)
+//
+    a8 : - ratio - 32768
+    a9 : diff                 比率判定用に利用
+*/
+
+  // x5 ~ x6
+  void IRAM_ATTR blit_x50_x60_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x50_x60_565:                  \n"
+    ASM_READ_RGB565_2PIXEL
+
+    "sll        a12,a10                 \n"
+    "s32i       a12,a2, 0               \n" // 0,1 保存
+    "s32i       a12,a2, 8               \n" // 4,5 保存
+    "sll        a13,a11                 \n"
+    "s32i       a13,a2, 16              \n" // 8,9 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a15,a11                 \n"
+    "s32i       a15,a2, 12              \n" // 6,7 保存
+    "bgez       a9, BGEZ_x50_x60_565    \n"
+// diffがマイナスの時の処理 x5.0
+    "s16i       a13,a2, 8               \n" //   5 保存
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 5*4             \n" // 出力先 += 5 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x50_x60_565\n"
+    "retw                               \n"
+
+"BGEZ_x50_x60_565:                  \n"
+// diffがプラスの時の処理 x6.0
+    "s32i       a15,a2, 20              \n" // 10,11 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 6*4             \n" // 出力先 += 6 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x50_x60_565\n"
+    );
+  }
+
+  // x5 ~ x6
+  void IRAM_ATTR blit_x50_x60_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x50_x60_332:                  \n"
+    ASM_READ_RGB332_2PIXEL
+
+    "sll        a12,a10                 \n"
+    "s32i       a12,a2, 0               \n" // 0,1 保存
+    "s32i       a12,a2, 8               \n" // 4,5 保存
+    "sll        a13,a11                 \n"
+    "s32i       a13,a2, 16              \n" // 8,9 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a15,a11                 \n"
+    "s32i       a15,a2, 12              \n" // 6,7 保存
+    "bgez       a9, BGEZ_x50_x60_332    \n"
+// diffがマイナスの時の処理 x5.0
+    "s16i       a13,a2, 8               \n" //   5 保存
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 5*4             \n" // 出力先 += 5 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x50_x60_332\n"
+    "retw                               \n"
+
+"BGEZ_x50_x60_332:                  \n"
+// diffがプラスの時の処理 x6.0
+    "s32i       a15,a2, 20              \n" // 10,11 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 6*4             \n" // 出力先 += 6 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x50_x60_332\n"
+    );
+  }
+
+  // x4 ~ x5
+  void IRAM_ATTR blit_x40_x50_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x40_x50_565:                  \n"
+    ASM_READ_RGB565_2PIXEL
+
+    "sll        a12,a10                 \n"
+    "s32i       a12,a2, 0               \n" // 0,1 保存
+    "sll        a13,a11                 \n"
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a15,a11                 \n"
+    "s32i       a15,a2, 12              \n" // 6,7 保存
+
+    "bgez       a9, BGEZ_x40_x50_565    \n"
+// diffがマイナスの時の処理 x4.0
+    "s32i       a13,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x40_x50_565\n"
+    "retw                               \n"
+
+"BGEZ_x40_x50_565:                  \n"
+// diffがプラスの時の処理 x5.0
+    "s32i       a12,a2, 8               \n" // 4,5 保存
+    "s32i       a13,a2, 16              \n" // 8,9 保存
+    "s16i       a13,a2, 8               \n" //   5 保存
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 5*4             \n" // 出力先 += 5 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x40_x50_565\n"
+    );
+  }
+
+  // x4 ~ x5
+  void IRAM_ATTR blit_x40_x50_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x40_x50_332:                  \n"
+    ASM_READ_RGB332_2PIXEL
+
+    "sll        a12,a10                 \n"
+    "s32i       a12,a2, 0               \n" // 0,1 保存
+    "sll        a13,a11                 \n"
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a15,a11                 \n"
+    "s32i       a15,a2, 12              \n" // 6,7 保存
+
+    "bgez       a9, BGEZ_x40_x50_332    \n"
+// diffがマイナスの時の処理 x4.0
+    "s32i       a13,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x40_x50_332\n"
+    "retw                               \n"
+
+"BGEZ_x40_x50_332:                  \n"
+// diffがプラスの時の処理 x5.0
+    "s32i       a12,a2, 8               \n" // 4,5 保存
+    "s32i       a13,a2, 16              \n" // 8,9 保存
+    "s16i       a13,a2, 8               \n" //   5 保存
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 5*4             \n" // 出力先 += 5 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x40_x50_332\n"
+    );
+  }
+
+  // x3 ~ x4
+  void IRAM_ATTR blit_x30_x40_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x30_x40_565:                  \n"
+    ASM_READ_RGB565_2PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a11                 \n"
+    "bgez       a9, BGEZ_x30_x40_565    \n"
+// diffがマイナスの時の処理 x3.0
+    "s16i       a14,a2, 4               \n" //   3 保存
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x30_x40_565\n"
+    "retw                               \n"
+
+"BGEZ_x30_x40_565:                  \n"
+// diffがプラスの時の処理 x4.0
+    "s32i       a14,a2, 12              \n" // 6,7 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x30_x40_565\n"
+    );
+  }
+
+  // x3 ~ x4
+  void IRAM_ATTR blit_x30_x40_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x30_x40_332:                  \n"
+    ASM_READ_RGB332_2PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a11                 \n"
+    "bgez       a9, BGEZ_x30_x40_332    \n"
+// diffがマイナスの時の処理 x3.0
+    "s16i       a14,a2, 4               \n" //   3 保存
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x30_x40_332\n"
+    "retw                               \n"
+
+"BGEZ_x30_x40_332:                  \n"
+// diffがプラスの時の処理 x4.0
+    "s32i       a14,a2, 12              \n" // 6,7 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x30_x40_332\n"
+    );
+  }
+
+  // x2 ~ x3
+  void IRAM_ATTR blit_x20_x30_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x20_x30_565:                  \n"
+    ASM_READ_RGB565_2PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "bgez       a9, BGEZ_x20_x30_565    \n"
+// diffがマイナスの時の処理 x2.0
+
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 2*4             \n" // 出力先 += 2 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x20_x30_565\n"
+    "retw                               \n"
+
+"BGEZ_x20_x30_565:                  \n"
+// diffがプラスの時の処理 x3.0
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a11                 \n" // a14 = !odd a10
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x20_x30_565\n"
+    );
+  }
+
+  // x2 ~ x3
+  void IRAM_ATTR blit_x20_x30_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x20_x30_332:                  \n"
+    ASM_READ_RGB332_2PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "bgez       a9, BGEZ_x20_x30_332    \n"
+// diffがマイナスの時の処理 x2.0
+
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 2*4             \n" // 出力先 += 2 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x20_x30_332\n"
+    "retw                               \n"
+
+"BGEZ_x20_x30_332:                  \n"
+// diffがプラスの時の処理 x3.0
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a11                 \n" // a14 = !odd a10
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x20_x30_332\n"
+    );
+  }
+
+  // x1.5~x2.0
+  void IRAM_ATTR blit_x15_x20_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x15_x20_565:                  \n"
+    ASM_READ_RGB565_4PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "sll        a14,a12                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+
+    "bgez       a9, BGEZ_x15_x20_565    \n"
+// diffがマイナスの時の処理 x1.5
+    "sll        a14,a13                 \n"
+    "s16i       a14,a2, 8               \n" //   5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a12                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x15_x20_565\n"
+    "retw                               \n"
+
+"BGEZ_x15_x20_565:                  \n"
+// diffがプラスの時の処理 x2.0
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a13                 \n"
+    "s32i       a14,a2, 12              \n" // 6,7 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x15_x20_565\n"
+    );
+  }
+
+  // x1.5~x2.0
+  void IRAM_ATTR blit_x15_x20_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x15_x20_332:                  \n"
+    ASM_READ_RGB332_4PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "sll        a14,a12                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+
+    "bgez       a9, BGEZ_x15_x20_332    \n"
+// diffがマイナスの時の処理 x1.5
+    "sll        a14,a13                 \n"
+    "s16i       a14,a2, 8               \n" //   5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a12                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x15_x20_332\n"
+    "retw                               \n"
+
+"BGEZ_x15_x20_332:                  \n"
+// diffがプラスの時の処理 x2.0
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2,3 保存
+    "sll        a14,a13                 \n"
+    "s32i       a14,a2, 12              \n" // 6,7 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 4*4             \n" // 出力先 += 4 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x15_x20_332\n"
+    );
+  }
+
+  // x1.0~x1.5
+  void IRAM_ATTR blit_x10_x15_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x10_x15_565:                  \n"
+    ASM_READ_RGB565_4PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "bgez       a9, BGEZ_x10_x15_565    \n"
+// diffがマイナスの時の処理 x1.0
+
+    "sll        a14,a11                 \n"
+    "s16i       a14,a2, 0               \n" //   1 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a12                 \n"
+    "s32i       a14,a2, 4               \n" // 2   保存
+    "sll        a14,a13                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 2*4             \n" // 出力先 += 2 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x10_x15_565\n"
+    "retw                               \n"
+
+"BGEZ_x10_x15_565:                  \n"
+// diffがプラスの時の処理 x1.5
+    "sll        a14,a13                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2   保存
+    "sll        a14,a12                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x10_x15_565\n"
+    );
+  }
+
+  // x1.0~x1.5
+  void IRAM_ATTR blit_x10_x15_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int odd, int ratio)
+  {
+    __asm__ (
+    ASM_INIT_BLIT
+"LOOP_x10_x15_332:                  \n"
+    ASM_READ_RGB332_4PIXEL
+
+    "sll        a14,a10                 \n"
+    "s32i       a14,a2, 0               \n" // 0,1 保存
+    "bgez       a9, BGEZ_x10_x15_332    \n"
+// diffがマイナスの時の処理 x1.0
+
+    "sll        a14,a11                 \n"
+    "s16i       a14,a2, 0               \n" //   1 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a12                 \n"
+    "s32i       a14,a2, 4               \n" // 2   保存
+    "sll        a14,a13                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+
+    "add        a9, a9, a7              \n" // diff += ratio
+    "addi       a2, a2, 2*4             \n" // 出力先 += 2 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x10_x15_332\n"
+    "retw                               \n"
+
+"BGEZ_x10_x15_332:                  \n"
+// diffがプラスの時の処理 x1.5
+    "sll        a14,a13                 \n"
+    "s32i       a14,a2, 8               \n" // 4,5 保存
+    "xsr        a6, SAR                 \n" // シフト量スイッチ
+    "sll        a14,a11                 \n"
+    "s32i       a14,a2, 4               \n" // 2   保存
+    "sll        a14,a12                 \n"
+    "s16i       a14,a2, 4               \n" //   3 保存
+
+    "addmi      a9, a9, -32768          \n" // diff -= 32768
+    "addi       a2, a2, 3*4             \n" // 出力先 += 3 * sizeof(uint32_t)
+    "bltu       a3, a4, LOOP_x10_x15_332\n"
+    );
+  }
+
+#else
+
+  // x5 ~ x6
+  void IRAM_ATTR blit_x50_x60_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      s += 4;
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[2] = s0even;
+      d[3] = s1odd;
+      d[4] = s1even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[2]) = s1even;
+        d += 5;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[5] = s1odd;
+        shift ^= 8;
+        d += 6;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x5 ~ x6
+  void IRAM_ATTR blit_x50_x60_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      s += 2;
+      s0 = p[s0];
+      s1 = p[s1];
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[2] = s0even;
+      d[3] = s1odd;
+      d[4] = s1even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[2]) = s1even;
+        d += 5;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[5] = s1odd;
+        shift ^= 8;
+        d += 6;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x4 ~ x5
+  void IRAM_ATTR blit_x40_x50_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      s += 4;
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[3] = s1odd;
+      if (diff < 0)
+      {
+        diff += ratio;
+        d[2] = s1even;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[4] = s1even;
+        d[2] = s0even;
+        *((uint16_t*)&d[2]) = s1even;
+        d += 5;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x4 ~ x5
+  void IRAM_ATTR blit_x40_x50_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      s += 2;
+      s0 = p[s0];
+      s1 = p[s1];
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[3] = s1odd;
+      if (diff < 0)
+      {
+        diff += ratio;
+        d[2] = s1even;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[4] = s1even;
+        d[2] = s0even;
+        *((uint16_t*)&d[2]) = s1even;
+        d += 5;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x3 ~ x4
+  void IRAM_ATTR blit_x30_x40_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      s += 4;
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[2] = s1even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[1]) = s1odd;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[3] = s1odd;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x3 ~ x4
+  void IRAM_ATTR blit_x30_x40_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      s += 2;
+      s0 = p[s0];
+      s1 = p[s1];
+
+      uint32_t s0even = s0 << shift;
+      uint32_t s1even = s1 << shift;
+      shift ^= 8;
+      uint32_t s0odd = s0 << shift;
+      uint32_t s1odd = s1 << shift;
+      d[0] = s0even;
+      d[1] = s0odd;
+      d[2] = s1even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[1]) = s1odd;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[3] = s1odd;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x2 ~ x3
+  void IRAM_ATTR blit_x20_x30_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      s += 4;
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s0even = s0 << shift;
+      d[0] = s0even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        shift ^= 8;
+        uint32_t s1odd = s1 << shift;
+        d[1] = s1odd;
+        shift ^= 8;
+        d += 2;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        uint32_t s1even = s1 << shift;
+        shift ^= 8;
+        uint32_t s0odd = s0 << shift;
+        uint32_t s1odd = s1 << shift;
+        d[1] = s0odd;
+        d[2] = s1even;
+        *((uint16_t*)&d[1]) = s1odd;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x2 ~ x3
+  void IRAM_ATTR blit_x20_x30_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      s += 2;
+      s0 = p[s0];
+      s1 = p[s1];
+
+      uint32_t s0even = s0 << shift;
+      d[0] = s0even;
+      if (diff < 0)
+      {
+        diff += ratio;
+        shift ^= 8;
+        uint32_t s1odd = s1 << shift;
+        d[1] = s1odd;
+        shift ^= 8;
+        d += 2;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        uint32_t s1even = s1 << shift;
+        shift ^= 8;
+        uint32_t s0odd = s0 << shift;
+        uint32_t s1odd = s1 << shift;
+        d[1] = s0odd;
+        d[2] = s1even;
+        *((uint16_t*)&d[1]) = s1odd;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x1.5~x2.0
+  void IRAM_ATTR blit_x15_x20_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s2h = s[4];
+      uint32_t s2l = s[5];
+      uint32_t s3h = s[6];
+      uint32_t s3l = s[7];
+      s2h = p[(s2h << 1)  ];
+      s2l = p[(s2l << 1)+1];
+      s3h = p[(s3h << 1)  ];
+      s3l = p[(s3l << 1)+1];
+      s += 8;
+      uint32_t s2 = s2h + s2l;
+      uint32_t s3 = s3h + s3l;
+
+      d[0] = s0 << shift;
+      d[2] = s2 << shift;
+
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[2]) = s3 << shift;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        *((uint16_t*)&d[1]) = s2 << shift;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        d[3] = s3 << shift;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x1.5~x2.0
+  void IRAM_ATTR blit_x15_x20_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      uint32_t s2 = s[2];
+      uint32_t s3 = s[3];
+      s0 = p[s0];
+      s1 = p[s1];
+      s2 = p[s2];
+      s3 = p[s3];
+      s += 4;
+
+      d[0] = s0 << shift;
+      d[2] = s2 << shift;
+
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[2]) = s3 << shift;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        *((uint16_t*)&d[1]) = s2 << shift;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        d[3] = s3 << shift;
+        shift ^= 8;
+        d += 4;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x1.0~x1.5
+  void IRAM_ATTR blit_x10_x15_565(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0h = s[0];
+      uint32_t s0l = s[1];
+      uint32_t s1h = s[2];
+      uint32_t s1l = s[3];
+      s0h = p[(s0h << 1)  ];
+      s0l = p[(s0l << 1)+1];
+      s1h = p[(s1h << 1)  ];
+      s1l = p[(s1l << 1)+1];
+      uint32_t s0 = s0h + s0l;
+      uint32_t s1 = s1h + s1l;
+
+      uint32_t s2h = s[4];
+      uint32_t s2l = s[5];
+      uint32_t s3h = s[6];
+      uint32_t s3l = s[7];
+      s2h = p[(s2h << 1)  ];
+      s2l = p[(s2l << 1)+1];
+      s3h = p[(s3h << 1)  ];
+      s3l = p[(s3l << 1)+1];
+      s += 8;
+      uint32_t s2 = s2h + s2l;
+      uint32_t s3 = s3h + s3l;
+
+      d[0] = s0 << shift;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[0]) = s1 << shift;
+        shift ^= 8;
+        d[1] = s2 << shift;
+        *((uint16_t*)&d[1]) = s3 << shift;
+        shift ^= 8;
+        d += 2;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[2] = s3 << shift;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        *((uint16_t*)&d[1]) = s2 << shift;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+  // x1.0~x1.5
+  void IRAM_ATTR blit_x10_x15_332(uint32_t* __restrict d, const uint8_t* s, const uint8_t* s_end, const uint32_t* p, int shift, int ratio)
+  {
+    int diff = (ratio - 32768) >> 1;
+    for (;;)
+    {
+      uint32_t s0 = s[0];
+      uint32_t s1 = s[1];
+      uint32_t s2 = s[2];
+      uint32_t s3 = s[3];
+      s0 = p[s0];
+      s1 = p[s1];
+      s2 = p[s2];
+      s3 = p[s3];
+      s += 4;
+
+      d[0] = s0 << shift;
+      if (diff < 0)
+      {
+        diff += ratio;
+        *((uint16_t*)&d[0]) = s1 << shift;
+        shift ^= 8;
+        d[1] = s2 << shift;
+        *((uint16_t*)&d[1]) = s3 << shift;
+        shift ^= 8;
+        d += 2;
+        if (s >= s_end) { return; }
+      }
+      else
+      {
+        diff -= 32768;
+        d[2] = s3 << shift;
+        shift ^= 8;
+        d[1] = s1 << shift;
+        *((uint16_t*)&d[1]) = s2 << shift;
+        d += 3;
+        if (s >= s_end) { return; }
+      }
+    }
+  }
+
+#endif
+  const CVBS_Encoder::signal_spec_t& CVBS_Encoder::getSignalSpec(signal_type_t type)
+  {
+    return signal_spec_info_list[(uint32_t)type < signal_type_max ? type : NTSC];
+  }
+
+  uint32_t CVBS_Encoder::getSampleRate(void) const
+  {
+    // カラーサブキャリア周波数 x4 (ESP32のAPLL設定値ではなく規格上の値);
+    static constexpr const uint32_t sample_rate_list[] =
+    { 14318182   // NTSC   3.579545 x4
+    , 14318182   // NTSC_J
+    , 17734475   // PAL    4.43361875 x4
+    , 14302446   // PAL_M  3.57561149 x4
+    , 14328225   // PAL_N  3.58205625 x4
+    };
+    return sample_rate_list[_signal_type];
+  }
+
+  bool CVBS_Encoder::init(const config_t& config)
+  {
+    release();
+
+    _signal_type = (uint32_t)config.signal_type < signal_type_max ? config.signal_type : NTSC;
+    const signal_spec_t& spec_info = signal_spec_info_list[_signal_type];
+    _spec = spec_info;
+
+    _gray = (config.color_depth == grayscale_8bit);
+    uint32_t pixelPerBytes = (config.color_depth & color_depth_t::bit_mask) >> 3;
+    _pixel_bytes = pixelPerBytes;
+
+// 幅方向の解像度に関する準備 ;
+    {
+      uint16_t output_width = std::min(config.memory_width, spec_info.display_width);
+      uint16_t panel_width = std::min(config.panel_width , output_width);
+      _panel_width = panel_width;
+
+      uint_fast16_t offset_x = std::min<uint32_t>(config.offset_x , output_width - panel_width);
+
+      uint32_t scale_index = (spec_info.display_width << 1) / output_width;
+      scale_index = (scale_index < 2 ? 2 : scale_index > 10 ? 10 : scale_index) - 2;
+
+      /// 表示倍率に応じて出力データ生成関数を変更する;
+      static constexpr const blit_func_t fp_tbl_332[] =
+      {
+        blit_x10_x15_332,
+        blit_x15_x20_332,
+        blit_x20_x30_332,
+        blit_x20_x30_332,
+        blit_x30_x40_332,
+        blit_x30_x40_332,
+        blit_x40_x50_332,
+        blit_x40_x50_332,
+        blit_x50_x60_332
+      };
+      static constexpr const blit_func_t fp_tbl_565[] =
+      {
+        blit_x10_x15_565,
+        blit_x15_x20_565,
+        blit_x20_x30_565,
+        blit_x20_x30_565,
+        blit_x30_x40_565,
+        blit_x30_x40_565,
+        blit_x40_x50_565,
+        blit_x40_x50_565,
+        blit_x50_x60_565
+      };
+
+      /// 描画時の引き延ばし倍率テーブル (例:2=等倍  3=1.5倍  4=2倍)  上位4bitと下位4bitで２種類の倍率を指定する;
+      /// この２種類の倍率をデータ生成時に切り替えて任意サイズの出力倍率を実現する;
+      static constexpr const uint8_t scale_tbl[] = { 0x23, 0x34, 0x46, 0x46, 0x68, 0x68, 0x8A, 0x8A, 0xAC };
+      uint8_t scale_h = scale_tbl[scale_index];
+      uint8_t scale_l = scale_h >> 4;
+      scale_h &= 0x0F;
+
+      _fp_blit = (pixelPerBytes == 1 ? fp_tbl_332 : fp_tbl_565)[scale_index];
+
+      /// 表示倍率の比率を求める;
+      int32_t mul_ratio_h = spec_info.display_width - (output_width * scale_h / 2);
+      int32_t mul_ratio_l = spec_info.display_width - (output_width * scale_l / 2);
+      int32_t mul_ratio = INT32_MAX;
+      if (mul_ratio_h < 0) {
+        mul_ratio_h = -mul_ratio_h;
+        mul_ratio = ((mul_ratio_l << 15) + (mul_ratio_h >> 1)) / mul_ratio_h;
+      }
+      _mul_ratio = mul_ratio;
+
+      // Xオフセットに表示倍率を掛けたものを描画開始位置情報に加える
+      int scale_offset = (offset_x * spec_info.display_width + output_width-1) / output_width;
+
+      _leftside_index = (spec_info.active_start + scale_offset) & ~3u;
+    }
+
+    {
+      uint16_t output_height = std::min(config.memory_height, spec_info.display_height);
+      uint16_t panel_height = std::min(config.panel_height, output_height);
+      _memory_height = output_height;
+      _panel_height = panel_height;
+
+      _offset_y = std::min<uint32_t>(config.offset_y , output_height - panel_height);
+    }
+
+    const signal_setup_info_t& setup_info = signal_setup_info_list[_signal_type];
+    _palette = (uint32_t*)heap_alloc(setup_info.palette_num_256 * pixelPerBytes * 256 * sizeof(uint32_t));
+    if (!_palette) { return false; }
+
+    _burst_shift = 0;
+    _current_scanline = 0;
+    _converted_scanline = 0;
+    _render_index = 0;
+
+    updateSignalLevel(config.output_level, config.chroma_level);
+    return true;
+  }
+
+  void CVBS_Encoder::release(void)
+  {
+    if (_palette != nullptr) { heap_free(_palette); }
+    _palette = nullptr;
+    if (_render_buf != nullptr) { heap_free(_render_buf); }
+    _render_buf = nullptr;
+  }
+
+  void CVBS_Encoder::updateSignalLevel(uint8_t output_level, uint8_t chroma_level)
+  {
+    uint32_t level = 48 * output_level;
+
+    const auto &setup_info = signal_setup_info_list[_signal_type];
+
+    _white_level    = (setup_info.white_mv    * level) >> 8;
+    _black_level    = (setup_info.black_mv    * level) >> 8;
+    _blanking_level = (setup_info.blanking_mv * level) >> 8;
+
+    uint8_t blank_n = (_blanking_level - (_blanking_level >> 1)) >> 8;
+    uint8_t blank_p = (_blanking_level + (_blanking_level >> 1)) >> 8;
+    _burst_wave[0] = blank_n << 24
+                   | blank_p << 8
+                   | blank_p << 16
+                   | blank_n << 0
+                   ;
+    _burst_wave[1] = blank_p << 24
+                   | blank_p << 8
+                   | blank_n << 16
+                   | blank_n << 0
+                   ;
+
+    if (_palette)
+    {
+      auto fp_setup_palette = _pixel_bytes == 1
+                            ? setup_info.setup_palette_332
+                            : setup_info.setup_palette_565
+                            ;
+      if (_gray) {
+        fp_setup_palette = setup_info.setup_palette_gray;
+      }
+      fp_setup_palette(_palette, _white_level, _black_level, chroma_level);
+    }
+  }
+
+  void IRAM_ATTR CVBS_Encoder::writeScanline(uint16_t* buf)
+  {
+    _current_scanline = _current_scanline + 1;
+    if (_current_scanline >= _spec.total_scanlines) {
+      _current_scanline = 0;
+    }
+
+    // インターレース込みでの走査線位置を取得;
+    int i = _current_scanline;
+    // インターレースを外した走査線位置に変換する (奇数フィールドの場合に走査線位置が0基準になるように変換する)
+    bool odd_field = i >= (_spec.total_scanlines >> 1);
+    if (odd_field) { i -= (_spec.total_scanlines >> 1); }
+    _odd_field = odd_field;
+
+    // getScanLine用の走査線位置を設定しておく;
+    _converted_scanline = i;
+
+    _burst_shift = _burst_shift ^ _spec.burst_shift_mask;
+
+    if (i >= _spec.vsync_lines)
+    {
+      i -= _spec.vsync_lines;
+      uint32_t idx = scanlineToY(i, odd_field);
+      if (idx >= _panel_height)
+      {
+        if (idx - _panel_height < (line_buffers << 1))
+        {
+          memset(&buf[_spec.active_start], _black_level >> 8, (_spec.scanline_width - 22 - _spec.active_start) << 1);
+          // memset(&buf[_spec.scanline_width - 22], _blanking_level >> 8, 22 << 1);
+        }
+      }
+      else
+      {
+        const uint8_t* src = _lines[idx];
+        if (_fp_fetch_line)
+        {
+          src = _fp_fetch_line(src);
+        }
+        int pidx = 0;
+        if (_burst_shift & 1)
+        {
+          pidx = _pixel_bytes << 8;
+        }
+        if (src) {
+          _fp_blit( (uint32_t*)(&buf[_leftside_index]),
+                    src,
+                    &src[_panel_width * _pixel_bytes],
+                    &_palette[pidx],
+                    (_burst_shift & 2) << 2,  // burst_shift ? 8 : 0
+                    _mul_ratio );
+        }
+      }
+    }
+    else
+    {
+      if ((size_t)i < _spec.sync_proc_count)
+      {
+        auto sync_proc = _spec.sync_proc[odd_field][i];
+        size_t half_index = (_spec.scanline_width >> 1);
+        if (sync_proc & 0x40)  // 水平期間前半のブランキングレベル化;
+        {
+          memset(buf, _blanking_level >> 8, half_index << 1);
+          buf[(half_index - 1) ^ 1] = _blanking_level;
+        }
+        if (sync_proc & 0x04)  // 水平期間後半のブランキングレベル化;
+        {
+          int blank_idx = (half_index + 1) & ~1u;
+          memset(&buf[blank_idx], _blanking_level >> 8, (_spec.scanline_width - blank_idx) << 1);
+          buf[half_index ^ 1] = _blanking_level;
+        }
+        if (sync_proc & 0x03) // 水平期間後半のパルス付与;
+        {
+          // 0x01=等化パルス幅  /  0x02=垂直同期パルス幅
+          int syncwidth = ((sync_proc & 0x01) ? _spec.hsync_equalizing : _spec.hsync_long);
+          memset(&buf[((_spec.scanline_width >> 1) + 1) & ~1u], SYNC_LEVEL >> 8, syncwidth << 1);
+          buf[(_spec.scanline_width >> 1) ^ 1] = SYNC_LEVEL;
+        }
+        if (sync_proc & 0x30) // 水平期間前半のパルス付与;
+        {
+          int syncwidth = _spec.hsync_equalizing;  // 等化パルス幅;
+          switch ((sync_proc >> 4) & 3)
+          {
+          case 2: syncwidth = _spec.hsync_long;  break;   // 垂直同期パルス幅;
+          case 3: syncwidth = _spec.hsync_short; break;   // 水平同期パルス幅;
+          default: break;
+          }
+          memset(buf, SYNC_LEVEL >> 8, syncwidth << 1);
+        }
+        if (sync_proc & 0x80) // バースト信号付与;
+        {
+          uint32_t b0 = _burst_wave[_burst_shift & 1];
+          uint32_t b1 = b0 << 8;
+          uint32_t* l = (uint32_t*)(&buf[_spec.burst_start]);
+          bool flg_swap = (bool)(_spec.burst_start & 3) ^ (bool)(_burst_shift & 2);
+          if (flg_swap) { std::swap(b0, b1); }
+          int burst_len = _spec.burst_cycle;
+          do
+          {
+            *l++ = b0;
+            *l++ = b1;
+          } while (--burst_len);
+
+          memset(&buf[_spec.active_start], _black_level >> 8, (_spec.scanline_width - 22 - _spec.active_start) << 1);
+        }
+      }
+      i -= _spec.vsync_lines;
+    }
+    _field_line = i;
+  }
+
+  bool CVBS_Encoder::renderFrame(uint8_t* dst)
+  {
+    if (_palette == nullptr || _lines == nullptr) { return false; }
+
+    size_t width = _spec.scanline_width;
+    if (_render_buf == nullptr)
+    {
+      size_t len = width * line_buffers * sizeof(uint16_t);
+      _render_buf = (uint16_t*)heap_alloc(len);
+      if (_render_buf == nullptr) { return false; }
+      memset(_render_buf, 0, len);
+    }
+
+    for (size_t y = 0; y < _spec.total_scanlines; ++y)
+    {
+      auto buf = &_render_buf[_render_index * width];
+      _render_index = (_render_index + 1) % line_buffers;
+      writeScanline(buf);
+      // I2Sは16bitサンプルを2つずつ入替えて出力し、DACには上位8bitが出力される;
+      for (size_t x = 0; x < width; ++x)
+      {
+        dst[x] = buf[x ^ 1] >> 8;
+      }
+      dst += width;
+    }
+    return true;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
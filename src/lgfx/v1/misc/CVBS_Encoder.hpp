@@ -0,0 +1,173 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+
+Inspiration Sources:
+ [Roger Cheng](https://github.com/Roger-random/ESP_8_BIT_composite)
+ [rossum](https://github.com/rossumur/esp_8_bit)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "enum.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// NTSC / PAL コンポジット映像信号の生成部;
+  /// フレームバッファの各行から1走査線分の16bitサンプル列 (上位8bitがDAC出力値) を生成する;
+  /// Panel_CVBS は I2S の割込みから writeScanline を呼ぶ。それ以外の環境では renderFrame でサンプル列を得られる;
+  class CVBS_Encoder
+  {
+  public:
+    /// same order as Panel_CVBS::config_detail_t::signal_type_t
+    enum signal_type_t
+    {
+      NTSC,    // black = 7.5IRE
+      NTSC_J,  // black = 0IRE (for Japan)
+      PAL,
+      PAL_M,
+      PAL_N,
+      signal_type_max,
+    };
+
+    struct config_t
+    {
+      signal_type_t signal_type = NTSC;
+
+      /// rgb332_1Byte / rgb565_2Byte / grayscale_8bit
+      color_depth_t color_depth = rgb332_1Byte;
+
+      /// 出力解像度 (memory) とフレームバッファの大きさ (panel) 及びその表示位置;
+      uint16_t memory_width = 180;
+      uint16_t memory_height = 120;
+      uint16_t panel_width = 180;
+      uint16_t panel_height = 120;
+      uint16_t offset_x = 0;
+      uint16_t offset_y = 0;
+
+      // luminance_gain default:128  0=no signal
+      uint8_t output_level = 128;
+
+      // default:128  0=monochrome
+      uint8_t chroma_level = 128;
+    };
+
+    struct signal_spec_t
+    {
+      static constexpr const size_t sync_proc_count = 12;
+      uint16_t total_scanlines;     // 走査線数(２フィールド、１フレーム);
+      uint16_t scanline_width;      // 走査線内のサンプル数 (カラークロック数 x4);
+      uint8_t hsync_equalizing;     // 等化パルス幅;
+      uint8_t hsync_short;          // 水平同期期間のSYNC幅;
+      uint16_t hsync_long;          // 垂直同期期間のSYNC幅;
+      uint8_t burst_start;
+      uint8_t burst_cycle;          // バースト信号の数;
+      uint8_t active_start;
+      uint8_t burst_shift_mask;
+      uint16_t display_width;       // X方向 表示可能ピクセル数;
+      uint16_t display_height;      // Y方向 表示可能ピクセル数;
+      uint8_t sync_proc[2][sync_proc_count];     // 垂直同期期間の処理内容テーブル 偶数行・奇数行で2要素,各要素12ライン分;
+      uint8_t vsync_lines;          // 垂直同期期間(表示期間外)の走査線数(単フィールド分)
+    };
+
+    /// 走査線データを交互に書込むバッファの数 (Panel_CVBS の DMAディスクリプタ数);
+    static constexpr const uint8_t line_buffers = 2;
+
+    typedef void (*blit_func_t)(uint32_t*, const uint8_t*, const uint8_t*, const uint32_t*, int, int);
+
+    /// PSRAM上の行を読む前に呼ばれる。SRAM上の読出し先を返す;
+    typedef const uint8_t* (*fetch_line_t)(const uint8_t* src);
+
+    ~CVBS_Encoder(void) { release(); }
+
+    /// 信号仕様と解像度から描画倍率・開始位置を求め、パレットを確保して生成する;
+    bool init(const config_t& config);
+    void release(void);
+
+    void updateSignalLevel(uint8_t output_level, uint8_t chroma_level);
+
+    /// frame buffer lines ( panel_height x panel_width * getPixelBytes() )
+    void setLines(const uint8_t* const* lines) { _lines = lines; }
+    void setFetchLine(fetch_line_t fp) { _fp_fetch_line = fp; }
+
+    /// 次の走査線へ進め、その内容を buf (走査線幅 x 16bit) に書込む;
+    /// 変化する部分のみを書込むため、buf は line_buffers 本前に渡したものを順に使うこと;
+    void writeScanline(uint16_t* buf);
+
+    /// 次の1フレーム (total_scanlines x scanline_width) 分のDAC出力値を dst に書込む;
+    bool renderFrame(uint8_t* dst);
+
+    /// 信号のサンプリング周波数 (カラーサブキャリア x4) Hz;
+    uint32_t getSampleRate(void) const;
+    static const signal_spec_t& getSignalSpec(signal_type_t type);
+    const signal_spec_t& getSignalSpec(void) const { return _spec; }
+
+    uint8_t getPixelBytes(void) const { return _pixel_bytes; }
+    uint16_t getPanelWidth(void) const { return _panel_width; }
+    uint16_t getPanelHeight(void) const { return _panel_height; }
+
+    /// インターレース込みの走査線位置;
+    uint16_t getCurrentScanline(void) const { return _current_scanline; }
+    /// インターレースを外した走査線位置 (getScanLine用);
+    uint16_t getScanLine(void) const { return _converted_scanline; }
+    /// 直前に書込んだ走査線の表示期間先頭からの位置 (垂直同期期間中は負の値);
+    int32_t getFieldLine(void) const { return _field_line; }
+    bool isOddField(void) const { return _odd_field; }
+
+    /// 表示期間先頭からの走査線位置をフレームバッファの行番号に変換する;
+    int32_t scanlineToY(int32_t line, bool odd) const
+    {
+      return ((line << 1) + (!odd)) * _memory_height / _spec.display_height - _offset_y;
+    }
+
+  private:
+    signal_spec_t _spec;
+    const uint8_t* const* _lines = nullptr;
+    fetch_line_t _fp_fetch_line = nullptr;
+    uint32_t* _palette = nullptr;   // RGB332から波形に変換するためのテーブル;
+    uint16_t* _render_buf = nullptr;
+    blit_func_t _fp_blit = nullptr;
+    uint32_t _burst_wave[2];       // カラーバースト信号の波形データ(EVENとODDで２通り)
+    int32_t _mul_ratio = 0;
+    int32_t _field_line = 0;
+    int16_t _offset_y = 0;
+    uint16_t _memory_height = 0;
+    uint16_t _panel_height = 0;
+    uint16_t _panel_width = 0;
+    uint16_t _leftside_index = 0;
+    volatile uint16_t _current_scanline = 0;
+    volatile uint16_t _converted_scanline = 0;
+    uint16_t _blanking_level = 0;
+    uint16_t _black_level = 0;
+    uint16_t _white_level = 0;
+    signal_type_t _signal_type = NTSC;
+    uint8_t _burst_shift = 0;        // カラーバースト信号の反転・位相ずらし処理状態保持用;
+    uint8_t _pixel_bytes = 1;
+    uint8_t _render_index = 0;
+    bool _gray = false;
+    bool _odd_field = false;
+    static constexpr uint8_t SYNC_LEVEL = 0;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -76,6 +76,15 @@ namespace lgfx
     virtual void close(void) = 0;
     virtual int32_t tell(void) = 0;
 
+    /// Only the wrappers of files and streams can be written to ( see LGFXBase::writeImage ).
+    virtual int write(const uint8_t *buf, uint32_t len) { (void)buf; (void)len; return 0; }
+
+    /// The wrapper this one reads through ( see BufferedDataWrapper ). The bus handoff for reads is set on that one.
+    virtual DataWrapper* getSource(void) { return nullptr; }
+
+    /// File system the paths given to open are looked up in ( e.g. the fs::FS of SD or LittleFS ), nullptr for the default one.
+    virtual const void* getFileSystem(void) const { return nullptr; }
+
     LGFX_INLINE void preRead(void) { if (fp_pre_read) fp_pre_read(parent); }
     LGFX_INLINE void postRead(void) { if (fp_post_read) fp_post_read(parent); }
     LGFX_INLINE bool hasParent(void) const { return parent; }
@@ -122,6 +131,7 @@ namespace lgfx
     }
 #endif
     int read(uint8_t *buf, uint32_t len) override { return fread((char*)buf, 1, len, _fp); }
+    int write(const uint8_t *buf, uint32_t len) override { return fwrite((const char*)buf, 1, len, _fp); }
     void skip(int32_t offset) override { seek(offset, SEEK_CUR); }
     bool seek(uint32_t offset) override { return seek(offset, SEEK_SET); }
     bool seek(uint32_t offset, int origin) { return fseek(_fp, offset, origin); }
@@ -188,6 +198,7 @@ namespace lgfx
   {
     DataWrapperT_SdFatFile(TFile* fp = nullptr) : DataWrapper{}, _fp { fp } { need_transaction = true; }
     int read(uint8_t *buf, uint32_t len) override { uint32_t a = _fp->available(); return _fp->read(buf, a < len ? a : len); }
+    int write(const uint8_t *buf, uint32_t len) override { return _fp->write(buf, len); }
     void skip(int32_t offset) override { _fp->seekCur(offset); }
     bool seek(uint32_t offset) override { return _fp->seekSet(offset); }
     void close(void) override { if (_fp) { _fp->close(); _fp = nullptr; } }
@@ -221,6 +232,7 @@ namespace lgfx
       DataWrapperT_SdFatFile<TFile>::_fp = &_file;
       return _file;
     }
+    const void* getFileSystem(void) const override { return _fs; }
   protected:
     TFS *_fs;
     TFile _file;
@@ -296,6 +308,7 @@ namespace lgfx
       } while (offset);
     }
     bool seek(uint32_t offset) override { if (offset < _index) { return false; } skip(offset - _index); return true; }
+    int write(const uint8_t *buf, uint32_t len) override { return _stream->write(buf, len); }
     void close() override { }
     int32_t tell(void) override { return _index; }
 
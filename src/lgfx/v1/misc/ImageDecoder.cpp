@@ -0,0 +1,151 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "ImageDecoder.hpp"
+
+#include "../platforms/common.hpp"
+#include "../../utility/lgfx_pngle.h"
+#include "../../utility/lgfx_qoi.h"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  // the line buffer holds bgra8888_t pixels at the top of the work area, the state of the C decoder follows.
+  static constexpr size_t line_pixel_bytes = 4;
+
+  void ImageDecoder::release(void)
+  {
+    if (_work && _owned) { heap_free(_work); }
+    _work = nullptr;
+    _work_len = 0;
+    _line_buffer = nullptr;
+    _max_width = 0;
+    _owned = false;
+  }
+
+  bool ImageDecoder::init_work(void* work, size_t len)
+  {
+    auto top = (uint8_t*)(((uintptr_t)work + 3) & ~(uintptr_t)3);
+    size_t pad = top - (uint8_t*)work;
+    size_t base = state_size(0);
+    size_t per_pixel = state_size(1) - base + line_pixel_bytes;
+    if (work == nullptr || len < pad + base + per_pixel) { return false; }
+
+    uint32_t max_width = (len - pad - base) / per_pixel;
+    size_t line_len = max_width * line_pixel_bytes;
+    if (!create_state(top + line_len, len - pad - line_len)) { return false; }
+    _work = (uint8_t*)work;
+    _work_len = len;
+    _line_buffer = top;
+    _max_width = max_width;
+    return true;
+  }
+
+  bool ImageDecoder::setWork(void* work, size_t len)
+  {
+    release();
+    return init_work(work, len);
+  }
+
+  bool ImageDecoder::allocate(uint32_t max_width, bool psram)
+  {
+    release();
+    _psram = psram;
+    if (max_width == 0) { max_width = 1; }
+    size_t len = state_size(max_width) + max_width * line_pixel_bytes;
+    void* work = psram ? heap_alloc_psram(len) : nullptr;
+    if (work == nullptr) { work = heap_alloc(len); }
+    if (work == nullptr) { return false; }
+    ++_alloc_count;
+    if (!init_work(work, len))
+    {
+      heap_free(work);
+      return false;
+    }
+    _owned = true;
+    return true;
+  }
+
+  bool ImageDecoder::read_header(DataWrapper* data, uint8_t header_len, const char* signature, uint8_t signature_len)
+  {
+    _header_len = 0;
+    data->preRead();
+    if (data->read(_header, header_len, header_len) != header_len) { return false; }
+    _header_len = header_len;
+    // not an image of this format : the size bytes mean nothing, do not size the work area by them.
+    if (memcmp(_header, signature, signature_len)) { return false; }
+
+    auto p = &_header[signature_len];
+    _width  = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    _height = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+    if (_work && _width <= _max_width) { return true; }
+    if ((_work && !_owned) || _width >= (1u << 24)) { return false; }
+    // round up, so that a series of slightly wider images does not reallocate every time.
+    return allocate((_width + 15) & ~15u, _psram);
+  }
+
+  void* ImageDecoder::get_line_buffer(uint32_t len)
+  {
+    if (len <= _max_width) { return _line_buffer; }
+    ++_heap_line_count;
+    return nullptr;
+  }
+
+//----------------------------------------------------------------------------
+
+  size_t PngDecoder::getWorkSize(uint32_t max_width)
+  {
+    return lgfx_pngle_work_size(max_width) + max_width * line_pixel_bytes + 3;
+  }
+
+  size_t PngDecoder::state_size(uint32_t max_width) const
+  {
+    return lgfx_pngle_work_size(max_width);
+  }
+
+  bool PngDecoder::create_state(void* work, size_t len)
+  {
+    _pngle = lgfx_pngle_new_static(work, len);
+    return _pngle != nullptr;
+  }
+
+//----------------------------------------------------------------------------
+
+  size_t QoiDecoder::getWorkSize(uint32_t max_width)
+  {
+    return lgfx_qoi_work_size(max_width) + max_width * line_pixel_bytes + 3;
+  }
+
+  size_t QoiDecoder::state_size(uint32_t max_width) const
+  {
+    return lgfx_qoi_work_size(max_width);
+  }
+
+  bool QoiDecoder::create_state(void* work, size_t len)
+  {
+    _qoi = lgfx_qoi_new_static(work, len);
+    return _qoi != nullptr;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
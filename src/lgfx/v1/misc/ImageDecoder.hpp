@@ -0,0 +1,147 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "DataWrapper.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct _pngle_t;
+struct _qoi_t;
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Work area of a PngDecoder / QoiDecoder.
+  /// It holds the whole decoder state and the line buffer the rows are blended in,
+  /// so drawing with the same decoder again does not touch the heap.
+  /// The decoders share no state; one decoder per task can draw into different sprites at the same time.
+  class ImageDecoder
+  {
+    friend class LGFXBase;
+  public:
+    ImageDecoder(const ImageDecoder&) = delete;
+    ImageDecoder& operator=(const ImageDecoder&) = delete;
+    virtual ~ImageDecoder(void) { release(); }
+
+    /// Uses memory of the caller ( internal RAM, PSRAM or a static array ) as the work area.
+    /// It must stay valid until release or the next setWork, and is never freed by the decoder.
+    /// Images wider than getMaxWidth() then fail to draw.
+    bool setWork(void* work, size_t len);
+
+    /// Allocates the work area for images up to max_width pixels wide, in PSRAM when psram is true.
+    /// Without setWork or allocate, the work area is allocated by the first draw and grown for wider images.
+    bool allocate(uint32_t max_width, bool psram = false);
+
+    /// Frees the work area if the decoder allocated it, and forgets the memory given to setWork.
+    void release(void);
+
+    /// Widest image the work area holds. Rows drawn wider than this ( scale > 1 ) blend in a line buffer from the heap.
+    uint32_t getMaxWidth(void) const { return _max_width; }
+    size_t getWorkLength(void) const { return _work_len; }
+
+    /// Size of the last image.
+    uint32_t width(void) const { return _width; }
+    uint32_t height(void) const { return _height; }
+
+    /// Number of work area allocations and of draws that needed a line buffer from the heap.
+    uint32_t getAllocCount(void) const { return _alloc_count; }
+    uint32_t getHeapLineCount(void) const { return _heap_line_count; }
+    void resetStats(void) { _alloc_count = _heap_line_count = 0; }
+
+  protected:
+    ImageDecoder(void) = default;
+
+    static constexpr uint8_t header_max = 32;
+
+    /// Bytes of the state of the C decoder for images up to max_width pixels wide.
+    virtual size_t state_size(uint32_t max_width) const = 0;
+    /// Builds the state of the C decoder in work.
+    virtual bool create_state(void* work, size_t len) = 0;
+
+    /// Reads the first header_len bytes, which must start with the signature, and takes the image size
+    /// that follows it ( width and height, big endian ).
+    /// Grows the work area if the decoder allocated it; fails if the image does not fit in memory of the caller.
+    bool read_header(DataWrapper* data, uint8_t header_len, const char* signature, uint8_t signature_len);
+
+    /// The line buffer if it holds len pixels, otherwise nullptr.
+    void* get_line_buffer(uint32_t len);
+
+    bool init_work(void* work, size_t len);
+
+    uint8_t* _work = nullptr;
+    size_t _work_len = 0;
+    void* _line_buffer = nullptr;   // bgra8888_t x _max_width
+    uint32_t _max_width = 0;
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    uint32_t _alloc_count = 0;
+    uint32_t _heap_line_count = 0;
+    uint8_t _header[header_max];    // bytes read by read_header, passed to the C decoder first
+    uint8_t _header_len = 0;
+    bool _owned = false;            // _work was allocated by the decoder
+    bool _psram = false;
+  };
+
+  /// Decoder context for drawPng. Unlike drawPng without a decoder,
+  /// the inflate window, the scanline buffer and the palette live in the work area of this object.
+  class PngDecoder : public ImageDecoder
+  {
+    friend class LGFXBase;
+  public:
+    PngDecoder(void) = default;
+
+    /// Bytes of the work area for images up to max_width pixels wide. ( about 44 KiB + 12 bytes per pixel )
+    static size_t getWorkSize(uint32_t max_width);
+
+  protected:
+    size_t state_size(uint32_t max_width) const override;
+    bool create_state(void* work, size_t len) override;
+
+    /// PNG signature, then the length and the type of the IHDR chunk, which comes first and holds the size.
+    bool read_header(DataWrapper* data) { return ImageDecoder::read_header(data, 29, "\x89PNG\r\n\x1A\n\0\0\0\x0DIHDR", 16); }
+
+    _pngle_t* _pngle = nullptr;
+  };
+
+  /// Decoder context for drawQoi; the pixel row and the color index live in the work area of this object.
+  class QoiDecoder : public ImageDecoder
+  {
+    friend class LGFXBase;
+  public:
+    QoiDecoder(void) = default;
+
+    /// Bytes of the work area for images up to max_width pixels wide. ( about 600 bytes + 8 bytes per pixel )
+    static size_t getWorkSize(uint32_t max_width);
+
+  protected:
+    size_t state_size(uint32_t max_width) const override;
+    bool create_state(void* work, size_t len) override;
+
+    bool read_header(DataWrapper* data) { return ImageDecoder::read_header(data, 14, "qoif", 4); }
+
+    _qoi_t* _qoi = nullptr;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,512 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "ImageEncoder.hpp"
+
+#include "../platforms/common.hpp"
+#include "../../utility/lgfx_miniz.h"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  static constexpr uint32_t chunk_size_min = 64;
+
+  void ImageEncoder::release(void)
+  {
+    if (_buf) { heap_free(_buf); _buf = nullptr; }
+    if (_tdefl) { heap_free(_tdefl); _tdefl = nullptr; }
+    if (_png_prev) { heap_free(_png_prev); _png_prev = nullptr; }
+    if (_png_row) { heap_free(_png_row); _png_row = nullptr; }
+    _png_row_capacity = 0;
+    _buf_size = 0;
+    _buf_len = 0;
+  }
+
+  bool ImageEncoder::begin(const config_t& config, uint32_t width, uint32_t height, writer_t writer, void* user)
+  {
+    if (width == 0 || height == 0 || writer == nullptr) { return false; }
+
+    uint32_t chunk_size = config.chunk_size < chunk_size_min ? chunk_size_min : config.chunk_size;
+    if (_buf_size != chunk_size)
+    {
+      if (_buf) { heap_free(_buf); }
+      _buf = (uint8_t*)heap_alloc(chunk_size);
+      _buf_size = _buf ? chunk_size : 0;
+      if (_buf == nullptr) { return false; }
+    }
+
+    _config = config;
+    _writer = writer;
+    _user = user;
+    _width = width;
+    _height = height;
+    _buf_len = 0;
+    _written = 0;
+    _rows = 0;
+    _error = false;
+
+    switch (config.format)
+    {
+    case png: _error = !begin_png(); break;
+    case qoi: _error = !begin_qoi(); break;
+    case bmp: _error = !begin_bmp(); break;
+    default:  _error = true;         break;
+    }
+    return !_error;
+  }
+
+  bool ImageEncoder::writeRow(const uint8_t* rgb)
+  {
+    if (_error || _rows >= _height) { return false; }
+    ++_rows;
+    bool res = false;
+    switch (_config.format)
+    {
+    case png: res = row_png(rgb); break;
+    case qoi: res = row_qoi(rgb); break;
+    case bmp: res = row_bmp(rgb); break;
+    default: break;
+    }
+    _error = !res;
+    return res;
+  }
+
+  size_t ImageEncoder::end(void)
+  {
+    if (_error || _rows != _height) { _error = true; return 0; }
+    bool res = true;
+    switch (_config.format)
+    {
+    case png: res = end_png(); break;
+    case qoi: res = end_qoi(); break;
+    default: break;
+    }
+    if (!res || !flush()) { _error = true; return 0; }
+    return _written;
+  }
+
+//----------------------------------------------------------------------------
+
+  bool ImageEncoder::flush(void)
+  {
+    if (_buf_len == 0) { return true; }
+    bool res = _writer(_user, _buf, _buf_len);
+    _written += _buf_len;
+    _buf_len = 0;
+    return res;
+  }
+
+  bool ImageEncoder::put(const void* data, uint32_t len)
+  {
+    auto src = (const uint8_t*)data;
+    while (len)
+    {
+      uint32_t l = _buf_size - _buf_len;
+      if (l > len) { l = len; }
+      memcpy(&_buf[_buf_len], src, l);
+      _buf_len += l;
+      src += l;
+      len -= l;
+      if (_buf_len == _buf_size && !flush()) { return false; }
+    }
+    return true;
+  }
+
+  bool ImageEncoder::put32be(uint32_t value)
+  {
+    uint8_t b[4] = { (uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value };
+    return put(b, 4);
+  }
+
+  bool ImageEncoder::put_crc(const void* data, uint32_t len)
+  {
+    _crc = (uint32_t)lgfx_mz_crc32(_crc, (const uint8_t*)data, len);
+    return put(data, len);
+  }
+
+//----------------------------------------------------------------------------
+
+  bool ImageEncoder::begin_png(void)
+  {
+    static constexpr uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    uint8_t ihdr[17] = { 'I', 'H', 'D', 'R'
+                       , (uint8_t)(_width  >> 24), (uint8_t)(_width  >> 16), (uint8_t)(_width  >> 8), (uint8_t)_width
+                       , (uint8_t)(_height >> 24), (uint8_t)(_height >> 16), (uint8_t)(_height >> 8), (uint8_t)_height
+                       , 8     // bit depth
+                       , 2     // RGB
+                       , 0, 0, 0 };
+    _crc = MZ_CRC32_INIT;
+    if (!put(signature, sizeof(signature))
+     || !put32be(13)
+     || !put_crc(ihdr, sizeof(ihdr))
+     || !put32be(_crc))
+    {
+      return false;
+    }
+
+    if (_config.png_filter != png_filter_none)
+    {
+      if (_png_row_capacity < _width)
+      {
+        if (_png_prev) { heap_free(_png_prev); }
+        if (_png_row) { heap_free(_png_row); }
+        _png_prev = (uint8_t*)heap_alloc(_width * 3);
+        _png_row = (uint8_t*)heap_alloc(_width * 3 + 1);
+        _png_row_capacity = (_png_prev && _png_row) ? _width : 0;
+        if (_png_row_capacity == 0) { return false; }
+      }
+      memset(_png_prev, 0, _width * 3);
+    }
+
+    if (_config.png_preset == png_store)
+    {
+      _adler = MZ_ADLER32_INIT;
+      return true;
+    }
+
+    if (_tdefl == nullptr)
+    {
+      _tdefl = heap_alloc_psram(sizeof(tdefl_compressor));
+      if (_tdefl == nullptr) { _tdefl = heap_alloc(sizeof(tdefl_compressor)); }
+      if (_tdefl == nullptr) { return false; }
+    }
+
+    static constexpr uint32_t preset_flags[] =
+    { 0   // png_store
+    , 1 | TDEFL_GREEDY_PARSING_FLAG
+    , 128
+    , 768
+    };
+    uint32_t flags = preset_flags[_config.png_preset <= png_max ? _config.png_preset : png_balanced];
+    return TDEFL_STATUS_OKAY == tdefl_init((tdefl_compressor*)_tdefl, png_put_idat, this, flags | TDEFL_WRITE_ZLIB_HEADER);
+  }
+
+  int ImageEncoder::png_put_idat(const void* buf, int len, void* user)
+  {
+    auto me = (ImageEncoder*)user;
+    static constexpr uint8_t idat[] = { 'I', 'D', 'A', 'T' };
+    me->_crc = MZ_CRC32_INIT;
+    return me->put32be(len)
+        && me->put_crc(idat, sizeof(idat))
+        && me->put_crc(buf, len)
+        && me->put32be(me->_crc);
+  }
+
+  bool ImageEncoder::store_png(uint8_t filter_type, const uint8_t* data, uint32_t len)
+  {
+    static constexpr uint8_t idat[] = { 'I', 'D', 'A', 'T' };
+    static constexpr uint8_t zlib_header[] = { 0x78, 0x01 };
+    static constexpr uint32_t block_max = 65535;
+    bool first = _rows == 1;
+    bool last = _rows == _height;
+    uint32_t remain = len + 1;  // with the filter type byte
+    uint32_t blocks = (remain + block_max - 1) / block_max;
+
+    _crc = MZ_CRC32_INIT;
+    if (!put32be((first ? 2 : 0) + blocks * 5 + remain + (last ? 4 : 0))
+     || !put_crc(idat, sizeof(idat))
+     || (first && !put_crc(zlib_header, sizeof(zlib_header))))
+    {
+      return false;
+    }
+
+    _adler = (uint32_t)lgfx_mz_adler32(_adler, &filter_type, 1);
+    _adler = (uint32_t)lgfx_mz_adler32(_adler, data, len);
+    bool type_written = false;
+    do
+    {
+      uint32_t n = remain < block_max ? remain : block_max;
+      remain -= n;
+      uint8_t header[5] = { (uint8_t)(last && remain == 0), (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)~n, (uint8_t)(~n >> 8) };
+      if (!put_crc(header, sizeof(header))) { return false; }
+      if (!type_written)
+      {
+        type_written = true;
+        if (!put_crc(&filter_type, 1)) { return false; }
+        --n;
+      }
+      if (!put_crc(data, n)) { return false; }
+      data += n;
+    } while (remain);
+
+    if (last)
+    {
+      uint8_t adler[4] = { (uint8_t)(_adler >> 24), (uint8_t)(_adler >> 16), (uint8_t)(_adler >> 8), (uint8_t)_adler };
+      if (!put_crc(adler, sizeof(adler))) { return false; }
+    }
+    return put32be(_crc);
+  }
+
+  static inline uint8_t paeth(uint_fast16_t a, uint_fast16_t b, uint_fast16_t c)
+  {
+    int_fast16_t p = a + b - c;
+    uint_fast16_t pa = p > (int_fast16_t)a ? p - a : a - p;
+    uint_fast16_t pb = p > (int_fast16_t)b ? p - b : b - p;
+    uint_fast16_t pc = p > (int_fast16_t)c ? p - c : c - p;
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+  }
+
+  static inline uint32_t abs8(uint_fast8_t v) { return v < 128 ? v : 256 - v; }
+
+  void ImageEncoder::filter_png(const uint8_t* rgb)
+  {
+    enum { none, sub, up, average, paeth_ };
+    uint32_t len = _width * 3;
+    const uint8_t* prev = _png_prev;
+    uint8_t* dst = &_png_row[1];
+    uint_fast8_t type;
+    switch (_config.png_filter)
+    {
+    case png_filter_sub: type = sub; break;
+    case png_filter_up:  type = up;  break;
+    default:
+      { // estimate each filter by the sum of the residuals as signed bytes.
+        uint32_t sum[5] = { 0, 0, 0, 0, 0 };
+        for (uint32_t i = 0; i < len; ++i)
+        {
+          uint_fast8_t x = rgb[i];
+          uint_fast8_t a = i < 3 ? 0 : rgb[i - 3];
+          uint_fast8_t b = prev[i];
+          uint_fast8_t c = i < 3 ? 0 : prev[i - 3];
+          sum[none   ] += abs8(x);
+          sum[sub    ] += abs8((uint8_t)(x - a));
+          sum[up     ] += abs8((uint8_t)(x - b));
+          sum[average] += abs8((uint8_t)(x - ((a + b) >> 1)));
+          sum[paeth_ ] += abs8((uint8_t)(x - paeth(a, b, c)));
+        }
+        type = none;
+        for (uint_fast8_t t = 1; t < 5; ++t)
+        {
+          if (sum[type] > sum[t]) { type = t; }
+        }
+      }
+      break;
+    }
+
+    _png_row[0] = type;
+    switch (type)
+    {
+    case none:
+      memcpy(dst, rgb, len);
+      break;
+    case sub:
+      memcpy(dst, rgb, 3);
+      for (uint32_t i = 3; i < len; ++i) { dst[i] = rgb[i] - rgb[i - 3]; }
+      break;
+    case up:
+      for (uint32_t i = 0; i < len; ++i) { dst[i] = rgb[i] - prev[i]; }
+      break;
+    case average:
+      for (uint32_t i = 0; i < 3; ++i) { dst[i] = rgb[i] - (prev[i] >> 1); }
+      for (uint32_t i = 3; i < len; ++i) { dst[i] = rgb[i] - ((rgb[i - 3] + prev[i]) >> 1); }
+      break;
+    default:
+      for (uint32_t i = 0; i < 3; ++i) { dst[i] = rgb[i] - prev[i]; }
+      for (uint32_t i = 3; i < len; ++i) { dst[i] = rgb[i] - paeth(rgb[i - 3], prev[i], prev[i - 3]); }
+      break;
+    }
+    memcpy(_png_prev, rgb, len);
+  }
+
+  bool ImageEncoder::row_png(const uint8_t* rgb)
+  {
+    auto comp = (tdefl_compressor*)_tdefl;
+    uint32_t len = _width * 3;
+    if (_config.png_filter == png_filter_none)
+    {
+      static constexpr uint8_t filter_none = 0;
+      if (_config.png_preset == png_store) { return store_png(filter_none, rgb, len); }
+      return TDEFL_STATUS_OKAY == tdefl_compress_buffer(comp, &filter_none, 1, TDEFL_NO_FLUSH)
+          && TDEFL_STATUS_OKAY == tdefl_compress_buffer(comp, rgb, len, TDEFL_NO_FLUSH);
+    }
+    filter_png(rgb);
+    if (_config.png_preset == png_store) { return store_png(_png_row[0], &_png_row[1], len); }
+    return TDEFL_STATUS_OKAY == tdefl_compress_buffer(comp, _png_row, len + 1, TDEFL_NO_FLUSH);
+  }
+
+  bool ImageEncoder::end_png(void)
+  {
+    static constexpr uint8_t iend[] = { 0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82 };
+    return (_config.png_preset == png_store
+         || TDEFL_STATUS_DONE == tdefl_compress_buffer((tdefl_compressor*)_tdefl, nullptr, 0, TDEFL_FINISH))
+        && put(iend, sizeof(iend));
+  }
+
+//----------------------------------------------------------------------------
+
+  bool ImageEncoder::begin_qoi(void)
+  {
+    uint8_t header[14] = { 'q', 'o', 'i', 'f'
+                         , (uint8_t)(_width  >> 24), (uint8_t)(_width  >> 16), (uint8_t)(_width  >> 8), (uint8_t)_width
+                         , (uint8_t)(_height >> 24), (uint8_t)(_height >> 16), (uint8_t)(_height >> 8), (uint8_t)_height
+                         , 3     // RGB
+                         , 0 };  // sRGB with linear alpha
+    memset(_qoi_index, 0, sizeof(_qoi_index));
+    _qoi_prev = 0xFF000000u;
+    _qoi_run = 0;
+    return put(header, sizeof(header));
+  }
+
+  bool ImageEncoder::row_qoi(const uint8_t* rgb)
+  {
+    static constexpr uint8_t op_index = 0x00;
+    static constexpr uint8_t op_diff  = 0x40;
+    static constexpr uint8_t op_luma  = 0x80;
+    static constexpr uint8_t op_run   = 0xC0;
+    static constexpr uint8_t op_rgb   = 0xFE;
+
+    uint32_t prev = _qoi_prev;
+    uint_fast8_t run = _qoi_run;
+    uint8_t tmp[5];
+    for (uint32_t i = 0; i < _width; ++i, rgb += 3)
+    {
+      // one pixel takes at most 5 bytes ( a pending run and QOI_OP_RGB ).
+      // near the end of the chunk they go through tmp so that every chunk is filled up.
+      bool direct = _buf_size - _buf_len >= sizeof(tmp);
+      uint8_t* dst = direct ? &_buf[_buf_len] : tmp;
+      auto start = dst;
+
+      uint32_t px = rgb[0] | rgb[1] << 8 | rgb[2] << 16 | 0xFF000000u;
+      if (px == prev)
+      {
+        if (++run == 62) { *dst++ = op_run | (run - 1); run = 0; }
+      }
+      else
+      {
+        if (run) { *dst++ = op_run | (run - 1); run = 0; }
+
+        uint_fast8_t hash = (rgb[0] * 3 + rgb[1] * 5 + rgb[2] * 7 + 255 * 11) & 63;
+        if (_qoi_index[hash] == px)
+        {
+          *dst++ = op_index | hash;
+        }
+        else
+        {
+          _qoi_index[hash] = px;
+          int_fast8_t vr = (int8_t)(rgb[0] - (uint8_t)prev);
+          int_fast8_t vg = (int8_t)(rgb[1] - (uint8_t)(prev >> 8));
+          int_fast8_t vb = (int8_t)(rgb[2] - (uint8_t)(prev >> 16));
+          int_fast8_t vg_r = vr - vg;
+          int_fast8_t vg_b = vb - vg;
+          if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+          {
+            *dst++ = op_diff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+          }
+          else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8)
+          {
+            *dst++ = op_luma | (vg + 32);
+            *dst++ = (vg_r + 8) << 4 | (vg_b + 8);
+          }
+          else
+          {
+            *dst++ = op_rgb;
+            *dst++ = rgb[0];
+            *dst++ = rgb[1];
+            *dst++ = rgb[2];
+          }
+        }
+        prev = px;
+      }
+      if (direct) { _buf_len += dst - start; }
+      else if (!put(tmp, dst - tmp)) { return false; }
+    }
+    _qoi_prev = prev;
+    _qoi_run = run;
+    return true;
+  }
+
+  bool ImageEncoder::end_qoi(void)
+  {
+    static constexpr uint8_t padding[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    if (_qoi_run)
+    {
+      uint8_t op = 0xC0 | (_qoi_run - 1);
+      _qoi_run = 0;
+      if (!put(&op, 1)) { return false; }
+    }
+    return put(padding, sizeof(padding));
+  }
+
+//----------------------------------------------------------------------------
+
+  bool ImageEncoder::begin_bmp(void)
+  {
+    uint32_t stride = (_width * 3 + 3) & ~3u;
+    uint32_t image_size = stride * _height;
+    uint32_t file_size = 54 + image_size;
+    uint8_t header[54] = { 'B', 'M' };
+    auto set32 = [&header](uint32_t pos, uint32_t value)
+    {
+      header[pos    ] = value;
+      header[pos + 1] = value >> 8;
+      header[pos + 2] = value >> 16;
+      header[pos + 3] = value >> 24;
+    };
+    set32( 2, file_size);
+    set32(10, 54);            // offset of the pixels
+    set32(14, 40);            // BITMAPINFOHEADER
+    set32(18, _width);
+    set32(22, _height);       // positive = bottom-up
+    header[26] = 1;           // planes
+    header[28] = 24;          // bits per pixel
+    set32(34, image_size);
+    set32(38, 2835);          // 72 dpi
+    set32(42, 2835);
+    return put(header, sizeof(header));
+  }
+
+  bool ImageEncoder::row_bmp(const uint8_t* rgb)
+  {
+    uint32_t remain = _width;
+    do
+    {
+      uint32_t len = (_buf_size - _buf_len) / 3;
+      if (len == 0)
+      { // the pixel on the chunk boundary.
+        uint8_t bgr[3] = { rgb[2], rgb[1], rgb[0] };
+        if (!put(bgr, 3)) { return false; }
+        rgb += 3;
+        --remain;
+        continue;
+      }
+      if (len > remain) { len = remain; }
+      remain -= len;
+      auto dst = &_buf[_buf_len];
+      _buf_len += len * 3;
+      do
+      {
+        dst[0] = rgb[2];
+        dst[1] = rgb[1];
+        dst[2] = rgb[0];
+        dst += 3;
+        rgb += 3;
+      } while (--len);
+      if (_buf_len == _buf_size && !flush()) { return false; }
+    } while (remain);
+
+    static constexpr uint8_t padding[3] = { 0, 0, 0 };
+    return put(padding, (4 - ((_width * 3) & 3)) & 3);
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,153 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Streaming PNG / QOI / BMP encoder for RGB888 rows.
+  /// The output goes to a writer callback in chunks of config_t::chunk_size bytes,
+  /// so only the chunk buffer ( and the deflate state for PNG ) has to be in memory,
+  /// never the whole image.
+  class ImageEncoder
+  {
+  public:
+    enum format_t : uint8_t
+    {
+      png,
+      qoi,
+      bmp,   // 24bit, bottom-up
+    };
+
+    /// speed / size trade-off of the PNG deflate stream.
+    enum png_preset_t : uint8_t
+    {
+      png_store,     // uncompressed deflate blocks, written without the deflate encoder
+      png_fast,      // greedy parsing, 1 probe ( miniz level 1 )
+      png_balanced,  // 128 probes ( miniz level 6 , the former createPng )
+      png_max,       // 768 probes ( miniz level 9 )
+    };
+
+    /// PNG row filter.
+    enum png_filter_t : uint8_t
+    {
+      png_filter_none,
+      png_filter_sub,
+      png_filter_up,
+      png_filter_adaptive,  // per row, the filter with the smallest sum of absolute differences ( none / sub / up / average / paeth )
+    };
+
+    /// Receives the next len bytes of the file. Return false to abort the encoding.
+    typedef bool (*writer_t)(void* user, const uint8_t* data, uint32_t len);
+
+    struct config_t
+    {
+      format_t format = png;
+
+      /// bytes passed to the writer per call, except for the last one.
+      uint32_t chunk_size = 1024;
+
+      /// bytes of RGB888 rows LGFXBase::writeImage reads back at a time ( at least one row ).
+      uint32_t readback_size = 4096;
+
+      png_preset_t png_preset = png_balanced;
+      png_filter_t png_filter = png_filter_none;
+    };
+
+    ImageEncoder(void) = default;
+    ImageEncoder(const ImageEncoder&) = delete;
+    ImageEncoder& operator=(const ImageEncoder&) = delete;
+    ~ImageEncoder(void) { release(); }
+
+    /// Writes the file header. The rows follow with writeRow.
+    bool begin(const config_t& config, uint32_t width, uint32_t height, writer_t writer, void* user);
+
+    /// Encodes one row of width x RGB888 pixels.
+    /// Rows go from top to bottom, or from bottom to top when isBottomUp() is true.
+    bool writeRow(const uint8_t* rgb);
+
+    /// Writes the trailer and the remaining bytes. Returns the file size, or 0 on error.
+    size_t end(void);
+
+    /// Frees the chunk buffer, the deflate state and the filter rows.
+    /// Otherwise they are kept for the next image.
+    void release(void);
+
+    bool isBottomUp(void) const { return _config.format == bmp; }
+
+    /// Bytes passed to the writer so far.
+    size_t getWrittenSize(void) const { return _written; }
+
+  private:
+    bool put(const void* data, uint32_t len);
+    bool put32be(uint32_t value);
+    bool put_crc(const void* data, uint32_t len);   // put, adding data to the CRC of the current PNG chunk
+    bool flush(void);
+
+    bool begin_png(void);
+    bool begin_qoi(void);
+    bool begin_bmp(void);
+    bool row_png(const uint8_t* rgb);
+    bool row_qoi(const uint8_t* rgb);
+    bool row_bmp(const uint8_t* rgb);
+    bool end_png(void);
+    bool end_qoi(void);
+
+    /// tdefl output callback; every deflate block becomes one IDAT chunk.
+    static int png_put_idat(const void* buf, int len, void* user);
+
+    /// Writes the filter type and the filtered row to _png_row, and keeps rgb in _png_prev.
+    void filter_png(const uint8_t* rgb);
+
+    /// png_store: one IDAT chunk of stored deflate blocks per row.
+    bool store_png(uint8_t filter_type, const uint8_t* data, uint32_t len);
+
+    config_t _config;
+    writer_t _writer = nullptr;
+    void* _user = nullptr;
+    uint8_t* _buf = nullptr;        // chunk buffer
+    uint32_t _buf_size = 0;
+    uint32_t _buf_len = 0;
+    size_t _written = 0;
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    uint32_t _rows = 0;
+    void* _tdefl = nullptr;         // tdefl_compressor
+    uint8_t* _png_prev = nullptr;   // previous row ( width x 3 )
+    uint8_t* _png_row = nullptr;    // filtered row ( 1 + width x 3 )
+    uint32_t _png_row_capacity = 0; // width the two rows are allocated for
+    uint32_t _crc = 0;
+    uint32_t _adler = 1;            // adler32 of the zlib stream ( png_store )
+
+    // QOI encoder state
+    uint32_t _qoi_index[64];
+    uint32_t _qoi_prev = 0;
+    uint8_t _qoi_run = 0;
+
+    bool _error = false;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
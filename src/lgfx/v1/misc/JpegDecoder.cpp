@@ -0,0 +1,127 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "JpegDecoder.hpp"
+
+#include "../platforms/common.hpp"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  void JpegDecoder::release(void)
+  {
+    if (_pool) { heap_free(_pool); }
+    _pool = nullptr;
+    _valid = false;
+    _header.clear();
+    _header.shrink_to_fit();
+    _cached.clear();
+    _cached.shrink_to_fit();
+  }
+
+  JRESULT JpegDecoder::read_header(DataWrapper* data)
+  {
+    _header.clear();
+    data->preRead();
+    uint8_t seg[4];
+    if (data->read(seg, 2, 2) != 2) return JDR_INP;
+    if (seg[0] != 0xFF || seg[1] != 0xD8) return JDR_FMT1;
+    _header.assign(seg, seg + 2);
+
+    for (;;)
+    {
+      if (data->read(seg, 1, 1) != 1) return JDR_INP;
+      if (seg[0] != 0xFF) return JDR_FMT1;
+      do
+      {
+        if (data->read(&seg[1], 1, 1) != 1) return JDR_INP;
+      } while (seg[1] == 0xFF);
+      if (data->read(&seg[2], 2, 2) != 2) return JDR_INP;
+      uint_fast8_t marker = seg[1];
+      uint32_t len = (seg[2] << 8 | seg[3]) - 2;
+
+      if ((marker & 0xF0) == 0xE0 || marker == 0xFE)
+      { // APPn, COM : not needed by the decoder, and not worth comparing.
+        data->skip(len);
+        continue;
+      }
+
+      size_t pos = _header.size();
+      _header.insert(_header.end(), seg, seg + 4);
+      if (marker == 0xD9 || ((marker & 0xF0) == 0xC0 && marker != 0xC0 && marker != 0xC4 && marker != 0xC8 && marker != 0xCC))
+      { // EOI, unsupported SOFn : lgfx_jd_prepare reports the error.
+        return JDR_OK;
+      }
+      _header.resize(pos + 4 + len);
+      if (len && data->read(_header.data() + pos + 4, len, len) != (int)len) return JDR_INP;
+      if (marker == 0xDA) return JDR_OK;  // SOS
+    }
+  }
+
+  uint32_t JpegDecoder::read_chained(void* self, uint8_t* buf, uint32_t len)
+  {
+    auto me = (JpegDecoder*)self;
+    uint32_t remain = me->_header.size() - me->_header_pos;
+    if (remain == 0) { return me->_infunc(me->_device, buf, len); }
+    if (len > remain) { len = remain; }
+    if (buf) { memcpy(buf, &me->_header[me->_header_pos], len); }
+    me->_header_pos += len;
+    return len;
+  }
+
+  JRESULT JpegDecoder::prepare(uint32_t (*infunc)(void*, uint8_t*, uint32_t), void* device)
+  {
+    if (_pool == nullptr)
+    {
+      _pool = (uint8_t*)heap_alloc_dma(sz_pool);
+      if (_pool == nullptr) { return JDR_MEM1; }
+      _valid = false;
+    }
+
+    if (_valid && _header == _cached)
+    { // Same tables as the previous frame ; restart the bit stream at the entropy coded data that follows.
+      _jdec.infunc = infunc;
+      _jdec.device = device;
+      _jdec.dptr = _jdec.inbuf;
+      _jdec.dpend = _jdec.inbuf + 1;
+      _jdec.dbit = 0;
+      ++_reuse_count;
+      return JDR_OK;
+    }
+
+    _valid = false;
+    _infunc = infunc;
+    _device = device;
+    _header_pos = 0;
+    auto res = lgfx_jd_prepare(&_jdec, read_chained, _pool, sz_pool, this);
+    if (res != JDR_OK) { return res; }
+    _jdec.infunc = infunc;
+    _jdec.device = device;
+    _cached.swap(_header);
+    _valid = true;
+    ++_parse_count;
+    return JDR_OK;
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,83 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [FreeBSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "DataWrapper.hpp"
+#include "../../utility/lgfx_tjpgd.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Decoder context for drawJpg that outlives a single call.
+  /// The work pool stays allocated, and the Huffman / quantization tables are
+  /// parsed again only when the table segments of the next frame differ,
+  /// so MJPEG style streams of frames with identical headers skip the setup.
+  class JpegDecoder
+  {
+    friend class LGFXBase;
+  public:
+    JpegDecoder(void) = default;
+    JpegDecoder(const JpegDecoder&) = delete;
+    JpegDecoder& operator=(const JpegDecoder&) = delete;
+    ~JpegDecoder(void) { release(); }
+
+    /// Frees the work pool and forgets the cached tables.
+    void release(void);
+
+    /// Size of the last prepared frame.
+    uint16_t width(void) const { return _valid ? _jdec.width : 0; }
+    uint16_t height(void) const { return _valid ? _jdec.height : 0; }
+
+    /// Number of frames whose headers were parsed / reused.
+    uint32_t getParseCount(void) const { return _parse_count; }
+    uint32_t getReuseCount(void) const { return _reuse_count; }
+    void resetStats(void) { _parse_count = _reuse_count = 0; }
+
+  private:
+    static constexpr uint16_t sz_pool = 3900;
+
+    /// Reads the frame header up to the SOS segment, leaving out APPn and COM segments.
+    JRESULT read_header(DataWrapper* data);
+
+    /// Parses the header read by read_header, or reuses the tables of the previous frame when it is identical.
+    /// The entropy coded data that follows is read with infunc.
+    JRESULT prepare(uint32_t (*infunc)(void*, uint8_t*, uint32_t), void* device);
+
+    static uint32_t read_chained(void* self, uint8_t* buf, uint32_t len);
+
+    lgfxJdec _jdec;
+    uint8_t* _pool = nullptr;
+    std::vector<uint8_t> _header;   // table segments of the current frame
+    std::vector<uint8_t> _cached;   // table segments the pool was prepared with
+    uint32_t _header_pos = 0;       // read position of read_chained in _header
+    uint32_t (*_infunc)(void*, uint8_t*, uint32_t) = nullptr;
+    void* _device = nullptr;
+    uint32_t _parse_count = 0;
+    uint32_t _reuse_count = 0;
+    bool _valid = false;
+  };
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,194 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "dither.hpp"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+  namespace dither
+  {
+//----------------------------------------------------------------------------
+
+    void luma(uint8_t* dst, const swap565_t* src, uint32_t length)
+    {
+      for (uint32_t i = 0; i < length; ++i)
+      {
+        auto color = src[i];
+        dst[i] = (color.R8() + (color.G8() << 1) + color.B8()) >> 2;
+      }
+    }
+
+    void error_diffusion(uint8_t* luma, int16_t* error, uint32_t length)
+    {
+      // error[i + 1] is the error (x16) carried to pixel i of this row from the row above.
+      // It is replaced with the error for the next row as soon as pixel i has been read.
+      int32_t right = 0;  // 7/16 to the next pixel
+      int32_t below = 0;  // 5/16 + 1/16 already collected for the pixel below
+      int32_t below_right = 0;
+      for (uint32_t i = 0; i < length; ++i)
+      {
+        int32_t v = luma[i] + ((error[i + 1] + right + 8) >> 4);
+        int32_t out = (v < 128) ? 0 : 255;
+        int32_t e = v - out;
+        luma[i] = out;
+        right = e * 7;
+        error[i] = below + e * 3;  // below left
+        below = below_right + e * 5;
+        below_right = e;
+      }
+      error[length] = below;
+    }
+
+    void pack_row(uint8_t* row, uint32_t xs, uint32_t xe, const uint8_t* luma, const uint8_t* threshold)
+    {
+      uint8_t t[8];  // thresholds of a byte, the same for every byte of the row.
+      for (uint_fast8_t k = 0; k < 8; ++k) { t[k] = threshold[k & 3]; }
+
+      uint32_t x = xs;
+      if (x & 7)
+      { // head
+        uint32_t end = (x | 7) < xe ? (x | 7) : xe;
+        uint_fast8_t mask = (0xFF >> (x & 7)) & (0xFF << (7 - (end & 7)));
+        uint_fast8_t bits = 0;
+        for (; x <= end; ++x)
+        {
+          bits |= ((*luma++ + t[x & 7]) >> 8) << (7 - (x & 7));
+        }
+        auto d = &row[end >> 3];
+        *d = (*d & ~mask) | (bits & mask);
+        if (x > xe) { return; }
+      }
+      auto d = &row[x >> 3];
+      for (; x + 7 <= xe; x += 8)
+      { // 8 pixels to a byte.
+        *d++ = ((luma[0] + t[0]) >> 8) << 7
+             | ((luma[1] + t[1]) >> 8) << 6
+             | ((luma[2] + t[2]) >> 8) << 5
+             | ((luma[3] + t[3]) >> 8) << 4
+             | ((luma[4] + t[4]) >> 8) << 3
+             | ((luma[5] + t[5]) >> 8) << 2
+             | ((luma[6] + t[6]) >> 8) << 1
+             | ((luma[7] + t[7]) >> 8);
+        luma += 8;
+      }
+      if (x <= xe)
+      { // tail
+        uint_fast8_t mask = 0xFF << (7 - (xe & 7));
+        uint_fast8_t bits = 0;
+        for (uint_fast8_t k = 0; x <= xe; ++x, ++k)
+        {
+          bits |= ((luma[k] + t[k]) >> 8) << (7 - k);
+        }
+        *d = (*d & ~mask) | (bits & mask);
+      }
+    }
+
+    void pack_column(uint8_t* buf, uint32_t stride, uint32_t x, uint32_t ys, uint32_t ye, const uint8_t* luma, const uint8_t* threshold)
+    {
+      uint_fast8_t bit = 0x80 >> (x & 7);
+      auto d = &buf[ys * stride + (x >> 3)];
+      for (uint32_t y = ys; y <= ye; ++y)
+      {
+        if ((*luma++ + threshold[y & 3]) >> 8) { *d |=  bit; }
+        else                                   { *d &= ~bit; }
+        d += stride;
+      }
+    }
+
+    void fill_row(uint8_t* row, uint32_t xs, uint32_t xe, uint8_t bits)
+    {
+      uint32_t bs = xs >> 3;
+      uint32_t be = xe >> 3;
+      uint_fast8_t head = 0xFF >> (xs & 7);
+      uint_fast8_t tail = 0xFF << (7 - (xe & 7));
+      if (bs == be)
+      {
+        head &= tail;
+        row[bs] = (row[bs] & ~head) | (bits & head);
+        return;
+      }
+      row[bs] = (row[bs] & ~head) | (bits & head);
+      if (be - bs > 1) { memset(&row[bs + 1], bits, be - bs - 1); }
+      row[be] = (row[be] & ~tail) | (bits & tail);
+    }
+
+    template <bool Binary>
+    static inline uint_fast8_t gray4(const bgr888_t& color, int_fast16_t threshold)
+    {
+      int_fast16_t v = color.R8() + (color.G8() << 1) + color.B8() + threshold;
+      if (Binary) { return (v >= 512) ? 15 : 0; }
+      v = (v < 0) ? 0 : (v >> 6);
+      return (v > 15) ? 15 : v;
+    }
+
+    template <bool Binary>
+    static uint32_t pack_gray4_impl(uint8_t* dst, const bgr888_t* src, uint32_t xs, uint32_t xe, const int8_t* threshold, uint8_t xor_mask)
+    {
+      int_fast16_t t[4];
+      for (uint_fast8_t k = 0; k < 4; ++k) { t[k] = Binary ? threshold[k] << 4 : threshold[k]; }
+
+      auto d = dst;
+      uint32_t x = xs & ~3u;
+      if (x != xs || xe < (x | 3))
+      { // head, a part of a group.
+        uint_fast16_t word = 0;
+        for (uint_fast8_t k = 0; k < 4; ++k, ++x)
+        {
+          word <<= 4;
+          if (xs <= x && x <= xe) { word |= gray4<Binary>(*src++, t[k]); }
+        }
+        d[0] = (word >> 8) ^ xor_mask;
+        d[1] = word ^ xor_mask;
+        d += 2;
+      }
+      for (; x + 3 <= xe; x += 4)
+      { // 4 pixels to a word.
+        d[0] = (gray4<Binary>(src[0], t[0]) << 4 | gray4<Binary>(src[1], t[1])) ^ xor_mask;
+        d[1] = (gray4<Binary>(src[2], t[2]) << 4 | gray4<Binary>(src[3], t[3])) ^ xor_mask;
+        src += 4;
+        d += 2;
+      }
+      if (x <= xe)
+      { // tail
+        uint_fast16_t word = 0;
+        for (uint_fast8_t k = 0; k < 4; ++k, ++x)
+        {
+          word <<= 4;
+          if (x <= xe) { word |= gray4<Binary>(*src++, t[k]); }
+        }
+        d[0] = (word >> 8) ^ xor_mask;
+        d[1] = word ^ xor_mask;
+        d += 2;
+      }
+      return d - dst;
+    }
+
+    uint32_t pack_gray4(uint8_t* dst, const bgr888_t* src, uint32_t xs, uint32_t xe, const int8_t* threshold, bool binary, bool invert)
+    {
+      uint8_t xor_mask = invert ? 0xFF : 0;
+      return binary ? pack_gray4_impl<true >(dst, src, xs, xe, threshold, xor_mask)
+                    : pack_gray4_impl<false>(dst, src, xs, xe, threshold, xor_mask);
+    }
+
+//----------------------------------------------------------------------------
+  }
+ }
+}
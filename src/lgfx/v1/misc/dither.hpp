@@ -0,0 +1,64 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "colortype.hpp"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Row kernels for the e-paper panels.
+  /// 1bpp buffers hold 8 pixels per byte, MSB first, in rows of `stride` bytes.
+  /// A pixel is set when its luma plus its threshold is 256 or more.
+  namespace dither
+  {
+    /// Luma ( R + 2G + B ) / 4 of each pixel.
+    void luma(uint8_t* dst, const swap565_t* src, uint32_t length);
+
+    /// Floyd-Steinberg error diffusion. Replaces a row of luma with 0 or 255.
+    /// `error` keeps the error carried to the next row, length + 1 entries cleared before the first row.
+    /// Use a threshold of 1 to store the result.
+    void error_diffusion(uint8_t* luma, int16_t* error, uint32_t length);
+
+    /// Stores pixels xs ~ xe of a row. luma[0] is pixel xs, threshold[x & 3] is the threshold of pixel x.
+    void pack_row(uint8_t* row, uint32_t xs, uint32_t xe, const uint8_t* luma, const uint8_t* threshold);
+
+    /// Stores pixels ys ~ ye of column x. luma[0] is pixel ys, threshold[y & 3] is the threshold of pixel y.
+    void pack_column(uint8_t* buf, uint32_t stride, uint32_t x, uint32_t ys, uint32_t ye, const uint8_t* luma, const uint8_t* threshold);
+
+    /// Stores the same 8 pixels `bits` to every byte of pixels xs ~ xe of a row.
+    void fill_row(uint8_t* row, uint32_t xs, uint32_t xe, uint8_t bits);
+
+    /// Converts pixels xs ~ xe of a row to 4bit gray, min(15, (R + 2G + B + threshold[x & 3]) / 64),
+    /// and packs them 2 pixels per byte, first pixel in the high nibble. ( the 4bpp image format of IT8951 )
+    /// The data covers whole groups of 4 pixels, from xs & ~3 to xe | 3; the pixels outside xs ~ xe are 0.
+    /// binary : 15 when R + 2G + B + threshold * 16 is 512 or more, otherwise 0. ( for the fast waveforms )
+    /// invert : all bits of the result are inverted.
+    /// Returns the number of bytes stored.
+    uint32_t pack_gray4(uint8_t* dst, const bgr888_t* src, uint32_t xs, uint32_t xe, const int8_t* threshold, bool binary, bool invert);
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
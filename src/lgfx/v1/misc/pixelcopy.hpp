@@ -20,6 +20,7 @@ Contributors:
 #include <string.h>
 
 #include "colortype.hpp"
+#include "pixelcopy_simd.hpp"
 
 namespace lgfx
 {
@@ -167,6 +168,10 @@ namespace lgfx
       }
       else
       {
+#if LGFX_PIXELCOPY_SIMD
+        index += simd::copy_rgb(&d[index], &s[index], last - index);
+        if (index == last) { return last; }
+#endif
         do {
           d[index].set(color_convert<TDst, TSrc>(s[index].get()));
         } while (++index != last);
@@ -456,6 +461,15 @@ namespace lgfx
       auto src_x32_add = param->src_x32_add;
       auto src_y32_add = param->src_y32_add;
       auto s = static_cast<const argb8888_t*>(param->src_data);
+#if LGFX_PIXELCOPY_SIMD
+      if (src_y32_add == 0 && src_x32_add == (1 << FP_SCALE))
+      {
+        uint32_t len = simd::blend_rgb(&d[index], &s[param->src_x + param->src_y * param->src_bitwidth], last - index);
+        param->src_x32 += len << FP_SCALE;
+        index += len;
+        if (index == last) { return last; }
+      }
+#endif
       for (;;) {
         uint32_t i = param->src_x + param->src_y * param->src_bitwidth;
         uint_fast16_t a = s[i].a;
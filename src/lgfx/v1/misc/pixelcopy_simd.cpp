@@ -0,0 +1,541 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+
+#include "pixelcopy_simd.hpp"
+
+#if LGFX_PIXELCOPY_SIMD
+
+#if defined ( __SSE2__ )
+ #define LGFX_SIMD_X86
+ #include <immintrin.h>
+#else
+ #include <arm_neon.h>
+#endif
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+  namespace simd
+  {
+//----------------------------------------------------------------------------
+
+    static simd_level_t detect_level(void)
+    {
+#if defined ( LGFX_SIMD_X86 )
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))  { return level_avx2; }
+      if (__builtin_cpu_supports("ssse3")) { return level_ssse3; }
+      return level_sse2;
+#else
+      return level_neon;
+#endif
+    }
+
+    static simd_level_t supported_level(void)
+    {
+      static const simd_level_t level = detect_level();
+      return level;
+    }
+
+    static simd_level_t& current_level(void)
+    {
+      static simd_level_t level = supported_level();
+      return level;
+    }
+
+    simd_level_t get_level(void)
+    {
+      return current_level();
+    }
+
+    simd_level_t set_level(simd_level_t level)
+    {
+      auto supported = supported_level();
+      if (level > supported) { level = supported; }
+#if defined ( LGFX_SIMD_X86 )
+      if (level == level_neon) { level = supported; }
+#else
+      if (level != level_none) { level = supported; }
+#endif
+      current_level() = level;
+      return level;
+    }
+
+    const char* get_level_name(simd_level_t level)
+    {
+      switch (level)
+      {
+      case level_sse2:  return "SSE2";
+      case level_ssse3: return "SSSE3";
+      case level_avx2:  return "AVX2";
+      case level_neon:  return "NEON";
+      default:          return "none";
+      }
+    }
+
+#if defined ( LGFX_SIMD_X86 )
+//----------------------------------------------------------------------------
+// x86 : SSE2 / SSSE3 / AVX2
+
+    /// swapped rgb565 (big endian) <-> native rgb565.
+    static inline __m128i swap16(__m128i v)
+    {
+      return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+
+    /// 8bit channels (in 16bit lanes) -> swapped rgb565.
+    static inline __m128i pack_swap565(__m128i r, __m128i g, __m128i b)
+    {
+      __m128i v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(r, _mm_set1_epi16(0xF8)), 8)
+                , _mm_or_si128(_mm_slli_epi16(_mm_and_si128(g, _mm_set1_epi16(0xFC)), 3)
+                             , _mm_srli_epi16(b, 3)));
+      return swap16(v);
+    }
+
+    static inline __m128i rgb332_to_swap565(__m128i c)
+    {
+      __m128i r = _mm_and_si128(_mm_srli_epi16(c, 5), _mm_set1_epi16(7));
+      __m128i g = _mm_and_si128(_mm_srli_epi16(c, 2), _mm_set1_epi16(7));
+      __m128i b = _mm_and_si128(c, _mm_set1_epi16(3));
+      r = _mm_or_si128(_mm_slli_epi16(r, 2), _mm_srli_epi16(r, 1));
+      g = _mm_or_si128(_mm_slli_epi16(g, 3), g);
+      b = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(b, 3), _mm_slli_epi16(b, 1)), _mm_srli_epi16(b, 1));
+      return swap16(_mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 11), _mm_slli_epi16(g, 5)), b));
+    }
+
+    /// Store 8 pixels of 8bit r|g<<8 and b (16bit lanes) as 24 bytes of bgr888.
+    __attribute__((target("ssse3")))
+    static inline void store_bgr888_x8(uint8_t* d, __m128i rg, __m128i b)
+    {
+      const __m128i pack24 = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+      __m128i lo = _mm_shuffle_epi8(_mm_unpacklo_epi16(rg, b), pack24);
+      __m128i hi = _mm_shuffle_epi8(_mm_unpackhi_epi16(rg, b), pack24);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d), _mm_or_si128(lo, _mm_slli_si128(hi, 12)));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(d + 16), _mm_srli_si128(hi, 4));
+    }
+
+    /// bgr888 in 32bit lanes -> native rgb565 in 32bit lanes.
+    static inline __m128i bgr888_to_rgb565_epi32(__m128i x)
+    {
+      return _mm_or_si128(_mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xF8)), 8)
+           , _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 5), _mm_set1_epi32(0x7E0))
+                        , _mm_and_si128(_mm_srli_epi32(x, 19), _mm_set1_epi32(0x1F))));
+    }
+
+    static inline __m128i blend_swap565_x8(__m128i dst, __m128i s0, __m128i s1)
+    {
+      const __m128i m8 = _mm_set1_epi32(0xFF);
+      __m128i b = _mm_packs_epi32(_mm_and_si128(s0, m8), _mm_and_si128(s1, m8));
+      __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0,  8), m8), _mm_and_si128(_mm_srli_epi32(s1,  8), m8));
+      __m128i r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 16), m8), _mm_and_si128(_mm_srli_epi32(s1, 16), m8));
+      __m128i a = _mm_packs_epi32(_mm_srli_epi32(s0, 24), _mm_srli_epi32(s1, 24));
+
+      __m128i v = swap16(dst);
+      __m128i dr = _mm_srli_epi16(v, 11);
+      __m128i dg = _mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3F));
+      __m128i db = _mm_and_si128(v, _mm_set1_epi16(0x1F));
+      dr = _mm_or_si128(_mm_slli_epi16(dr, 3), _mm_srli_epi16(dr, 2));
+      dg = _mm_or_si128(_mm_slli_epi16(dg, 2), _mm_srli_epi16(dg, 4));
+      db = _mm_or_si128(_mm_slli_epi16(db, 3), _mm_srli_epi16(db, 2));
+
+      // inv + a1 == 257, so the weighted sum never exceeds 255 * 257 and fits in 16 bits.
+      // a == 0 and a == 255 produce the same result as the scalar early-outs.
+      __m128i inv = _mm_sub_epi16(_mm_set1_epi16(256), a);
+      __m128i a1 = _mm_add_epi16(a, _mm_set1_epi16(1));
+      r = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(dr, inv), _mm_mullo_epi16(r, a1)), 8);
+      g = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(dg, inv), _mm_mullo_epi16(g, a1)), 8);
+      b = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(db, inv), _mm_mullo_epi16(b, a1)), 8);
+      return pack_swap565(r, g, b);
+    }
+
+    __attribute__((target("ssse3")))
+    static uint32_t copy_swap565_to_bgr888_ssse3(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        __m128i v = swap16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i * 2])));
+        __m128i r = _mm_srli_epi16(v, 11);
+        __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3F));
+        __m128i b = _mm_and_si128(v, _mm_set1_epi16(0x1F));
+        r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        store_bgr888_x8(&d[i * 3], _mm_or_si128(r, _mm_slli_epi16(g, 8)), b);
+      }
+      return i;
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t copy_swap565_to_bgr888_avx2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 16 <= length; i += 16)
+      {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[i * 2]));
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+        __m256i r = _mm256_srli_epi16(v, 11);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(v, 5), _mm256_set1_epi16(0x3F));
+        __m256i b = _mm256_and_si256(v, _mm256_set1_epi16(0x1F));
+        r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+        g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+        b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+        __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+        store_bgr888_x8(&d[i * 3     ], _mm256_castsi256_si128(rg), _mm256_castsi256_si128(b));
+        store_bgr888_x8(&d[i * 3 + 24], _mm256_extracti128_si256(rg, 1), _mm256_extracti128_si256(b, 1));
+      }
+      return i;
+    }
+
+    __attribute__((target("ssse3")))
+    static uint32_t copy_bgr888_to_swap565_ssse3(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+      const __m128i pack16 = _mm_setr_epi8(1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1);
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i * 3]));
+        __m128i hi = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&s[i * 3 + 16]));
+        __m128i p0 = bgr888_to_rgb565_epi32(_mm_shuffle_epi8(lo, expand));
+        __m128i p1 = bgr888_to_rgb565_epi32(_mm_shuffle_epi8(_mm_alignr_epi8(hi, lo, 12), expand));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&d[i * 2])
+                        , _mm_unpacklo_epi64(_mm_shuffle_epi8(p0, pack16), _mm_shuffle_epi8(p1, pack16)));
+      }
+      return i;
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t copy_bgr888_to_swap565_avx2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      const __m256i expand = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+                                             , 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+      const __m256i pack16 = _mm256_setr_epi8(1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1
+                                             , 1, 0, 5, 4, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1);
+      const __m256i m8 = _mm256_set1_epi32(0xF8);
+      const __m256i m6 = _mm256_set1_epi32(0x7E0);
+      const __m256i m5 = _mm256_set1_epi32(0x1F);
+      uint32_t i = 0;
+      // Each 8 pixel half reads 4 bytes past its 24 bytes, so keep 2 pixels of slack at the end.
+      for (; i + 18 <= length; i += 16)
+      {
+        __m256i v[2];
+        for (int j = 0; j < 2; ++j)
+        {
+          auto src = &s[(i + j * 8) * 3];
+          __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)))
+                                             , _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 12)), 1);
+          x = _mm256_shuffle_epi8(x, expand);
+          x = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(x, m8), 8)
+            , _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 5), m6)
+                            , _mm256_and_si256(_mm256_srli_epi32(x, 19), m5)));
+          v[j] = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, pack16), 0x08);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&d[i * 2]), _mm256_permute2x128_si256(v[0], v[1], 0x20));
+      }
+      return i;
+    }
+
+    static uint32_t copy_rgb332_to_swap565_sse2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      uint32_t i = 0;
+      for (; i + 16 <= length; i += 16)
+      {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&d[i * 2     ]), rgb332_to_swap565(_mm_unpacklo_epi8(v, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&d[i * 2 + 16]), rgb332_to_swap565(_mm_unpackhi_epi8(v, zero)));
+      }
+      return i;
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t copy_rgb332_to_swap565_avx2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      const __m256i m7 = _mm256_set1_epi16(7);
+      const __m256i m3 = _mm256_set1_epi16(3);
+      uint32_t i = 0;
+      for (; i + 16 <= length; i += 16)
+      {
+        __m256i c = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i])));
+        __m256i r = _mm256_and_si256(_mm256_srli_epi16(c, 5), m7);
+        __m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 2), m7);
+        __m256i b = _mm256_and_si256(c, m3);
+        r = _mm256_or_si256(_mm256_slli_epi16(r, 2), _mm256_srli_epi16(r, 1));
+        g = _mm256_or_si256(_mm256_slli_epi16(g, 3), g);
+        b = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_slli_epi16(b, 1)), _mm256_srli_epi16(b, 1));
+        __m256i v = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(r, 11), _mm256_slli_epi16(g, 5)), b);
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&d[i * 2]), v);
+      }
+      return i;
+    }
+
+    static uint32_t blend_argb8888_to_swap565_sse2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        __m128i s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i * 4     ]));
+        __m128i s1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&s[i * 4 + 16]));
+        auto dst = reinterpret_cast<__m128i*>(&d[i * 2]);
+        _mm_storeu_si128(dst, blend_swap565_x8(_mm_loadu_si128(dst), s0, s1));
+      }
+      return i;
+    }
+
+    __attribute__((target("avx2")))
+    static uint32_t blend_argb8888_to_swap565_avx2(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      const __m256i m8 = _mm256_set1_epi32(0xFF);
+      const __m256i m6 = _mm256_set1_epi16(0x3F);
+      const __m256i m5 = _mm256_set1_epi16(0x1F);
+      uint32_t i = 0;
+      for (; i + 16 <= length; i += 16)
+      {
+        __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[i * 4     ]));
+        __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&s[i * 4 + 32]));
+        // packs works per 128bit lane; permute restores the pixel order.
+        __m256i b = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(s0, m8), _mm256_and_si256(s1, m8)), 0xD8);
+        __m256i g = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0,  8), m8), _mm256_and_si256(_mm256_srli_epi32(s1,  8), m8)), 0xD8);
+        __m256i r = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0, 16), m8), _mm256_and_si256(_mm256_srli_epi32(s1, 16), m8)), 0xD8);
+        __m256i a = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_srli_epi32(s0, 24), _mm256_srli_epi32(s1, 24)), 0xD8);
+
+        auto dst = reinterpret_cast<__m256i*>(&d[i * 2]);
+        __m256i v = _mm256_loadu_si256(dst);
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+        __m256i dr = _mm256_srli_epi16(v, 11);
+        __m256i dg = _mm256_and_si256(_mm256_srli_epi16(v, 5), m6);
+        __m256i db = _mm256_and_si256(v, m5);
+        dr = _mm256_or_si256(_mm256_slli_epi16(dr, 3), _mm256_srli_epi16(dr, 2));
+        dg = _mm256_or_si256(_mm256_slli_epi16(dg, 2), _mm256_srli_epi16(dg, 4));
+        db = _mm256_or_si256(_mm256_slli_epi16(db, 3), _mm256_srli_epi16(db, 2));
+
+        __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(256), a);
+        __m256i a1 = _mm256_add_epi16(a, _mm256_set1_epi16(1));
+        r = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(dr, inv), _mm256_mullo_epi16(r, a1)), 8);
+        g = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(dg, inv), _mm256_mullo_epi16(g, a1)), 8);
+        b = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(db, inv), _mm256_mullo_epi16(b, a1)), 8);
+
+        v = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(r, _mm256_set1_epi16(0xF8)), 8)
+          , _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(g, _mm256_set1_epi16(0xFC)), 3)
+                          , _mm256_srli_epi16(b, 3)));
+        _mm256_storeu_si256(dst, _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8)));
+      }
+      return i;
+    }
+
+#else
+//----------------------------------------------------------------------------
+// ARM : NEON
+
+    static inline uint16x8_t rgb332_to_swap565(uint16x8_t c)
+    {
+      uint16x8_t r = vandq_u16(vshrq_n_u16(c, 5), vdupq_n_u16(7));
+      uint16x8_t g = vandq_u16(vshrq_n_u16(c, 2), vdupq_n_u16(7));
+      uint16x8_t b = vandq_u16(c, vdupq_n_u16(3));
+      r = vorrq_u16(vshlq_n_u16(r, 2), vshrq_n_u16(r, 1));
+      g = vorrq_u16(vshlq_n_u16(g, 3), g);
+      b = vorrq_u16(vorrq_u16(vshlq_n_u16(b, 3), vshlq_n_u16(b, 1)), vshrq_n_u16(b, 1));
+      uint16x8_t v = vorrq_u16(vorrq_u16(vshlq_n_u16(r, 11), vshlq_n_u16(g, 5)), b);
+      return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+    }
+
+    static inline uint8x16_t pack_swap565(uint16x8_t r, uint16x8_t g, uint16x8_t b)
+    {
+      uint16x8_t v = vorrq_u16(vshlq_n_u16(vandq_u16(r, vdupq_n_u16(0xF8)), 8)
+                   , vorrq_u16(vshlq_n_u16(vandq_u16(g, vdupq_n_u16(0xFC)), 3)
+                             , vshrq_n_u16(b, 3)));
+      return vrev16q_u8(vreinterpretq_u8_u16(v));
+    }
+
+    static uint32_t copy_swap565_to_bgr888_neon(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        uint16x8_t v = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(&s[i * 2])));
+        uint16x8_t r = vshrq_n_u16(v, 11);
+        uint16x8_t g = vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(0x3F));
+        uint16x8_t b = vandq_u16(v, vdupq_n_u16(0x1F));
+        uint8x8x3_t out;
+        out.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+        out.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+        out.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+        vst3_u8(&d[i * 3], out);
+      }
+      return i;
+    }
+
+    static uint32_t copy_bgr888_to_swap565_neon(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        uint8x8x3_t in = vld3_u8(&s[i * 3]);
+        vst1q_u8(&d[i * 2], pack_swap565(vmovl_u8(in.val[0]), vmovl_u8(in.val[1]), vmovl_u8(in.val[2])));
+      }
+      return i;
+    }
+
+    static uint32_t copy_rgb332_to_swap565_neon(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 16 <= length; i += 16)
+      {
+        uint8x16_t v = vld1q_u8(&s[i]);
+        vst1q_u8(&d[i * 2     ], vreinterpretq_u8_u16(rgb332_to_swap565(vmovl_u8(vget_low_u8(v)))));
+        vst1q_u8(&d[i * 2 + 16], vreinterpretq_u8_u16(rgb332_to_swap565(vmovl_u8(vget_high_u8(v)))));
+      }
+      return i;
+    }
+
+    static uint32_t blend_argb8888_to_swap565_neon(uint8_t* d, const uint8_t* s, uint32_t length)
+    {
+      uint32_t i = 0;
+      for (; i + 8 <= length; i += 8)
+      {
+        uint8x8x4_t src = vld4_u8(&s[i * 4]);  // b, g, r, a
+        uint16x8_t a = vmovl_u8(src.val[3]);
+
+        uint16x8_t v = vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(&d[i * 2])));
+        uint16x8_t dr = vshrq_n_u16(v, 11);
+        uint16x8_t dg = vandq_u16(vshrq_n_u16(v, 5), vdupq_n_u16(0x3F));
+        uint16x8_t db = vandq_u16(v, vdupq_n_u16(0x1F));
+        dr = vorrq_u16(vshlq_n_u16(dr, 3), vshrq_n_u16(dr, 2));
+        dg = vorrq_u16(vshlq_n_u16(dg, 2), vshrq_n_u16(dg, 4));
+        db = vorrq_u16(vshlq_n_u16(db, 3), vshrq_n_u16(db, 2));
+
+        uint16x8_t inv = vsubq_u16(vdupq_n_u16(256), a);
+        uint16x8_t a1 = vaddq_u16(a, vdupq_n_u16(1));
+        uint16x8_t r = vshrq_n_u16(vmlaq_u16(vmulq_u16(dr, inv), vmovl_u8(src.val[2]), a1), 8);
+        uint16x8_t g = vshrq_n_u16(vmlaq_u16(vmulq_u16(dg, inv), vmovl_u8(src.val[1]), a1), 8);
+        uint16x8_t b = vshrq_n_u16(vmlaq_u16(vmulq_u16(db, inv), vmovl_u8(src.val[0]), a1), 8);
+        vst1q_u8(&d[i * 2], pack_swap565(r, g, b));
+      }
+      return i;
+    }
+
+#endif
+
+//----------------------------------------------------------------------------
+
+    uint32_t copy_rgb(bgr888_t* dst, const swap565_t* src, uint32_t length)
+    {
+      auto d = reinterpret_cast<uint8_t*>(dst);
+      auto s = reinterpret_cast<const uint8_t*>(src);
+      switch (current_level())
+      {
+#if defined ( LGFX_SIMD_X86 )
+      case level_avx2:
+        {
+          uint32_t i = copy_swap565_to_bgr888_avx2(d, s, length);
+          return i + copy_swap565_to_bgr888_ssse3(&d[i * 3], &s[i * 2], length - i);
+        }
+      case level_ssse3: return copy_swap565_to_bgr888_ssse3(d, s, length);
+#else
+      case level_neon:  return copy_swap565_to_bgr888_neon(d, s, length);
+#endif
+      default: return 0;
+      }
+    }
+
+    uint32_t copy_rgb(swap565_t* dst, const bgr888_t* src, uint32_t length)
+    {
+      auto d = reinterpret_cast<uint8_t*>(dst);
+      auto s = reinterpret_cast<const uint8_t*>(src);
+      switch (current_level())
+      {
+#if defined ( LGFX_SIMD_X86 )
+      case level_avx2:
+        {
+          uint32_t i = copy_bgr888_to_swap565_avx2(d, s, length);
+          return i + copy_bgr888_to_swap565_ssse3(&d[i * 2], &s[i * 3], length - i);
+        }
+      case level_ssse3: return copy_bgr888_to_swap565_ssse3(d, s, length);
+#else
+      case level_neon:  return copy_bgr888_to_swap565_neon(d, s, length);
+#endif
+      default: return 0;
+      }
+    }
+
+    uint32_t copy_rgb(swap565_t* dst, const rgb332_t* src, uint32_t length)
+    {
+      auto d = reinterpret_cast<uint8_t*>(dst);
+      auto s = reinterpret_cast<const uint8_t*>(src);
+      switch (current_level())
+      {
+#if defined ( LGFX_SIMD_X86 )
+      case level_avx2:
+        {
+          uint32_t i = copy_rgb332_to_swap565_avx2(d, s, length);
+          return i + copy_rgb332_to_swap565_sse2(&d[i * 2], &s[i], length - i);
+        }
+      case level_ssse3:
+      case level_sse2:  return copy_rgb332_to_swap565_sse2(d, s, length);
+#else
+      case level_neon:  return copy_rgb332_to_swap565_neon(d, s, length);
+#endif
+      default: return 0;
+      }
+    }
+
+    uint32_t blend_rgb(swap565_t* dst, const argb8888_t* src, uint32_t length)
+    {
+      auto d = reinterpret_cast<uint8_t*>(dst);
+      auto s = reinterpret_cast<const uint8_t*>(src);
+      switch (current_level())
+      {
+#if defined ( LGFX_SIMD_X86 )
+      case level_avx2:
+        {
+          uint32_t i = blend_argb8888_to_swap565_avx2(d, s, length);
+          return i + blend_argb8888_to_swap565_sse2(&d[i * 2], &s[i * 4], length - i);
+        }
+      case level_ssse3:
+      case level_sse2:  return blend_argb8888_to_swap565_sse2(d, s, length);
+#else
+      case level_neon:  return blend_argb8888_to_swap565_neon(d, s, length);
+#endif
+      default: return 0;
+      }
+    }
+
+//----------------------------------------------------------------------------
+  }
+ }
+}
+
+#else
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+  namespace simd
+  {
+    simd_level_t get_level(void) { return level_none; }
+    simd_level_t set_level(simd_level_t) { return level_none; }
+    const char* get_level_name(simd_level_t) { return "none"; }
+  }
+ }
+}
+
+#endif
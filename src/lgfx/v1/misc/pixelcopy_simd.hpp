@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include "colortype.hpp"
+
+/// Vectorized color conversion kernels for host builds (SDL / Linux framebuffer).
+/// Enabled for GCC/Clang on x86 (SSE2 baseline, SSSE3/AVX2 chosen at runtime) and ARM with NEON.
+/// Define LGFX_PIXELCOPY_SIMD to 0 to force the scalar templates.
+#if !defined ( LGFX_PIXELCOPY_SIMD )
+ #if ( defined ( __GNUC__ ) || defined ( __clang__ ) ) && !defined ( ESP_PLATFORM ) \
+  && ( defined ( __SSE2__ ) || defined ( __ARM_NEON ) || defined ( __ARM_NEON__ ) )
+  #define LGFX_PIXELCOPY_SIMD 1
+ #else
+  #define LGFX_PIXELCOPY_SIMD 0
+ #endif
+#endif
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  namespace simd
+  {
+    enum simd_level_t : uint8_t
+    { level_none
+    , level_sse2
+    , level_ssse3
+    , level_avx2
+    , level_neon
+    , level_max = 0xFF
+    };
+
+    /// Returns the instruction set currently used by the kernels.
+    simd_level_t get_level(void);
+
+    /// Limits the instruction set used by the kernels (level_none forces the scalar path).
+    /// The level is clamped to what the running CPU supports. Returns the level in effect.
+    simd_level_t set_level(simd_level_t level);
+
+    const char* get_level_name(simd_level_t level);
+
+    /// Each kernel converts as many leading pixels as its vector width allows and returns that count.
+    /// The caller converts the remaining tail with the scalar code.
+    template <typename TDst, typename TSrc>
+    inline uint32_t copy_rgb(TDst*, const TSrc*, uint32_t) { return 0; }
+
+    template <typename TDst>
+    inline uint32_t blend_rgb(TDst*, const argb8888_t*, uint32_t) { return 0; }
+
+#if LGFX_PIXELCOPY_SIMD
+    uint32_t copy_rgb(bgr888_t*  dst, const swap565_t* src, uint32_t length);
+    uint32_t copy_rgb(swap565_t* dst, const bgr888_t*  src, uint32_t length);
+    uint32_t copy_rgb(swap565_t* dst, const rgb332_t*  src, uint32_t length);
+    uint32_t blend_rgb(swap565_t* dst, const argb8888_t* src, uint32_t length);
+#endif
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
@@ -0,0 +1,214 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#include "rle.hpp"
+
+#include <string.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+  namespace rle
+  {
+//----------------------------------------------------------------------------
+
+    static constexpr uint32_t max_count = 255;
+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+    typedef uint64_t word_t;
+#else
+    typedef uint32_t word_t;
+#endif
+
+    static inline word_t load_word(const uint8_t* p)
+    {
+      word_t w;
+      memcpy(&w, p, sizeof(word_t));
+      return w;
+    }
+
+    /// Offset in memory of the first non zero byte of a non zero word.
+    static inline uint32_t first_byte(word_t x)
+    {
+#if defined ( __GNUC__ ) || defined ( __clang__ )
+ #if defined ( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ )
+      return (sizeof(word_t) == 8 ? __builtin_clzll(x) : __builtin_clz((uint32_t)x)) >> 3;
+ #else
+      return (sizeof(word_t) == 8 ? __builtin_ctzll(x) : __builtin_ctz((uint32_t)x)) >> 3;
+ #endif
+#else
+      uint8_t b[sizeof(word_t)];
+      memcpy(b, &x, sizeof(word_t));
+      uint32_t i = 0;
+      while (b[i] == 0) { ++i; }
+      return i;
+#endif
+    }
+
+    template <size_t Bytes>
+    static inline bool equal(const uint8_t* a, const uint8_t* b)
+    {
+      return memcmp(a, b, Bytes) == 0;
+    }
+
+    /// Number of pixels from p that are equal to p[0], up to max.
+    /// Compares p[k + Bytes] with p[k] a word at a time; the first differing byte ends the run.
+    template <size_t Bytes>
+    static uint32_t run_length(const uint8_t* p, uint32_t max)
+    {
+      size_t n = (max - 1) * Bytes;
+      auto a = p;
+      auto b = p + Bytes;
+      size_t k = 0;
+      for (; k + sizeof(word_t) <= n; k += sizeof(word_t))
+      {
+        word_t x = load_word(a + k) ^ load_word(b + k);
+        if (x) { return 1 + (k + first_byte(x)) / Bytes; }
+      }
+      for (; k < n; ++k)
+      {
+        if (a[k] != b[k]) { return 1 + k / Bytes; }
+      }
+      return max;
+    }
+
+    /// Number of pixels from p up to the next pair of equal pixels, at most max.
+    /// p[0] is always included. `avail` is the number of pixels readable from p.
+    template <size_t Bytes>
+    static uint32_t literal_length(const uint8_t* p, uint32_t max, uint32_t avail)
+    {
+      uint32_t lim = max < avail ? max : avail - 1;  // pixel j is compared with pixel j + 1 for 1 <= j < lim.
+      if (lim < 2) { return max; }
+      size_t n = (lim - 1) * Bytes;
+      auto a = p + Bytes;
+      auto b = p + Bytes * 2;
+      size_t k = 0;
+      if (Bytes != 3)
+      { // a zero lane of (a ^ b) is a pair of equal pixels. (lane = 1 pixel)
+        static constexpr word_t ones  = ~(word_t)0 / (word_t)((1ull << (Bytes * 8)) - 1);
+        static constexpr word_t highs = ones << (Bytes * 8 - 1);
+        for (; k + sizeof(word_t) <= n; k += sizeof(word_t))
+        {
+          word_t x = load_word(a + k) ^ load_word(b + k);
+          word_t z = (x - ones) & ~x & highs;
+          if (z) { return 1 + (k + first_byte(z)) / Bytes; }
+        }
+      }
+      for (; k < n; k += Bytes)
+      {
+        if (equal<Bytes>(a + k, b + k)) { return 1 + k / Bytes; }
+      }
+      return max;
+    }
+
+    template <size_t Bytes>
+    static size_t encode_impl(uint8_t* dst, const uint8_t* src, uint32_t length, size_t limit)
+    {
+      size_t pos = 0;
+      uint32_t i = 0;
+      while (i < length)
+      {
+        auto p = &src[i * Bytes];
+        uint32_t avail = length - i;
+        uint32_t max = avail < max_count ? avail : max_count;
+        uint32_t len = (max > 1) ? run_length<Bytes>(p, max) : 1;
+        if (len == 1)
+        {
+          len = literal_length<Bytes>(p, max, avail);
+          if (len >= 3)
+          { // absolute mode
+            size_t size = 2 + len * Bytes;
+            if (limit - pos < size) { return 0; }
+            // the pixels are moved before the header is written, dst may overlap src. ( see encode_margin )
+            memmove(&dst[pos + 2], p, len * Bytes);
+            dst[pos    ] = 0;
+            dst[pos + 1] = len;
+            pos += size;
+            i += len;
+            continue;
+          }
+          len = 1;
+        }
+        if (limit - pos < 1 + Bytes) { return 0; }
+        memmove(&dst[pos + 1], p, Bytes);
+        dst[pos] = len;
+        pos += 1 + Bytes;
+        i += len;
+      }
+      return pos;
+    }
+
+    size_t encode(uint8_t* dst, const uint8_t* src, uint32_t length, uint_fast8_t bytes, size_t limit)
+    {
+      switch (bytes)
+      {
+      case 1:  return encode_impl<1>(dst, src, length, limit);
+      case 2:  return encode_impl<2>(dst, src, length, limit);
+      case 3:  return encode_impl<3>(dst, src, length, limit);
+      case 4:  return encode_impl<4>(dst, src, length, limit);
+      default: return 0;
+      }
+    }
+
+    /// Repeats the first pixel of dst to `count` pixels, doubling the copied block each time.
+    static void fill_pixels(uint8_t* dst, uint32_t count, uint_fast8_t bytes)
+    {
+      size_t total = count * bytes;
+      size_t done = bytes;
+      while (done < total)
+      {
+        size_t len = (done < total - done) ? done : total - done;
+        memcpy(&dst[done], dst, len);
+        done += len;
+      }
+    }
+
+    uint32_t decode(uint8_t* dst, uint32_t length, const uint8_t* src, size_t srclen, uint_fast8_t bytes, size_t* used)
+    {
+      size_t s = 0;
+      uint32_t n = 0;
+      while (s < srclen && n < length)
+      {
+        uint32_t count = src[s];
+        if (count)
+        {
+          if (srclen - s < 1u + bytes || length - n < count) { break; }
+          auto d = &dst[n * bytes];
+          memcpy(d, &src[s + 1], bytes);
+          fill_pixels(d, count, bytes);
+          s += 1 + bytes;
+        }
+        else
+        {
+          if (srclen - s < 2) { break; }
+          count = src[s + 1];
+          size_t size = count * bytes;
+          if (srclen - s - 2 < size || length - n < count) { break; }
+          memcpy(&dst[n * bytes], &src[s + 2], size);
+          s += 2 + size;
+        }
+        n += count;
+      }
+      if (used) { *used = s; }
+      return n;
+    }
+
+//----------------------------------------------------------------------------
+  }
+ }
+}
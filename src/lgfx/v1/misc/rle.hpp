@@ -0,0 +1,65 @@
+/*----------------------------------------------------------------------------/
+  Lovyan GFX - Graphics library for embedded devices.
+
+Original Source:
+ https://github.com/lovyan03/LovyanGFX/
+
+Licence:
+ [BSD](https://github.com/lovyan03/LovyanGFX/blob/master/license.txt)
+
+Author:
+ [lovyan03](https://twitter.com/lovyan03)
+
+Contributors:
+ [ciniml](https://github.com/ciniml)
+ [mongonta0716](https://github.com/mongonta0716)
+ [tobozo](https://github.com/tobozo)
+/----------------------------------------------------------------------------*/
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lgfx
+{
+ inline namespace v1
+ {
+//----------------------------------------------------------------------------
+
+  /// Run length coding of the pixel data of CMD_WRITE_RLE_* ( Panel_M5UnitLCD, Panel_M5HDMI ).
+  ///
+  /// 符号の形式 (BMPのRLEに近い);
+  ///   [1~255][pixel]            : 同じ画素が 1~255 個続く;
+  ///   [0][3~255][pixel x n]     : 絶対モード、続く n 個の画素をそのまま並べる;
+  /// 絶対モードの長さ 0~2 は予約されているため、2 画素以下の非連続部分は長さ 1 のランとして送る;
+  /// 画素は 1~4 バイトで、バイト列の並びは問わない;
+  namespace rle
+  {
+    /// Largest size of the encoded data of `length` pixels.
+    constexpr size_t encode_bound(uint32_t length, uint_fast8_t bytes)
+    {
+      return (size_t)length * (1 + bytes);
+    }
+
+    /// How far the encoded data can run ahead of the pixels it has read.
+    /// encode() works in place when src is placed at least this many bytes after dst.
+    constexpr size_t encode_margin(uint32_t length, uint_fast8_t bytes)
+    {
+      return 2 + ( bytes == 1 ? (length >> 1)
+                 : bytes == 2 ? (length >> 2)
+                 : (length / 255) * 2);
+    }
+
+    /// Encodes `length` pixels of `bytes` (1~4) bytes each.
+    /// Returns the size of the encoded data, or 0 if it would exceed `limit` bytes.
+    size_t encode(uint8_t* dst, const uint8_t* src, uint32_t length, uint_fast8_t bytes, size_t limit = ~(size_t)0);
+
+    /// Decodes up to `length` pixels into dst and returns the number of pixels stored.
+    /// Stops before a record that is cut off at the end of src or does not fit in dst.
+    /// The number of bytes of src consumed is stored to `used` when it is not nullptr.
+    uint32_t decode(uint8_t* dst, uint32_t length, const uint8_t* src, size_t srclen, uint_fast8_t bytes, size_t* used = nullptr);
+  }
+
+//----------------------------------------------------------------------------
+ }
+}
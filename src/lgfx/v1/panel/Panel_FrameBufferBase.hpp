@@ -46,6 +46,7 @@ namespace lgfx
     void setPowerSave(bool flg) override {}
 
     void display(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h) override {}
+    bool isMemoryBacked(void) const override { return true; }
 
     void setWindow(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye) override;
     void drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor) override;
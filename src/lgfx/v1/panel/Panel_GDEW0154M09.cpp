@@ -20,6 +20,10 @@ Contributors:
 #include "../platforms/common.hpp"
 #include "../misc/pixelcopy.hpp"
 #include "../misc/colortype.hpp"
+#include "../misc/dither.hpp"
+
+#include <string.h>
+#include <algorithm>
 
 #ifdef min
 #undef min
@@ -195,31 +199,53 @@ namespace lgfx
     color.raw = rawcolor;
     uint32_t value = (color.R8() + (color.G8() << 1) + color.B8()) >> 2;
 
+    uint32_t stride = ((_cfg.panel_width + 7) & ~7) >> 3;
     y = ys;
     do
-    {
-      x = xs;
-      uint32_t idx = ((_cfg.panel_width + 7) & ~7) * y + x;
+    { // the dither matrix is 4 pixels wide, so every byte of a row gets the same bits.
       auto btbl = &Bayer[(y & 3) << 2];
-      do
+      uint_fast8_t bits = 0;
+      for (uint_fast8_t k = 0; k < 8; ++k)
       {
-        bool flg = 256 <= value + btbl[x & 3];
-        if (flg) _buf[idx >> 3] |=   0x80 >> (idx & 7);
-        else     _buf[idx >> 3] &= ~(0x80 >> (idx & 7));
-        ++idx;
-      } while (++x <= xe);
+        bits = bits << 1 | ((value + btbl[k & 3]) >> 8);
+      }
+      dither::fill_row(&_buf[y * stride], xs, xe, bits);
     } while (++y <= ye);
   }
 
   void Panel_GDEW0154M09::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
   {
-    uint_fast16_t xs = x, xe = x + w - 1;
-    uint_fast16_t ys = y, ye = y + h - 1;
-    _update_transferred_rect(xs, ys, xe, ye);
+    {
+      uint_fast16_t xs = x, xe = x + w - 1;
+      uint_fast16_t ys = y, ye = y + h - 1;
+      _update_transferred_rect(xs, ys, xe, ye);
+    }
 
     auto readbuf = (swap565_t*)alloca(w * sizeof(swap565_t));
+    auto luma = (uint8_t*)alloca(w);
     auto sx = param->src_x32;
     h += y;
+
+    if (param->transp == pixelcopy_t::NON_TRANSP)
+    {
+      int16_t* error = nullptr;
+      if (_error_diffusion)
+      {
+        error = (int16_t*)alloca((w + 1) * sizeof(int16_t));
+        memset(error, 0, (w + 1) * sizeof(int16_t));
+      }
+      do
+      {
+        param->fp_copy(readbuf, 0, w, param);
+        dither::luma(luma, readbuf, w);
+        if (error) { dither::error_diffusion(luma, error, w); }
+        _draw_row(x, y, w, luma, error != nullptr);
+        param->src_x32 = sx;
+        param->src_y++;
+      } while (++y < h);
+      return;
+    }
+
     do
     {
       uint32_t prev_pos = 0, new_pos = 0;
@@ -228,11 +254,8 @@ namespace lgfx
         new_pos = param->fp_copy(readbuf, prev_pos, w, param);
         if (new_pos != prev_pos)
         {
-          do
-          {
-            auto color = readbuf[prev_pos];
-            _draw_pixel(x + prev_pos, y, (color.R8() + (color.G8() << 1) + color.B8()) >> 2);
-          } while (new_pos != ++prev_pos);
+          dither::luma(luma, &readbuf[prev_pos], new_pos - prev_pos);
+          _draw_row(x + prev_pos, y, new_pos - prev_pos, luma);
         }
       } while (w != new_pos && w != (prev_pos = param->fp_skip(new_pos, w, param)));
       param->src_x32 = sx;
@@ -256,18 +279,17 @@ namespace lgfx
     uint_fast16_t xpos = _xpos;
     uint_fast16_t ypos = _ypos;
 
-    static constexpr uint32_t buflen = 16;
-    swap565_t colors[buflen];
-    int bufpos = buflen;
+    uint32_t maxlen = xe - xs + 1;
+    auto readbuf = (swap565_t*)alloca(maxlen * sizeof(swap565_t));
+    auto luma = (uint8_t*)alloca(maxlen);
     do
-    {
-      if (bufpos == buflen) {
-        param->fp_copy(colors, 0, std::min(length, buflen), param);
-        bufpos = 0;
-      }
-      auto color = colors[bufpos++];
-      _draw_pixel(xpos, ypos, (color.R8() + (color.G8() << 1) + color.B8()) >> 2);
-      if (++xpos > xe)
+    { // up to the end of the current row of the window.
+      uint32_t len = std::min<uint32_t>(length, xe - xpos + 1);
+      param->fp_copy(readbuf, 0, len, param);
+      dither::luma(luma, readbuf, len);
+      _draw_row(xpos, ypos, len, luma);
+      xpos += len;
+      if (xpos > xe)
       {
         xpos = xs;
         if (++ypos > ye)
@@ -275,7 +297,8 @@ namespace lgfx
           ypos = ys;
         }
       }
-    } while (--length);
+      length -= len;
+    } while (length);
     _xpos = xpos;
     _ypos = ypos;
   }
@@ -312,13 +335,30 @@ namespace lgfx
     return true;
   }
 
-  void Panel_GDEW0154M09::_draw_pixel(uint_fast16_t x, uint_fast16_t y, uint32_t value)
+  void Panel_GDEW0154M09::_draw_row(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint8_t* luma, bool quantized)
   {
-    _rotate_pos(x, y);
-    uint32_t idx = ((_cfg.panel_width + 7) & ~7) * y + x;
-    bool flg = 256 <= value + Bayer[(x & 3) | (y & 3) << 2];
-    if (flg) _buf[idx >> 3] |=   0x80 >> (idx & 7);
-    else     _buf[idx >> 3] &= ~(0x80 >> (idx & 7));
+    static constexpr uint8_t threshold_quantized[4] = { 1, 1, 1, 1 }; // luma is already 0 or 255.
+    uint_fast16_t xs = x, xe = x + w - 1;
+    uint_fast16_t ys = y, ye = y;
+    _rotate_pos(xs, ys, xe, ye);
+    uint_fast8_t r = _internal_rotation;
+    uint_fast8_t rb = 1 << r;
+    uint32_t stride = ((_cfg.panel_width + 7) & ~7) >> 3;
+    if (r & 1)
+    { // the row is a column of the panel memory.
+      if (rb & 0b10011100) { std::reverse(luma, luma + w); } // case 3:7:
+      uint8_t threshold[4];
+      for (uint_fast8_t k = 0; k < 4; ++k)
+      {
+        threshold[k] = quantized ? 1 : Bayer[(xs & 3) | k << 2];
+      }
+      dither::pack_column(_buf, stride, xs, ys, ye, luma, threshold);
+    }
+    else
+    {
+      if (rb & 0b11000110) { std::reverse(luma, luma + w); } // case 2:6:
+      dither::pack_row(&_buf[ys * stride], xs, xe, luma, quantized ? threshold_quantized : &Bayer[(ys & 3) << 2]);
+    }
   }
 
   bool Panel_GDEW0154M09::_read_pixel(uint_fast16_t x, uint_fast16_t y)
@@ -51,17 +51,23 @@ namespace lgfx
 
     void readRect(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, void* dst, pixelcopy_t* param) override;
 
+    /// Floyd-Steinberg error diffusion instead of the ordered dither for images. ( pushImage, pushSprite, drawJpg ... )
+    /// Suits photos; the error is diffused within each image drawn, and fills keep the ordered dither.
+    void setErrorDiffusion(bool enable) { _error_diffusion = enable; }
+    bool getErrorDiffusion(void) const { return _error_diffusion; }
+
   private:
 
     static constexpr unsigned long _refresh_msec = 320;
 
     range_rect_t _range_old;
     unsigned long _send_msec = 0;
+    bool _error_diffusion = false;
 
     size_t _get_buffer_length(void) const override;
 
     bool _wait_busy(uint32_t timeout = 1000);
-    void _draw_pixel(uint_fast16_t x, uint_fast16_t y, uint32_t value);
+    void _draw_row(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint8_t* luma, bool quantized = false);
     bool _read_pixel(uint_fast16_t x, uint_fast16_t y);
     void _update_transferred_rect(uint_fast16_t &xs, uint_fast16_t &ys, uint_fast16_t &xe, uint_fast16_t &ye);
     void _exec_transfer(uint32_t cmd, const range_rect_t& range, bool invert = false);
@@ -20,6 +20,7 @@ Contributors:
 #include "../platforms/common.hpp"
 #include "../misc/pixelcopy.hpp"
 #include "../misc/colortype.hpp"
+#include "../misc/dither.hpp"
 
 #if __has_include (<esp_log.h>)
  #include <esp_log.h>
@@ -40,6 +41,9 @@ namespace lgfx
 
   static constexpr int8_t Bayer[16] = {-30, 2, -22, 10, 18, -14, 26, -6, -18, 14, -26, 6, 30, -2, 22, -10};
 
+  // Largest size of the pixel data sent at once while loading an image.
+  static constexpr uint32_t max_burst_bytes = 2048;
+
 //Built in I80 Command Code
   static constexpr uint32_t IT8951_TCON_SYS_RUN         = 0x0001;
   static constexpr uint32_t IT8951_TCON_STANDBY         = 0x0002;
@@ -127,10 +131,9 @@ IT8951 Registers defines
 
   bool Panel_IT8951::init(bool use_reset)
   {
-    _range_new.top = INT16_MAX;
-    _range_new.left = INT16_MAX;
-    _range_new.right = 0;
-    _range_new.bottom = 0;
+    _dirty_count = 0;
+    _queue_count = 0;
+    _refreshing_count = 0;
 
     if (!Panel_Device::init(use_reset))
     {
@@ -271,6 +274,13 @@ IT8951 Registers defines
   {
     startWrite();
     _check_afsr();
+    _refreshing_count = 0;
+    while (_queue_count)
+    {
+      _flush_queue();
+      _check_afsr();
+      _refreshing_count = 0;
+    }
     endWrite();
   }
 
@@ -279,26 +289,46 @@ IT8951 Registers defines
     uint16_t infobuf[2] = { 1 };
     bool res = true;
     startWrite();
-    if (_write_command(IT8951_TCON_REG_RD)
-      && _write_word(IT8951_LUTAFSR)
-      && _read_words(infobuf, 1))
+    if (_read_afsr(infobuf))
     {
-      res = (0 != infobuf[0]);
+      if (0 == infobuf[0])
+      {
+        _refreshing_count = 0;
+        _flush_queue();
+      }
+      res = infobuf[0] || _refreshing_count || _queue_count;
     }
     cs_control(true);
     endWrite();
     return res;
   }
 
+  bool Panel_IT8951::_read_afsr(uint16_t* value)
+  {
+    return _write_command(IT8951_TCON_REG_RD)
+        && _write_word(IT8951_LUTAFSR)
+        && _read_words(value, 1);
+  }
+
+  /// Checks the LUT engines once without waiting. Returns true while the refreshes sent may still be running.
+  bool Panel_IT8951::_poll_afsr(void)
+  {
+    uint16_t infobuf[2] = { 1 };
+    if (_read_afsr(infobuf) && infobuf[0] == 0)
+    {
+      _refreshing_count = 0;
+    }
+    cs_control(true);
+    return _refreshing_count;
+  }
+
   bool Panel_IT8951::_check_afsr(void)
   {
     uint32_t start_time = millis();
     uint16_t infobuf[2] = { 1 };
     do
     {
-      if (_write_command(IT8951_TCON_REG_RD)
-       && _write_word(IT8951_LUTAFSR)
-       && _read_words(infobuf, 1)
+      if (_read_afsr(infobuf)
        && infobuf[0] == 0)
       {
         break;
@@ -338,7 +368,7 @@ IT8951 Registers defines
       {
         uint32_t buf = getSwap16(args[i]);
         _bus->wait();
-        while (!lgfx::gpio_in(_cfg.pin_busy));
+        if (_cfg.pin_busy >= 0) { while (!lgfx::gpio_in(_cfg.pin_busy)); }
         _bus->writeData(buf, 16);
       } while ( ++i < length );
       return true;
@@ -374,7 +404,7 @@ IT8951 Registers defines
         && _write_reg(IT8951_LISAR    , tar_addr      );
   }
 
-  bool Panel_IT8951::_set_area( uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+  range_rect_t Panel_IT8951::_get_raw_range( uint32_t x, uint32_t y, uint32_t w, uint32_t h) const
   {
     uint32_t rx, ry, rw, rh;
     rx = ((_it8951_rotation+1) & 2) ? _width  - w - x : x;
@@ -386,21 +416,134 @@ IT8951 Registers defines
       std::swap(rx, ry);
       std::swap(rw, rh);
     }
+    range_rect_t range;
+    range.left   = rx;
+    range.right  = rx + rw - 1;
+    range.top    = ry;
+    range.bottom = ry + rh - 1;
+    return range;
+  }
+
+  Panel_IT8951::epd_update_mode_t Panel_IT8951::_get_update_mode(void) const
+  {
+    switch (_epd_mode)
+    {
+    case epd_mode_t::epd_fastest:  return UPDATE_MODE_DU4;
+    case epd_mode_t::epd_fast:     return UPDATE_MODE_DU;
+    case epd_mode_t::epd_text:     return UPDATE_MODE_GL16;
+    default:                       return UPDATE_MODE_GC16;
+    }
+  }
 
-    _range_new.left   = std::min<uint32_t>(_range_new.left  , rx         );
-    _range_new.right  = std::max<uint32_t>(_range_new.right , rx + rw - 1);
-    _range_new.top    = std::min<uint32_t>(_range_new.top   , ry         );
-    _range_new.bottom = std::max<uint32_t>(_range_new.bottom, ry + rh - 1);
+  static uint32_t area_of(const range_rect_t& r)
+  {
+    return r.width() * r.height();
+  }
+
+  static range_rect_t union_of(const range_rect_t& a, const range_rect_t& b)
+  {
+    range_rect_t r;
+    r.left   = std::min(a.left  , b.left  );
+    r.right  = std::max(a.right , b.right );
+    r.top    = std::min(a.top   , b.top   );
+    r.bottom = std::max(a.bottom, b.bottom);
+    return r;
+  }
+
+  /// Order of the waveforms by image quality. A merged region is refreshed with the better one of the two.
+  static uint_fast8_t quality_of(uint_fast8_t mode)
+  {
+    static constexpr uint8_t quality[] = { 9, 2, 4, 3, 3, 3, 1, 0, 0 };  // INIT, DU, GC16, GL16, GLR16, GLD16, DU4, A2, NONE
+    return quality[mode < sizeof(quality) ? mode : 0];
+  }
+
+  uint8_t Panel_IT8951::_add_region(update_region_t* list, uint8_t count, range_rect_t range, epd_update_mode_t mode)
+  {
+    for (;;)
+    {
+      uint32_t area = area_of(range);
+      int_fast16_t merge = -1;
+      for (uint_fast8_t i = 0; i < count; ++i)
+      {
+        auto& reg = list[i];
+        if (reg.range.intersectsWith(range))
+        { // Overlapping areas would have to be refreshed one after the other, one refresh is always faster.
+          merge = i;
+          break;
+        }
+        if (reg.mode == mode)
+        { // Two refreshes with the same waveform take as long as one, merge unless it adds much area that is not drawn.
+          uint32_t sum = area + area_of(reg.range);
+          if (sum * 4 >= area_of(union_of(reg.range, range)) * 3)
+          {
+            merge = i;
+            break;
+          }
+        }
+      }
+      if (merge < 0)
+      {
+        if (count < max_regions)
+        {
+          list[count].range = range;
+          list[count].mode = mode;
+          return count + 1;
+        }
+        // the list is full, merge with the region that adds the least area.
+        uint32_t best = UINT32_MAX;
+        for (uint_fast8_t i = 0; i < count; ++i)
+        {
+          uint32_t waste = area_of(union_of(list[i].range, range)) - area_of(list[i].range);
+          if (best > waste) { best = waste; merge = i; }
+        }
+      }
+      // take the merged region out of the list, and add the union again since it may now touch others.
+      auto& reg = list[merge];
+      range = union_of(reg.range, range);
+      if (quality_of(mode) < quality_of(reg.mode)) { mode = reg.mode; }
+      reg = list[--count];
+    }
+  }
+
+  bool Panel_IT8951::_intersects(const update_region_t* list, uint8_t count, const range_rect_t& range)
+  {
+    for (uint_fast8_t i = 0; i < count; ++i)
+    {
+      if (list[i].range.intersectsWith(range)) { return true; }
+    }
+    return false;
+  }
+
+  void Panel_IT8951::_flush_queue(const range_rect_t* keep)
+  {
+    uint_fast8_t i = 0;
+    while (i < _queue_count)
+    {
+      auto& reg = _queue[i];
+      if (_intersects(_refreshing, _refreshing_count, reg.range)
+       || (keep && keep->intersectsWith(reg.range)))
+      {
+        ++i;
+        continue;
+      }
+      _update_raw_area(reg);
+      _refreshing_count = _add_region(_refreshing, _refreshing_count, reg.range, reg.mode);
+      reg = _queue[--_queue_count];
+    }
+  }
+
+  bool Panel_IT8951::_set_area( uint32_t x, uint32_t y, uint32_t w, uint32_t h)
+  {
+    auto range = _get_raw_range(x, y, w, h);
+    _dirty_count = _add_region(_dirty, _dirty_count, range, _get_update_mode());
 
     if (_epd_mode != epd_mode_t::epd_fastest
-     && _range_old.horizon.intersectsWith(rx, rx + rw - 1)
-     && _range_old.vertical.intersectsWith(ry, ry + rh - 1))
+     && _intersects(_refreshing, _refreshing_count, range))
     {
       _check_afsr();
-      _range_old.left = INT16_MAX;
-      _range_old.top = INT16_MAX;
-      _range_old.right = 0;
-      _range_old.bottom = 0;
+      _refreshing_count = 0;
+      // send the queued refreshes that are now possible, except over the area about to be drawn.
+      _flush_queue(&range);
     }
 
     uint16_t params[5];
@@ -412,11 +555,12 @@ IT8951 Registers defines
     return _write_args(IT8951_TCON_LD_IMG_AREA, params, 5);
   }
 
-  bool Panel_IT8951::_update_raw_area(epd_update_mode_t mode)
+  bool Panel_IT8951::_update_raw_area(const update_region_t& region)
   {
-    if (_range_new.empty()) return false;
-    uint32_t l = _range_new.left;
-    uint32_t r = _range_new.right;
+    auto& range = region.range;
+    if (range.empty()) return false;
+    uint32_t l = range.left;
+    uint32_t r = range.right;
 
     // 更新範囲の幅が小さすぎる場合、IT8951がフリーズすることがある。;
     // 厳密には、範囲の左右端の座標値の下2ビット捨てた場合に同値になる場合、;
@@ -436,10 +580,10 @@ IT8951 Registers defines
     uint32_t w = r - l + 1;
     uint16_t params[7];
     params[0] = l;
-    params[1] = _range_new.top;
+    params[1] = range.top;
     params[2] = w;
-    params[3] = _range_new.bottom - _range_new.top + 1;
-    params[4] = mode;
+    params[3] = range.bottom - range.top + 1;
+    params[4] = region.mode;
     params[5] = (uint16_t)_tar_memaddr;
     params[6] = (uint16_t)(_tar_memaddr >> 16);
     return _write_args(IT8951_I80_CMD_DPY_BUF_AREA, params, 7);
@@ -453,26 +597,21 @@ IT8951 Registers defines
       {
         y = height() - y - h;
       }
-      _set_area(x, y, w, h);
+      _dirty_count = _add_region(_dirty, _dirty_count, _get_raw_range(x, y, w, h), _get_update_mode());
     }
-    if (_range_new.empty()) return;
+    if (0 == _dirty_count && 0 == _queue_count) return;
 
-    _range_old = _range_new;
-    epd_update_mode_t mode;
-    switch (_epd_mode)
+    for (uint_fast8_t i = 0; i < _dirty_count; ++i)
     {
-    case epd_mode_t::epd_fastest:  mode = UPDATE_MODE_DU4;  break;
-    case epd_mode_t::epd_fast:     mode = UPDATE_MODE_DU;   break;
-    case epd_mode_t::epd_text:     mode = UPDATE_MODE_GL16; break;
-    default:                       mode = UPDATE_MODE_GC16; break;
+      _queue_count = _add_region(_queue, _queue_count, _dirty[i].range, _dirty[i].mode);
     }
+    _dirty_count = 0;
 
-    _update_raw_area(mode);
-
-    _range_new.top = INT16_MAX;
-    _range_new.left = INT16_MAX;
-    _range_new.right = 0;
-    _range_new.bottom = 0;
+    _flush_queue();
+    if (_queue_count && _poll_afsr() == false)
+    { // the refreshes in the way have ended.
+      _flush_queue();
+    }
   }
 
   void Panel_IT8951::setInvert(bool invert)
@@ -484,7 +623,8 @@ IT8951 Registers defines
   void Panel_IT8951::setSleep(bool flg)
   {
     if (flg)
-    {
+    { // send the refreshes still in the queue, and let them end before the controller sleeps.
+      waitDisplay();
       startWrite();
       _write_command(IT8951_TCON_SLEEP);
       endWrite();
@@ -497,6 +637,7 @@ IT8951 Registers defines
 
   void Panel_IT8951::setPowerSave(bool flg)
   {
+    if (flg) { waitDisplay(); }
     startWrite();
     _write_command(flg ? IT8951_TCON_STANDBY : IT8951_TCON_SYS_RUN);
     endWrite();
@@ -573,14 +714,10 @@ IT8951 Registers defines
 
   void Panel_IT8951::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
   {
-    uint16_t* writebuf = static_cast<uint16_t*>(heap_alloc(w * sizeof(bgr888_t) + 4));
-    bgr888_t* readbuf = reinterpret_cast<lgfx::bgr888_t*>(&writebuf[2]);
-
-    if (writebuf == nullptr) return;
-    writebuf[0] = 0;
+    bgr888_t* readbuf = static_cast<bgr888_t*>(heap_alloc(w * sizeof(bgr888_t)));
+    if (readbuf == nullptr) return;
 
     int32_t add_y = 1;
-    bool flg_setarea = false;
     if (_it8951_rotation & 4)
     {
       y = height() - (y + h);
@@ -589,16 +726,45 @@ IT8951 Registers defines
     }
     bool fast = _epd_mode == epd_mode_t::epd_fast || _epd_mode == epd_mode_t::epd_fastest;
     auto sx = param->src_x32;
+    uint32_t row_bytes = (((x + w + 3) >> 2) - (x >> 2)) << 1;
 
-    bool fastdraw = (param->transp == pixelcopy_t::NON_TRANSP);
-    if (fastdraw)
+    if (param->transp == pixelcopy_t::NON_TRANSP)
     {
       _set_area(x, y, w, h);
-      flg_setarea = true;
       _wait_busy();
       _bus->writeData(0, 16);
+      // the packed rows are sent in bursts, the next burst is converted while the previous one is sent.
+      uint32_t rows = std::max<uint32_t>(1, max_burst_bytes / row_bytes);
+      do
+      {
+        uint32_t n = std::min<uint32_t>(rows, h);
+        h -= n;
+        auto writebuf = _bus->getDMABuffer(2 + n * row_bytes);
+        writebuf[0] = 0;
+        writebuf[1] = 0;
+        uint32_t len = 2;
+        do
+        {
+          param->fp_copy(readbuf, 0, w, param);
+          len += dither::pack_gray4(&writebuf[len], readbuf, x, x + w - 1, &Bayer[(y & 3) << 2], fast, _invert);
+          param->src_x32 = sx;
+          param->src_y += add_y;
+          ++y;
+        } while (--n);
+        _wait_busy();
+        _bus->writeBytes(writebuf, len, true, true);
+      } while (h);
+      _write_command(IT8951_TCON_LD_IMG_END);
+      heap_free(readbuf);
+      return;
     }
 
+    uint8_t* writebuf = static_cast<uint8_t*>(heap_alloc(2 + row_bytes));
+    if (writebuf == nullptr) { heap_free(readbuf); return; }
+    writebuf[0] = 0;
+    writebuf[1] = 0;
+
+    bool flg_setarea = false;
     do
     {
       uint32_t prev_pos = 0, new_pos = 0;
@@ -607,46 +773,15 @@ IT8951 Registers defines
         new_pos = param->fp_copy(readbuf, prev_pos, w, param);
         if (new_pos != prev_pos)
         {
-          if (!fastdraw)
+          if (flg_setarea)
           {
-            if (flg_setarea)
-            {
-              _write_command(IT8951_TCON_LD_IMG_END);
-            }
-            flg_setarea = true;
-            _set_area(x + prev_pos, y, new_pos - prev_pos, 1);
-            //_wait_busy();
-            //_bus->writeData(0, 16);
+            _write_command(IT8951_TCON_LD_IMG_END);
           }
-          uint32_t writepos = 1;
-          int32_t shift = (3 - ((x + prev_pos) & 3)) << 2;
-          auto btbl = &Bayer[(y & 3) << 2];
-          do
-          {
-            uint_fast16_t buf = 0;
-            do
-            {
-              auto color = readbuf[prev_pos];
-              int32_t pixel = color.R8() + (color.G8() << 1) + color.B8();
-              if (fast)
-              {
-                pixel = (pixel + btbl[(x + prev_pos) & 3] * 16 < 512) ? 0 : 15;
-              }
-              else
-              {
-                pixel = std::min<int32_t>(15, std::max<int32_t>(0, pixel + btbl[(x + prev_pos) & 3]) >> 6);
-              }
-              buf |= pixel << shift;
-              shift -= 4;
-            } while (new_pos != ++ prev_pos && shift >= 0);
-            if (_invert) buf = ~buf;
-            writebuf[writepos] = getSwap16(buf);
-            writepos++;
-            shift = 12;
-            //_bus->writeData(getSwap16(buf), 16);
-          } while (new_pos != prev_pos);
+          flg_setarea = true;
+          _set_area(x + prev_pos, y, new_pos - prev_pos, 1);
+          uint32_t len = 2 + dither::pack_gray4(&writebuf[2], &readbuf[prev_pos], x + prev_pos, x + new_pos - 1, &Bayer[(y & 3) << 2], fast, _invert);
           _wait_busy();
-          _bus->writeBytes((uint8_t*)writebuf, writepos << 1, true, false);
+          _bus->writeBytes(writebuf, len, true, false);
         }
       } while (w != new_pos && w != (prev_pos = param->fp_skip(new_pos, w, param)));
       param->src_x32 = sx;
@@ -654,6 +789,7 @@ IT8951 Registers defines
       ++y;
     } while (--h);
     heap_free(writebuf);
+    heap_free(readbuf);
     if (flg_setarea)
     {
       _write_command(IT8951_TCON_LD_IMG_END);
@@ -695,46 +831,23 @@ IT8951 Registers defines
     uint32_t maxw = std::min(length, xe - xs + 1);
     bgr888_t* readbuf = static_cast<bgr888_t*>(heap_alloc(maxw * sizeof(bgr888_t)));
     if (readbuf == nullptr) return;
+    // 16bit preamble and the packed pixels of a row, which may start in the middle of a group of 4 pixels.
+    uint8_t* writebuf = static_cast<uint8_t*>(heap_alloc(2 + (((maxw + 6) >> 2) << 1)));
+    if (writebuf == nullptr) { heap_free(readbuf); return; }
+    writebuf[0] = 0;
+    writebuf[1] = 0;
+
+    bool fast = _epd_mode == epd_mode_t::epd_fast || _epd_mode == epd_mode_t::epd_fastest;
     do
     {
-      w = std::min(length, xe - xs + 1);
+      w = std::min(length, xe - xpos + 1);
       auto y = _it8951_rotation & 4 ? height() - ypos - 1 : ypos;
-      int32_t prev_pos = 0, new_pos = 0;
-      //do
-      {
-        new_pos = param->fp_copy(readbuf, prev_pos, w, param);
-        //if (new_pos != prev_pos)
-        {
-          _set_area(xpos + prev_pos, y, new_pos - prev_pos, 1);
-          _wait_busy();
-          _bus->writeData(0, 16);
-          uint32_t shift = (3 - ((xpos + prev_pos) & 3)) << 2;
-          uint16_t buf = 0;
-          auto btbl = &Bayer[(y & 3) << 2];
-          do
-          {
-            auto color = readbuf[prev_pos];
-            uint16_t pixel = std::min(15, std::max(0, (color.R8() + (color.G8() << 1) + color.B8() + btbl[(xpos + prev_pos) & 3])) >> 6);
-            buf |= pixel << shift;
-            if (shift)
-            {
-              shift -= 4;
-            }
-            else
-            {
-              _bus->writeData(getSwap16(buf), 16);
-              buf = 0;
-              shift = 12;
-            }
-          } while (new_pos != ++prev_pos);
-          if (shift != 12)
-          {
-            if (_invert) buf = ~buf;
-            _bus->writeData(getSwap16(buf), 16);
-          }
-          _write_command(IT8951_TCON_LD_IMG_END);
-        }
-      }// while (w != new_pos && w != (prev_pos = param->fp_skip(new_pos, w, param)));
+      param->fp_copy(readbuf, 0, w, param);
+      _set_area(xpos, y, w, 1);
+      uint32_t len = 2 + dither::pack_gray4(&writebuf[2], readbuf, xpos, xpos + w - 1, &Bayer[(y & 3) << 2], fast, _invert);
+      _wait_busy();
+      _bus->writeBytes(writebuf, len, true, false);
+      _write_command(IT8951_TCON_LD_IMG_END);
       xpos += w;
       if (xpos > xe)
       {
@@ -748,6 +861,7 @@ IT8951 Registers defines
     _xpos = xpos;
     _ypos = ypos;
 
+    heap_free(writebuf);
     heap_free(readbuf);
   }
 
@@ -44,6 +44,13 @@ namespace lgfx
 
     void waitDisplay(void) override;
     bool displayBusy(void) override;
+
+    /// 描画された範囲は、描画時の EPDモード に対応する波形ごとに最大8箇所まで保持される。;
+    /// 重なる範囲、および結合しても無駄な面積が少ない同じ波形の範囲は一つにまとめられる。;
+    /// 表示更新中の範囲と重なる範囲はキューに残り、その更新の完了後に
+    /// display() / displayBusy() / waitDisplay() または次の描画の際に送信されるため、呼出し元を待たせない。;
+    /// 従って最後の display() の範囲は、後の display() / displayBusy() / waitDisplay() / setSleep(true) / setPowerSave(true)
+    /// または重なる描画が行われるまで送信されないことがある。更新を確実に終えるには waitDisplay() を呼ぶこと。;
     void display(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h) override;
 
     void writeBlock(uint32_t rawcolor, uint32_t len) override;
@@ -77,8 +84,20 @@ namespace lgfx
       UPDATE_MODE_NONE    = 8
     };        // The ones marked with * are more commonly used
 
-    range_rect_t _range_new;
-    range_rect_t _range_old;
+    /// Area of the panel memory (in IT8951 coordinates) and the waveform it is to be refreshed with.
+    struct update_region_t
+    {
+      range_rect_t range;
+      epd_update_mode_t mode;
+    };
+    static constexpr uint8_t max_regions = 8;
+
+    update_region_t _dirty[max_regions];       // drawn since the last display()
+    update_region_t _queue[max_regions];       // display() requested, waiting for a refresh over the same area to end
+    update_region_t _refreshing[max_regions];  // sent to the IT8951, the waveform may still be running
+    uint8_t _dirty_count = 0;
+    uint8_t _queue_count = 0;
+    uint8_t _refreshing_count = 0;
 
     uint16_t _xpos = 0;
     uint16_t _ypos = 0;
@@ -93,10 +112,17 @@ namespace lgfx
     bool _write_args( uint16_t cmd, uint16_t *args, int32_t length);
     bool _write_reg( uint16_t addr, uint16_t data);
     bool _read_words( uint16_t *buf, uint32_t length);
+    bool _read_afsr( uint16_t* value);
     bool _check_afsr( void );
+    bool _poll_afsr( void );
     bool _set_target_memory_addr( uint32_t tar_addr);
+    range_rect_t _get_raw_range( uint32_t x, uint32_t y, uint32_t w, uint32_t h) const;
+    epd_update_mode_t _get_update_mode( void ) const;
     bool _set_area( uint32_t x, uint32_t y, uint32_t w, uint32_t h);
-    bool _update_raw_area( epd_update_mode_t mode);
+    bool _update_raw_area( const update_region_t& region);
+    void _flush_queue( const range_rect_t* keep = nullptr);
+    static uint8_t _add_region( update_region_t* list, uint8_t count, range_rect_t range, epd_update_mode_t mode);
+    static bool _intersects( const update_region_t* list, uint8_t count, const range_rect_t& range);
     bool _read_raw_line( int32_t raw_x, int32_t raw_y, int32_t len, uint16_t* buf);
 
     fastread_dir_t get_fastread_dir(void) const override { return _it8951_rotation & 1 ? fastread_vertical : fastread_horizontal; }
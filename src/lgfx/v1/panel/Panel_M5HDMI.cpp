@@ -15,19 +15,22 @@ Contributors:
  [mongonta0716](https://github.com/mongonta0716)
  [tobozo](https://github.com/tobozo)
 /----------------------------------------------------------------------------*/
-#if defined (ESP_PLATFORM)
-#include <sdkconfig.h>
-
 #include "Panel_M5HDMI.hpp"
-#include "Panel_M5HDMI_FS.h"
 #include "../Bus.hpp"
 #include "../platforms/common.hpp"
 #include "../misc/pixelcopy.hpp"
 #include "../misc/colortype.hpp"
+#include "../misc/rle.hpp"
 #include "../../internal/alloca.h"
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (ESP_PLATFORM)
+#include <sdkconfig.h>
+#include "Panel_M5HDMI_FS.h"
 #include <esp_log.h>
 #include <soc/gpio_periph.h>
 #include <soc/gpio_reg.h>
@@ -35,6 +38,13 @@ Contributors:
 #if __has_include(<hal/gpio_types.h>)
  #include <hal/gpio_types.h>
 #endif
+#else
+// Host builds drive a model of the FPGA (see misc/BusController.hpp), there is no log output.
+ #define ESP_LOGE(...)
+ #define ESP_LOGW(...)
+ #define ESP_LOGI(...)
+ #define ESP_LOGD(...)
+#endif
 
 #define TAG "M5HDMI"
 
@@ -46,6 +56,8 @@ namespace lgfx
 //----------------------------------------------------------------------------
   static constexpr const uint32_t base_clock = 74250000;
 
+#if defined (ESP_PLATFORM)
+
   enum GWFPGA_Inst_Def
   {
     ISC_NOOP          = 0x02,
@@ -443,6 +455,8 @@ namespace lgfx
     return result;
   }
 
+#endif
+
 //----------------------------------------------------------------------------
 
   uint32_t Panel_M5HDMI::_read_fpga_id(void)
@@ -463,8 +477,9 @@ namespace lgfx
     return fpga_id;
   }
 
-  bool Panel_M5HDMI::init(bool use_reset)
+  bool Panel_M5HDMI::init(bool)
   {
+#if defined (ESP_PLATFORM)
     ESP_LOGI(TAG, "i2c port:%d sda:%d scl:%d", _HDMI_Trans_config.i2c_port, _HDMI_Trans_config.pin_sda, _HDMI_Trans_config.pin_scl);
 
     lgfx::i2c::init(_HDMI_Trans_config.i2c_port, _HDMI_Trans_config.pin_sda, _HDMI_Trans_config.pin_scl);
@@ -480,9 +495,11 @@ namespace lgfx
 
     ESP_LOGI(TAG, "Resetting HDMI transmitter...");
     driver.reset();
+#endif
 
     if (!Panel_Device::init(false)) { return false; }
 
+#if defined (ESP_PLATFORM)
     if ((_read_fpga_id() & 0xFFFF) != ('H' | 'D' << 8))
     {
       auto bus_cfg = reinterpret_cast<lgfx::Bus_SPI*>(_bus)->config();
@@ -536,17 +553,23 @@ namespace lgfx
       ESP_LOGW(TAG, "read FPGA ID failed.");
       return false;
     }
+#else
+    // The bus is a model of the FPGA, there is no bitstream to load and no clock to tune.
+    if ((_read_fpga_id() & 0xFFFF) != ('H' | 'D' << 8)) { return false; }
+#endif
 
     startWrite();
     bool res = _init_resolution();
     endWrite();
 
+#if defined (ESP_PLATFORM)
     ESP_LOGI(TAG, "Initialize HDMI transmitter...");
     if (!driver.init() )
     {
       ESP_LOGW(TAG, "HDMI transmitter Initialize failed.");
       return false;
     }
+#endif
 
     ESP_LOGI(TAG, "done.");
     return res;
@@ -813,7 +836,7 @@ namespace lgfx
           uint32_t scale_height = scale * logical_height;
           uint32_t scale_width = scale * logical_width;
           uint32_t total = scale_width * scale_height;
-          if (scale_width > 1920 || scale_height > 1920 || total > limit) { break; }
+          if (scale_width > 1920 || scale_height > 1920 || total > (uint32_t)limit) { break; }
           scale_w = scale;
           scale_h = scale;
         }
@@ -883,7 +906,7 @@ namespace lgfx
 
   bool Panel_M5HDMI::displayBusy(void)
   {
-    if ((_last_cmd & ~7) == CMD_WRITE_RAW)
+    if ((_last_cmd & ~15) == CMD_WRITE_RAW) // CMD_WRITE_RAW_* or CMD_WRITE_RLE_*
     {
       _bus->wait();
       cs_control(true);
@@ -909,7 +932,7 @@ namespace lgfx
 
   void Panel_M5HDMI::_check_busy(uint32_t length, bool force)
   {
-    if ((_last_cmd & ~7) == CMD_WRITE_RAW)
+    if ((_last_cmd & ~15) == CMD_WRITE_RAW) // CMD_WRITE_RAW_* or CMD_WRITE_RLE_*
     {
       _total_send = 0;
 
@@ -958,12 +981,13 @@ namespace lgfx
     if (_internal_rotation & 1) std::swap(_width, _height);
   }
 
-  void Panel_M5HDMI::setInvert(bool invert)
+  void Panel_M5HDMI::setInvert(bool)
   {
   }
 
   void Panel_M5HDMI::setSleep(bool flg)
   {
+#if defined (ESP_PLATFORM)
     HDMI_Trans driver(_HDMI_Trans_config);
     if (flg)
     {
@@ -973,13 +997,16 @@ namespace lgfx
     {
       driver.init();
     }
+#else
+    (void)flg;
+#endif
   }
 
-  void Panel_M5HDMI::setPowerSave(bool flg)
+  void Panel_M5HDMI::setPowerSave(bool)
   {
   }
 
-  void Panel_M5HDMI::setBrightness(uint8_t brightness)
+  void Panel_M5HDMI::setBrightness(uint8_t)
   {
   }
 
@@ -1097,6 +1124,51 @@ namespace lgfx
     _last_cmd = cmd_write;
   }
 
+  uint8_t* Panel_M5HDMI::_get_line_buffer(uint32_t length)
+  {
+    // The first half is the output of the encoder, so that a line takes one DMA buffer.
+    uint32_t wb = length * (_write_bits >> 3);
+    return _bus->getDMABuffer(wb << 1) + wb;
+  }
+
+  size_t Panel_M5HDMI::_rle_encode(uint8_t* dst, const uint8_t* src, uint32_t length)
+  {
+    if (length < 4) { return 0; }
+    if (_rle_skip) { --_rle_skip; return 0; }
+
+    uint32_t wb = length * (_write_bits >> 3);
+    size_t limit = wb - (wb >> 3); // must save 1/8 to replace the raw data.
+    size_t res = rle::encode(dst, src, length, _write_bits >> 3, limit);
+    if (res)
+    {
+      _rle_miss = 0;
+    }
+    else
+    { // photos rarely compress; back off for 1, 3, 7, 15 lines after repeated misses.
+      if (_rle_miss < 4) { ++_rle_miss; }
+      _rle_skip = (1u << _rle_miss) - 1;
+    }
+    return res;
+  }
+
+  void Panel_M5HDMI::_write_line(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye, uint8_t* buf, uint32_t length)
+  {
+    auto bytes = _write_bits >> 3;
+    uint32_t wb = length * bytes;
+    auto enc = buf - wb;
+    size_t len = _rle_encode(enc, buf, length);
+    if (len)
+    {
+      _set_window(xs, ys, xe, ye, CMD_WRITE_RLE + bytes);
+      _bus->writeBytes(enc, len, false, true);
+    }
+    else
+    {
+      _set_window(xs, ys, xe, ye, CMD_WRITE_RAW + bytes);
+      _bus->writeBytes(buf, wb, false, true);
+    }
+  }
+
   void Panel_M5HDMI::_rotate_pixelcopy(uint_fast16_t& x, uint_fast16_t& y, uint_fast16_t& w, uint_fast16_t& h, pixelcopy_t* param, uint32_t& nextx, uint32_t& nexty)
   {
     uint32_t addx = param->src_x32_add;
@@ -1132,7 +1204,7 @@ namespace lgfx
     param->src_y32_add = addy;
   }
 
-  void Panel_M5HDMI::writePixels(pixelcopy_t* param, uint32_t length, bool use_dma)
+  void Panel_M5HDMI::writePixels(pixelcopy_t* param, uint32_t length, bool)
   {
     uint_fast16_t xs = _xs;
     uint_fast16_t xe = _xe;
@@ -1167,15 +1239,31 @@ namespace lgfx
         linelength = std::min<uint_fast16_t>(x - xe + 1, length);
         param->fp_copy(linebuf, 0, linelength, param);
         pc.src_x32 = (linelength - 1) << pixelcopy_t::FP_SCALE;
-        if (r & 1)
+        if (_rle)
         {
-          _set_window(y, x - linelength + 1, y, x, cmd);
+          auto buf = _get_line_buffer(linelength);
+          pc.fp_copy(buf, 0, linelength, &pc);
+          if (r & 1)
+          {
+            _write_line(y, x - linelength + 1, y, x, buf, linelength);
+          }
+          else
+          {
+            _write_line(x - linelength + 1, y, x, y, buf, linelength);
+          }
         }
         else
         {
-          _set_window(x - linelength + 1, y, x, y, cmd);
+          if (r & 1)
+          {
+            _set_window(y, x - linelength + 1, y, x, cmd);
+          }
+          else
+          {
+            _set_window(x - linelength + 1, y, x, y, cmd);
+          }
+          _bus->writePixels(&pc, linelength);
         }
-        _bus->writePixels(&pc, linelength);
         if ((x -= linelength) < xe)
         {
           x = xs;
@@ -1192,15 +1280,31 @@ namespace lgfx
       do
       {
         linelength = std::min<uint_fast16_t>(xe - x + 1, length);
-        if (r & 1)
+        if (_rle)
         {
-          _set_window(y, x, y, x + linelength - 1, cmd);
+          auto buf = _get_line_buffer(linelength);
+          param->fp_copy(buf, 0, linelength, param);
+          if (r & 1)
+          {
+            _write_line(y, x, y, x + linelength - 1, buf, linelength);
+          }
+          else
+          {
+            _write_line(x, y, x + linelength - 1, y, buf, linelength);
+          }
         }
         else
         {
-          _set_window(x, y, x + linelength - 1, y, cmd);
+          if (r & 1)
+          {
+            _set_window(y, x, y, x + linelength - 1, cmd);
+          }
+          else
+          {
+            _set_window(x, y, x + linelength - 1, y, cmd);
+          }
+          _bus->writePixels(param, linelength);
         }
-        _bus->writePixels(param, linelength);
 
         if ((x += linelength) > xe)
         {
@@ -1232,6 +1336,47 @@ namespace lgfx
     auto bytes = (_write_bits >> 3) & 3;
     uint32_t cmd = CMD_WRITE_RAW + bytes;
 
+    if (_rle && param->transp == pixelcopy_t::NON_TRANSP)
+    {
+      if (w == 1 && h > 1)
+      {
+        param->src_x32_add = nextx;
+        param->src_y32_add = nexty;
+        param->no_convert = false;
+        w = h;
+        h = 1;
+      }
+      uint32_t wb = w * bytes;
+      uint32_t ye = y + h - 1;
+      uint32_t stream = 0; // command of the window being sent, raw and RLE lines share it while the kind does not change.
+      do
+      {
+        auto buf = _get_line_buffer(w);
+        if (param->no_convert)
+        {
+          uint32_t i = (param->src_x + param->src_y * param->src_bitwidth) * bytes;
+          memcpy(buf, &((const uint8_t*)param->src_data)[i], wb);
+        }
+        else
+        {
+          param->fp_copy(buf, 0, w, param);
+        }
+        auto enc = buf - wb;
+        size_t len = _rle_encode(enc, buf, w);
+        uint32_t c = (len ? CMD_WRITE_RLE : CMD_WRITE_RAW) + bytes;
+        if (stream != c)
+        {
+          stream = c;
+          _set_window(x, y, x+w-1, ye, c);
+        }
+        if (len) { _bus->writeBytes(enc, len, false, true); }
+        else     { _bus->writeBytes(buf, wb, false, true); }
+        param->src_x32 = (sx32 += nextx);
+        param->src_y32 = (sy32 += nexty);
+        ++y;
+      } while (--h);
+    }
+    else
     if (param->transp == pixelcopy_t::NON_TRANSP)
     {
       _set_window(x, y, x+w-1, y+h-1, cmd);
@@ -1277,6 +1422,14 @@ namespace lgfx
         uint32_t i = 0;
         while (w != (i = param->fp_skip(i, w, param)))
         {
+          if (_rle)
+          {
+            auto buf = _get_line_buffer(w - i);
+            int32_t len = param->fp_copy(buf, 0, w - i, param);
+            _write_line(x + i, y, x + i + len - 1, y, buf, len);
+            if (w == (i += len)) break;
+            continue;
+          }
           auto dmabuf = _bus->getDMABuffer(wb + 1);
           int32_t len = param->fp_copy(dmabuf, 0, w - i, param);
           _set_window(x + i, y, x + i + len - 1, y, cmd);
@@ -1290,12 +1443,12 @@ namespace lgfx
     }
   }
 
-  void Panel_M5HDMI::writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param)
+  void Panel_M5HDMI::writeImageARGB(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, pixelcopy_t*)
   {
     // ToDo:unimplemented
   }
 
-  void Panel_M5HDMI::readRect(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, void* dst, pixelcopy_t* param)
+  void Panel_M5HDMI::readRect(uint_fast16_t, uint_fast16_t, uint_fast16_t, uint_fast16_t, void*, pixelcopy_t*)
   {
     // ToDo:unimplemented
   }
@@ -1505,12 +1658,16 @@ namespace lgfx
 
   size_t Panel_M5HDMI::readEDID(uint8_t* EDID, size_t len)
   {
+#if defined (ESP_PLATFORM)
     HDMI_Trans driver(_HDMI_Trans_config);
     return driver.readEDID(EDID, len);
+#else
+    (void)EDID;
+    (void)len;
+    return 0;
+#endif
   }
 
 //----------------------------------------------------------------------------
  }
 }
-
-#endif
@@ -141,6 +141,12 @@ namespace lgfx
     void setScaling(uint_fast8_t x_scale, uint_fast8_t y_scale);
     void setViewPort(uint_fast16_t x, uint_fast16_t y);
 
+    /// Sends the pixels of pushImage / pushPixels RLE compressed (CMD_WRITE_RLE_*) where it pays off.
+    /// Lines that do not get smaller are sent raw, and after repeated misses the encoder is skipped for a few lines.
+    /// The FPGA must support CMD_WRITE_RLE_*. default : false
+    void setRLE(bool enable) { _rle = enable; _rle_miss = 0; _rle_skip = 0; }
+    bool getRLE(void) const { return _rle; }
+
     static constexpr uint8_t CMD_NOP          = 0x00; // 1Byte 何もしない;
     static constexpr uint8_t CMD_READ_ID      = 0x04; // 1Byte ID読出し  スレーブからの回答は4Byte ([0]=0x48 [1]=0x44 [2]=メジャーバージョン [3]=マイナーバージョン);
 
@@ -160,12 +166,13 @@ namespace lgfx
     static constexpr uint8_t CMD_WRITE_RAW_32 = 0x44; // 不定長 ARGB8888 4Byteのピクセルデータを連続送信;
     static constexpr uint8_t CMD_WRITE_RAW_A  = 0x45; // 不定長 A8       1Byteのピクセルデータを連続送信(アルファチャネルのみ、描画色は最後に使用したものを再利用する);
 
-//  static constexpr uint8_t CMD_WRITE_RLE    = 0x48;
-//  static constexpr uint8_t CMD_WRITE_RLE_8  = 0x49; // 不定長 RGB332   1Byteのピクセルデータを連続送信(RLE圧縮);
-//  static constexpr uint8_t CMD_WRITE_RLE_16 = 0x4A; // 不定長 RGB565   2Byteのピクセルデータを連続送信(RLE圧縮);
-//  static constexpr uint8_t CMD_WRITE_RLE_24 = 0x4B; // 不定長 RGB888   3Byteのピクセルデータを連続送信(RLE圧縮);
-//  static constexpr uint8_t CMD_WRITE_RLE_32 = 0x4C; // 不定長 ARGB8888 4Byteのピクセルデータを連続送信(RLE圧縮);
-//  static constexpr uint8_t CMD_WRITE_RLE_A  = 0x4D; // 不定長 A8       1Byteのピクセルデータを連続送信(RLE圧縮 アルファチャネルのみ、描画色は最後に使用したものを再利用する);
+    static constexpr uint8_t CMD_WRITE_RLE    = 0x48;
+    static constexpr uint8_t CMD_WRITE_RLE_8  = 0x49; // 不定長 RGB332   1Byteのピクセルデータを連続送信(RLE圧縮);
+    static constexpr uint8_t CMD_WRITE_RLE_16 = 0x4A; // 不定長 RGB565   2Byteのピクセルデータを連続送信(RLE圧縮);
+    static constexpr uint8_t CMD_WRITE_RLE_24 = 0x4B; // 不定長 RGB888   3Byteのピクセルデータを連続送信(RLE圧縮);
+    static constexpr uint8_t CMD_WRITE_RLE_32 = 0x4C; // 不定長 ARGB8888 4Byteのピクセルデータを連続送信(RLE圧縮);
+    static constexpr uint8_t CMD_WRITE_RLE_A  = 0x4D; // 不定長 A8       1Byteのピクセルデータを連続送信(RLE圧縮 アルファチャネルのみ、描画色は最後に使用したものを再利用する);
+    // RLEの形式は Panel_M5UnitLCD と同じ。 [1~255]=連続数 + ピクセル1個 / [0]+[3~255]=個数 + 非圧縮ピクセル
 
 //  static constexpr uint8_t CMD_RAM_FILL     = 0x50; // 1Byte 現在の描画色で選択範囲全塗り;
 //  static constexpr uint8_t CMD_SET_COLOR    = 0x50;
@@ -211,7 +218,23 @@ namespace lgfx
     class HDMI_Trans
     {
     public:
+#if defined (ESP_PLATFORM)
       typedef lgfx::Bus_I2C::config_t config_t;
+#else
+      // Host builds have no transmitter, the settings are only kept.
+      struct config_t
+      {
+        uint32_t freq_write = 400000;
+        uint32_t freq_read = 400000;
+        int16_t pin_scl = 22;
+        int16_t pin_sda = 21;
+        uint8_t i2c_port = 0;
+        uint8_t i2c_addr = 0x39;
+        uint32_t prefix_cmd = 0x00;
+        uint32_t prefix_data = 0x40;
+        uint32_t prefix_len = 1;
+      };
+#endif
     private:
       config_t HDMI_Trans_config;
 
@@ -227,7 +250,7 @@ namespace lgfx
         uint8_t id[3];
       };
 
-      HDMI_Trans(const lgfx::Bus_I2C::config_t& i2c_config) : HDMI_Trans_config(i2c_config) {}
+      HDMI_Trans(const config_t& i2c_config) : HDMI_Trans_config(i2c_config) {}
       HDMI_Trans(const HDMI_Trans&) = delete;
       HDMI_Trans(HDMI_Trans&&) = delete;
       ChipID readChipID(void);
@@ -296,6 +319,9 @@ namespace lgfx
     float _refresh_rate = 60.0f;
     uint32_t _pixel_clock = 74250000;
     bool _in_transaction = false;
+    bool _rle = false;
+    uint8_t _rle_miss = 0;
+    uint8_t _rle_skip = 0;
 
     bool _init_resolution(void);
     void _set_window(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye, uint_fast8_t cmd);
@@ -305,6 +331,9 @@ namespace lgfx
     void _set_video_timing(const video_timing_t::info_t* param, uint8_t cmd);
     void _set_video_clock(const video_clock_t* param);
     void _copy_rect(uint32_t dst_xy, uint32_t src_xy, uint32_t wh);
+    uint8_t* _get_line_buffer(uint32_t length);
+    size_t _rle_encode(uint8_t* dst, const uint8_t* src, uint32_t length);
+    void _write_line(uint_fast16_t xs, uint_fast16_t ys, uint_fast16_t xe, uint_fast16_t ye, uint8_t* buf, uint32_t length);
     uint32_t _read_fpga_id(void);
   };
 
@@ -20,6 +20,7 @@ Contributors:
 #include "../platforms/common.hpp"
 #include "../misc/pixelcopy.hpp"
 #include "../misc/colortype.hpp"
+#include "../misc/rle.hpp"
 
 namespace lgfx
 {
@@ -354,134 +355,20 @@ namespace lgfx
   }
 
 
-  static uint8_t* store_encoded(uint8_t* dst, const uint8_t* src, size_t data_num, size_t bytes)
-  {
-    *dst++ = data_num;
-    memmove(dst, src, bytes);
-    dst += bytes;
-    return dst;
-  }
-
-  static uint8_t* store_absolute(uint8_t* dst, const uint8_t* src, size_t src_size, size_t bytes)
-  {
-    if (src_size >= 3)  // 絶対モード;
-    {
-      *dst++ = 0x00;
-      *dst++ = src_size;
-      memmove(dst, src, src_size * bytes);
-      dst += src_size * bytes;
-    }
-    else  // RLEモード;
-    {
-      for (size_t i = 0; i < src_size; i++)
-      {
-        dst = store_encoded(dst, src + i * bytes, 1, bytes);
-      }
-    }
-    return dst;
-  }
-/*
-  static size_t rleDecode(const uint8_t* src, size_t len, size_t bytes)
-  {
-    size_t res = 0;
-    size_t idx = 0;
-    while (idx < len)
-    {
-      if (src[idx++] == 0)
-      {
-        size_t abs_len = src[idx++];
-        idx += abs_len * bytes;
-        res += abs_len;
-        continue;
-      }
-      res += src[idx-1];
-      idx += bytes;
-    }
-    return res;
-  }
-*/
-  static size_t rleEncode(uint8_t* dest, const uint8_t* src, size_t bytelen, size_t bytes)
-  {
-/*
-Serial.printf("bytelen:%d bytes:%d\r\n", bytelen, bytes);
-for (int i = 0; i < bytelen; ++i) { Serial.printf("%02x ",src[i]); } Serial.println();
-//*/
-    static constexpr size_t maxbyte = 255;
-
-    uint8_t* pdest = dest;
-    const uint8_t* pabs = src;
-    const uint8_t* prev = src;
- 
-    int_fast16_t cont = 1;
-    int_fast16_t abso = 0;
-
-    for (size_t i = bytes; i < bytelen; i += bytes)
-    {
-      size_t byteidx = 0;
-      while (src[i + byteidx] == src[i + byteidx - bytes] && ++byteidx != bytes);
-
-      if (byteidx == bytes)
-      {
-        cont++;
-        if (abso >= 1)
-        {
-          pdest = store_absolute(pdest, pabs, abso, bytes);
-        }
-        else if (cont == maxbyte)
-        {
-          pdest = store_encoded(pdest, prev, maxbyte, bytes);
-          cont = 1;
-          prev = src + i;
-        }
-        abso = -1;
-      }
-      else
-      {
-        abso++;
-        if (cont >= 2)
-        {
-          pdest = store_encoded(pdest, prev, cont, bytes);
-        }
-        else if (abso == maxbyte)
-        {
-          pdest = store_absolute(pdest, pabs, maxbyte, bytes);
-          abso = 0;
-        }
-        cont = 1;
-        if (abso == 0) { pabs = src + i; }
-        prev = src + i;
-      }
-    }
-     if (abso >= 0)
-    {
-      pdest = store_absolute(pdest, pabs, abso + 1, bytes);
-    }
-    else if (cont >= 2)
-    {
-      pdest = store_encoded(pdest, prev, cont, bytes);
-    }
-/*
-size_t res = pdest - dest;
-if (bytelen != rleDecode(dest, res, bytes)*bytes) {
-  Serial.printf("res:%d\r\n", res);
-  for (int i = 0; i < res; ++i) { Serial.printf("%02x ",dest[i]); } Serial.println();
-}
-//*/
-    return pdest - dest;
-  }
 //*
   void Panel_M5UnitLCD::writePixels(pixelcopy_t* param, uint32_t length, bool use_dma)
   {
     (void)use_dma;
     auto bytes = _write_bits >> 3;
     uint32_t wb = length * bytes;
-    auto dmabuf = _bus->getDMABuffer(wb + (wb >> 7) + 128);
+    size_t margin = 1 + rle::encode_margin(length, bytes);  // command byte and the growth of the encoded data.
+    auto dmabuf = _bus->getDMABuffer(wb + margin);
     dmabuf[0] = CMD_WRITE_RLE | bytes;
     size_t idx = _check_repeat(dmabuf[0]) ? 0 : 1;
 
-    auto buf = &dmabuf[(wb >> 7) + 128];
+    auto buf = &dmabuf[margin];
     param->fp_copy(buf, 0, length, param);
-    size_t writelen = idx + rleEncode(&dmabuf[idx], buf, length * bytes, bytes);
+    size_t writelen = idx + rle::encode(&dmabuf[idx], buf, length, bytes);
     _bus->writeBytes(dmabuf, writelen, false, true);
     _raw_color = ~0u;
   }
@@ -546,6 +433,7 @@ if (bytelen != rleDecode(dest, res, bytes)*bytes) {
       _set_window(x, y, x+w-1, y+h-1);
     }
     uint32_t wb = w * bytes;
+    size_t margin = rle::encode_margin(w, bytes);
     do
     {
       uint32_t i = 0;
@@ -555,9 +443,8 @@ if (bytelen != rleDecode(dest, res, bytes)*bytes) {
         _buff_free_count = (_buff_free_count > sub)
                          ? (_buff_free_count - sub)
                          : 0;
-        auto dmabuf = _bus->getDMABuffer(wb + (wb >> 7) + 128);
-        dmabuf[0] = cmd;
-        auto buf = &dmabuf[(wb >> 7) + 128];
+        auto dmabuf = _bus->getDMABuffer(wb + margin);
+        auto buf = &dmabuf[margin];
         int32_t len = param->fp_copy(buf, 0, w - i, param);
         if (transp)
         {
@@ -567,8 +454,7 @@ if (bytelen != rleDecode(dest, res, bytes)*bytes) {
         {
           _bus->writeCommand(cmd, 8);
         }
-        size_t idx = 0;
-        size_t writelen = rleEncode(&dmabuf[idx], buf, len * bytes, bytes);
+        size_t writelen = rle::encode(dmabuf, buf, len, bytes);
         _bus->writeBytes(dmabuf, writelen, false, true);
         if (w == (i += len)) break;
       }
@@ -20,6 +20,9 @@ Contributors:
 #include "../platforms/common.hpp"
 #include "../misc/pixelcopy.hpp"
 
+#include <string.h>
+#include <algorithm>
+
 #ifdef min
 #undef min
 #endif
@@ -117,6 +120,80 @@ namespace lgfx
     endWrite();
   }
 
+  /// Stores the `mask` bits of len bytes, byte i taken from pattern[i & 3]. 4 bytes at a time.
+  static void store_pattern(uint8_t* dst, uint32_t len, const uint8_t* pattern, uint32_t mask)
+  {
+    uint32_t pat;
+    memcpy(&pat, pattern, 4);
+    uint32_t m = mask * 0x01010101u;
+    uint32_t i = 0;
+    if (mask == 0xFF)
+    {
+      for (; i + 4 <= len; i += 4) { memcpy(&dst[i], &pat, 4); }
+    }
+    else
+    {
+      for (; i + 4 <= len; i += 4)
+      {
+        uint32_t d;
+        memcpy(&d, &dst[i], 4);
+        d = (d & ~m) | (pat & m);
+        memcpy(&dst[i], &d, 4);
+      }
+    }
+    for (; i < len; ++i) { dst[i] = (dst[i] & ~mask) | (pattern[i & 3] & mask); }
+  }
+
+  /// Stores the `mask` bits of len bytes from src. 4 bytes at a time.
+  static void store_bits(uint8_t* dst, const uint8_t* src, uint32_t len, uint32_t mask)
+  {
+    uint32_t m = mask * 0x01010101u;
+    uint32_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+      uint32_t d, s;
+      memcpy(&d, &dst[i], 4);
+      memcpy(&s, &src[i], 4);
+      d = (d & ~m) | (s & m);
+      memcpy(&dst[i], &d, 4);
+    }
+    for (; i < len; ++i) { dst[i] = (dst[i] & ~mask) | (src[i] & mask); }
+  }
+
+  /// The terms of to_gray for every rgb565 component, so a pixel takes 3 lookups instead of 3 multiplications.
+  struct gray_table_t
+  {
+    uint32_t r[32];
+    uint32_t g[64];
+    uint32_t b[32];
+
+    gray_table_t(void)
+    {
+      for (uint32_t i = 0; i < 32; ++i)
+      {
+        uint32_t v = (i << 3) + (i >> 2);
+        r[i] = v * v * 19749;
+        b[i] = v * v *  7530;
+      }
+      for (uint32_t i = 0; i < 64; ++i)
+      {
+        uint32_t v = (i << 2) + (i >> 4);
+        g[i] = v * v * 38771;
+      }
+    }
+  };
+
+  static void read_gray(pixelcopy_t* param, swap565_t* readbuf, uint8_t* gray, uint32_t len)
+  {
+    static const gray_table_t table;
+    param->fp_copy(readbuf, 0, len, param);
+    for (uint32_t i = 0; i < len; ++i)
+    {
+      auto color = readbuf[i];
+      gray[i] = (table.r[color.r5] + table.g[color.gh << 3 | color.gl] + table.b[color.b5]) >> 24;
+    }
+  }
+
   void Panel_1bitOLED::writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor)
   {
     uint_fast16_t xs = x, xe = x + w - 1;
@@ -131,21 +208,30 @@ namespace lgfx
     color.raw = rawcolor;
     uint32_t value = to_gray(color.R8(), color.G8(), color.B8());
 
-    y = ys;
-    do
+    // The dither pattern repeats every 4 columns, and a page holds 8 rows (2 periods of the matrix),
+    // so a solid color is 4 column bytes that are the same for every page.
+    uint8_t pattern[4];
+    for (uint_fast8_t i = 0; i < 4; ++i)
     {
-      x = xs;
-      uint32_t idx = x + (y >> 3) * _cfg.panel_width;
-      auto btbl = &Bayer[((y + (_bayer_offset >> 2)) & 3) << 2];
-      uint32_t mask = 1 << (y&7);
-      do
+      auto btbl = &Bayer[(xs + i + _bayer_offset) & 3];
+      uint_fast8_t bits = 0;
+      for (uint_fast8_t k = 0; k < 8; ++k)
       {
-        bool flg = 256 <= value + btbl[(x + _bayer_offset) & 3];
-        if (flg) _buf[idx] |=   mask;
-        else     _buf[idx] &= ~ mask;
-        ++idx;
-      } while (++x <= xe);
-    } while (++y <= ye);
+        if (256 <= value + btbl[((k + (_bayer_offset >> 2)) & 3) << 2]) { bits |= 1 << k; }
+      }
+      pattern[i] = bits;
+    }
+
+    uint32_t len = xe - xs + 1;
+    uint_fast16_t page = ys >> 3;
+    uint_fast16_t page_end = ye >> 3;
+    do
+    {
+      uint32_t mask = 0xFF;
+      if (page == (ys >> 3)) { mask &= 0xFF << (ys & 7); }
+      if (page == page_end)  { mask &= 0xFF >> (7 - (ye & 7)); }
+      store_pattern(&_buf[xs + page * _cfg.panel_width], len, pattern, mask);
+    } while (++page <= page_end);
   }
 
   void Panel_1bitOLED::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma)
@@ -156,25 +242,98 @@ namespace lgfx
 
     auto readbuf = (swap565_t*)alloca(w * sizeof(swap565_t));
     auto sx = param->src_x32;
-    h += y;
-    do
+
+    if (param->transp != pixelcopy_t::NON_TRANSP)
     {
-      uint32_t prev_pos = 0, new_pos = 0;
+      h += y;
       do
       {
-        new_pos = param->fp_copy(readbuf, prev_pos, w, param);
-        if (new_pos != prev_pos)
+        uint32_t prev_pos = 0, new_pos = 0;
+        do
+        {
+          new_pos = param->fp_copy(readbuf, prev_pos, w, param);
+          if (new_pos != prev_pos)
+          {
+            do
+            {
+              auto color = readbuf[prev_pos];
+              _draw_pixel(x + prev_pos, y, to_gray(color.R8(), color.G8(), color.B8()));
+            } while (new_pos != ++prev_pos);
+          }
+        } while (w != new_pos && w != (prev_pos = param->fp_skip(new_pos, w, param)));
+        param->src_x32 = sx;
+        param->src_y++;
+      } while (++y < h);
+      return;
+    }
+
+    // xs ~ ye are now the rectangle on the panel memory.
+    // The rows are converted to gray, compared with the Bayer matrix and packed 8 vertical pixels to a byte.
+    uint_fast8_t rb = 1 << _internal_rotation;
+    bool flip_x = rb & 0b11000110; // case 1:2:6:7:
+    bool flip_y = rb & 0b10011100; // case 2:3:4:7:
+    uint_fast8_t ox = _bayer_offset & 3;
+    uint_fast8_t oy = _bayer_offset >> 2;
+    uint32_t panel_width = _cfg.panel_width;
+    auto gray = (uint8_t*)alloca(w);
+
+    if (_internal_rotation & 1)
+    { // each row of the image is a column of the panel memory.
+      for (uint32_t i = 0; i < h; ++i)
+      {
+        read_gray(param, readbuf, gray, w);
+        param->src_x32 = sx;
+        param->src_y++;
+
+        uint_fast16_t px = flip_x ? xe - i : xs + i;
+        auto btbl = &Bayer[(px + ox) & 3];
+        uint_fast16_t py = ys;
+        do
         {
+          uint32_t page = py >> 3;
+          uint_fast8_t bits = 0;
+          uint_fast8_t mask = 0;
           do
           {
-            auto color = readbuf[prev_pos];
-            _draw_pixel(x + prev_pos, y, to_gray(color.R8(), color.G8(), color.B8()));
-          } while (new_pos != ++prev_pos);
+            uint_fast8_t bit = 1 << (py & 7);
+            mask |= bit;
+            if (256 <= gray[flip_y ? ye - py : py - ys] + btbl[((py + oy) & 3) << 2]) { bits |= bit; }
+          } while (++py <= ye && (py & 7));
+          auto dst = &_buf[px + page * panel_width];
+          *dst = (*dst & ~mask) | bits;
+        } while (py <= ye);
+      }
+    }
+    else
+    { // rows of the image are rows of the panel memory; they are collected for a page and stored together.
+      auto bits = (uint8_t*)alloca(w);
+      memset(bits, 0, w);
+      uint_fast8_t mask = 0;
+      for (uint32_t i = 0; i < h; ++i)
+      {
+        read_gray(param, readbuf, gray, w);
+        param->src_x32 = sx;
+        param->src_y++;
+        if (flip_x) { std::reverse(gray, gray + w); }
+
+        uint_fast16_t py = flip_y ? ye - i : ys + i;
+        auto btbl = &Bayer[((py + oy) & 3) << 2];
+        uint8_t threshold[4];
+        for (uint_fast8_t j = 0; j < 4; ++j) { threshold[j] = btbl[(xs + j + ox) & 3]; }
+        uint_fast8_t bit = 1 << (py & 7);
+        mask |= bit;
+        for (uint32_t j = 0; j < w; ++j)
+        {
+          if (256 <= gray[j] + threshold[j & 3]) { bits[j] |= bit; }
         }
-      } while (w != new_pos && w != (prev_pos = param->fp_skip(new_pos, w, param)));
-      param->src_x32 = sx;
-      param->src_y++;
-    } while (++y < h);
+        if (i + 1 == h || ((flip_y ? py - 1 : py + 1) >> 3) != (py >> 3))
+        {
+          store_bits(&_buf[xs + (py >> 3) * panel_width], bits, w, mask);
+          memset(bits, 0, w);
+          mask = 0;
+        }
+      }
+    }
   }
 
   void Panel_1bitOLED::writePixels(pixelcopy_t* param, uint32_t length, bool use_dma)
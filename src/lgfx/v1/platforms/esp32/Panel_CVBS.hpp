@@ -63,6 +63,21 @@ namespace lgfx
 
       /// background PSRAM read task pinned core. (APP_CPU_NUM or PRO_CPU_NUM)
       uint8_t task_pinned_core = -1;
+
+      /// number of scanlines copied ahead from PSRAM. (2, 4, 8 or 16)
+      uint8_t psram_prefetch_lines = 8;
+    };
+
+    struct scanline_stats_t
+    {
+      /// PSRAM lines that were copied to SRAM in time.
+      uint32_t hit;
+      /// PSRAM lines that were not prefetched. another line is shown instead.
+      uint32_t miss;
+      /// PSRAM lines whose copy had not finished. the previous content shows through.
+      uint32_t late;
+      /// scanlines whose interrupt ran longer than one line period. the DMA sent the line before it was written.
+      uint32_t underrun;
     };
 
     color_depth_t setColorDepth(color_depth_t) override;
@@ -76,6 +91,10 @@ namespace lgfx
 
     int32_t getScanLine(void) override;
 
+    /// counters of the scanline interrupt since init or resetScanlineStats(), to diagnose tearing.
+    scanline_stats_t getScanlineStats(void) const;
+    void resetScanlineStats(void);
+
     const config_detail_t& config_detail(void) const { return _config_detail; }
     void config_detail(const config_detail_t& config_detail);
 
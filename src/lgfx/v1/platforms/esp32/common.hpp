@@ -163,6 +163,7 @@ namespace lgfx
       need_transaction = true;
     }
     int read(uint8_t *buf, uint32_t len) override { return _fp->read(buf, len); }
+    int write(const uint8_t *buf, uint32_t len) override { return _fp->write(buf, len); }
     void skip(int32_t offset) override { _fp->seek(offset, SeekCur); }
     bool seek(uint32_t offset) override { return _fp->seek(offset, SeekSet); }
     bool seek(uint32_t offset, SeekMode mode) { return _fp->seek(offset, mode); }
@@ -185,6 +186,7 @@ protected:
       DataWrapperT<fs::File>::_fp = &_file;
       return _file;
     }
+    const void* getFileSystem(void) const override { return _fs; }
 
 protected:
     fs::FS* _fs;
@@ -42,7 +42,7 @@ namespace lgfx
     uint8_t r = 0, g = 0, b = 0;
 
     // GGGBBBBB RRRRRGGG
-    if (_write_depth = color_depth_t::rgb565_2Byte)
+    if (_write_depth == color_depth_t::rgb565_2Byte)
     {
       b = (uint8_t)((rawcolor >> 8) & 0b11111);
       g = (uint8_t)((((rawcolor >> 10) & 0b111000)) | (rawcolor & 0b111));
@@ -54,7 +54,7 @@ namespace lgfx
       *((unsigned short*)(_fbp + pix_offset)) = c;
     }
     // BBBBBBBB GGGGGGGG RRRRRRRR
-    else if (_write_depth = color_depth_t::rgb888_3Byte)
+    else if (_write_depth == color_depth_t::rgb888_3Byte)
     {
       b = (uint8_t)((rawcolor >> 16) & 0xff);
       g = (uint8_t)((rawcolor >> 8) & 0xff);
@@ -87,10 +87,11 @@ namespace lgfx
 
   Panel_fb::~Panel_fb(void)
   {
+    if (_back_ram) { heap_free(_back_ram); }
     // unmap fb file from memory
-    munmap(_fbp, _screensize);
+    if (_fb_map) { munmap(_fb_map, _screensize); }
     // reset the display mode
-    if (ioctl(_fbfd, FBIOPUT_VSCREENINFO, &_fix_info)) {
+    if (_var_info_changed && ioctl(_fbfd, FBIOPUT_VSCREENINFO, &_var_info_orig)) {
         printf("Error re-setting variable information.\n");
     }
     // close fb file    
@@ -105,6 +106,11 @@ namespace lgfx
     _fbp = 0;
   }
 
+  void Panel_fb::config_detail(const config_detail_t& config_detail)
+  {
+    _config_detail = config_detail;
+  }
+
   bool Panel_fb::init(bool use_reset)
   {
     _fbfd = open(_config_detail.device_name, O_RDWR);
@@ -145,6 +151,7 @@ namespace lgfx
         printf("Error reading variable information.\n");
         return false;
     }
+    _var_info_orig = _var_info;
     // printf("%dx%d, %dbpp\n", _var_info.xres, _var_info.yres, _var_info.bits_per_pixel);
 
     // 16/24/32
@@ -159,20 +166,161 @@ namespace lgfx
     // Figure out the size of the screen in bytes
     _screensize = _fix_info.smem_len;  //finfo.line_length * vinfo.yres;    
 
+    if (_config_detail.double_buffer && !init_double_buffer())
+    {
+      return false;
+    }
+
     // Map the device to memory
-    _fbp = (char *)mmap(0, _screensize, PROT_READ | PROT_WRITE, MAP_SHARED, _fbfd, 0);
-    if((intptr_t)_fbp == -1) {
+    _fb_map = (char *)mmap(0, _screensize, PROT_READ | PROT_WRITE, MAP_SHARED, _fbfd, 0);
+    if((intptr_t)_fb_map == -1) {
+        _fb_map = nullptr;
         perror("Error: failed to map framebuffer device to memory");
         return false;
     }
-    memset(_fbp, 0, _screensize);
+    memset(_fb_map, 0, _screensize);
+    _fbp = _fb_map;
+
+    if (_config_detail.double_buffer)
+    {
+      if (_page_flip)
+      { // draw into the page after the visible one.
+        _fb_front = _fb_map;
+        _fbp = _fb_map + _page_bytes;
+      }
+      else
+      {
+        _fb_front = _fb_map;
+        _fbp = (char*)_back_ram;
+      }
+    }
+    _range_mod.top = INT16_MAX;
+    _range_mod.left = INT16_MAX;
+    _range_mod.right = 0;
+    _range_mod.bottom = 0;
 
     return Panel_Device::init(use_reset);
   }
 
+  bool Panel_fb::init_double_buffer(void)
+  {
+    _page_bytes = _fix_info.line_length * _var_info.yres;
+
+    // Ask for a virtual screen twice as tall as the visible one, so that the back buffer is video memory that can be panned into view.
+    if (_var_info.yres_virtual < _var_info.yres * 2)
+    {
+      auto var = _var_info;
+      var.yres_virtual = _var_info.yres * 2;
+      var.yoffset = 0;
+      if (0 == ioctl(_fbfd, FBIOPUT_VSCREENINFO, &var))
+      { // the virtual size is restored on destruction, even if the driver then turns out not to pan.
+        _var_info_changed = true;
+        ioctl(_fbfd, FBIOGET_VSCREENINFO, &_var_info);
+        ioctl(_fbfd, FBIOGET_FSCREENINFO, &_fix_info);
+        _screensize = _fix_info.smem_len;
+        _page_bytes = _fix_info.line_length * _var_info.yres;
+      }
+    }
+    _var_info.yoffset = 0;
+    _page_flip = (_var_info.yres_virtual >= _var_info.yres * 2)
+              && (_fix_info.ypanstep != 0)
+              && ((uint32_t)_screensize >= _page_bytes * 2)
+              && (0 == ioctl(_fbfd, FBIOPAN_DISPLAY, &_var_info));
+    if (_page_flip) { _var_info_changed = true; }
+
+    if (!_page_flip)
+    { // the driver can not pan ; keep the back buffer in system memory and copy the changed area.
+      _back_ram = (uint8_t*)heap_alloc(_page_bytes);
+      if (_back_ram == nullptr)
+      {
+        printf("Error: failed to allocate the back buffer.\n");
+        return false;
+      }
+      memset(_back_ram, 0, _page_bytes);
+    }
+
+#if defined ( FBIO_WAITFORVSYNC )
+    uint32_t crtc = 0;
+    _vsync = _config_detail.wait_vsync && (0 == ioctl(_fbfd, FBIO_WAITFORVSYNC, &crtc));
+#endif
+    return true;
+  }
+
+  void Panel_fb::wait_vsync(void)
+  {
+#if defined ( FBIO_WAITFORVSYNC )
+    if (!_vsync) return;
+    uint32_t crtc = 0;
+    if (ioctl(_fbfd, FBIO_WAITFORVSYNC, &crtc))
+    { // the driver stopped supporting it (e.g. the output was unplugged) ; don't retry every frame.
+      _vsync = false;
+    }
+#endif
+  }
+
+  void Panel_fb::mark_modified(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h)
+  {
+    if (_fb_front == nullptr) return;
+    uint_fast8_t r = _internal_rotation;
+    if (r)
+    {
+      if ((1u << r) & 0b10010110) { y = _height - (y + h); }
+      if (r & 2)                  { x = _width  - (x + w); }
+      if (r & 1) { std::swap(x, y);  std::swap(w, h); }
+    }
+    if (_range_mod.left   > (int_fast16_t)x          ) { _range_mod.left   = x; }
+    if (_range_mod.right  < (int_fast16_t)(x + w - 1)) { _range_mod.right  = x + w - 1; }
+    if (_range_mod.top    > (int_fast16_t)y          ) { _range_mod.top    = y; }
+    if (_range_mod.bottom < (int_fast16_t)(y + h - 1)) { _range_mod.bottom = y + h - 1; }
+  }
+
+  void Panel_fb::copy_range(char* dst, const char* src, const range_rect_t& range)
+  {
+    size_t bytes = _var_info.bits_per_pixel >> 3;
+    size_t line = _fix_info.line_length;
+    size_t offset = range.top * line + range.left * bytes;
+    size_t len = range.width() * bytes;
+    if (len == line)
+    {
+      memcpy(&dst[offset], &src[offset], len * range.height());
+      return;
+    }
+    int_fast16_t h = range.height();
+    do
+    {
+      memcpy(&dst[offset], &src[offset], len);
+      offset += line;
+    } while (--h);
+  }
+
   void Panel_fb::display(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h)
   {
-    // Nothings to do
+    if (_fb_front == nullptr) return;  // drawing goes straight to the visible buffer.
+
+    if (w && h) { mark_modified(x, y, w, h); }
+    range_rect_t range = _range_mod;
+    if (range.right  >= (int_fast16_t)_var_info.xres) { range.right  = _var_info.xres - 1; }
+    if (range.bottom >= (int_fast16_t)_var_info.yres) { range.bottom = _var_info.yres - 1; }
+    if (range.empty()) return;
+
+    _range_mod.top = INT16_MAX;
+    _range_mod.left = INT16_MAX;
+    _range_mod.right = 0;
+    _range_mod.bottom = 0;
+
+    if (!_page_flip)
+    {
+      wait_vsync();
+      copy_range(_fb_front, _fbp, range);
+      return;
+    }
+
+    // Show the back page, then bring the page that was visible up to date so drawing can continue on it.
+    _var_info.yoffset = (_fbp == _fb_map) ? 0 : _var_info.yres;
+    ioctl(_fbfd, FBIOPAN_DISPLAY, &_var_info);
+    wait_vsync();
+    std::swap(_fbp, _fb_front);
+    copy_range(_fbp, _fb_front, range);
   }
 
   color_depth_t Panel_fb::setColorDepth(color_depth_t depth)
@@ -216,6 +364,7 @@ namespace lgfx
 
   void Panel_fb::drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor)
   {
+    mark_modified(x, y, 1, 1);
     uint_fast8_t rotation = _internal_rotation;
     if (rotation)
     {
@@ -236,21 +385,17 @@ namespace lgfx
       default:
         break;
     }
-
-    if (!getStartCount())
-    {
-      display(x, y, 1, 1);
-    }
   }
 
   void Panel_fb::writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor)
   {
+    mark_modified(x, y, w, h);
     uint_fast8_t rotation = _internal_rotation;
     if (rotation)
     {
-      if ((1u << rotation) & 0b10010110) { y = _height - (y + 1); }
-      if (rotation & 2)                  { x = _width  - (x + 1); }
-      if (rotation & 1) { std::swap(x, y); }
+      if ((1u << rotation) & 0b10010110) { y = _height - (y + h); }
+      if (rotation & 2)                  { x = _width  - (x + w); }
+      if (rotation & 1) { std::swap(x, y);  std::swap(w, h); }
     }
 
     for (size_t width = 0; width < w; width++)
@@ -329,6 +474,7 @@ namespace lgfx
   void Panel_fb::writePixels(pixelcopy_t* param, uint32_t length, bool use_dma)
   {
     // NOT TEST
+    mark_modified(_xs, _ys, _xe + 1 - _xs, _ye + 1 - _ys);
     uint_fast16_t xs = _xs;
     uint_fast16_t xe = _xe;
     uint_fast16_t ys = _ys;
@@ -433,6 +579,7 @@ namespace lgfx
   void Panel_fb::writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool)
   {
     // NOT TEST
+    mark_modified(x, y, w, h);
     uint_fast8_t r = _internal_rotation;
     if (r == 0 && param->transp == pixelcopy_t::NON_TRANSP && param->no_convert)
     {
@@ -484,6 +631,7 @@ namespace lgfx
   void Panel_fb::writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param)
   {
     // NOT TEST
+    mark_modified(x, y, w, h);
     uint32_t nextx = 0;
     uint32_t nexty = 1 << pixelcopy_t::FP_SCALE;
     if (_internal_rotation)
@@ -513,6 +661,7 @@ namespace lgfx
 
   void Panel_fb::copyRect(uint_fast16_t dst_x, uint_fast16_t dst_y, uint_fast16_t w, uint_fast16_t h, uint_fast16_t src_x, uint_fast16_t src_y)
   {
+    mark_modified(dst_x, dst_y, w, h);
 
     uint_fast8_t r = _internal_rotation;
     if (r)
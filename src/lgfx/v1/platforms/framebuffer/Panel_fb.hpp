@@ -47,6 +47,14 @@ namespace lgfx
     {
       // 操作対象とするフレームバッファのパス名、または、デバイス名称 ("st7789") 等の文字列へのポインタを指定する。
       const char* device_name = "/dev/fb0";
+
+      // true : 描画をバックバッファに対して行い、display() の呼出しで表示側に反映する。
+      // yres_virtual を拡張できるドライバでは FBIOPAN_DISPLAY によるページ切替え、
+      // それ以外ではシステムRAM上のバッファから変更範囲のみを memcpy する。
+      bool double_buffer = false;
+
+      // true : display() で表示を切替える際に FBIO_WAITFORVSYNC で垂直同期を待つ。(非対応のドライバでは無視)
+      bool wait_vsync = true;
     };
 
     bool init(bool use_reset) override;
@@ -61,6 +69,7 @@ namespace lgfx
 
     void waitDisplay(void) override {}
     bool displayBusy(void) override { return false; }
+    bool isMemoryBacked(void) const override { return true; }
 
     void writePixels(pixelcopy_t* param, uint32_t len, bool use_dma) override;
     void writeBlock(uint32_t rawcolor, uint32_t length) override;
@@ -78,6 +87,14 @@ namespace lgfx
 
     uint_fast8_t getTouchRaw(touch_point_t* tp, uint_fast8_t count) override;
 
+    // init前に使用し、ダブルバッファの有効/無効を指定する。
+    void setDoubleBuffer(bool enable) { _config_detail.double_buffer = enable; };
+
+    /// true when the panel draws into a back buffer and display() presents it.
+    bool isDoubleBuffered(void) const { return _fb_front != nullptr; }
+    /// true when the back buffer is a second page of the device, flipped with FBIOPAN_DISPLAY.
+    bool isPageFlipping(void) const { return _page_flip; }
+
     // init前に使用し、操作対象とするフレームバッファのパス名、または、デバイス名称 ("st7789") 等の文字列へのポインタを指定する。
     void setDeviceName(const char* device_name) { _config_detail.device_name = device_name; };
 
@@ -91,16 +108,30 @@ namespace lgfx
     touch_point_t _touch_point;
     // framebuffer
     int _fbfd = 0;
-    char* _fbp = 0;
+    char* _fbp = 0;       // drawing target ; the back buffer when double buffered
+    char* _fb_map = 0;    // mapped device memory
+    char* _fb_front = 0;  // page being scanned out when double buffered, otherwise nullptr
+    uint8_t* _back_ram = nullptr;
     long int _screensize = 0;
+    uint32_t _page_bytes = 0;
     struct fb_var_screeninfo _var_info;
+    struct fb_var_screeninfo _var_info_orig;
     struct fb_fix_screeninfo _fix_info;
+    range_rect_t _range_mod;  // area of the back buffer changed since the last display(), in panel coordinates
+    bool _page_flip = false;
+    bool _var_info_changed = false;  // _var_info_orig is to be put back on destruction
+    bool _vsync = false;
 
     int32_t _xpos = 0;
     int32_t _ypos = 0;
 
     void _rotate_pixelcopy(uint_fast16_t& x, uint_fast16_t& y, uint_fast16_t& w, uint_fast16_t& h, pixelcopy_t* param, uint32_t& nextx, uint32_t& nexty);
 
+    bool init_double_buffer(void);
+    void wait_vsync(void);
+    void mark_modified(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h);
+    void copy_range(char* dst, const char* src, const range_rect_t& range);
+
   private:
     void fb_draw_rgb_pixel(int x, int y, uint32_t rawcolor);
     void fb_draw_argb_pixel(int x, int y, uint32_t rawcolor);
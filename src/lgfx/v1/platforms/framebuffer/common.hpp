@@ -71,6 +71,7 @@ namespace lgfx
     FILE* _fp;
     bool open(const char* path) override { return (_fp = fopen(path, "rb")); }
     int read(uint8_t *buf, uint32_t len) override { return fread((char*)buf, 1, len, _fp); }
+    int write(const uint8_t *buf, uint32_t len) override { return fwrite((const char*)buf, 1, len, _fp); }
     void skip(int32_t offset) override { seek(offset, SEEK_CUR); }
     bool seek(uint32_t offset) override { return seek(offset, SEEK_SET); }
     bool seek(uint32_t offset, int origin) { return fseek(_fp, offset, origin); }
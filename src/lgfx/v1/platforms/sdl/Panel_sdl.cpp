@@ -363,6 +363,7 @@ namespace lgfx
 
   color_depth_t Panel_sdl::setColorDepth(color_depth_t depth)
   {
+    _dirty_all = true;
     auto bits = depth & color_depth_t::bit_mask;
     if (bits >= 16) {
       depth = (bits > 16)
@@ -398,16 +399,76 @@ namespace lgfx
     }
   };
 
+  static inline int rect_area(const SDL_Rect& r) { return r.w * r.h; }
+
+  static inline SDL_Rect rect_union(const SDL_Rect& a, const SDL_Rect& b)
+  {
+    SDL_Rect r;
+    r.x = std::min(a.x, b.x);
+    r.y = std::min(a.y, b.y);
+    r.w = std::max(a.x + a.w, b.x + b.w) - r.x;
+    r.h = std::max(a.y + a.h, b.y + b.h) - r.y;
+    return r;
+  }
+
+  void Panel_sdl::add_dirty(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h)
+  {
+    if (_dirty_all || !w || !h) { return; }
+    uint_fast8_t r = _internal_rotation;
+    if (r)
+    {
+      if ((1u << r) & 0b10010110) { y = _height - (y + h); }
+      if (r & 2)                  { x = _width  - (x + w); }
+      if (r & 1) { std::swap(x, y);  std::swap(w, h); }
+    }
+    SDL_Rect rect;
+    rect.x = x;
+    rect.y = y;
+    rect.w = w;
+    rect.h = h;
+    add_dirty_rect(rect);
+  }
+
+  void Panel_sdl::add_dirty_rect(SDL_Rect rect)
+  {
+    for (;;)
+    {
+      uint_fast8_t best = 0;
+      int best_growth = INT32_MAX;
+      for (uint_fast8_t i = 0; i < _dirty_count; ++i)
+      {
+        auto u = rect_union(_dirty_rects[i], rect);
+        int growth = rect_area(u) - rect_area(_dirty_rects[i]) - rect_area(rect);
+        if (growth < best_growth) { best_growth = growth; best = i; }
+      }
+      // merge when the union costs no more than the two regions, or when the list is full.
+      if (best_growth > 0 && _dirty_count < dirty_max)
+      {
+        _dirty_rects[_dirty_count++] = rect;
+        return;
+      }
+      rect = rect_union(_dirty_rects[best], rect);
+      _dirty_rects[best] = _dirty_rects[--_dirty_count];
+      if (_dirty_count == 0 && rect.w >= (int)_cfg.panel_width && rect.h >= (int)_cfg.panel_height)
+      {
+        _dirty_all = true;
+        return;
+      }
+    }
+  }
+
   void Panel_sdl::drawPixelPreclipped(uint_fast16_t x, uint_fast16_t y, uint32_t rawcolor)
   {
     lock_t lock(this);
     Panel_FrameBufferBase::drawPixelPreclipped(x, y, rawcolor);
+    add_dirty(x, y, 1, 1);
   }
 
   void Panel_sdl::writeFillRectPreclipped(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, uint32_t rawcolor)
   {
     lock_t lock(this);
     Panel_FrameBufferBase::writeFillRectPreclipped(x, y, w, h, rawcolor);
+    add_dirty(x, y, w, h);
   }
 
   void Panel_sdl::writeBlock(uint32_t rawcolor, uint32_t length)
@@ -420,20 +481,30 @@ namespace lgfx
   {
     lock_t lock(this);
     Panel_FrameBufferBase::writeImage(x, y, w, h, param, use_dma);
+    add_dirty(x, y, w, h);
   }
 
   void Panel_sdl::writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param)
   {
     lock_t lock(this);
     Panel_FrameBufferBase::writeImageARGB(x, y, w, h, param);
+    add_dirty(x, y, w, h);
   }
 
   void Panel_sdl::writePixels(pixelcopy_t* param, uint32_t len, bool use_dma)
   {
     lock_t lock(this);
+    add_dirty(_xs, _ys, _xe + 1 - _xs, _ye + 1 - _ys);
     Panel_FrameBufferBase::writePixels(param, len, use_dma);
   }
 
+  void Panel_sdl::copyRect(uint_fast16_t dst_x, uint_fast16_t dst_y, uint_fast16_t w, uint_fast16_t h, uint_fast16_t src_x, uint_fast16_t src_y)
+  {
+    lock_t lock(this);
+    Panel_FrameBufferBase::copyRect(dst_x, dst_y, w, h, src_x, src_y);
+    add_dirty(dst_x, dst_y, w, h);
+  }
+
   void Panel_sdl::display(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h)
   {
     (void)x;
@@ -519,6 +590,7 @@ namespace lgfx
     m->renderer = SDL_CreateRenderer(m->window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
     m->texture = SDL_CreateTexture(m->renderer, SDL_PIXELFORMAT_RGB24,
                      SDL_TEXTUREACCESS_STREAMING, _cfg.panel_width, _cfg.panel_height);
+    _dirty_all = true;
     SDL_SetTextureBlendMode(m->texture, SDL_BLENDMODE_NONE);
 
     if (m->frame_image) {
@@ -558,14 +630,42 @@ namespace lgfx
       if (0 == SDL_LockMutex(_sdl_mutex))
       {
         _texupdate_counter = _modified_counter;
-        for (int y = 0; y < _cfg.panel_height; ++y)
+        SDL_Rect rects[dirty_max];
+        uint_fast8_t count = _dirty_count;
+        if (_dirty_all)
+        {
+          rects[0].x = 0;
+          rects[0].y = 0;
+          rects[0].w = _cfg.panel_width;
+          rects[0].h = _cfg.panel_height;
+          count = 1;
+        }
+        else
         {
-          pc.src_x32 = 0;
-          pc.src_data = _lines_buffer[y];
-          pc.fp_copy(&_texturebuf[y * _cfg.panel_width], 0, _cfg.panel_width, &pc);
+          memcpy(rects, _dirty_rects, count * sizeof(SDL_Rect));
+        }
+        _dirty_all = false;
+        _dirty_count = 0;
+
+        int pitch = _cfg.panel_width;
+        for (uint_fast8_t i = 0; i < count; ++i)
+        {
+          auto& r = rects[i];
+          for (int y = r.y; y < r.y + r.h; ++y)
+          {
+            pc.src_x32 = r.x;
+            pc.src_data = _lines_buffer[y];
+            pc.fp_copy(&_texturebuf[y * pitch], r.x, r.x + r.w, &pc);
+          }
         }
         SDL_UnlockMutex(_sdl_mutex);
-        SDL_UpdateTexture(monitor.texture, nullptr, _texturebuf, _cfg.panel_width * sizeof(rgb888_t));
+
+        // upload only the changed regions ; the texture keeps the rest.
+        for (uint_fast8_t i = 0; i < count; ++i)
+        {
+          auto& r = rects[i];
+          SDL_UpdateTexture(monitor.texture, &r, &_texturebuf[r.y * pitch + r.x], pitch * sizeof(rgb888_t));
+        }
       }
     }
 
@@ -87,6 +87,7 @@ namespace lgfx
     void writeImage(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param, bool use_dma) override;
     void writeImageARGB(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h, pixelcopy_t* param) override;
     void writePixels(pixelcopy_t* param, uint32_t len, bool use_dma) override;
+    void copyRect(uint_fast16_t dst_x, uint_fast16_t dst_y, uint_fast16_t w, uint_fast16_t h, uint_fast16_t src_x, uint_fast16_t src_y) override;
 
     uint_fast8_t getTouchRaw(touch_point_t* tp, uint_fast8_t count) override;
 
@@ -127,6 +128,17 @@ namespace lgfx
     uint_fast16_t _display_counter;
     bool _invalidated;
 
+    // Regions of _lines_buffer (panel coordinates) changed since the last texture upload.
+    // Touching or overlapping regions are merged ; when the list is full the new region
+    // is merged into the one it enlarges the least.
+    static constexpr uint_fast8_t dirty_max = 16;
+    SDL_Rect _dirty_rects[dirty_max];
+    uint_fast8_t _dirty_count = 0;
+    bool _dirty_all = true;
+
+    void add_dirty(uint_fast16_t x, uint_fast16_t y, uint_fast16_t w, uint_fast16_t h);
+    void add_dirty_rect(SDL_Rect rect);
+
     static void _event_proc(void);
     static void _update_proc(void);
     static void _update_scaling(monitor_t * m, float sx, float sy);